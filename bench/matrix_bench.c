@@ -0,0 +1,533 @@
+/**
+ * @file matrix_bench.c
+ * @brief Замеры производительности матричных операций
+ *
+ * @details
+ * Программа перебирает размеры s = min, 2 min, ..., max и для каждого
+ * измеряет операции на двух формах:
+ * - square: A (s x s) x B (s x s), поэлементные операции над s x s
+ * - rect: A (s x 2s) x B (2s x s/2), поэлементные операции над s x s/2
+ *
+ * Каждый замер начинается с прогрева (--warmup), затем выполняется
+ * --repeat выборок. Выборка повторяет операцию столько раз, чтобы длиться
+ * не меньше BENCH_MIN_SAMPLE секунд; время операции - время выборки,
+ * деленное на число повторов. Для выборок выводятся медиана и 95-й
+ * перцентиль, производительность по медиане (GFLOP/s для умножения и
+ * детерминанта, GB/s для остальных) и пиковый объем резидентной памяти
+ * за время замера.
+ *
+ * Матрицы заполняются генератором xorshift с фиксированным зерном (--seed),
+ * поэтому запуски с одинаковыми аргументами выполняют одинаковую работу.
+ * Результаты выводятся построчно в формате CSV (--csv, по умолчанию) или
+ * JSON (--json) в stdout или файл --output.
+ *
+ * @see matrix.h README.md
+ */
+
+#include "matrix/cache.h"
+#include "matrix/matrix.h"
+#include "matrix/simd.h"
+#include "parallel/thread_pool.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/** Наименьшая длительность одной выборки в секундах */
+#define BENCH_MIN_SAMPLE 0.01
+
+/** Наибольшее число выборок */
+#define BENCH_MAX_REPEAT 1000
+
+/**
+ * @struct BenchData
+ * @brief Матрицы одного замера
+ */
+typedef struct {
+    int         m;         ///< Строк в A и результате
+    int         k;         ///< Столбцов в A и строк в B
+    int         n;         ///< Столбцов в B и результате
+    Matrix      a;         ///< Первый операнд
+    Matrix      b;         ///< Второй операнд
+    Matrix      out;       ///< Результат
+    const char* scratch;   ///< Временный файл для load и save
+} BenchData;
+
+/**
+ * @struct BenchOp
+ * @brief Описание измеряемой операции
+ */
+typedef struct {
+    const char* name;                          ///< Имя операции
+    int (*setup) (BenchData* data);            ///< Подготовка, 0 при успехе
+    int (*run) (BenchData* data);              ///< Выполнение, 0 при успехе
+    double (*flops) (const BenchData* data);   ///< Операций с плавающей точкой
+    double (*bytes) (const BenchData* data);   ///< Байтов прочитано и записано
+    int square_only;                           ///< 1 - только квадратная форма
+} BenchOp;
+
+/**
+ * @struct BenchOptions
+ * @brief Параметры командной строки
+ */
+typedef struct {
+    int         min_size;   ///< Наименьший размер
+    int         max_size;   ///< Наибольший размер
+    int         warmup;     ///< Прогревочных выполнений
+    int         repeat;     ///< Выборок
+    uint64_t    seed;       ///< Зерно генератора
+    int         json;       ///< 1 - JSON, 0 - CSV
+    const char* ops;        ///< Список операций через запятую или NULL
+    const char* output;     ///< Файл результатов или NULL для stdout
+    const char* scratch;    ///< Временный файл для load и save
+} BenchOptions;
+
+// ----------------------------------------------------------------------------
+//  Время, память и данные
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Монотонное время в секундах
+ * @return Время
+ */
+static double bench_now (void) {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Сбрасывает пиковый объем резидентной памяти процесса
+ *
+ * Запись "5" в /proc/self/clear_refs (Linux 4.0+) обнуляет VmHWM; без неё
+ * пик считается с начала работы процесса.
+ */
+static void bench_reset_peak_rss (void) {
+    FILE* f = fopen ("/proc/self/clear_refs", "w");
+
+    if (f) {
+        fputs ("5", f);
+        fclose (f);
+    }
+}
+
+/**
+ * @brief Пиковый объем резидентной памяти
+ *
+ * Читает VmHWM из /proc/self/status, а если его нет - ru_maxrss.
+ *
+ * @return Объем в килобайтах
+ */
+static long bench_peak_rss (void) {
+    long  peak = -1;
+    char  line[256];
+    FILE* f = fopen ("/proc/self/status", "r");
+
+    if (f) {
+        while (peak < 0 && fgets (line, sizeof line, f)) {
+            if (strncmp (line, "VmHWM:", 6) == 0) peak = strtol (line + 6, NULL, 10);
+        }
+        fclose (f);
+    }
+    if (peak < 0) {
+        struct rusage usage;
+        peak = getrusage (RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+    }
+
+    return peak;
+}
+
+/**
+ * @brief Заполняет матрицу значениями из [-1, 1] генератором xorshift
+ * @param m Матрица
+ * @param seed Зерно (не 0)
+ */
+static void bench_fill (Matrix* m, uint64_t seed) {
+    uint64_t state = seed ? seed : 1;
+
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            m->data[i][j] = (double) (state >> 11) * 0x1p-52 - 1.0;
+        }
+    }
+}
+
+/** Зерно генератора для текущего замера */
+static uint64_t bench_seed = 42;
+
+/**
+ * @brief Создает и заполняет матрицу
+ * @param m Матрица
+ * @param rows Строк
+ * @param cols Столбцов
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+static int bench_matrix (Matrix* m, int rows, int cols) {
+    *m = create_matrix (rows, cols);
+    if (m->data) bench_fill (m, bench_seed++);
+
+    return m->data ? 0 : -1;
+}
+
+/**
+ * @brief Освобождает матрицы замера
+ * @param data Замер
+ */
+static void bench_release (BenchData* data) {
+    free_matrix (&data->a);
+    free_matrix (&data->b);
+    free_matrix (&data->out);
+    remove (data->scratch);
+}
+
+// ----------------------------------------------------------------------------
+//  Операции
+// ----------------------------------------------------------------------------
+
+// Подготовка матриц: операнды заполняются, результат выделяется заранее
+
+static int setup_multiply (BenchData* d) {
+    int res = bench_matrix (&d->a, d->m, d->k);
+
+    if (res == 0) res = bench_matrix (&d->b, d->k, d->n);
+    if (res == 0) res = bench_matrix (&d->out, d->m, d->n);
+
+    return res;
+}
+
+static int setup_elementwise (BenchData* d) {
+    int res = bench_matrix (&d->a, d->m, d->n);
+
+    if (res == 0) res = bench_matrix (&d->b, d->m, d->n);
+    if (res == 0) res = bench_matrix (&d->out, d->m, d->n);
+
+    return res;
+}
+
+static int setup_single (BenchData* d) {
+    return bench_matrix (&d->a, d->m, d->n);
+}
+
+static int setup_square (BenchData* d) {
+    return bench_matrix (&d->a, d->n, d->n);
+}
+
+static int setup_load_text (BenchData* d) {
+    int res = bench_matrix (&d->a, d->m, d->n);
+
+    if (res == 0) res = save_matrix_to_file (&d->a, d->scratch);
+
+    return res;
+}
+
+static int setup_load_binary (BenchData* d) {
+    int res = bench_matrix (&d->a, d->m, d->n);
+
+    if (res == 0) res = save_matrix_to_binary_file (&d->a, d->scratch);
+
+    return res;
+}
+
+// Одно выполнение операции
+
+static int run_multiply (BenchData* d) {
+    return multiply_matrices (&d->a, &d->b, &d->out);
+}
+
+static int run_add (BenchData* d) {
+    return add_matrices (&d->a, &d->b, &d->out);
+}
+
+static int run_subtract (BenchData* d) {
+    return subtract_matrices (&d->a, &d->b, &d->out);
+}
+
+static int run_transpose (BenchData* d) {
+    Matrix t   = transpose_matrix (&d->a);
+    int    res = t.data ? 0 : -1;
+
+    free_matrix (&t);
+
+    return res;
+}
+
+static int run_determinant (BenchData* d) {
+    volatile MATRIX_TYPE det = determinant (&d->a);   // Результат не отбрасывается
+
+    (void) det;
+
+    return 0;
+}
+
+static int run_save_text (BenchData* d) {
+    return save_matrix_to_file (&d->a, d->scratch);
+}
+
+static int run_save_binary (BenchData* d) {
+    return save_matrix_to_binary_file (&d->a, d->scratch);
+}
+
+static int run_hash (BenchData* d) {
+    volatile uint64_t hash = matrix_hash (&d->a);   // Результат не отбрасывается
+
+    (void) hash;
+
+    return 0;
+}
+
+static int run_load (BenchData* d) {
+    Matrix m   = load_matrix_from_file (d->scratch);
+    int    res = m.data ? 0 : -1;
+
+    free_matrix (&m);
+
+    return res;
+}
+
+// Объем работы одного выполнения
+
+static double flops_multiply (const BenchData* d) {
+    return 2.0 * d->m * d->n * d->k;
+}
+
+static double flops_determinant (const BenchData* d) {
+    return 2.0 / 3.0 * d->n * d->n * d->n;
+}
+
+static double bytes_elementwise (const BenchData* d) {
+    return 3.0 * d->m * d->n * sizeof (MATRIX_TYPE);
+}
+
+static double bytes_single (const BenchData* d) {
+    return (double) d->m * d->n * sizeof (MATRIX_TYPE);
+}
+
+static double bytes_transpose (const BenchData* d) {
+    return 2.0 * d->m * d->n * sizeof (MATRIX_TYPE);
+}
+
+static double bytes_file (const BenchData* d) {
+    double size = 0;
+    FILE*  f    = fopen (d->scratch, "rb");
+
+    if (f) {
+        if (fseek (f, 0, SEEK_END) == 0) size = (double) ftell (f);
+        fclose (f);
+    }
+
+    return size;
+}
+
+/** Все операции в порядке вывода */
+static const BenchOp bench_ops[] = {
+    {"multiply", setup_multiply, run_multiply, flops_multiply, NULL, 0},
+    {"add", setup_elementwise, run_add, NULL, bytes_elementwise, 0},
+    {"subtract", setup_elementwise, run_subtract, NULL, bytes_elementwise, 0},
+    {"transpose", setup_single, run_transpose, NULL, bytes_transpose, 0},
+    {"determinant", setup_square, run_determinant, flops_determinant, NULL, 1},
+    {"save", setup_single, run_save_text, NULL, bytes_file, 0},
+    {"load", setup_load_text, run_load, NULL, bytes_file, 0},
+    {"save_binary", setup_single, run_save_binary, NULL, bytes_file, 0},
+    {"load_binary", setup_load_binary, run_load, NULL, bytes_file, 0},
+    {"hash", setup_single, run_hash, NULL, bytes_single, 0},
+};
+
+// ----------------------------------------------------------------------------
+//  Замер и вывод
+// ----------------------------------------------------------------------------
+
+static int compare_double (const void* x, const void* y) {
+    const double a = *(const double*) x, b = *(const double*) y;
+
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Проверяет, входит ли операция в список через запятую
+ * @param list Список или NULL (все операции)
+ * @param name Имя операции
+ * @return 1, если операция выбрана
+ */
+static int bench_selected (const char* list, const char* name) {
+    const size_t length = strlen (name);
+    int          found  = (list == NULL);
+
+    for (const char* p = list; p && !found; p = strchr (p, ',')) {
+        if (*p == ',') p++;
+        found = strncmp (p, name, length) == 0 && (p[length] == ',' || !p[length]);
+    }
+
+    return found;
+}
+
+/**
+ * @brief Выполняет один замер и выводит его строку
+ *
+ * @param out Поток результатов
+ * @param options Параметры
+ * @param op Операция
+ * @param shape Имя формы
+ * @param data Замер с размерами и именем временного файла
+ * @param first 1 для первой строки JSON
+ * @return 0 при успехе, -1 при ошибке операции
+ */
+static int bench_case (FILE* out, const BenchOptions* options, const BenchOp* op,
+                       const char* shape, BenchData* data, int first) {
+    double samples[BENCH_MAX_REPEAT];
+    int    inner = 1;   // Выполнений на выборку
+    int    res   = 0;
+
+    bench_reset_peak_rss ();
+    res = op->setup (data);
+
+    // Прогрев и подбор числа выполнений на выборку
+    for (int i = 0; i < options->warmup && res == 0; i++) {
+        const double start = bench_now ();
+        res                = op->run (data);
+        const double time  = bench_now () - start;
+        if (time < BENCH_MIN_SAMPLE)
+            inner = time > 0 ? (int) (BENCH_MIN_SAMPLE / time) + 1 : 1000;
+    }
+
+    for (int r = 0; r < options->repeat && res == 0; r++) {
+        const double start = bench_now ();
+        for (int i = 0; i < inner && res == 0; i++) res = op->run (data);
+        samples[r] = (bench_now () - start) / inner;
+    }
+
+    if (res == 0) {
+        qsort (samples, options->repeat, sizeof (double), compare_double);
+        const int    count  = options->repeat;
+        const double median = (samples[(count - 1) / 2] + samples[count / 2]) / 2;
+        const double p95    = samples[(95 * count + 99) / 100 - 1];
+        const double gflops = op->flops ? op->flops (data) / median * 1e-9 : 0;
+        const double gbps   = op->bytes ? op->bytes (data) / median * 1e-9 : 0;
+        const long   rss    = bench_peak_rss ();
+
+        if (options->json) {
+            fprintf (out,
+                     "%s  {\"op\": \"%s\", \"shape\": \"%s\", \"m\": %d, \"k\": %d, "
+                     "\"n\": %d, \"warmup\": %d, \"repeat\": %d, \"inner\": %d, "
+                     "\"median_s\": %.6e, \"p95_s\": %.6e, \"gflops\": %.3f, "
+                     "\"gbps\": %.3f, \"peak_rss_kb\": %ld}",
+                     first ? "" : ",\n", op->name, shape, data->m, data->k, data->n,
+                     options->warmup, options->repeat, inner, median, p95, gflops,
+                     gbps, rss);
+        } else {
+            fprintf (out, "%s,%s,%d,%d,%d,%d,%d,%d,%.6e,%.6e,%.3f,%.3f,%ld,%s,%d\n",
+                     op->name, shape, data->m, data->k, data->n, options->warmup,
+                     options->repeat, inner, median, p95, gflops, gbps, rss,
+                     simd_ops ()->name, thread_pool_threads ());
+        }
+        fflush (out);
+    } else {
+        fprintf (stderr, "Ошибка замера %s (%s, %d x %d x %d)\n", op->name, shape,
+                 data->m, data->k, data->n);
+    }
+
+    bench_release (data);
+
+    return res == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Разбирает аргументы командной строки
+ * @param argc Число аргументов
+ * @param argv Аргументы
+ * @param options Параметры (заполнены значениями по умолчанию)
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int bench_parse_args (int argc, char* argv[], BenchOptions* options) {
+    int res = 0;
+
+    for (int i = 1; i < argc && res == 0; i++) {
+        const char* flag  = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp (flag, "--json") == 0) options->json = 1;
+        else if (strcmp (flag, "--csv") == 0) options->json = 0;
+        else if (value == NULL) res = -1;
+        else if (strcmp (flag, "--min") == 0) options->min_size = atoi (value);
+        else if (strcmp (flag, "--max") == 0) options->max_size = atoi (value);
+        else if (strcmp (flag, "--warmup") == 0) options->warmup = atoi (value);
+        else if (strcmp (flag, "--repeat") == 0) options->repeat = atoi (value);
+        else if (strcmp (flag, "--seed") == 0)
+            options->seed = strtoull (value, NULL, 10);
+        else if (strcmp (flag, "--ops") == 0) options->ops = value;
+        else if (strcmp (flag, "--output") == 0) options->output = value;
+        else if (strcmp (flag, "--scratch") == 0) options->scratch = value;
+        else res = -1;
+
+        if (res != 0) fprintf (stderr, "Неизвестный аргумент: %s\n", flag);
+        else if (strcmp (flag, "--json") != 0 && strcmp (flag, "--csv") != 0) i++;
+    }
+
+    if (res == 0 &&
+        (options->min_size < 1 || options->max_size < options->min_size ||
+         options->warmup < 1 || options->repeat < 1 ||
+         options->repeat > BENCH_MAX_REPEAT)) {
+        fprintf (stderr, "Недопустимые размеры или число повторов\n");
+        res = -1;
+    }
+
+    return res;
+}
+
+int main (int argc, char* argv[]) {
+    BenchOptions options = {16, 8192, 1, 5, 42, 0, NULL, NULL, "matrix_bench.tmp"};
+    FILE*        out     = stdout;
+    int          res     = bench_parse_args (argc, argv, &options);
+    int          first   = 1;
+    int          header  = 0;   // Заголовок выведен
+
+    if (res == 0 && options.output) {
+        out = fopen (options.output, "w");
+        if (out == NULL) {
+            fprintf (stderr, "Не удалось открыть файл %s\n", options.output);
+            res = -1;
+        }
+    }
+
+    if (res == 0) {
+        header = 1;
+        if (options.json) {
+            fprintf (out, "{\"simd\": \"%s\", \"threads\": %d, \"seed\": %llu, "
+                          "\"results\": [\n",
+                     simd_ops ()->name, thread_pool_threads (),
+                     (unsigned long long) options.seed);
+        } else {
+            fprintf (out, "op,shape,m,k,n,warmup,repeat,inner,median_s,p95_s,"
+                          "gflops,gbps,peak_rss_kb,simd,threads\n");
+        }
+    }
+
+    for (int s = options.min_size; res == 0 && s <= options.max_size; s *= 2) {
+        for (size_t i = 0; i < sizeof (bench_ops) / sizeof (bench_ops[0]); i++) {
+            if (!bench_selected (options.ops, bench_ops[i].name)) continue;
+            BenchData square = {s, s, s, {0}, {0}, {0}, options.scratch};
+            BenchData rect   = {s, 2 * s, s / 2 > 0 ? s / 2 : 1,
+                                {0}, {0}, {0}, options.scratch};
+
+            // Одинаковые данные для каждого размера независимо от --ops
+            bench_seed = options.seed + (uint64_t) s * 16;
+            if (bench_case (out, &options, &bench_ops[i], "square", &square, first))
+                res = -1;
+            first = 0;
+            if (!bench_ops[i].square_only &&
+                bench_case (out, &options, &bench_ops[i], "rect", &rect, first))
+                res = -1;
+        }
+    }
+
+    if (header && options.json) fprintf (out, "\n]}\n");
+    if (out != NULL && out != stdout) fclose (out);
+
+    return res == 0 ? 0 : 1;
+}
@@ -7,9 +7,110 @@
 #define CONFIG_H
 
 /**
- * @brief Определение типа данных для элементов матрицы
- * Можно изменить на float, int и т.д.
+ * @brief Тип элементов матриц MATRIX_F64 (double)
+ * Матрицы float и int32_t задаются типом элементов при создании
+ * (create_matrix_typed, MATRIX_F32 и MATRIX_I32, ядра в typed.c), а не
+ * заменой MATRIX_TYPE: код double рассчитан на 8-байтовые элементы
  */
 typedef double MATRIX_TYPE;
 
+/**
+ * @brief Выравнивание единого блока данных матрицы в байтах
+ * Совпадает с размером кэш-линии и шириной регистра AVX-512
+ */
+#define MATRIX_ALIGNMENT 64
+
+/**
+ * @brief Период совпадения наборов кэша в байтах
+ * Если шаг строки кратен этому значению, он увеличивается на одну кэш-линию,
+ * чтобы соседние строки не попадали в один и тот же набор кэша
+ */
+#define MATRIX_ALIAS_PERIOD 2048
+
+/**
+ * @brief Параметры блокировки умножения матриц (GEMM)
+ *
+ * GEMM_KC x GEMM_NR - микропанель B, должна помещаться в L1
+ * GEMM_MC x GEMM_KC - блок упакованной A, должен помещаться в L2
+ * GEMM_KC x GEMM_NC - блок упакованной B, должен помещаться в L3
+ */
+#define GEMM_MC 192
+#define GEMM_KC 256
+#define GEMM_NC 4096
+
+/**
+ * @brief Порог (m * n * k), ниже которого умножение выполняется без упаковки
+ */
+#define GEMM_SMALL_THRESHOLD (32 * 32 * 32)
+
+/**
+ * @brief Порог (m * n * k), начиная с которого умножение распределяется
+ * между потоками пула
+ */
+#define GEMM_PARALLEL_THRESHOLD (128 * 128 * 128)
+
+/**
+ * @brief Размер, до которого рекурсия Штрассена-Винограда спускается
+ * перед переходом к обычному блочному умножению
+ */
+#define STRASSEN_CROSSOVER 512
+
+/**
+ * @brief Наименьшая размерность, начиная с которой multiply_matrices
+ * автоматически использует метод Штрассена-Винограда
+ * 0 - выключено (метод доступен через multiply_matrices_strassen); например,
+ * 2048 включает его для больших произведений ценой точности (см. strassen.h)
+ */
+#define STRASSEN_AUTO_MIN 0
+
+/**
+ * @brief Размер квадратной плитки поэлементного прохода ленивых выражений
+ * Плитки всех узлов одной цепочки должны вместе помещаться в L2
+ */
+#define EXPR_TILE 64
+
+/**
+ * @brief Сторона листового блока транспонирования
+ * Рекурсия делит матрицу пополам, пока блок больше TRANSPOSE_TILE x
+ * TRANSPOSE_TILE; исходный и результирующий блоки вместе помещаются в L1-L2
+ */
+#define TRANSPOSE_TILE 64
+
+/**
+ * @brief Сторона плитки по умолчанию для плиточных файлов (ooc.h)
+ * Плитка 512 x 512 double занимает 2 МБ и читается одним pread
+ */
+#define OOC_TILE 512
+
+/**
+ * @brief Бюджет памяти умножения плиточных файлов по умолчанию в байтах
+ */
+#define OOC_MEMORY_BUDGET ((size_t) 1 << 30)
+
+/**
+ * @brief Размер куска арены по умолчанию в байтах (arena.h)
+ * Буферы упаковки одного умножения GEMM_NC x GEMM_KC занимают около 8 МБ
+ */
+#define ARENA_CHUNK_SIZE ((size_t) 1 << 24)
+
+/**
+ * @brief Число матриц пакета в одной задаче пакетных операций (batch.h)
+ * Кратно MATRIX_ALIGNMENT / sizeof (MATRIX_TYPE); три операнда 8 x 8 по
+ * 256 матриц занимают 384 КБ и помещаются в L2
+ */
+#define BATCH_CHUNK 256
+
+/**
+ * @brief Наибольшая доля ненулевых элементов, при которой main умножает
+ * через формат CSR (sparse.h)
+ * При большей плотности блочное умножение быстрее
+ */
+#define SPARSE_DENSITY_THRESHOLD 0.05
+
+/**
+ * @brief Предел суммарного размера записей кэша результатов (cache.h) в
+ * байтах, если он не задан при открытии
+ */
+#define MATRIX_CACHE_LIMIT (1ULL << 30)
+
 #endif   // CONFIG_H
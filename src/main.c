@@ -1,111 +1,432 @@
 /**
  * @file main.c
- * @brief 
+ * @brief
  *
  * @details
  * Программа вычисляет выражение выражение A × B + C - D^T.
  *
  * Алгоритм программы:
- * 1.Загрузка матриц A, B, C, D из файлов
- * 2.Умножение A на B
- * 3.Сложение с матрицей C
- * 4.Транспонирование матрицы D
- * 5.Вычитание матрицы D^T
- * 6.Сохранение результата
+ * 1.Запуск фоновой загрузки матриц A, B, C, D (loader.h): все четыре
+ *   файла читаются одновременно
+ * 2.Ожидание A и B
+ * 3.Если C и D к этому моменту тоже загружены - вычисление
+ *   A × B + C - D^T за один проход: C и D^T применяются к каждой плитке
+ *   произведения, промежуточные матрицы не создаются. Иначе сначала
+ *   считается A × B, а C и D догружаются во время умножения, после чего
+ *   C прибавляется и D^T вычитается на месте за один проход плитками,
+ *   без матрицы D^T
+ * 4.Сохранение результата
+ *
+ * Если A или B разрежена (доля ненулевых элементов не больше
+ * SPARSE_DENSITY_THRESHOLD), произведение считается через формат CSR
+ * (sparse.h), после чего так же прибавляется C и вычитается D^T.
+ *
+ * С флагом --step-by-step выражение всегда вычисляется по шагам:
+ * умножение, сложение, транспонирование, вычитание (сложение и вычитание -
+ * на месте в матрице произведения). Результаты обоих путей совпадают
+ * побитово, флаг нужен для их сверки.
+ *
+ * С флагом --batch MANIFEST программа вместо A × B + C - D^T выполняет
+ * пакет заданий из манифеста (jobs.h): каждое задание вычисляет свое
+ * выражение над своими файлами, общие файлы загружаются один раз, задания
+ * идут параллельно на пуле потоков. После пакета печатается время каждого
+ * задания и сводка; код возврата ненулевой, если хотя бы одно задание не
+ * выполнено.
+ *
+ * С флагом --cache DIR результаты хранятся в кэше на диске (cache.h):
+ * ключ - хеш выражения и содержимого всех четырех входов, поэтому перед
+ * вычислением программа дожидается C и D. Если результат уже есть в
+ * кэше, он загружается вместо вычисления, иначе вычисляется и
+ * сохраняется. Флаг --cache-limit MB задает предел размера кэша (по
+ * умолчанию MATRIX_CACHE_LIMIT). Кэш работает и в пакетном режиме: для
+ * каждого задания ключ строится по его выражению и входам. В конце
+ * печатаются попадания и промахи.
+ *
+ * С флагом --convert SRC DST программа только преобразует файл матрицы SRC
+ * из текстового формата в двоичный или обратно (формат SRC определяется
+ * по сигнатуре) и завершается.
+ *
+ * С флагом --lossless результат сохраняется кратчайшей записью, которая
+ * читается обратно в те же числа, а не с двумя знаками после точки.
+ *
+ * С флагом --metrics FILE при завершении в FILE записываются время,
+ * байты и выделения памяти по операциям в JSON (см. metrics.h; замеры
+ * собираются только при сборке с make METRICS=1).
+ *
+ * С флагом --type f32|i32 матрицы после загрузки преобразуются к float
+ * или int32_t (convert_matrix_type), и выражение вычисляется ядрами этого
+ * типа; по умолчанию - f64. Разреженный путь используется только для f64.
  *
  * @return 1 при успешном выполнении, 0 при ошибке
  *
  * @note Для работы требуются файлы в папке data/
  *
- * @see matrix.h output.h
+ * @see matrix.h loader.h jobs.h cache.h sparse.h output.h
  */
 
+#include "matrix/cache.h"
+#include "matrix/jobs.h"
+#include "matrix/loader.h"
 #include "matrix/matrix.h"
+#include "matrix/sparse.h"
+#include "metrics/metrics.h"
 #include "output/output.h"
 
+#include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-int main () {
-    int res = 1;   //Флаг для проверки выполнения операции
+/** Флаг пошагового вычисления */
+#define STEP_BY_STEP_FLAG "--step-by-step"
+
+/** Флаг преобразования файла матрицы */
+#define CONVERT_FLAG "--convert"
+
+/** Флаг сохранения результата без потерь */
+#define LOSSLESS_FLAG "--lossless"
+
+/** Флаг записи метрик операций при завершении */
+#define METRICS_FLAG "--metrics"
+
+/** Флаг типа элементов, в котором вычисляется выражение */
+#define TYPE_FLAG "--type"
 
-    Matrix A = load_matrix_from_file ("input_matrices/matrix_a.txt");
-    Matrix B = load_matrix_from_file ("input_matrices/matrix_b.txt");
-    Matrix C = load_matrix_from_file ("input_matrices/matrix_c.txt");
-    Matrix D = load_matrix_from_file ("input_matrices/matrix_d.txt");
+/** Флаг пакетного режима с манифестом заданий */
+#define BATCH_FLAG "--batch"
 
-    if (!A.data || !B.data || !C.data || !D.data) {
-        res = 0;
-        fprintf (stderr, "Ошибка загрузки матриц.\n");
+/** Флаг каталога кэша результатов */
+#define CACHE_FLAG "--cache"
+
+/** Флаг предела размера кэша в мегабайтах */
+#define CACHE_LIMIT_FLAG "--cache-limit"
+
+/** Запись выражения в ключе кэша */
+#define EXPRESSION "A*B+C-D^T"
+
+/** Количество входных матриц */
+#define INPUT_COUNT 4
+
+/** Файлы входных матриц A, B, C и D */
+static const char* const input_files[INPUT_COUNT] = {
+    "input_matrices/matrix_a.txt", "input_matrices/matrix_b.txt",
+    "input_matrices/matrix_c.txt", "input_matrices/matrix_d.txt"};
+
+/**
+ * @brief Дожидается фоновой загрузки входной матрицы
+ *
+ * Если матрица уже получена, возвращает 0 без ожидания.
+ *
+ * @param load Описание загрузки
+ * @param matrix Загруженная матрица; при ошибке нулевая
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int await_matrix (MatrixLoad* load, Matrix* matrix) {
+    int res = 0;
+
+    if (!matrix_valid (matrix)) *matrix = matrix_load_wait (load);
+    if (!matrix_valid (matrix)) {
+        res = -1;
+        fprintf (stderr, "Ошибка загрузки матрицы %s.\n", load->filename);
     }
 
-    Matrix AB = {0};
-    if (res) {
-        AB = create_matrix (A.rows, B.cols);
-        if (!AB.data) {
-            res = 0;
-            fprintf (stderr, "Ошибка создания матрицы AB.\n");
+    return res;
+}
+
+/**
+ * @brief Вычисляет A × B + C - D^T за один проход
+ *
+ * @param A Первая матрица
+ * @param B Вторая матрица
+ * @param C Прибавляемая матрица
+ * @param D Матрица, транспонированная которой вычитается
+ * @return Результат или нулевая матрица при ошибке
+ */
+static Matrix evaluate_fused (const Matrix* A, const Matrix* B, const Matrix* C,
+                              const Matrix* D) {
+    Matrix result = create_matrix_typed (A->rows, B->cols, A->type);
+
+    if (!matrix_valid (&result)) {
+        fprintf (stderr, "Ошибка создания финальной матрицы.\n");
+    } else if (multiply_add_subtract_transposed (A, B, C, D, &result) != 0) {
+        fprintf (stderr, "Ошибка вычисления выражения.\n");
+        free_matrix (&result);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Вычисляет A × B с разреженным множителем
+ *
+ * Произведение считается через CSR: обе матрицы разрежены - sparse_multiply,
+ * иначе умножение разреженной матрицы на плотную или наоборот.
+ *
+ * @param A Первая матрица
+ * @param B Вторая матрица
+ * @param A_sparse A в формате CSR или NULL, если A плотная
+ * @param B_sparse B в формате CSR или NULL, если B плотная
+ * @return Произведение или нулевая матрица при ошибке
+ */
+static Matrix evaluate_sparse_product (const Matrix* A, const Matrix* B,
+                                       const SparseMatrix* A_sparse,
+                                       const SparseMatrix* B_sparse) {
+    Matrix result = {0};
+
+    if (A_sparse && B_sparse) {
+        SparseMatrix AB = sparse_multiply (A_sparse, B_sparse);
+        result          = sparse_to_dense (&AB);
+        sparse_free (&AB);
+    } else {
+        result = create_matrix (A->rows, B->cols);
+        if (result.data) {
+            int status = A_sparse ? sparse_multiply_dense (A_sparse, B, &result)
+                                  : dense_multiply_sparse (A, B_sparse, &result);
+            if (status != 0) free_matrix (&result);
         }
     }
+    if (!result.data) fprintf (stderr, "Ошибка умножения разреженных матриц.\n");
+
+    return result;
+}
+
+/**
+ * @brief Вычисляет A × B - первый шаг пошагового вычисления
+ *
+ * @param A Первая матрица
+ * @param B Вторая матрица
+ * @return Произведение или нулевая матрица при ошибке
+ */
+static Matrix evaluate_product (const Matrix* A, const Matrix* B) {
+    Matrix result = create_matrix_typed (A->rows, B->cols, A->type);
 
     //1 действие
-    if (res) {
-        if (multiply_matrices (&A, &B, &AB) != 0) {
-            res = 0;
-            fprintf (stderr, "Ошибка умножения матриц.\n");
-        }
+    if (!matrix_valid (&result)) {
+        fprintf (stderr, "Ошибка создания матрицы AB.\n");
+    } else if (multiply_matrices (A, B, &result) != 0) {
+        fprintf (stderr, "Ошибка умножения матриц.\n");
+        free_matrix (&result);
     }
 
-    // 2 действие
-    Matrix AB_plus_C = {0};
-    if (res) {
-        AB_plus_C = create_matrix (AB.rows, AB.cols);
-        if (!AB_plus_C.data) {
+    return result;
+}
+
+/**
+ * @brief Прибавляет C и вычитает D^T на месте в матрице произведения
+ *
+ * Обычно C и D^T применяются за один проход плитками
+ * (add_subtract_transposed), D^T не создается. Пошагово выполняются
+ * отдельные сложение, транспонирование и вычитание; результат тот же
+ * побитово.
+ *
+ * @param result Произведение A × B; при ошибке освобождается
+ * @param C Прибавляемая матрица
+ * @param D Матрица, транспонированная которой вычитается
+ * @param step_by_step Флаг пошагового вычисления
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int evaluate_addends (Matrix* result, const Matrix* C, const Matrix* D,
+                             int step_by_step) {
+    int res = 1;   //Флаг для проверки выполнения операции
+
+    // 2-4 действия за один проход
+    if (!step_by_step) {
+        if (add_subtract_transposed (C, D, result) != 0) {
             res = 0;
-            fprintf (stderr, "Ошибка создания матрицы AB_plus_C.\n");
+            fprintf (stderr, "Ошибка сложения с C и вычитания D^T.\n");
         }
     }
 
-    if (res) {
-        if (add_matrices (&AB, &C, &AB_plus_C) != 0) {
+    // 2 действие
+    if (res && step_by_step) {
+        if (add_matrices (result, C, result) != 0) {
             res = 0;
             fprintf (stderr, "Ошибка сложения матриц.\n");
         }
     }
-    
+
     //3 действие
     Matrix D_transpose = {0};
-    if (res) {
-        D_transpose = transpose_matrix (&D);
-        if (!D_transpose.data) {
+    if (res && step_by_step) {
+        D_transpose = transpose_matrix (D);
+        if (!matrix_valid (&D_transpose)) {
             res = 0;
             fprintf (stderr, "Ошибка транспонирования D.\n");
         }
     }
 
     // 4 действие
-    Matrix result = {0};
-    if (res) {
-        result = create_matrix (AB_plus_C.rows, AB_plus_C.cols);
-        if (!result.data) {
+    if (res && step_by_step) {
+        if (subtract_matrices (result, &D_transpose, result) != 0) {
+            res = 0;
+            fprintf (stderr, "Ошибка вычитания матриц.\n");
+        }
+    }
+
+    if (!res) free_matrix (result);
+    free_matrix (&D_transpose);
+
+    return res ? 0 : -1;
+}
+
+int main (int argc, char* argv[]) {
+    int               res          = 1;   //Флаг для проверки выполнения операции
+    int               step_by_step = 0;   //Флаг пошагового вычисления
+    int               precision    = OUTPUT_DEFAULT_PRECISION;   //Точность вывода
+    const char*       convert_src  = NULL;   //Файлы для преобразования формата
+    const char*       convert_dst  = NULL;
+    const char*       manifest     = NULL;   //Манифест пакетного режима
+    const char*       cache_dir    = NULL;   //Каталог кэша результатов
+    uint64_t          cache_limit  = 0;      //Предел кэша, 0 - по умолчанию
+    MatrixElementType type         = MATRIX_F64;   //Тип элементов вычисления
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp (argv[i], STEP_BY_STEP_FLAG) == 0) step_by_step = 1;
+        else if (strcmp (argv[i], LOSSLESS_FLAG) == 0)
+            precision = OUTPUT_PRECISION_LOSSLESS;
+        else if (strcmp (argv[i], METRICS_FLAG) == 0 && i + 1 < argc) {
+            if (metrics_dump_at_exit (argv[++i]) != 0) res = 0;
+        } else if (strcmp (argv[i], TYPE_FLAG) == 0 && i + 1 < argc) {
+            if (matrix_type_from_name (argv[++i], &type) != 0) {
+                res = 0;
+                fprintf (stderr, "Неизвестный тип элементов: %s\n", argv[i]);
+            }
+        } else if (strcmp (argv[i], CACHE_FLAG) == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (strcmp (argv[i], CACHE_LIMIT_FLAG) == 0 && i + 1 < argc) {
+            char* end = NULL;   // Первый неразобранный символ
+            errno     = 0;
+            const long megabytes = strtol (argv[++i], &end, 10);
+            // Число целиком, без мусора в хвосте и переполнения при сдвиге
+            if (end == argv[i] || *end != '\0' || errno != 0 || megabytes <= 0 ||
+                (unsigned long) megabytes > UINT64_MAX >> 20) {
+                res = 0;
+                fprintf (stderr, "Неверный предел кэша: %s\n", argv[i]);
+            } else {
+                cache_limit = (uint64_t) megabytes << 20;
+            }
+        } else if (strcmp (argv[i], BATCH_FLAG) == 0 && i + 1 < argc) {
+            manifest = argv[++i];
+        } else if (strcmp (argv[i], CONVERT_FLAG) == 0 && i + 2 < argc) {
+            convert_src = argv[++i];
+            convert_dst = argv[++i];
+        } else {
             res = 0;
-            fprintf (stderr, "Ошибка создания финальной матрицы.\n");
+            fprintf (stderr, "Неизвестный аргумент: %s\n", argv[i]);
         }
     }
 
-    if (res) {
-        if (subtract_matrices (&AB_plus_C, &D_transpose, &result) != 0) {
+    if (res && convert_src) {
+        if (convert_matrix_file (convert_src, convert_dst) != 0) {
             res = 0;
-            fprintf (stderr, "Ошибка вычитания матриц.\n");
+            fprintf (stderr, "Ошибка преобразования файла %s.\n", convert_src);
+        } else {
+            printf ("Файл %s преобразован в %s\n", convert_src, convert_dst);
+        }
+    }
+
+    //Кэш результатов; без него все вычисляется заново
+    MatrixCache* cache = NULL;
+    if (res && cache_dir && !convert_src) {
+        cache = matrix_cache_open (cache_dir, cache_limit);
+        if (!cache) {
+            res = 0;
+            fprintf (stderr, "Ошибка открытия кэша %s.\n", cache_dir);
         }
     }
 
+    //Пакетный режим: выражения заданий вычисляются только в f64 (expr.h)
+    if (res && manifest && !convert_src) {
+        JobManifest jobs = {0};
+        if (type != MATRIX_F64) {
+            res = 0;
+            fprintf (stderr, "Пакетный режим поддерживает только тип f64.\n");
+        } else if (jobs_load_manifest (manifest, &jobs) != 0) {
+            res = 0;
+        } else {
+            if (jobs_run (&jobs, precision, cache) != 0) res = 0;
+            jobs_report (&jobs, stdout);
+        }
+        jobs_free (&jobs);
+    }
+
+    //Вычисление A × B + C - D^T из файлов input_matrices/
+    const int evaluate = !convert_src && !manifest;
+
+    //Все четыре файла загружаются одновременно, вычисление ждет только A и B
+    MatrixLoad loads[INPUT_COUNT] = {0};
+    Matrix     A = {0}, B = {0}, C = {0}, D = {0};
+    if (res && evaluate) {
+        for (int i = 0; i < INPUT_COUNT; i++) {
+            matrix_load_start (&loads[i], input_files[i], type);
+        }
+        if (await_matrix (&loads[0], &A) != 0 || await_matrix (&loads[1], &B) != 0)
+            res = 0;
+    }
+
+    //С кэшем ключ зависит от всех входов: дожидаемся C и D и ищем результат
+    Matrix   result = {0};
+    uint64_t key    = 0;
+    int      cached = 0;   //Результат взят из кэша
+    if (res && evaluate && cache) {
+        if (await_matrix (&loads[2], &C) != 0 || await_matrix (&loads[3], &D) != 0) {
+            res = 0;
+        } else {
+            const Matrix* inputs[INPUT_COUNT] = {&A, &B, &C, &D};
+            uint64_t      hashes[INPUT_COUNT];
+            for (int i = 0; i < INPUT_COUNT; i++) {
+                hashes[i] = matrix_hash (inputs[i]);
+            }
+            key    = matrix_cache_key (EXPRESSION, hashes, INPUT_COUNT);
+            cached = matrix_cache_lookup (cache, key, &result);
+            if (cached) printf ("Результат взят из кэша %s\n", cache_dir);
+        }
+    }
+
+    //Разреженные множители (нулевая структура - матрица плотная)
+    SparseMatrix A_sparse = {0}, B_sparse = {0};
+    if (res && evaluate && !cached && !step_by_step && type == MATRIX_F64) {
+        A_sparse = sparse_from_dense (&A, SPARSE_DENSITY_THRESHOLD);
+        B_sparse = sparse_from_dense (&B, SPARSE_DENSITY_THRESHOLD);
+    }
+
+    //Слитое вычисление, только если C и D уже загружены, иначе они
+    //догружаются во время умножения
+    if (res && evaluate && !cached) {
+        const int sparse = A_sparse.row_ptr || B_sparse.row_ptr;
+        if (!step_by_step && !sparse && matrix_load_ready (&loads[2]) &&
+            matrix_load_ready (&loads[3])) {
+            if (await_matrix (&loads[2], &C) == 0 &&
+                await_matrix (&loads[3], &D) == 0)
+                result = evaluate_fused (&A, &B, &C, &D);
+        } else {
+            if (sparse) {
+                printf ("Умножение через разреженный формат CSR\n");
+                result = evaluate_sparse_product (
+                    &A, &B, A_sparse.row_ptr ? &A_sparse : NULL,
+                    B_sparse.row_ptr ? &B_sparse : NULL);
+            } else {
+                result = evaluate_product (&A, &B);
+            }
+            if (matrix_valid (&result) &&
+                (await_matrix (&loads[2], &C) != 0 ||
+                 await_matrix (&loads[3], &D) != 0 ||
+                 evaluate_addends (&result, &C, &D, step_by_step) != 0))
+                free_matrix (&result);
+        }
+        if (!matrix_valid (&result)) res = 0;
+        else if (cache && matrix_cache_store (cache, key, &result) != 0)
+            fprintf (stderr, "Ошибка записи результата в кэш %s.\n", cache_dir);
+    }
+
     //Вывод
-    if (res) {
+    if (res && evaluate) {
         printf ("Результат выражения A × B + C - D^T:\n");
         print_matrix (&result);
 
-        if (save_matrix_to_file (&result, "input_matrices/result.txt") != 0) {
+        if (save_matrix_to_file_precision (&result, "input_matrices/result.txt",
+                                           precision) != 0) {
             res = 0;
             fprintf (stderr, "Ошибка сохранения результата.\n");
         } else {
@@ -113,15 +434,28 @@ int main () {
         }
     }
 
-    //Освобождаем память
+    if (cache) {
+        const MatrixCacheStats stats = matrix_cache_stats (cache);
+        printf ("Кэш: попаданий %" PRIu64 ", промахов %" PRIu64 ", записей %" PRIu64
+                " (%.1f МБ), вытеснено %" PRIu64 "\n",
+                stats.hits, stats.misses, stats.entries,
+                (double) stats.bytes / (1 << 20), stats.evictions);
+    }
+
+    //Освобождаем память (загрузки, результат которых не понадобился, тоже
+    //нужно дождаться)
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        Matrix unused = matrix_load_wait (&loads[i]);
+        free_matrix (&unused);
+    }
     free_matrix (&A);
     free_matrix (&B);
     free_matrix (&C);
     free_matrix (&D);
-    free_matrix (&D_transpose);
-    free_matrix (&AB);
-    free_matrix (&AB_plus_C);
+    sparse_free (&A_sparse);
+    sparse_free (&B_sparse);
     free_matrix (&result);
+    matrix_cache_close (cache);
 
     return res ? 0 : 1;
 }
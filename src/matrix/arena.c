@@ -0,0 +1,219 @@
+/**
+ * @file arena.c
+ * @brief Реализация рабочей области (арены)
+ *
+ * @details
+ * Куски образуют односвязный список в порядке выделения. Блок, который
+ * не помещается в остаток текущего куска, берется из следующего
+ * подходящего куска списка; если такого нет, в конец списка добавляется
+ * новый кусок. arena_reset лишь переносит позицию назад, куски остаются в
+ * списке и используются следующими вычислениями.
+ *
+ * @see arena.h
+ */
+
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @struct ArenaChunk
+ * @brief Заголовок куска; данные начинаются через MATRIX_ALIGNMENT байт
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;   ///< Следующий кусок
+    size_t             size;   ///< Размер данных в байтах
+} ArenaChunk;
+
+/**
+ * @struct MatrixArena
+ * @brief Список кусков и текущая позиция
+ */
+struct MatrixArena {
+    ArenaChunk* first;         ///< Первый кусок
+    ArenaChunk* last;          ///< Последний кусок
+    ArenaChunk* current;       ///< Кусок, из которого идет выделение
+    size_t      used;          ///< Занято в текущем куске
+    size_t      live;          ///< Занято выделенными блоками
+    size_t      high_water;    ///< Наибольшее значение live
+    size_t      chunk_size;    ///< Наименьший размер нового куска
+    size_t      capacity;      ///< Суммарный размер кусков
+    size_t      allocations;   ///< Число выделенных кусков
+};
+
+/** Смещение данных куска от его начала */
+#define ARENA_HEADER MATRIX_ALIGNMENT
+
+/**
+ * @brief Выделяет кусок и добавляет его в конец списка
+ *
+ * @param arena Арена
+ * @param size Размер данных в байтах
+ * @return Кусок или NULL при ошибке выделения памяти
+ */
+static ArenaChunk* arena_grow (MatrixArena* arena, size_t size) {
+    void*       memory = NULL;
+    ArenaChunk* chunk  = NULL;
+
+    if (size <= SIZE_MAX - ARENA_HEADER &&
+        posix_memalign (&memory, MATRIX_ALIGNMENT, ARENA_HEADER + size) == 0) {
+        chunk       = memory;
+        chunk->next = NULL;
+        chunk->size = size;
+        if (arena->last) arena->last->next = chunk;
+        else arena->first = chunk;
+        arena->last = chunk;
+        arena->capacity += size;
+        arena->allocations++;
+    }
+
+    return chunk;
+}
+
+/**
+ * @brief Создает арену
+ *
+ * @param capacity Размер первого куска или 0 для ARENA_CHUNK_SIZE
+ *
+ * @return Арена или NULL при ошибке
+ */
+MatrixArena* arena_create (size_t capacity) {
+    MatrixArena* arena = calloc (1, sizeof (MatrixArena));
+
+    if (arena != NULL) {
+        arena->chunk_size = capacity > 0 ? capacity : ARENA_CHUNK_SIZE;
+        if (arena_grow (arena, arena->chunk_size) == NULL) {
+            free (arena);
+            arena = NULL;
+        }
+    }
+
+    return arena;
+}
+
+/**
+ * @brief Освобождает арену и все её куски
+ *
+ * @param arena Арена или NULL
+ */
+void arena_destroy (MatrixArena* arena) {
+    if (arena != NULL) {
+        ArenaChunk* chunk = arena->first;
+        while (chunk != NULL) {
+            ArenaChunk* next = chunk->next;
+            free (chunk);
+            chunk = next;
+        }
+        free (arena);
+    }
+}
+
+/**
+ * @brief Выделяет блок сдвигом позиции
+ *
+ * Размер округляется вверх до MATRIX_ALIGNMENT, поэтому каждый следующий
+ * блок тоже выровнен.
+ *
+ * @param arena Арена
+ * @param bytes Размер в байтах
+ *
+ * @return Выровненный блок или NULL при ошибке
+ */
+void* arena_alloc (MatrixArena* arena, size_t bytes) {
+    void*  block = NULL;
+    size_t size  = 0;   // Размер, округленный до выравнивания
+
+    if (arena != NULL && bytes <= SIZE_MAX - MATRIX_ALIGNMENT) {
+        size = (bytes + MATRIX_ALIGNMENT - 1) & ~(size_t) (MATRIX_ALIGNMENT - 1);
+
+        ArenaChunk* chunk = arena->current ? arena->current : arena->first;
+        size_t      used  = arena->current ? arena->used : 0;
+
+        // Остаток текущего куска, затем следующие куски, затем новый
+        while (chunk != NULL && chunk->size - used < size) {
+            chunk = chunk->next;
+            used  = 0;
+        }
+        if (chunk == NULL) {
+            chunk = arena_grow (arena,
+                                size > arena->chunk_size ? size : arena->chunk_size);
+        }
+
+        if (chunk != NULL) {
+            block          = (char*) chunk + ARENA_HEADER + used;
+            arena->current = chunk;
+            arena->used    = used + size;
+            arena->live += size;
+            if (arena->live > arena->high_water) arena->high_water = arena->live;
+        }
+    }
+
+    return block;
+}
+
+/**
+ * @brief Запоминает текущую позицию арены
+ *
+ * @param arena Арена
+ *
+ * @return Позиция
+ */
+ArenaMark arena_mark (const MatrixArena* arena) {
+    ArenaMark mark = {NULL, 0, 0};
+
+    if (arena != NULL) {
+        mark.chunk = arena->current;
+        mark.used  = arena->used;
+        mark.live  = arena->live;
+    }
+
+    return mark;
+}
+
+/**
+ * @brief Возвращает арену к позиции
+ *
+ * @param arena Арена
+ * @param mark Позиция из arena_mark
+ */
+void arena_reset (MatrixArena* arena, ArenaMark mark) {
+    if (arena != NULL) {
+        arena->current = mark.chunk;
+        arena->used    = mark.used;
+        arena->live    = mark.live;
+    }
+}
+
+/**
+ * @brief Наибольший объем, занятый ареной одновременно
+ *
+ * @param arena Арена
+ *
+ * @return Размер в байтах
+ */
+size_t arena_high_water (const MatrixArena* arena) {
+    return arena ? arena->high_water : 0;
+}
+
+/**
+ * @brief Суммарный размер кусков арены
+ *
+ * @param arena Арена
+ *
+ * @return Размер в байтах
+ */
+size_t arena_capacity (const MatrixArena* arena) {
+    return arena ? arena->capacity : 0;
+}
+
+/**
+ * @brief Число выделенных кусков
+ *
+ * @param arena Арена
+ *
+ * @return Число обращений к куче
+ */
+size_t arena_heap_allocations (const MatrixArena* arena) {
+    return arena ? arena->allocations : 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file arena.h
+ * @brief Рабочая область (арена) для временных буферов
+ *
+ * @details
+ * Арена выделяет память сдвигом указателя внутри заранее выделенных
+ * кусков, каждый блок выровнен по MATRIX_ALIGNMENT. Память отдельных
+ * блоков не освобождается: arena_mark запоминает позицию, arena_reset
+ * возвращает к ней всё, что выделено позже. Куски при этом остаются у
+ * арены, поэтому повторное вычисление той же формы после первого
+ * (прогрева) не обращается к куче.
+ *
+ * Функции, принимающие арену (gemm_multiply_arena, multiply_matrices_arena,
+ * determinant_arena и другие), берут из неё буферы упаковки и рабочие
+ * копии и возвращают позицию арены перед выходом. Вместо арены можно
+ * передать NULL - тогда буферы выделяются в куче, как раньше.
+ *
+ * Арена не потокобезопасна: выделять из неё должен один поток.
+ *
+ * @see matrix.h gemm.h
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "../../include/config.h"
+
+#include <stddef.h>
+
+/** Непрозрачная арена */
+typedef struct MatrixArena MatrixArena;
+
+/**
+ * @struct ArenaMark
+ * @brief Позиция арены, к которой возвращает arena_reset
+ */
+typedef struct {
+    void*  chunk;   ///< Текущий кусок (внутреннее поле)
+    size_t used;    ///< Занято в текущем куске
+    size_t live;    ///< Занято во всех кусках
+} ArenaMark;
+
+/**
+ * @brief Создает арену
+ * @param capacity Размер первого куска в байтах или 0 для ARENA_CHUNK_SIZE
+ * @note Следующие куски выделяются по мере нужды размером не меньше первого
+ * @return Арена или NULL при ошибке выделения памяти
+ */
+MatrixArena* arena_create (size_t capacity);
+
+/**
+ * @brief Освобождает арену и все её куски
+ * @param arena Арена или NULL
+ */
+void arena_destroy (MatrixArena* arena);
+
+/**
+ * @brief Выделяет выровненный блок
+ * @param arena Арена
+ * @param bytes Размер в байтах
+ * @return Блок, выровненный по MATRIX_ALIGNMENT, или NULL при ошибке
+ */
+void* arena_alloc (MatrixArena* arena, size_t bytes);
+
+/**
+ * @brief Запоминает текущую позицию арены
+ * @param arena Арена
+ * @return Позиция для arena_reset
+ */
+ArenaMark arena_mark (const MatrixArena* arena);
+
+/**
+ * @brief Возвращает арену к позиции, освобождая всё выделенное после неё
+ * @param arena Арена
+ * @param mark Позиция из arena_mark; нулевая позиция очищает арену целиком
+ */
+void arena_reset (MatrixArena* arena, ArenaMark mark);
+
+/**
+ * @brief Наибольший объем, занятый ареной одновременно
+ * @param arena Арена
+ * @return Размер в байтах с учетом выравнивания
+ */
+size_t arena_high_water (const MatrixArena* arena);
+
+/**
+ * @brief Суммарный размер кусков арены
+ * @param arena Арена
+ * @return Размер в байтах
+ */
+size_t arena_capacity (const MatrixArena* arena);
+
+/**
+ * @brief Число обращений арены к куче за время её жизни
+ * @param arena Арена
+ * @note Не растет, пока вычисления помещаются в уже выделенные куски
+ * @return Число выделенных кусков
+ */
+size_t arena_heap_allocations (const MatrixArena* arena);
+
+#endif   // ARENA_H
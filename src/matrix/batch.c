@@ -0,0 +1,558 @@
+/**
+ * @file batch.c
+ * @brief Реализация пакетных операций над малыми матрицами
+ *
+ * @details
+ * Пакет делится на отрезки по BATCH_CHUNK матриц. Для отрезка
+ * произведение считается как для одной матрицы, только каждый элемент -
+ * это отрезок из len чисел; ядро batch_gemm держит накопители нескольких
+ * элементов C в регистрах и записывает каждый отрезок C один раз. Отрезки
+ * всех операндов отрезка вместе помещаются в L2. Ядро обрабатывает длину,
+ * кратную SIMD_BATCH_LANES: хвост последнего отрезка дополняется нулевыми
+ * матрицами, которые есть в пакете благодаря выравниванию lanes.
+ *
+ * Детерминант считается в рабочей копии отрезка (у каждого потока своя).
+ * Главный элемент и перестановка строк выбираются для каждой матрицы
+ * отдельно за O(n) на столбец, а исключение под главным элементом
+ * (O(n^3)) выполняет ядро mul_sub для всех матриц отрезка. Нулевой
+ * главный элемент обнуляет детерминант и множители исключения, так что
+ * вырожденные матрицы не мешают остальным.
+ *
+ * @see batch.h
+ */
+
+#include "batch.h"
+
+#include "../parallel/thread_pool.h"
+#include "simd.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Выравнивание lanes в элементах: отрезок элемента занимает целые кэш-линии */
+#define BATCH_LANE_ALIGN (MATRIX_ALIGNMENT / (int) sizeof (MATRIX_TYPE))
+
+_Static_assert (BATCH_CHUNK % BATCH_LANE_ALIGN == 0,
+                "BATCH_CHUNK должен быть кратен выравниванию отрезков");
+_Static_assert (BATCH_LANE_ALIGN % SIMD_BATCH_LANES == 0,
+                "Выравнивание отрезков должно покрывать хвост ядра batch_gemm");
+
+/**
+ * @struct BatchTask
+ * @brief Аргументы пакетной операции для задач пула
+ */
+typedef struct BatchTask {
+    const MatrixBatch* A;        ///< Первый операнд
+    const MatrixBatch* B;        ///< Второй операнд или NULL
+    const MatrixBatch* C;        ///< Прибавляемый пакет или NULL
+    const MatrixBatch* D;        ///< Пакет, транспонированный которого вычитается
+    MatrixBatch*       result;   ///< Результат или NULL
+    MATRIX_TYPE*       det;      ///< Детерминанты или NULL
+    MATRIX_TYPE*       work;     ///< Рабочие копии потоков или NULL
+    simd_binary_fn     binary;   ///< Поэлементное ядро (сложение, вычитание)
+    /** Обрабатывает отрезок матриц first .. first + len - 1 */
+    void (*chunk_fn) (const struct BatchTask* task, int first, int len, int worker);
+} BatchTask;
+
+/**
+ * @brief Начало отрезка элемента (i, j) в пакете
+ *
+ * @param batch Пакет
+ * @param row Номер строки
+ * @param col Номер столбца
+ * @param first Номер первой матрицы отрезка
+ *
+ * @return Указатель на элемент матрицы first
+ */
+static inline MATRIX_TYPE* batch_lane (const MatrixBatch* batch, int row, int col,
+                                       int first) {
+    return batch->data + ((size_t) row * batch->cols + col) * batch->lanes + first;
+}
+
+/**
+ * @brief Проверяет пакет
+ *
+ * @param batch Пакет
+ *
+ * @return 1, если пакет создан
+ */
+static int batch_valid (const MatrixBatch* batch) {
+    return batch != NULL && batch->data != NULL && batch->count > 0;
+}
+
+/**
+ * @brief Проверяет, что пакеты одной формы
+ *
+ * @param a Первый пакет
+ * @param b Второй пакет
+ *
+ * @return 1, если оба пакета созданы и совпадают по форме
+ */
+static int batch_same_shape (const MatrixBatch* a, const MatrixBatch* b) {
+    return batch_valid (a) && batch_valid (b) && a->count == b->count &&
+           a->rows == b->rows && a->cols == b->cols;
+}
+
+/**
+ * @brief Создает пакет нулевых матриц
+ *
+ * @param count Количество матриц
+ * @param rows Строк в каждой матрице
+ * @param cols Столбцов в каждой матрице
+ *
+ * @return Пакет или нулевая структура при ошибке
+ */
+MatrixBatch batch_create (int count, int rows, int cols) {
+    MatrixBatch batch = {0, 0, 0, 0, NULL};
+    void*       block = NULL;
+    size_t      elements = 0;   // rows * cols * lanes
+    int         lanes    = 0;
+    char        res      = 1;   // Флаг успешности выполнения
+
+    // Шаг отрезков - как у строк матрицы, с защитой от совпадения наборов кэша
+    if (count > 0) lanes = matrix_leading_dimension (count, sizeof (MATRIX_TYPE));
+
+    if (lanes == 0 || rows <= 0 || cols <= 0) res = 0;
+    else {
+        if ((size_t) rows * cols > SIZE_MAX / sizeof (MATRIX_TYPE) / lanes) res = 0;
+        else {
+            elements = (size_t) rows * cols * lanes;
+            if (posix_memalign (&block, MATRIX_ALIGNMENT,
+                                elements * sizeof (MATRIX_TYPE)) != 0)
+                res = 0;   // Ошибка выделения памяти
+        }
+    }
+
+    if (res) {
+        batch.count = count;
+        batch.rows  = rows;
+        batch.cols  = cols;
+        batch.lanes = lanes;
+        batch.data  = block;
+        memset (batch.data, 0, elements * sizeof (MATRIX_TYPE));
+    }
+
+    return batch;
+}
+
+/**
+ * @brief Освобождает память пакета
+ *
+ * @param batch Пакет или NULL
+ */
+void batch_free (MatrixBatch* batch) {
+    if (batch != NULL && batch->data != NULL) {
+        free (batch->data);
+        batch->data  = NULL;
+        batch->count = 0;
+        batch->rows  = 0;
+        batch->cols  = 0;
+        batch->lanes = 0;
+    }
+}
+
+/**
+ * @brief Копирует матрицу в пакет
+ *
+ * @param batch Пакет
+ * @param index Номер матрицы в пакете
+ * @param matrix Матрица той же формы
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_set (MatrixBatch* batch, int index, const Matrix* matrix) {
+    int res = -1;
+
+    if (batch_valid (batch) && index >= 0 && index < batch->count &&
+        matrix != NULL && matrix->block != NULL && matrix->rows == batch->rows &&
+        matrix->cols == batch->cols) {
+        for (int i = 0; i < batch->rows; i++) {
+            for (int j = 0; j < batch->cols; j++) {
+                BATCH_AT (batch, index, i, j) = MATRIX_AT (matrix, i, j);
+            }
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Копирует матрицу из пакета
+ *
+ * @param batch Пакет
+ * @param index Номер матрицы в пакете
+ * @param matrix Матрица не меньше rows x cols
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_get (const MatrixBatch* batch, int index, Matrix* matrix) {
+    int res = -1;
+
+    if (batch_valid (batch) && index >= 0 && index < batch->count &&
+        matrix != NULL && matrix->block != NULL && matrix->rows >= batch->rows &&
+        matrix->cols >= batch->cols) {
+        for (int i = 0; i < batch->rows; i++) {
+            for (int j = 0; j < batch->cols; j++) {
+                MATRIX_AT (matrix, i, j) = BATCH_AT (batch, index, i, j);
+            }
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Задача пула: отрезок пакета
+ *
+ * @param arg Аргументы операции (BatchTask)
+ * @param task Номер отрезка
+ * @param worker Номер потока
+ */
+static void batch_task (void* arg, int task, int worker) {
+    const BatchTask* op    = arg;
+    const int        first = task * BATCH_CHUNK;
+    const int        count = op->A->count;
+    const int        len = (count - first < BATCH_CHUNK) ? count - first
+                                                         : BATCH_CHUNK;
+
+    op->chunk_fn (op, first, len, worker);
+}
+
+/**
+ * @brief Выполняет операцию по отрезкам, при большом объеме - на пуле
+ *
+ * @param task Аргументы операции
+ * @param threads Число потоков (1 - в вызывающем потоке)
+ */
+static void batch_run (BatchTask* task, int threads) {
+    const int chunks = (task->A->count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+
+    if (threads > 1 && chunks > 1) thread_pool_run (chunks, batch_task, task);
+    else {
+        for (int chunk = 0; chunk < chunks; chunk++) batch_task (task, chunk, 0);
+    }
+}
+
+/**
+ * @brief Число потоков для операции заданного объема
+ *
+ * @param work Число арифметических операций
+ *
+ * @return thread_pool_threads () для больших операций, иначе 1
+ */
+static int batch_threads (double work) {
+    return work >= (double) GEMM_PARALLEL_THRESHOLD ? thread_pool_threads () : 1;
+}
+
+/**
+ * @brief Поэлементная операция над отрезком
+ *
+ * @param task Аргументы операции
+ * @param first Первая матрица отрезка
+ * @param len Матриц в отрезке
+ * @param worker Номер потока
+ */
+static void batch_binary_chunk (const BatchTask* task, int first, int len,
+                                int worker) {
+    (void) worker;
+    for (int i = 0; i < task->A->rows; i++) {
+        for (int j = 0; j < task->A->cols; j++) {
+            task->binary (len, batch_lane (task->A, i, j, first),
+                          batch_lane (task->B, i, j, first),
+                          batch_lane (task->result, i, j, first));
+        }
+    }
+}
+
+/**
+ * @brief Поэлементная операция над пакетами
+ *
+ * @param A Первый пакет
+ * @param B Второй пакет
+ * @param result Результат
+ * @param binary Ядро
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int batch_binary (const MatrixBatch* A, const MatrixBatch* B,
+                         MatrixBatch* result, simd_binary_fn binary) {
+    int res = -1;
+
+    if (batch_same_shape (A, B) && batch_same_shape (A, result)) {
+        BatchTask task = {A, B, NULL, NULL, result, NULL, NULL, binary,
+                          batch_binary_chunk};
+        batch_run (&task, batch_threads ((double) A->count * A->rows * A->cols));
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Складывает пакеты поматрично
+ *
+ * @param A Первый пакет
+ * @param B Второй пакет
+ * @param result Результат
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_add (const MatrixBatch* A, const MatrixBatch* B, MatrixBatch* result) {
+    return batch_binary (A, B, result, simd_ops ()->add);
+}
+
+/**
+ * @brief Вычитает пакеты поматрично
+ *
+ * @param A Уменьшаемое
+ * @param B Вычитаемое
+ * @param result Результат
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_subtract (const MatrixBatch* A, const MatrixBatch* B,
+                    MatrixBatch* result) {
+    return batch_binary (A, B, result, simd_ops ()->sub);
+}
+
+/**
+ * @brief Произведение отрезка, при наличии C и D - с прибавлением C - D^T
+ *
+ * @param task Аргументы операции
+ * @param first Первая матрица отрезка
+ * @param len Матриц в отрезке
+ * @param worker Номер потока
+ */
+static void batch_multiply_chunk (const BatchTask* task, int first, int len,
+                                  int worker) {
+    const SimdOps* ops = simd_ops ();
+    const int      m = task->result->rows, n = task->result->cols;
+    // Хвост отрезка дополняется нулевыми матрицами выравнивания lanes
+    const int padded = (len + SIMD_BATCH_LANES - 1) / SIMD_BATCH_LANES *
+                       SIMD_BATCH_LANES;
+
+    (void) worker;
+    ops->batch_gemm (padded, m, n, task->A->cols, batch_lane (task->A, 0, 0, first),
+                     task->A->lanes, batch_lane (task->B, 0, 0, first),
+                     task->B->lanes, batch_lane (task->result, 0, 0, first),
+                     task->result->lanes);
+    if (task->C) {
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                MATRIX_TYPE* r = batch_lane (task->result, i, j, first);
+                ops->add (len, r, batch_lane (task->C, i, j, first), r);
+                ops->sub (len, r, batch_lane (task->D, j, i, first), r);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Проверяет формы операндов умножения
+ *
+ * @param A Пакет матриц m x k
+ * @param B Пакет матриц k x n
+ * @param result Пакет матриц m x n
+ *
+ * @return 1, если формы согласованы, а результат не совпадает с операндами
+ */
+static int batch_multiply_valid (const MatrixBatch* A, const MatrixBatch* B,
+                                 const MatrixBatch* result) {
+    return batch_valid (A) && batch_valid (B) && batch_valid (result) &&
+           A->count == B->count && A->count == result->count && A->cols == B->rows &&
+           result->rows == A->rows && result->cols == B->cols &&
+           result->data != A->data && result->data != B->data;
+}
+
+/**
+ * @brief Умножает пакеты поматрично
+ *
+ * @param A Пакет матриц m x k
+ * @param B Пакет матриц k x n
+ * @param result Пакет матриц m x n
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_multiply (const MatrixBatch* A, const MatrixBatch* B,
+                    MatrixBatch* result) {
+    int res = -1;
+
+    if (batch_multiply_valid (A, B, result)) {
+        BatchTask task = {A, B, NULL, NULL, result, NULL, NULL, NULL,
+                          batch_multiply_chunk};
+        batch_run (&task, batch_threads ((double) A->count * A->rows * A->cols *
+                                         B->cols));
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Вычисляет A x B + C - D^T для каждой матрицы пакетов
+ *
+ * @param A Пакет матриц m x k
+ * @param B Пакет матриц k x n
+ * @param C Пакет матриц m x n
+ * @param D Пакет матриц n x m
+ * @param result Пакет матриц m x n
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_multiply_add_subtract_transposed (const MatrixBatch* A,
+                                            const MatrixBatch* B,
+                                            const MatrixBatch* C,
+                                            const MatrixBatch* D,
+                                            MatrixBatch*       result) {
+    int res = -1;
+
+    if (batch_multiply_valid (A, B, result) && batch_same_shape (C, result) &&
+        batch_valid (D) && D->count == A->count && D->rows == result->cols &&
+        D->cols == result->rows && D->data != result->data) {
+        BatchTask task = {A,    B,    C,    D, result,
+                          NULL, NULL, NULL, batch_multiply_chunk};
+        batch_run (&task, batch_threads ((double) A->count * A->rows * A->cols *
+                                         B->cols));
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Транспонирование отрезка: отрезки элементов переставляются целиком
+ *
+ * @param task Аргументы операции
+ * @param first Первая матрица отрезка
+ * @param len Матриц в отрезке
+ * @param worker Номер потока
+ */
+static void batch_transpose_chunk (const BatchTask* task, int first, int len,
+                                   int worker) {
+    (void) worker;
+    for (int i = 0; i < task->A->rows; i++) {
+        for (int j = 0; j < task->A->cols; j++) {
+            memcpy (batch_lane (task->result, j, i, first),
+                    batch_lane (task->A, i, j, first),
+                    (size_t) len * sizeof (MATRIX_TYPE));
+        }
+    }
+}
+
+/**
+ * @brief Транспонирует пакет поматрично
+ *
+ * @param A Пакет матриц m x n
+ * @param result Пакет матриц n x m
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_transpose (const MatrixBatch* A, MatrixBatch* result) {
+    int res = -1;
+
+    if (batch_valid (A) && batch_valid (result) && A->count == result->count &&
+        A->rows == result->cols && A->cols == result->rows &&
+        A->data != result->data) {
+        BatchTask task = {A, NULL, NULL, NULL, result, NULL, NULL, NULL,
+                          batch_transpose_chunk};
+        batch_run (&task, batch_threads ((double) A->count * A->rows * A->cols));
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Детерминанты отрезка LU-разложением рабочей копии
+ *
+ * @param task Аргументы операции
+ * @param first Первая матрица отрезка
+ * @param len Матриц в отрезке
+ * @param worker Номер потока
+ */
+static void batch_determinant_chunk (const BatchTask* task, int first, int len,
+                                     int worker) {
+    const SimdOps* ops = simd_ops ();
+    const int      n   = task->A->rows;
+    MATRIX_TYPE*   det = task->det + first;
+    MATRIX_TYPE*   w   = task->work + (size_t) worker * n * n * BATCH_CHUNK;
+    MATRIX_TYPE    inv[BATCH_CHUNK];      // Обратные главные элементы
+    MATRIX_TYPE    factor[BATCH_CHUNK];   // Множители исключения строки
+
+    // Элемент (i, j) копии - отрезок w + (i * n + j) * BATCH_CHUNK
+#define W(i, j) (w + ((size_t) (i) * n + (j)) * BATCH_CHUNK)
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            memcpy (W (i, j), batch_lane (task->A, i, j, first),
+                    (size_t) len * sizeof (MATRIX_TYPE));
+        }
+    }
+    for (int l = 0; l < len; l++) det[l] = 1;
+
+    for (int k = 0; k < n; k++) {
+        // Главный элемент и перестановка строк - для каждой матрицы отдельно
+        for (int l = 0; l < len; l++) {
+            int         pivot = k;
+            MATRIX_TYPE best  = fabs (W (k, k)[l]);
+            for (int i = k + 1; i < n; i++) {
+                if (fabs (W (i, k)[l]) > best) {
+                    best  = fabs (W (i, k)[l]);
+                    pivot = i;
+                }
+            }
+            if (pivot != k) {
+                for (int j = k; j < n; j++) {
+                    MATRIX_TYPE t = W (k, j)[l];
+                    W (k, j)[l]   = W (pivot, j)[l];
+                    W (pivot, j)[l] = t;
+                }
+                det[l] = -det[l];
+            }
+            det[l] *= W (k, k)[l];
+            inv[l] = W (k, k)[l] != 0 ? 1 / W (k, k)[l] : 0;
+        }
+
+        // Исключение под главным элементом - ядром для всего отрезка
+        for (int i = k + 1; i < n; i++) {
+            for (int l = 0; l < len; l++) factor[l] = W (i, k)[l] * inv[l];
+            for (int j = k + 1; j < n; j++)
+                ops->mul_sub (len, factor, W (k, j), W (i, j));
+        }
+    }
+
+#undef W
+}
+
+/**
+ * @brief Вычисляет детерминанты матриц пакета
+ *
+ * @param A Пакет квадратных матриц
+ * @param det Массив из A->count детерминантов
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_determinant (const MatrixBatch* A, MATRIX_TYPE* det) {
+    int   res     = -1;
+    int   threads = 1;      // Потоков для этой операции
+    void* work    = NULL;   // Рабочие копии отрезков по одной на поток
+
+    if (batch_valid (A) && A->rows == A->cols && det != NULL) {
+        threads = batch_threads ((double) A->count * A->rows * A->rows * A->rows);
+        if (posix_memalign (&work, MATRIX_ALIGNMENT,
+                            (size_t) threads * A->rows * A->rows * BATCH_CHUNK *
+                                sizeof (MATRIX_TYPE)) == 0) {
+            BatchTask task = {A, NULL, NULL, NULL, NULL, det, work, NULL,
+                              batch_determinant_chunk};
+            batch_run (&task, threads);
+            free (work);
+            res = 0;
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file batch.h
+ * @brief Пакетные операции над множеством малых матриц одной формы
+ *
+ * @details
+ * Пакет хранит count матриц rows x cols с чередованием (structure of
+ * arrays): элемент (i, j) всех матриц лежит подряд, элемент (i, j)
+ * матрицы b находится по адресу data[(i * cols + j) * lanes + b]. Так
+ * одна векторная инструкция обрабатывает один и тот же элемент нескольких
+ * матриц, и операции над матрицами 3 x 3 .. 8 x 8 не тратят время на
+ * короткие циклы, вызовы create_matrix и упаковку.
+ *
+ * Умножение, детерминант и выражение A x B + C - D^T сводятся к
+ * поэлементным ядрам над отрезками длиной до BATCH_CHUNK матриц
+ * (simd.h: batch_gemm, add, sub, mul_sub). Отрезки - независимые задачи пула
+ * потоков, если объем работы не меньше GEMM_PARALLEL_THRESHOLD.
+ *
+ * Порядок операций для каждой матрицы тот же, что у классического
+ * умножения, поэтому результат отличается от multiply_matrices не больше
+ * чем на GEMM_TOLERANCE. Детерминант считается LU-разложением с выбором
+ * главного элемента в каждой матрице отдельно.
+ *
+ * @see matrix.h simd.h
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "../../include/config.h"
+#include "matrix.h"
+
+/**
+ * @struct MatrixBatch
+ * @brief Пакет матриц одной формы с чередованием элементов
+ */
+typedef struct {
+    int          count;   ///< Количество матриц
+    int          rows;    ///< Строк в каждой матрице
+    int          cols;    ///< Столбцов в каждой матрице
+    int          lanes;   ///< Шаг отрезков: count с выравниванием
+    MATRIX_TYPE* data;    ///< Элементы, rows * cols отрезков по lanes
+} MatrixBatch;
+
+/**
+ * @brief Доступ к элементу матрицы пакета
+ * @param batch Указатель на пакет
+ * @param index Номер матрицы
+ * @param row Номер строки
+ * @param col Номер столбца
+ */
+#define BATCH_AT(batch, index, row, col)                                            \
+    ((batch)->data[((size_t) (row) * (batch)->cols + (col)) * (batch)->lanes +     \
+                   (index)])
+
+/**
+ * @brief Создает пакет нулевых матриц
+ * @param count Количество матриц
+ * @param rows Строк в каждой матрице
+ * @param cols Столбцов в каждой матрице
+ * @note Каждый отрезок элемента выровнен по MATRIX_ALIGNMENT
+ * @return Пакет или нулевая структура при ошибке
+ */
+MatrixBatch batch_create (int count, int rows, int cols);
+
+/**
+ * @brief Освобождает память пакета
+ * @param batch Пакет или NULL
+ */
+void batch_free (MatrixBatch* batch);
+
+/**
+ * @brief Копирует матрицу в пакет
+ * @param batch Пакет
+ * @param index Номер матрицы в пакете
+ * @param matrix Матрица той же формы
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_set (MatrixBatch* batch, int index, const Matrix* matrix);
+
+/**
+ * @brief Копирует матрицу из пакета
+ * @param batch Пакет
+ * @param index Номер матрицы в пакете
+ * @param matrix Матрица не меньше rows x cols
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_get (const MatrixBatch* batch, int index, Matrix* matrix);
+
+/**
+ * @brief Складывает пакеты поматрично
+ * @param A Первый пакет
+ * @param B Второй пакет той же формы
+ * @param result Пакет той же формы; может совпадать с A или B
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_add (const MatrixBatch* A, const MatrixBatch* B, MatrixBatch* result);
+
+/**
+ * @brief Вычитает пакеты поматрично
+ * @param A Уменьшаемое
+ * @param B Вычитаемое той же формы
+ * @param result Пакет той же формы; может совпадать с A или B
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_subtract (const MatrixBatch* A, const MatrixBatch* B,
+                    MatrixBatch* result);
+
+/**
+ * @brief Умножает пакеты поматрично
+ * @param A Пакет матриц m x k
+ * @param B Пакет матриц k x n того же размера
+ * @param result Пакет матриц m x n, отличный от A и B
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_multiply (const MatrixBatch* A, const MatrixBatch* B,
+                    MatrixBatch* result);
+
+/**
+ * @brief Вычисляет A x B + C - D^T для каждой матрицы пакетов
+ * @param A Пакет матриц m x k
+ * @param B Пакет матриц k x n
+ * @param C Пакет матриц m x n
+ * @param D Пакет матриц n x m
+ * @param result Пакет матриц m x n, отличный от A, B и D
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_multiply_add_subtract_transposed (const MatrixBatch* A,
+                                            const MatrixBatch* B,
+                                            const MatrixBatch* C,
+                                            const MatrixBatch* D,
+                                            MatrixBatch*       result);
+
+/**
+ * @brief Транспонирует пакет поматрично
+ * @param A Пакет матриц m x n
+ * @param result Пакет матриц n x m, отличный от A
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_transpose (const MatrixBatch* A, MatrixBatch* result);
+
+/**
+ * @brief Вычисляет детерминанты матриц пакета
+ * @param A Пакет квадратных матриц
+ * @param det Массив из A->count детерминантов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int batch_determinant (const MatrixBatch* A, MATRIX_TYPE* det);
+
+#endif   // BATCH_H
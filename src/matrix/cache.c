@@ -0,0 +1,507 @@
+/**
+ * @file cache.c
+ * @brief Реализация кэша результатов на диске
+ *
+ * @details
+ * Хеш устроен как xxHash64: четыре цепочки (lane) принимают по 8 байт из
+ * каждых 32 и не зависят друг от друга, поэтому умножения разных цепочек
+ * выполняются конвейером одновременно. Хвост строки короче 32 байт
+ * раскладывается по тем же цепочкам, так что результат зависит только от
+ * элементов, а не от выравнивания строк.
+ *
+ * Мьютекс кэша защищает счетчики и вытеснение внутри процесса; между
+ * процессами записи согласуются только атомарностью rename и unlink.
+ * Отображенная в память запись остается доступной и после того, как ее
+ * файл удален вытеснением.
+ *
+ * @see cache.h
+ */
+
+#include "cache.h"
+
+#include "../../include/config.h"
+#include "../metrics/metrics.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Константы xxHash64 */
+#define CACHE_PRIME1 0x9E3779B185EBCA87ULL
+#define CACHE_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define CACHE_PRIME3 0x165667B19E3779F9ULL
+#define CACHE_PRIME4 0x85EBCA77C2B2AE63ULL
+#define CACHE_PRIME5 0x27D4EB2F165667C5ULL
+
+/** Длина имени записи: 16 шестнадцатеричных цифр и ".bin" */
+#define CACHE_NAME_LENGTH 20
+
+/**
+ * @struct MatrixCache
+ * @brief Открытый кэш
+ */
+struct MatrixCache {
+    char*            directory;   ///< Каталог записей
+    uint64_t         limit;       ///< Предел суммарного размера записей
+    uint64_t         sequence;    ///< Счетчик имен временных файлов
+    MatrixCacheStats stats;       ///< Счетчики
+    pthread_mutex_t  lock;        ///< Защищает sequence, stats и вытеснение
+};
+
+/**
+ * @struct CacheEntry
+ * @brief Запись каталога при вытеснении
+ */
+typedef struct {
+    struct timespec used;                         ///< Время последнего обращения
+    uint64_t        size;                         ///< Размер файла
+    char            name[CACHE_NAME_LENGTH + 1];  ///< Имя файла
+} CacheEntry;
+
+// ----------------------------------------------------------------------------
+//  Хеш
+// ----------------------------------------------------------------------------
+
+static inline uint64_t cache_rotl (uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/** Шаг цепочки: добавляет 8 байт входа */
+static inline uint64_t cache_round (uint64_t lane, uint64_t input) {
+    return cache_rotl (lane + input * CACHE_PRIME2, 31) * CACHE_PRIME1;
+}
+
+/** Вносит значение в итоговый хеш */
+static inline uint64_t cache_merge (uint64_t hash, uint64_t value) {
+    return cache_rotl (hash ^ cache_round (0, value), 27) * CACHE_PRIME1 +
+           CACHE_PRIME4;
+}
+
+/** Перемешивает биты итогового хеша */
+static inline uint64_t cache_avalanche (uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= CACHE_PRIME2;
+    hash ^= hash >> 29;
+    hash *= CACHE_PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/** Читает 8 байт без требований к выравниванию */
+static inline uint64_t cache_read64 (const unsigned char* p) {
+    uint64_t value;
+
+    memcpy (&value, p, sizeof (value));
+
+    return value;
+}
+
+/**
+ * @brief Хеш содержимого матрицы
+ *
+ * @param matrix Матрица
+ *
+ * @return Хеш или 0 для пустой матрицы
+ */
+uint64_t matrix_hash (const Matrix* matrix) {
+    uint64_t hash = 0;
+    METRICS_BEGIN (timer);
+
+    if (matrix_valid (matrix)) {
+        const size_t         size  = matrix_element_size (matrix->type);
+        const size_t         bytes = (size_t) matrix->cols * size;   // Строки
+        const size_t         pitch = (size_t) matrix->stride * size;
+        const unsigned char* row   = matrix->type == MATRIX_F64
+                                         ? (const unsigned char*) matrix->block
+                                         : (const unsigned char*) matrix->elements;
+        const uint64_t       seed  = (uint64_t) matrix->type;
+        uint64_t             lane[4];
+
+        lane[0] = seed + CACHE_PRIME1 + CACHE_PRIME2;
+        lane[1] = seed + CACHE_PRIME2;
+        lane[2] = seed;
+        lane[3] = seed - CACHE_PRIME1;
+
+        for (int i = 0; i < matrix->rows; i++, row += pitch) {
+            size_t offset = 0;
+
+            for (; offset + 32 <= bytes; offset += 32) {
+                lane[0] = cache_round (lane[0], cache_read64 (row + offset));
+                lane[1] = cache_round (lane[1], cache_read64 (row + offset + 8));
+                lane[2] = cache_round (lane[2], cache_read64 (row + offset + 16));
+                lane[3] = cache_round (lane[3], cache_read64 (row + offset + 24));
+            }
+
+            // Хвост: целые 8 байт и, для 4-байтовых элементов, еще 4
+            int l = 0;
+            for (; offset + 8 <= bytes; offset += 8, l++) {
+                lane[l] = cache_round (lane[l], cache_read64 (row + offset));
+            }
+            if (offset < bytes) {
+                uint32_t last;
+                memcpy (&last, row + offset, sizeof (last));
+                lane[l] = cache_round (lane[l], last);
+            }
+        }
+
+        hash = cache_rotl (lane[0], 1) + cache_rotl (lane[1], 7) +
+               cache_rotl (lane[2], 12) + cache_rotl (lane[3], 18);
+        for (int l = 0; l < 4; l++) hash = cache_merge (hash, lane[l]);
+        hash = cache_merge (hash, ((uint64_t) matrix->rows << 32) |
+                                      (uint32_t) matrix->cols);
+        hash = cache_avalanche (hash);
+
+        METRICS_END (timer, METRICS_HASH, (uint64_t) matrix->rows * bytes, 0);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Ключ кэша для операции над входами
+ *
+ * @param operation Запись операции
+ * @param hashes Хеши входов
+ * @param count Количество входов
+ *
+ * @return Ключ
+ */
+uint64_t matrix_cache_key (const char* operation, const uint64_t* hashes,
+                           int count) {
+    uint64_t key = CACHE_PRIME5;
+
+    for (const char* c = operation ? operation : ""; *c != '\0'; c++) {
+        key = cache_rotl (key ^ ((unsigned char) *c * CACHE_PRIME5), 11) *
+              CACHE_PRIME1;
+    }
+    for (int i = 0; hashes && i < count; i++) key = cache_merge (key, hashes[i]);
+    key = cache_merge (key, (uint64_t) count);
+
+    return cache_avalanche (key);
+}
+
+// ----------------------------------------------------------------------------
+//  Файлы записей
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Собирает путь к файлу в каталоге кэша
+ *
+ * @param cache Кэш
+ * @param name Имя файла
+ *
+ * @return Путь (освобождается free) или NULL
+ */
+static char* cache_path (const MatrixCache* cache, const char* name) {
+    const size_t length = strlen (cache->directory) + strlen (name) + 2;
+    char*        path   = malloc (length);
+
+    if (path) snprintf (path, length, "%s/%s", cache->directory, name);
+
+    return path;
+}
+
+/**
+ * @brief Путь к записи с ключом
+ *
+ * @param cache Кэш
+ * @param key Ключ
+ *
+ * @return Путь (освобождается free) или NULL
+ */
+static char* cache_entry_path (const MatrixCache* cache, uint64_t key) {
+    char name[CACHE_NAME_LENGTH + 1];
+
+    snprintf (name, sizeof (name), "%016llx.bin", (unsigned long long) key);
+
+    return cache_path (cache, name);
+}
+
+/**
+ * @brief Проверяет, что имя файла - имя записи
+ *
+ * @param name Имя файла
+ *
+ * @return 1 для имени записи, иначе 0 (временные и чужие файлы)
+ */
+static int cache_entry_name (const char* name) {
+    int res = strlen (name) == CACHE_NAME_LENGTH &&
+              strcmp (name + CACHE_NAME_LENGTH - 4, ".bin") == 0;
+
+    for (int i = 0; res && i < CACHE_NAME_LENGTH - 4; i++) {
+        res = (name[i] >= '0' && name[i] <= '9') ||
+              (name[i] >= 'a' && name[i] <= 'f');
+    }
+
+    return res;
+}
+
+/**
+ * @brief Отмечает обращение к записи
+ *
+ * Время изменения ставится по часам реального времени, а не по грубым
+ * часам файловой системы, чтобы записи, тронутые подряд, различались.
+ *
+ * @param path Путь к записи
+ */
+static void cache_touch (const char* path) {
+    struct timespec times[2];
+
+    clock_gettime (CLOCK_REALTIME, &times[0]);
+    times[1] = times[0];
+    utimensat (AT_FDCWD, path, times, 0);
+}
+
+/** Сравнение записей: давно использованные первыми, при равенстве по имени */
+static int cache_compare_entries (const void* x, const void* y) {
+    const CacheEntry* a   = x;
+    const CacheEntry* b   = y;
+    int               res = (a->used.tv_sec > b->used.tv_sec) -
+                            (a->used.tv_sec < b->used.tv_sec);
+
+    if (res == 0) {
+        res = (a->used.tv_nsec > b->used.tv_nsec) -
+              (a->used.tv_nsec < b->used.tv_nsec);
+    }
+    if (res == 0) res = strcmp (a->name, b->name);
+
+    return res;
+}
+
+/**
+ * @brief Пересчитывает записи каталога и удаляет давно не использовавшиеся,
+ *        пока их размер больше предела
+ *
+ * Вызывается под мьютексом кэша.
+ *
+ * @param cache Кэш
+ *
+ * @return 0 при успехе, -1 при ошибке чтения каталога
+ */
+static int cache_evict (MatrixCache* cache) {
+    DIR*           dir      = opendir (cache->directory);
+    CacheEntry*    entries  = NULL;
+    size_t         count    = 0;
+    size_t         capacity = 0;
+    uint64_t       total    = 0;
+    int            res      = dir ? 0 : -1;
+    struct dirent* item;
+
+    while (res == 0 && (item = readdir (dir)) != NULL) {
+        struct stat info;
+        char*       path = NULL;
+
+        if (cache_entry_name (item->d_name) && count == capacity) {
+            const size_t grown = capacity ? capacity * 2 : 64;
+            CacheEntry*  more  = realloc (entries, grown * sizeof (*entries));
+            if (more) {
+                entries  = more;
+                capacity = grown;
+            } else {
+                res = -1;
+            }
+        }
+        if (res == 0 && cache_entry_name (item->d_name))
+            path = cache_path (cache, item->d_name);
+        if (path && stat (path, &info) == 0 && S_ISREG (info.st_mode)) {
+            entries[count].used = info.st_mtim;
+            entries[count].size = (uint64_t) info.st_size;
+            memcpy (entries[count].name, item->d_name, CACHE_NAME_LENGTH + 1);
+            total += entries[count].size;
+            count++;
+        }
+        free (path);
+    }
+    if (dir) closedir (dir);
+
+    // Записи удаляются с начала упорядоченного массива, остаток - содержимое
+    size_t first = 0;
+    if (res == 0 && total > cache->limit) {
+        qsort (entries, count, sizeof (*entries), cache_compare_entries);
+        for (; first < count && total > cache->limit; first++) {
+            char* path = cache_path (cache, entries[first].name);
+            // Запись, уже удаленную другим процессом, тоже не считаем
+            if (path && unlink (path) == 0) cache->stats.evictions++;
+            total -= entries[first].size;
+            free (path);
+        }
+    }
+
+    if (res == 0) {
+        cache->stats.entries = count - first;
+        cache->stats.bytes   = total;
+    }
+    free (entries);
+
+    return res;
+}
+
+// ----------------------------------------------------------------------------
+//  Открытие, поиск и запись
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Открывает кэш в каталоге
+ *
+ * @param directory Каталог кэша
+ * @param limit Предел размера в байтах или 0 для MATRIX_CACHE_LIMIT
+ *
+ * @return Кэш или NULL при ошибке
+ */
+MatrixCache* matrix_cache_open (const char* directory, uint64_t limit) {
+    MatrixCache* cache = NULL;
+    struct stat  info;
+
+    if (directory && *directory != '\0' &&
+        (mkdir (directory, 0777) == 0 || errno == EEXIST) &&
+        stat (directory, &info) == 0 && S_ISDIR (info.st_mode)) {
+        cache = calloc (1, sizeof (*cache));
+    }
+    if (cache) {
+        cache->directory = strdup (directory);
+        cache->limit     = limit ? limit : MATRIX_CACHE_LIMIT;
+        if (!cache->directory || pthread_mutex_init (&cache->lock, NULL) != 0) {
+            free (cache->directory);
+            free (cache);
+            cache = NULL;
+        }
+    }
+
+    // Предел мог уменьшиться с прошлого запуска
+    if (cache && cache_evict (cache) != 0) {
+        matrix_cache_close (cache);
+        cache = NULL;
+    }
+
+    return cache;
+}
+
+/**
+ * @brief Закрывает кэш
+ *
+ * @param cache Кэш или NULL
+ */
+void matrix_cache_close (MatrixCache* cache) {
+    if (cache) {
+        pthread_mutex_destroy (&cache->lock);
+        free (cache->directory);
+        free (cache);
+    }
+}
+
+/**
+ * @brief Ищет результат по ключу
+ *
+ * Поврежденная запись удаляется и считается промахом.
+ *
+ * @param cache Кэш
+ * @param key Ключ
+ * @param result Найденная матрица
+ *
+ * @return 1 при попадании, 0 при промахе
+ */
+int matrix_cache_lookup (MatrixCache* cache, uint64_t key, Matrix* result) {
+    char* path = cache && result ? cache_entry_path (cache, key) : NULL;
+    int   hit  = 0;
+
+    // Отсутствующий файл проверяется заранее: загрузчик сообщил бы об ошибке
+    if (path && access (path, R_OK) == 0) {
+        *result = load_matrix_typed (path);
+        hit     = matrix_valid (result);
+        if (hit) cache_touch (path);
+        else unlink (path);
+    }
+
+    if (cache) {
+        pthread_mutex_lock (&cache->lock);
+        if (hit) cache->stats.hits++;
+        else cache->stats.misses++;
+        pthread_mutex_unlock (&cache->lock);
+    }
+    free (path);
+
+    return hit;
+}
+
+/**
+ * @brief Сохраняет результат под ключом и вытесняет старые записи
+ *
+ * Файл пишется под временным именем и переименовывается в имя записи.
+ *
+ * @param cache Кэш
+ * @param key Ключ
+ * @param matrix Результат
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int matrix_cache_store (MatrixCache* cache, uint64_t key, const Matrix* matrix) {
+    int      res  = cache && matrix_valid (matrix) ? 0 : -1;
+    uint64_t size = 0;
+    char*    path = NULL;
+    char*    temp = NULL;
+
+    if (res == 0) {
+        size = (uint64_t) matrix->rows * (uint64_t) matrix->cols *
+               matrix_element_size (matrix->type);
+        path = cache_entry_path (cache, key);
+        if (!path) res = -1;
+    }
+
+    if (res == 0 && size <= cache->limit) {
+        char     name[64];
+        uint64_t sequence;
+
+        pthread_mutex_lock (&cache->lock);
+        sequence = cache->sequence++;
+        pthread_mutex_unlock (&cache->lock);
+
+        snprintf (name, sizeof (name), "%016llx.tmp.%ld.%llu",
+                  (unsigned long long) key, (long) getpid (),
+                  (unsigned long long) sequence);
+        temp = cache_path (cache, name);
+
+        if (!temp || save_matrix_to_binary_file (matrix, temp) != 0 ||
+            rename (temp, path) != 0) {
+            res = -1;
+            if (temp) unlink (temp);
+        } else {
+            cache_touch (path);
+            pthread_mutex_lock (&cache->lock);
+            cache->stats.stores++;
+            cache_evict (cache);
+            pthread_mutex_unlock (&cache->lock);
+        }
+    }
+
+    free (temp);
+    free (path);
+
+    return res;
+}
+
+/**
+ * @brief Возвращает счетчики кэша
+ *
+ * @param cache Кэш
+ *
+ * @return Счетчики
+ */
+MatrixCacheStats matrix_cache_stats (MatrixCache* cache) {
+    MatrixCacheStats stats = {0};
+
+    if (cache) {
+        pthread_mutex_lock (&cache->lock);
+        stats = cache->stats;
+        pthread_mutex_unlock (&cache->lock);
+    }
+
+    return stats;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file cache.h
+ * @brief Кэш результатов на диске с адресацией по содержимому
+ *
+ * @details
+ * Результат вычисления хранится под ключом - 64-битным хешем записи
+ * операции и содержимого входных матриц. Повторное вычисление над теми же
+ * данными находит результат по ключу и не выполняется, даже в другом
+ * процессе и под другими именами файлов.
+ *
+ * Хеш matrix_hash обходит элементы построчно (шаг строки не влияет на
+ * результат) четырьмя независимыми цепочками умножения и сдвига, как
+ * xxHash64, поэтому он упирается в пропускную способность памяти и стоит
+ * много меньше умножения, которое экономит. Размеры и тип элементов
+ * входят в хеш. Хеш не криптографический: вероятность совпадения ключей у
+ * разных данных - порядка n^2 / 2^65 для n записей.
+ *
+ * Каждая запись - двоичный файл матрицы KEY.bin (output.h) в каталоге
+ * кэша: при попадании он загружается load_matrix_typed, то есть
+ * отображается в память без копирования. Запись сначала пишется во
+ * временный файл и переименовывается, поэтому параллельные процессы не
+ * видят недописанных записей. Время последнего обращения - время
+ * изменения файла, которое обновляется при каждом попадании; если после
+ * записи размер кэша превышает предел, удаляются давно не
+ * использовавшиеся записи (LRU).
+ *
+ * Функции кэша можно вызывать из разных потоков.
+ *
+ * @see matrix.h output.h
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "matrix.h"
+
+#include <stdint.h>
+
+/** Непрозрачный кэш */
+typedef struct MatrixCache MatrixCache;
+
+/**
+ * @struct MatrixCacheStats
+ * @brief Счетчики кэша с момента открытия
+ */
+typedef struct {
+    uint64_t hits;        ///< Найдено записей
+    uint64_t misses;      ///< Не найдено записей
+    uint64_t stores;      ///< Сохранено записей
+    uint64_t evictions;   ///< Удалено записей по пределу размера
+    uint64_t entries;     ///< Записей в каталоге после последней записи
+    uint64_t bytes;       ///< Их суммарный размер в байтах
+} MatrixCacheStats;
+
+/**
+ * @brief Хеш содержимого матрицы
+ * @param matrix Матрица любого типа или представление
+ * @note Зависит от размеров, типа и значений элементов (побитово), но не от
+ *       шага строки
+ * @return Хеш или 0 для пустой матрицы
+ */
+uint64_t matrix_hash (const Matrix* matrix);
+
+/**
+ * @brief Ключ кэша для операции над входами
+ * @param operation Запись операции, например "A*B+C-D^T"
+ * @param hashes Хеши входов (matrix_hash) в порядке операции
+ * @param count Количество входов
+ * @return Ключ
+ */
+uint64_t matrix_cache_key (const char* operation, const uint64_t* hashes, int count);
+
+/**
+ * @brief Открывает кэш в каталоге, создавая каталог при необходимости
+ * @param directory Каталог кэша
+ * @param limit Предел суммарного размера записей в байтах или 0 для
+ *              MATRIX_CACHE_LIMIT
+ * @return Кэш или NULL при ошибке
+ */
+MatrixCache* matrix_cache_open (const char* directory, uint64_t limit);
+
+/**
+ * @brief Закрывает кэш (записи на диске остаются)
+ * @param cache Кэш или NULL
+ */
+void matrix_cache_close (MatrixCache* cache);
+
+/**
+ * @brief Ищет результат по ключу
+ * @param cache Кэш
+ * @param key Ключ
+ * @param result Найденная матрица (освобождается free_matrix)
+ * @return 1 при попадании, 0 при промахе
+ */
+int matrix_cache_lookup (MatrixCache* cache, uint64_t key, Matrix* result);
+
+/**
+ * @brief Сохраняет результат под ключом и вытесняет старые записи
+ * @param cache Кэш
+ * @param key Ключ
+ * @param matrix Результат
+ * @note Результат больше предела кэша не сохраняется
+ * @return 0 при успехе, -1 при ошибке
+ */
+int matrix_cache_store (MatrixCache* cache, uint64_t key, const Matrix* matrix);
+
+/**
+ * @brief Возвращает счетчики кэша
+ * @param cache Кэш
+ * @return Счетчики (нулевые для NULL)
+ */
+MatrixCacheStats matrix_cache_stats (MatrixCache* cache);
+
+#endif   // CACHE_H
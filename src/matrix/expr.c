@@ -0,0 +1,1078 @@
+/**
+ * @file expr.c
+ * @brief Реализация ленивых матричных выражений
+ *
+ * @details
+ * Узлы хранятся в массиве графа и индексируются хеш-таблицей по
+ * (операция, операнды, множитель, входная матрица), что дает объединение
+ * общих подвыражений при построении.
+ *
+ * Вычисление делит граф на области: поэлементные узлы и транспонирования
+ * образуют область, границы которой - входные матрицы и произведения.
+ * Перед проходом по области вычисляются все произведения на ее границе,
+ * затем область вычисляется плитками: каждая плитка результата требует
+ * по одной плитке от каждого узла области.
+ *
+ * @see expr.h
+ */
+
+#include "expr.h"
+
+#include "gemm.h"
+#include "simd.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Начальная емкость массива узлов */
+#define EXPR_INITIAL_CAPACITY 16
+
+/** Наибольшая вложенность скобок в записи выражения (expr_parse) */
+#define EXPR_PARSE_MAX_DEPTH 64
+
+/**
+ * @struct Expr
+ * @brief Узел выражения и его состояние во время вычисления
+ */
+struct Expr {
+    ExprOp             op;         ///< Операция
+    int                id;         ///< Номер узла в графе
+    int                rows;       ///< Строк в значении
+    int                cols;       ///< Столбцов в значении
+    Expr*              a;          ///< Первый операнд
+    Expr*              b;          ///< Второй операнд
+    MATRIX_TYPE        alpha;      ///< Множитель EXPR_SCALE
+    const Matrix*      input;      ///< Матрица EXPR_INPUT
+
+    // Состояние последнего вычисления
+    int                users;      ///< Ссылок из узлов, достижимых из корня
+    char               visited;    ///< Учтен при подсчете ссылок
+    char               reach[2];   ///< Достижим без и с транспонированием
+    char               prepared;   ///< Границы области вычислены
+    char               ready;      ///< Значение вычислено в data
+    int                mark;       ///< Номер последнего поиска по области
+    const MATRIX_TYPE* data;       ///< Вычисленное значение
+    int                ld;         ///< Шаг строки data
+    Matrix             temp;       ///< Временная матрица значения
+    MATRIX_TYPE*       tile[2];    ///< Плитки без и с транспонированием
+    long               stamp[2];   ///< Номер прохода, для которого плитка готова
+};
+
+/**
+ * @struct ExprGraph
+ * @brief Узлы и хеш-таблица для объединения подвыражений
+ */
+struct ExprGraph {
+    Expr** nodes;         ///< Узлы в порядке создания
+    int    count;         ///< Количество узлов
+    int    capacity;      ///< Емкость nodes
+    int*   slots;         ///< Хеш-таблица номеров узлов, -1 - пусто
+    int    slot_count;    ///< Размер таблицы (степень двойки)
+    long   tile_id;       ///< Номер текущей плитки прохода
+    int    search;        ///< Номер текущего поиска по области
+    int    temporaries;   ///< Временных матриц в последнем вычислении
+};
+
+/**
+ * @brief Хеш ключа узла
+ *
+ * @param op Операция
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param alpha Множитель
+ * @param input Входная матрица
+ * @return Хеш
+ */
+static size_t expr_hash (ExprOp op, const Expr* a, const Expr* b, MATRIX_TYPE alpha,
+                         const Matrix* input) {
+    unsigned char bytes[sizeof (MATRIX_TYPE)];
+    uint64_t      hash = 1469598103934665603ULL;   // FNV-1a
+
+    memcpy (bytes, &alpha, sizeof bytes);
+    hash = (hash ^ (uint64_t) op) * 1099511628211ULL;
+    hash = (hash ^ (uint64_t) (a ? a->id + 1 : 0)) * 1099511628211ULL;
+    hash = (hash ^ (uint64_t) (b ? b->id + 1 : 0)) * 1099511628211ULL;
+    hash = (hash ^ (uint64_t) (uintptr_t) input) * 1099511628211ULL;
+    for (size_t i = 0; i < sizeof bytes; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+
+    return (size_t) hash;
+}
+
+/**
+ * @brief Ищет слот узла с заданным ключом или первый пустой слот
+ *
+ * @param graph Граф
+ * @param op Операция
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param alpha Множитель
+ * @param input Входная матрица
+ * @return Номер слота
+ */
+static int expr_find_slot (const ExprGraph* graph, ExprOp op, const Expr* a,
+                           const Expr* b, MATRIX_TYPE alpha, const Matrix* input) {
+    const size_t mask = (size_t) graph->slot_count - 1;
+    size_t       slot = expr_hash (op, a, b, alpha, input) & mask;
+
+    while (graph->slots[slot] >= 0) {
+        const Expr* node = graph->nodes[graph->slots[slot]];
+        if (node->op == op && node->a == a && node->b == b && node->input == input &&
+            memcmp (&node->alpha, &alpha, sizeof alpha) == 0)
+            break;
+        slot = (slot + 1) & mask;
+    }
+
+    return (int) slot;
+}
+
+/**
+ * @brief Увеличивает емкость графа и перестраивает хеш-таблицу
+ *
+ * @param graph Граф
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+static int expr_graph_grow (ExprGraph* graph) {
+    const int capacity = graph->capacity ? graph->capacity * 2 : EXPR_INITIAL_CAPACITY;
+    Expr**    nodes    = realloc (graph->nodes, (size_t) capacity * sizeof (Expr*));
+    int*      slots    = malloc ((size_t) capacity * 2 * sizeof (int));
+    int       res      = 0;
+
+    if (nodes) graph->nodes = nodes;
+    if (!nodes || !slots) {
+        free (slots);
+        res = -1;
+    } else {
+        free (graph->slots);
+        graph->capacity   = capacity;
+        graph->slots      = slots;
+        graph->slot_count = capacity * 2;
+        for (int i = 0; i < graph->slot_count; i++) graph->slots[i] = -1;
+        for (int i = 0; i < graph->count; i++) {
+            const Expr* node = graph->nodes[i];
+            graph->slots[expr_find_slot (graph, node->op, node->a, node->b,
+                                         node->alpha, node->input)] = i;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Возвращает существующий узел с тем же ключом или создает новый
+ *
+ * @param graph Граф
+ * @param op Операция
+ * @param rows Строк в значении
+ * @param cols Столбцов в значении
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param alpha Множитель
+ * @param input Входная матрица
+ * @return Узел или NULL при ошибке выделения памяти
+ */
+static Expr* expr_node (ExprGraph* graph, ExprOp op, int rows, int cols, Expr* a,
+                        Expr* b, MATRIX_TYPE alpha, const Matrix* input) {
+    Expr* node = NULL;
+    int   slot = 0;
+
+    if (graph->count < graph->capacity || expr_graph_grow (graph) == 0) {
+        slot = expr_find_slot (graph, op, a, b, alpha, input);
+        if (graph->slots[slot] >= 0) {
+            node = graph->nodes[graph->slots[slot]];
+        } else if ((node = calloc (1, sizeof (Expr))) != NULL) {
+            node->op    = op;
+            node->id    = graph->count;
+            node->rows  = rows;
+            node->cols  = cols;
+            node->a     = a;
+            node->b     = b;
+            node->alpha = alpha;
+            node->input = input;
+
+            graph->nodes[graph->count] = node;
+            graph->slots[slot]         = graph->count++;
+        }
+    }
+
+    return node;
+}
+
+/**
+ * @brief Создает пустой граф
+ *
+ * @return Граф или NULL при ошибке выделения памяти
+ */
+ExprGraph* expr_graph_create (void) {
+    ExprGraph* graph = calloc (1, sizeof (ExprGraph));
+
+    if (graph && expr_graph_grow (graph) != 0) {
+        expr_graph_free (graph);
+        graph = NULL;
+    }
+
+    return graph;
+}
+
+/**
+ * @brief Освобождает граф и все его узлы
+ *
+ * @param graph Граф или NULL
+ */
+void expr_graph_free (ExprGraph* graph) {
+    if (graph) {
+        for (int i = 0; i < graph->count; i++) free (graph->nodes[i]);
+        free (graph->nodes);
+        free (graph->slots);
+        free (graph);
+    }
+}
+
+/**
+ * @brief Узел входной матрицы
+ *
+ * @param graph Граф
+ * @param matrix Матрица
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_input (ExprGraph* graph, const Matrix* matrix) {
+    Expr* node = NULL;
+
+    if (graph && matrix && matrix->block) {
+        node = expr_node (graph, EXPR_INPUT, matrix->rows, matrix->cols, NULL, NULL, 0,
+                          matrix);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Узел поэлементной операции над операндами одного размера
+ *
+ * @param graph Граф
+ * @param op EXPR_ADD или EXPR_SUB
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @return Узел или NULL при ошибке
+ */
+static Expr* expr_elementwise (ExprGraph* graph, ExprOp op, Expr* a, Expr* b) {
+    Expr* node = NULL;
+
+    if (graph && a && b && a->rows == b->rows && a->cols == b->cols) {
+        // Сложение коммутативно: единый порядок операндов для объединения
+        if (op == EXPR_ADD && a->id > b->id) {
+            Expr* swap = a;
+            a          = b;
+            b          = swap;
+        }
+        node = expr_node (graph, op, a->rows, a->cols, a, b, 0, NULL);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Узел суммы
+ *
+ * @param graph Граф
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_add (ExprGraph* graph, Expr* a, Expr* b) {
+    return expr_elementwise (graph, EXPR_ADD, a, b);
+}
+
+/**
+ * @brief Узел разности
+ *
+ * @param graph Граф
+ * @param a Уменьшаемое
+ * @param b Вычитаемое
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_sub (ExprGraph* graph, Expr* a, Expr* b) {
+    return expr_elementwise (graph, EXPR_SUB, a, b);
+}
+
+/**
+ * @brief Узел произведения
+ *
+ * @param graph Граф
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_mul (ExprGraph* graph, Expr* a, Expr* b) {
+    Expr* node = NULL;
+
+    if (graph && a && b && a->cols == b->rows) {
+        node = expr_node (graph, EXPR_MUL, a->rows, b->cols, a, b, 0, NULL);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Узел транспонирования
+ *
+ * @param graph Граф
+ * @param a Операнд
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_transpose (ExprGraph* graph, Expr* a) {
+    Expr* node = NULL;
+
+    if (graph && a) {
+        node = (a->op == EXPR_TRANSPOSE)
+                   ? a->a
+                   : expr_node (graph, EXPR_TRANSPOSE, a->cols, a->rows, a, NULL, 0,
+                                NULL);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Узел умножения на число
+ *
+ * @param graph Граф
+ * @param a Операнд
+ * @param alpha Множитель
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_scale (ExprGraph* graph, Expr* a, MATRIX_TYPE alpha) {
+    Expr* node = NULL;
+
+    if (graph && a) node = expr_node (graph, EXPR_SCALE, a->rows, a->cols, a, NULL,
+                                      alpha, NULL);
+
+    return node;
+}
+
+/**
+ * @brief Число строк значения узла
+ *
+ * @param expr Узел
+ * @return Число строк
+ */
+int expr_rows (const Expr* expr) {
+    return expr ? expr->rows : 0;
+}
+
+/**
+ * @brief Число столбцов значения узла
+ *
+ * @param expr Узел
+ * @return Число столбцов
+ */
+int expr_cols (const Expr* expr) {
+    return expr ? expr->cols : 0;
+}
+
+/**
+ * @brief Число узлов в графе
+ *
+ * @param graph Граф
+ * @return Количество узлов
+ */
+int expr_node_count (const ExprGraph* graph) {
+    return graph ? graph->count : 0;
+}
+
+/**
+ * @brief Число временных матриц последнего вычисления
+ *
+ * @param graph Граф
+ * @return Количество временных матриц
+ */
+int expr_temporaries (const ExprGraph* graph) {
+    return graph ? graph->temporaries : 0;
+}
+
+/**
+ * @struct ExprParser
+ * @brief Состояние разбора записи выражения
+ */
+typedef struct {
+    ExprGraph*           graph;    ///< Граф, в котором строятся узлы
+    const char*          pos;      ///< Текущая позиция в записи
+    const char* const*   names;    ///< Имена входных матриц
+    const Matrix* const* inputs;   ///< Матрицы с этими именами
+    int                  count;    ///< Количество имен
+    int                  depth;    ///< Текущая вложенность скобок
+} ExprParser;
+
+/**
+ * @struct ExprValue
+ * @brief Значение разобранного подвыражения: узел или число
+ */
+typedef struct {
+    Expr*       node;     ///< Узел или NULL, если значение - число
+    MATRIX_TYPE scalar;   ///< Число, если node == NULL
+    int         valid;    ///< 0 - ошибка разбора
+} ExprValue;
+
+static ExprValue expr_parse_sum (ExprParser* parser);
+
+/**
+ * @brief Пропускает пробелы и табуляции
+ *
+ * @param parser Состояние разбора
+ */
+static void expr_parse_skip (ExprParser* parser) {
+    while (*parser->pos == ' ' || *parser->pos == '\t') parser->pos++;
+}
+
+/**
+ * @brief Пропускает символ c, если он следует за пробелами
+ *
+ * @param parser Состояние разбора
+ * @param c Ожидаемый символ
+ * @return 1, если символ найден и пропущен, иначе 0
+ */
+static int expr_parse_accept (ExprParser* parser, char c) {
+    int res = 0;
+
+    expr_parse_skip (parser);
+    if (*parser->pos == c) {
+        parser->pos++;
+        res = 1;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Проверяет, может ли символ входить в имя матрицы
+ *
+ * @param c Символ
+ * @param first 1 - первый символ имени (цифры не допускаются)
+ * @return 1, если может
+ */
+static int expr_name_char (char c, int first) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' ||
+           (!first && c >= '0' && c <= '9');
+}
+
+/**
+ * @brief Разбирает имя матрицы, число или выражение в скобках
+ *
+ * @param parser Состояние разбора
+ * @return Значение
+ */
+static ExprValue expr_parse_primary (ExprParser* parser) {
+    ExprValue value = {NULL, 0, 0};
+    char*     end   = NULL;
+
+    expr_parse_skip (parser);
+    if (*parser->pos == '(' && parser->depth < EXPR_PARSE_MAX_DEPTH) {
+        parser->pos++;
+        parser->depth++;
+        value = expr_parse_sum (parser);
+        parser->depth--;
+        if (value.valid && !expr_parse_accept (parser, ')')) value.valid = 0;
+    } else if (expr_name_char (*parser->pos, 1)) {
+        const char* name = parser->pos;
+        while (expr_name_char (*parser->pos, 0)) parser->pos++;
+
+        const size_t length = (size_t) (parser->pos - name);
+        for (int i = 0; i < parser->count && !value.valid; i++) {
+            if (strlen (parser->names[i]) == length &&
+                strncmp (parser->names[i], name, length) == 0) {
+                value.node  = expr_input (parser->graph, parser->inputs[i]);
+                value.valid = value.node != NULL;
+            }
+        }
+    } else if ((*parser->pos >= '0' && *parser->pos <= '9') || *parser->pos == '.') {
+        value.scalar = strtod (parser->pos, &end);
+        value.valid  = end != parser->pos;
+        parser->pos  = end;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Разбирает операнд с транспонированиями (^T) и знаками минус
+ *
+ * @param parser Состояние разбора
+ * @return Значение
+ */
+static ExprValue expr_parse_unary (ExprParser* parser) {
+    int negate = 0;   // Нечетное число знаков минус
+
+    while (expr_parse_accept (parser, '-')) negate = !negate;
+
+    ExprValue value = expr_parse_primary (parser);
+    while (value.valid && expr_parse_accept (parser, '^')) {
+        // Единственный допустимый показатель - T
+        if (!expr_parse_accept (parser, 'T')) value.valid = 0;
+        else if (value.node) {
+            value.node  = expr_transpose (parser->graph, value.node);
+            value.valid = value.node != NULL;
+        }
+    }
+
+    if (value.valid && negate) {
+        if (value.node) {
+            value.node  = expr_scale (parser->graph, value.node, -1);
+            value.valid = value.node != NULL;
+        } else {
+            value.scalar = -value.scalar;
+        }
+    }
+
+    return value;
+}
+
+/**
+ * @brief Разбирает произведение операндов
+ *
+ * Числовые множители перемножаются между собой, а множитель матрицы
+ * становится узлом EXPR_SCALE.
+ *
+ * @param parser Состояние разбора
+ * @return Значение
+ */
+static ExprValue expr_parse_product (ExprParser* parser) {
+    ExprValue value = expr_parse_unary (parser);
+
+    while (value.valid && expr_parse_accept (parser, '*')) {
+        const ExprValue factor = expr_parse_unary (parser);
+        const int       matrix = value.node || factor.node;   // Значение - матрица
+
+        if (!factor.valid) value.valid = 0;
+        else if (value.node && factor.node) {
+            value.node = expr_mul (parser->graph, value.node, factor.node);
+        } else if (value.node) {
+            value.node = expr_scale (parser->graph, value.node, factor.scalar);
+        } else if (factor.node) {
+            value.node = expr_scale (parser->graph, factor.node, value.scalar);
+        } else {
+            value.scalar *= factor.scalar;
+        }
+        if (value.valid && matrix) value.valid = value.node != NULL;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Разбирает сумму и разность произведений
+ *
+ * @param parser Состояние разбора
+ * @return Значение; складываются и вычитаются только матрицы
+ */
+static ExprValue expr_parse_sum (ExprParser* parser) {
+    ExprValue value = expr_parse_product (parser);
+    int       more  = 1;   // Следующее слагаемое есть
+
+    while (value.valid && more) {
+        const int add      = expr_parse_accept (parser, '+');
+        const int subtract = !add && expr_parse_accept (parser, '-');
+
+        if (add || subtract) {
+            const ExprValue term = expr_parse_product (parser);
+
+            value.valid = term.valid && value.node && term.node;
+            if (value.valid) {
+                value.node  = add ? expr_add (parser->graph, value.node, term.node)
+                                  : expr_sub (parser->graph, value.node, term.node);
+                value.valid = value.node != NULL;
+            }
+        } else {
+            more = 0;
+        }
+    }
+
+    return value;
+}
+
+/**
+ * @brief Строит выражение по текстовой записи
+ *
+ * Рекурсивный спуск: сумма - произведения через + и -, произведение -
+ * операнды через *, операнд - имя, число или выражение в скобках со
+ * знаками минус перед ним и ^T после него.
+ *
+ * @param graph Граф
+ * @param text Запись выражения
+ * @param names Имена входных матриц
+ * @param inputs Матрицы с этими именами
+ * @param count Количество имен
+ * @return Корень выражения или NULL при ошибке
+ */
+Expr* expr_parse (ExprGraph* graph, const char* text, const char* const* names,
+                  const Matrix* const* inputs, int count) {
+    Expr* root = NULL;
+
+    if (graph && text && count >= 0 && (count == 0 || (names && inputs))) {
+        ExprParser parser = {graph, text, names, inputs, count, 0};
+        ExprValue  value  = expr_parse_sum (&parser);
+
+        // Запись разобрана целиком, и ее значение - матрица
+        expr_parse_skip (&parser);
+        if (value.valid && *parser.pos == '\0') root = value.node;
+    }
+
+    return root;
+}
+
+/**
+ * @brief Проверяет, является ли узел границей поэлементной области
+ *
+ * @param node Узел
+ * @return 1 для входной матрицы, произведения или вычисленного узла
+ */
+static int expr_is_boundary (const Expr* node) {
+    return node->op == EXPR_INPUT || node->op == EXPR_MUL || node->ready;
+}
+
+/**
+ * @brief Считает ссылки на узлы, достижимые из корня
+ *
+ * @param node Узел
+ */
+static void expr_count_users (Expr* node) {
+    if (!node->visited) {
+        node->visited = 1;
+        if (node->a) {
+            node->a->users++;
+            expr_count_users (node->a);
+        }
+        if (node->b) {
+            node->b->users++;
+            expr_count_users (node->b);
+        }
+    }
+}
+
+/**
+ * @brief Отмечает, с каким транспонированием читаются узлы области
+ *
+ * @param node Узел
+ * @param trans 1, если значение узла читается транспонированным
+ */
+static void expr_mark_reach (Expr* node, int trans) {
+    if (!node->reach[trans]) {
+        node->reach[trans] = 1;
+        if (!expr_is_boundary (node)) {
+            if (node->op == EXPR_TRANSPOSE) expr_mark_reach (node->a, !trans);
+            else {
+                expr_mark_reach (node->a, trans);
+                if (node->b) expr_mark_reach (node->b, trans);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Ищет произведение, которое можно записать прямо в выход области
+ *
+ * Подходит произведение с единственной ссылкой, которое читается только
+ * без транспонирования: тогда каждая плитка выхода читает его значение
+ * только в тех же позициях до записи.
+ *
+ * @param graph Граф
+ * @param node Узел области
+ * @return Произведение или NULL
+ */
+static Expr* expr_find_in_place (ExprGraph* graph, Expr* node) {
+    Expr* found = NULL;
+
+    if (node->mark != graph->search && !node->ready) {
+        node->mark = graph->search;
+        if (node->op == EXPR_MUL) {
+            if (node->users == 1 && !node->reach[1]) found = node;
+        } else if (node->op != EXPR_INPUT) {
+            found = expr_find_in_place (graph, node->a);
+            if (!found && node->b) found = expr_find_in_place (graph, node->b);
+        }
+    }
+
+    return found;
+}
+
+static int expr_compute (ExprGraph* graph, Expr* node, MATRIX_TYPE* out, int ldo,
+                         int top);
+
+/**
+ * @brief Вычисляет значение узла во временную матрицу
+ *
+ * @param graph Граф
+ * @param node Узел
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int expr_materialize (ExprGraph* graph, Expr* node) {
+    int res = 0;
+
+    if (!node->ready) {
+        node->temp = create_matrix (node->rows, node->cols);
+        if (!node->temp.data) res = -1;
+        else {
+            graph->temporaries++;
+            res = expr_compute (graph, node, node->temp.block, node->temp.stride, 0);
+        }
+        if (res == 0) {
+            node->data  = node->temp.block;
+            node->ld    = node->temp.stride;
+            node->ready = 1;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Возвращает хранимые данные узла для умножения
+ *
+ * Транспонирования снимаются и передаются флагом; остальные узлы, кроме
+ * входных матриц, вычисляются во временные матрицы.
+ *
+ * @param graph Граф
+ * @param node Узел
+ * @param data Данные
+ * @param ld Шаг строки данных
+ * @param trans Флаг транспонирования данных
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int expr_operand (ExprGraph* graph, Expr* node, const MATRIX_TYPE** data,
+                         int* ld, int* trans) {
+    int res = 0;
+
+    *trans = 0;
+    while (node->op == EXPR_TRANSPOSE && !node->ready) {
+        *trans = !*trans;
+        node   = node->a;
+    }
+
+    if (node->op == EXPR_INPUT) {
+        *data = node->input->block;
+        *ld   = node->input->stride;
+    } else {
+        res   = expr_materialize (graph, node);
+        *data = node->data;
+        *ld   = node->ld;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Вычисляет произведение в out
+ *
+ * @param graph Граф
+ * @param node Узел EXPR_MUL
+ * @param out Выходные данные
+ * @param ldo Шаг строки out
+ * @param epilogue Эпилог или NULL
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int expr_gemm (ExprGraph* graph, Expr* node, MATRIX_TYPE* out, int ldo,
+                      const GemmEpilogue* epilogue) {
+    const MATRIX_TYPE *a = NULL, *b = NULL;
+    int                lda = 0, ldb = 0, trans_a = 0, trans_b = 0;
+    int                res = expr_operand (graph, node->a, &a, &lda, &trans_a);
+
+    if (res == 0) res = expr_operand (graph, node->b, &b, &ldb, &trans_b);
+    if (res == 0) {
+        res = gemm_multiply_trans (node->rows, node->cols, node->a->cols, a, lda,
+                                   trans_a, b, ldb, trans_b, out, ldo, epilogue);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Распознает шаблон M + C, M - D^T или (M + C) - D^T
+ *
+ * M - произведение с единственной ссылкой, C и D - входные матрицы.
+ * Такая область вычисляется одним умножением с эпилогом.
+ *
+ * @param node Корень области
+ * @param epilogue Заполняемый эпилог
+ * @return Произведение M или NULL
+ */
+static Expr* expr_match_epilogue (Expr* node, GemmEpilogue* epilogue) {
+    Expr* mul = NULL;
+
+    memset (epilogue, 0, sizeof (*epilogue));
+    if (node->op == EXPR_SUB && node->b->op == EXPR_TRANSPOSE &&
+        node->b->a->op == EXPR_INPUT && !node->b->ready) {
+        epilogue->sub_t    = node->b->a->input->block;
+        epilogue->ld_sub_t = node->b->a->input->stride;
+        node               = node->a;
+        if (node->op != EXPR_MUL && node->users > 1) node = NULL;
+    }
+
+    if (node && node->op == EXPR_ADD && !node->ready) {
+        Expr* input = (node->a->op == EXPR_INPUT) ? node->a : node->b;
+        Expr* other = (input == node->a) ? node->b : node->a;
+        if (input->op == EXPR_INPUT) {
+            epilogue->add    = input->input->block;
+            epilogue->ld_add = input->input->stride;
+            node             = other;
+        }
+    }
+
+    if (node && node->op == EXPR_MUL && !node->ready && node->users == 1 &&
+        (epilogue->add || epilogue->sub_t))
+        mul = node;
+
+    return mul;
+}
+
+/**
+ * @brief Вычисляет произведения на границе области
+ *
+ * @param graph Граф
+ * @param node Узел области
+ * @param in_place Произведение, записываемое прямо в out, или NULL
+ * @param out Выход области
+ * @param ldo Шаг строки out
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int expr_prepare (ExprGraph* graph, Expr* node, Expr* in_place,
+                         MATRIX_TYPE* out, int ldo) {
+    int res = 0;
+
+    if (node->op == EXPR_MUL && !node->ready) {
+        if (node == in_place) {
+            res = expr_gemm (graph, node, out, ldo, NULL);
+            if (res == 0) {
+                node->data  = out;
+                node->ld    = ldo;
+                node->ready = 1;
+            }
+        } else {
+            res = expr_materialize (graph, node);
+        }
+    } else if (!expr_is_boundary (node) && !node->prepared) {
+        node->prepared = 1;
+        res            = expr_prepare (graph, node->a, in_place, out, ldo);
+        if (res == 0 && node->b) res = expr_prepare (graph, node->b, in_place, out, ldo);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Хранимые данные граничного узла
+ *
+ * @param node Входная матрица или вычисленный узел
+ * @param ld Шаг строки данных
+ * @return Данные
+ */
+static const MATRIX_TYPE* expr_boundary_data (const Expr* node, int* ld) {
+    *ld = (node->op == EXPR_INPUT) ? node->input->stride : node->ld;
+    return (node->op == EXPR_INPUT) ? node->input->block : node->data;
+}
+
+static const MATRIX_TYPE* expr_tile (ExprGraph* graph, Expr* node, int trans, int r0,
+                                     int c0, int rows, int cols, MATRIX_TYPE* out,
+                                     int ldo, int* ld);
+
+/**
+ * @brief Записывает плитку узла в out
+ *
+ * @param graph Граф
+ * @param node Узел, кроме транспонирования
+ * @param trans Флаг транспонирования
+ * @param r0 Первая строка плитки
+ * @param c0 Первый столбец плитки
+ * @param rows Строк в плитке
+ * @param cols Столбцов в плитке
+ * @param out Плитка результата
+ * @param ldo Шаг строки out
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+static int expr_tile_compute (ExprGraph* graph, Expr* node, int trans, int r0, int c0,
+                              int rows, int cols, MATRIX_TYPE* out, int ldo) {
+    const SimdOps* ops = simd_ops ();
+    int            res = 0;
+
+    if (expr_is_boundary (node)) {
+        int                lds  = 0;
+        const MATRIX_TYPE* data = expr_boundary_data (node, &lds);
+        if (trans) {
+            ops->transpose (cols, rows, data + (size_t) c0 * lds + r0, lds, out, ldo);
+        } else {
+            for (int i = 0; i < rows; i++) {
+                memcpy (out + (size_t) i * ldo, data + (size_t) (r0 + i) * lds + c0,
+                        (size_t) cols * sizeof (MATRIX_TYPE));
+            }
+        }
+    } else {
+        int                lda = 0, ldb = 0;
+        const MATRIX_TYPE* a   = expr_tile (graph, node->a, trans, r0, c0, rows, cols,
+                                            NULL, 0, &lda);
+        const MATRIX_TYPE* b   = NULL;
+
+        if (a && node->b)
+            b = expr_tile (graph, node->b, trans, r0, c0, rows, cols, NULL, 0, &ldb);
+        if (!a || (node->b && !b)) res = -1;
+
+        for (int i = 0; res == 0 && i < rows; i++) {
+            const MATRIX_TYPE* a_i = a + (size_t) i * lda;
+            MATRIX_TYPE*       o_i = out + (size_t) i * ldo;
+            if (node->op == EXPR_ADD) ops->add (cols, a_i, b + (size_t) i * ldb, o_i);
+            else if (node->op == EXPR_SUB) ops->sub (cols, a_i, b + (size_t) i * ldb, o_i);
+            else {
+                for (int j = 0; j < cols; j++) o_i[j] = node->alpha * a_i[j];
+            }
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Возвращает плитку значения узла
+ *
+ * Плитка (r0, c0, rows x cols) берется из значения узла, транспонированного
+ * при trans = 1. Для поэлементных узлов транспонирование передается
+ * операндам, так как (a + b)^T = a^T + b^T. Плитка граничного узла без
+ * транспонирования читается на месте, остальные пишутся в out или в
+ * собственный буфер узла, который переиспользуется внутри одной плитки
+ * прохода, если на узел есть несколько ссылок.
+ *
+ * @param graph Граф
+ * @param node Узел
+ * @param trans Флаг транспонирования
+ * @param r0 Первая строка плитки
+ * @param c0 Первый столбец плитки
+ * @param rows Строк в плитке
+ * @param cols Столбцов в плитке
+ * @param out Куда записать плитку или NULL для собственного буфера узла
+ * @param ldo Шаг строки out
+ * @param ld Шаг строки возвращенной плитки
+ * @return Плитка или NULL при ошибке выделения памяти
+ */
+static const MATRIX_TYPE* expr_tile (ExprGraph* graph, Expr* node, int trans, int r0,
+                                     int c0, int rows, int cols, MATRIX_TYPE* out,
+                                     int ldo, int* ld) {
+    const MATRIX_TYPE* tile = NULL;
+    const int          own  = (out == NULL);   // Плитка в буфере узла
+    void*              buffer;
+
+    if (node->op == EXPR_TRANSPOSE && !node->ready) {
+        tile = expr_tile (graph, node->a, !trans, r0, c0, rows, cols, out, ldo, ld);
+    } else if (own && expr_is_boundary (node) && !trans) {
+        tile = expr_boundary_data (node, ld);
+        tile += (size_t) r0 * *ld + c0;
+    } else if (own && node->stamp[trans] == graph->tile_id) {
+        tile = node->tile[trans];
+        *ld  = EXPR_TILE;
+    } else {
+        if (own) {
+            if (!node->tile[trans] &&
+                posix_memalign (&buffer, MATRIX_ALIGNMENT,
+                                (size_t) EXPR_TILE * EXPR_TILE * sizeof (MATRIX_TYPE)) ==
+                    0)
+                node->tile[trans] = buffer;
+            out = node->tile[trans];
+            ldo = EXPR_TILE;
+        }
+        if (out && expr_tile_compute (graph, node, trans, r0, c0, rows, cols, out,
+                                      ldo) == 0) {
+            tile = out;
+            *ld  = ldo;
+            if (own) node->stamp[trans] = graph->tile_id;
+        }
+    }
+
+    return tile;
+}
+
+/**
+ * @brief Вычисляет значение узла в out
+ *
+ * Произведение пишется прямо в out только для корня всего выражения:
+ * результат перезаписывается последним, поэтому значение произведения
+ * доступно всем временным матрицам, вычисляемым до прохода.
+ *
+ * @param graph Граф
+ * @param node Узел
+ * @param out Выходные данные
+ * @param ldo Шаг строки out
+ * @param top 1 для корня выражения
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int expr_compute (ExprGraph* graph, Expr* node, MATRIX_TYPE* out, int ldo,
+                         int top) {
+    GemmEpilogue epilogue;
+    Expr*        mul = NULL;
+    int          res = 0;
+
+    if (node->op == EXPR_INPUT) {
+        for (int i = 0; i < node->rows; i++) {
+            memcpy (out + (size_t) i * ldo,
+                    node->input->block + (size_t) i * node->input->stride,
+                    (size_t) node->cols * sizeof (MATRIX_TYPE));
+        }
+    } else if (node->op == EXPR_MUL) {
+        res = expr_gemm (graph, node, out, ldo, NULL);
+    } else if ((mul = expr_match_epilogue (node, &epilogue)) != NULL) {
+        res = expr_gemm (graph, mul, out, ldo, &epilogue);
+    } else {
+        expr_mark_reach (node, 0);
+        graph->search++;
+        mul = top ? expr_find_in_place (graph, node) : NULL;
+        res = expr_prepare (graph, node, mul, out, ldo);
+
+        for (int r0 = 0; res == 0 && r0 < node->rows; r0 += EXPR_TILE) {
+            const int rows = (node->rows - r0 < EXPR_TILE) ? node->rows - r0 : EXPR_TILE;
+            for (int c0 = 0; res == 0 && c0 < node->cols; c0 += EXPR_TILE) {
+                const int cols = (node->cols - c0 < EXPR_TILE) ? node->cols - c0
+                                                               : EXPR_TILE;
+                int       ld   = 0;
+                graph->tile_id++;
+                if (!expr_tile (graph, node, 0, r0, c0, rows, cols,
+                                out + (size_t) r0 * ldo + c0, ldo, &ld))
+                    res = -1;
+            }
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Вычисляет выражение в матрицу result
+ *
+ * @param graph Граф
+ * @param root Корень выражения
+ * @param result Выводная матрица
+ * @return 0 при успехе, 1 при ошибке
+ */
+int expr_evaluate (ExprGraph* graph, Expr* root, Matrix* result) {
+    int res = 1;   // Флаг ошибок
+
+    if (graph && root && result && result->block && result->rows >= root->rows &&
+        result->cols >= root->cols) {
+        for (int i = 0; i < graph->count; i++) {
+            Expr* node = graph->nodes[i];
+            node->users = node->visited = node->prepared = node->ready = 0;
+            node->reach[0] = node->reach[1] = 0;
+            node->stamp[0] = node->stamp[1] = -1;
+            node->data                      = NULL;
+        }
+        graph->temporaries = 0;
+
+        expr_count_users (root);
+        if (expr_compute (graph, root, result->block, result->stride, 1) == 0) res = 0;
+
+        for (int i = 0; i < graph->count; i++) {
+            Expr* node = graph->nodes[i];
+            free_matrix (&node->temp);
+            free (node->tile[0]);
+            free (node->tile[1]);
+            node->tile[0] = node->tile[1] = NULL;
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file expr.h
+ * @brief Ленивые матричные выражения
+ *
+ * @details
+ * Выражение строится из узлов (сложение, вычитание, умножение,
+ * транспонирование, умножение на число) и вычисляется одним вызовом
+ * expr_evaluate. При вычислении:
+ * - одинаковые подвыражения объединяются уже при построении: повторный
+ *   вызов с теми же операндами возвращает существующий узел
+ * - транспонирование не копирует данные, а меняет порядок обхода:
+ *   поэлементные узлы читают транспонированные плитки, умножение
+ *   упаковывает панели из транспонированного операнда
+ * - цепочки поэлементных операций выполняются за один проход плитками
+ *   EXPR_TILE x EXPR_TILE, промежуточные значения живут только в плитках
+ * - временные матрицы создаются лишь для операндов умножения, которые
+ *   не являются входными матрицами, и для произведений, используемых
+ *   несколько раз; произведение, к которому применяются только
+ *   поэлементные операции, пишется сразу в результат, а шаблон
+ *   A x B + C - D^T выполняется одним умножением с эпилогом (gemm.h)
+ *
+ * Узлы принадлежат графу и освобождаются вместе с ним. Входные матрицы
+ * не копируются и должны жить до вычисления.
+ *
+ * @see matrix.h gemm.h
+ */
+
+#ifndef EXPR_H
+#define EXPR_H
+
+#include "matrix.h"
+
+/**
+ * @enum ExprOp
+ * @brief Операция узла
+ */
+typedef enum {
+    EXPR_INPUT,       ///< Входная матрица
+    EXPR_ADD,         ///< a + b
+    EXPR_SUB,         ///< a - b
+    EXPR_MUL,         ///< a x b
+    EXPR_TRANSPOSE,   ///< a^T
+    EXPR_SCALE,       ///< alpha * a
+} ExprOp;
+
+/** Узел выражения */
+typedef struct Expr Expr;
+
+/** Граф выражений, владеющий узлами */
+typedef struct ExprGraph ExprGraph;
+
+/**
+ * @brief Создает пустой граф
+ * @return Граф или NULL при ошибке выделения памяти
+ */
+ExprGraph* expr_graph_create (void);
+
+/**
+ * @brief Освобождает граф и все его узлы
+ * @param graph Граф или NULL
+ */
+void expr_graph_free (ExprGraph* graph);
+
+/**
+ * @brief Узел входной матрицы
+ * @param graph Граф
+ * @param matrix Матрица (не копируется)
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_input (ExprGraph* graph, const Matrix* matrix);
+
+/**
+ * @brief Узел суммы a + b
+ * @param graph Граф
+ * @param a Первый операнд
+ * @param b Второй операнд того же размера
+ * @return Узел или NULL при ошибке (в том числе если операнд NULL)
+ */
+Expr* expr_add (ExprGraph* graph, Expr* a, Expr* b);
+
+/**
+ * @brief Узел разности a - b
+ * @param graph Граф
+ * @param a Уменьшаемое
+ * @param b Вычитаемое того же размера
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_sub (ExprGraph* graph, Expr* a, Expr* b);
+
+/**
+ * @brief Узел произведения a x b
+ * @param graph Граф
+ * @param a Первый операнд
+ * @param b Второй операнд, строк столько же, сколько столбцов в a
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_mul (ExprGraph* graph, Expr* a, Expr* b);
+
+/**
+ * @brief Узел транспонирования a^T
+ * @param graph Граф
+ * @param a Операнд
+ * @note (a^T)^T возвращает сам a
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_transpose (ExprGraph* graph, Expr* a);
+
+/**
+ * @brief Узел умножения на число alpha * a
+ * @param graph Граф
+ * @param a Операнд
+ * @param alpha Множитель
+ * @return Узел или NULL при ошибке
+ */
+Expr* expr_scale (ExprGraph* graph, Expr* a, MATRIX_TYPE alpha);
+
+/**
+ * @brief Строит выражение по текстовой записи, например "A*B+C-D^T"
+ * @param graph Граф
+ * @param text Запись: имена матриц, числа, скобки, бинарные +, -, *,
+ *             унарный минус и транспонирование ^T; пробелы допускаются
+ * @param names Имена входных матриц (буквы, цифры и _, не с цифры)
+ * @param inputs Матрицы с этими именами (не копируются)
+ * @param count Количество имен
+ * @note Число в произведении дает узел EXPR_SCALE (2*A, A*0.5). Узлы,
+ *       созданные до ошибки, остаются в графе
+ * @return Корень выражения или NULL при синтаксической ошибке, неизвестном
+ *         имени, несогласованных размерах или значении-числе
+ */
+Expr* expr_parse (ExprGraph* graph, const char* text, const char* const* names,
+                  const Matrix* const* inputs, int count);
+
+/**
+ * @brief Число строк значения узла
+ * @param expr Узел
+ * @return Число строк или 0 для NULL
+ */
+int expr_rows (const Expr* expr);
+
+/**
+ * @brief Число столбцов значения узла
+ * @param expr Узел
+ * @return Число столбцов или 0 для NULL
+ */
+int expr_cols (const Expr* expr);
+
+/**
+ * @brief Число различных узлов в графе
+ * @param graph Граф
+ * @return Количество узлов
+ */
+int expr_node_count (const ExprGraph* graph);
+
+/**
+ * @brief Число временных матриц, созданных последним expr_evaluate
+ * @param graph Граф
+ * @return Количество временных матриц
+ */
+int expr_temporaries (const ExprGraph* graph);
+
+/**
+ * @brief Вычисляет выражение в матрицу result
+ * @param graph Граф
+ * @param root Корень выражения
+ * @param result Выводная матрица не меньше значения корня
+ * @note result не должна совпадать с входными матрицами выражения
+ * @return 0 при успехе, 1 при ошибке
+ */
+int expr_evaluate (ExprGraph* graph, Expr* root, Matrix* result);
+
+#endif   // EXPR_H
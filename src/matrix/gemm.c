@@ -0,0 +1,617 @@
+/**
+ * @file gemm.c
+ * @brief Реализация блочного умножения матриц
+ *
+ * @details
+ * Порядок циклов (снаружи внутрь):
+ * - jc: блоки по GEMM_NC столбцов B и C
+ * - pc: блоки по GEMM_KC вдоль общей размерности, упаковка B
+ * - ic: блоки по GEMM_MC строк A и C, упаковка A
+ * - jr, ir: плитки NR x MR, вызов микроядра
+ *
+ * Для больших произведений пары (блок строк, полоса столбцов) выполняются
+ * как задачи пула потоков; каждый поток упаковывает A в собственный буфер.
+ *
+ * Эпилог (GemmEpilogue) применяется к плитке сразу после последнего блока
+ * по k, пока плитка находится в кэше.
+ *
+ * Множитель alpha применяется при упаковке A, множитель beta - к блоку C
+ * перед первым блоком по k той же задачей, которая затем накапливает в
+ * него произведение; при beta = 0 старое содержимое C не читается.
+ *
+ * @see gemm.h
+ */
+
+#include "gemm.h"
+
+#include "../metrics/metrics.h"
+#include "../parallel/thread_pool.h"
+#include "simd.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief Адрес элемента (row, col) операнда с учетом транспонирования
+ *
+ * @param data Элементы операнда
+ * @param ld Шаг строки хранимой матрицы
+ * @param trans 1, если хранится транспонированный операнд
+ * @param row Строка операнда
+ * @param col Столбец операнда
+ * @return Указатель на элемент
+ */
+static inline const MATRIX_TYPE* gemm_at (const MATRIX_TYPE* data, int ld, int trans,
+                                          int row, int col) {
+    return trans ? data + (size_t) col * ld + row : data + (size_t) row * ld + col;
+}
+
+/**
+ * @brief Упаковывает блок A (mc x kc) в панели по mr строк
+ *
+ * Строки за пределами блока заполняются нулями. Транспонированный блок
+ * хранится по столбцам, и его упаковка читает память подряд.
+ *
+ * @param mc Строк в блоке
+ * @param kc Столбцов в блоке
+ * @param alpha Множитель элементов
+ * @param A Начало блока
+ * @param lda Шаг строки A
+ * @param trans 1, если A хранится транспонированной
+ * @param mr Высота панели
+ * @param pack Буфер упаковки
+ */
+static void gemm_pack_a (int mc, int kc, MATRIX_TYPE alpha, const MATRIX_TYPE* A,
+                         int lda, int trans, int mr, MATRIX_TYPE* pack) {
+    for (int ir = 0; ir < mc; ir += mr) {
+        const int rows = (mc - ir < mr) ? mc - ir : mr;
+        if (trans) {
+            for (int p = 0; p < kc; p++) {
+                const MATRIX_TYPE* src = A + (size_t) p * lda + ir;
+                int                i   = 0;
+                for (; i < rows; i++) pack[p * mr + i] = alpha * src[i];
+                for (; i < mr; i++) pack[p * mr + i] = 0;
+            }
+        } else {
+            for (int i = 0; i < mr; i++) {
+                if (i < rows) {
+                    const MATRIX_TYPE* src = A + (size_t) (ir + i) * lda;
+                    for (int p = 0; p < kc; p++) pack[p * mr + i] = alpha * src[p];
+                } else {
+                    for (int p = 0; p < kc; p++) pack[p * mr + i] = 0;
+                }
+            }
+        }
+        pack += (size_t) kc * mr;
+    }
+}
+
+/**
+ * @brief Упаковывает блок B (kc x nc) в панели по nr столбцов
+ *
+ * Столбцы за пределами блока заполняются нулями.
+ *
+ * @param kc Строк в блоке
+ * @param nc Столбцов в блоке
+ * @param B Начало блока
+ * @param ldb Шаг строки B
+ * @param trans 1, если B хранится транспонированной
+ * @param nr Ширина панели
+ * @param pack Буфер упаковки
+ */
+static void gemm_pack_b (int kc, int nc, const MATRIX_TYPE* B, int ldb, int trans,
+                         int nr, MATRIX_TYPE* pack) {
+    for (int jr = 0; jr < nc; jr += nr) {
+        const int cols = (nc - jr < nr) ? nc - jr : nr;
+        if (trans) {
+            for (int j = 0; j < nr; j++) {
+                const MATRIX_TYPE* src = B + (size_t) (jr + j) * ldb;
+                if (j < cols) {
+                    for (int p = 0; p < kc; p++) pack[p * nr + j] = src[p];
+                } else {
+                    for (int p = 0; p < kc; p++) pack[p * nr + j] = 0;
+                }
+            }
+        } else {
+            for (int p = 0; p < kc; p++) {
+                const MATRIX_TYPE* src = B + (size_t) p * ldb + jr;
+                MATRIX_TYPE*       dst = pack + (size_t) p * nr;
+                int                j   = 0;
+                for (; j < cols; j++) dst[j] = src[j];
+                for (; j < nr; j++) dst[j] = 0;
+            }
+        }
+        pack += (size_t) kc * nr;
+    }
+}
+
+/**
+ * @brief Применяет эпилог к плитке результата
+ *
+ * @param epilogue Слагаемые эпилога
+ * @param rows Строк в плитке
+ * @param cols Столбцов в плитке
+ * @param row Первая строка плитки в C
+ * @param col Первый столбец плитки в C
+ * @param c Плитка результата
+ * @param ldc Шаг строки C
+ */
+static void gemm_apply_epilogue (const GemmEpilogue* epilogue, int rows, int cols,
+                                 int row, int col, MATRIX_TYPE* c, int ldc) {
+    if (epilogue->add) {
+        for (int i = 0; i < rows; i++) {
+            const MATRIX_TYPE* add =
+                epilogue->add + (size_t) (row + i) * epilogue->ld_add + col;
+            MATRIX_TYPE* c_i = c + (size_t) i * ldc;
+            for (int j = 0; j < cols; j++) c_i[j] += add[j];
+        }
+    }
+    if (epilogue->sub_t) {
+        // Строка sub_t дает столбец плитки: читаем подряд по i
+        for (int j = 0; j < cols; j++) {
+            const MATRIX_TYPE* sub =
+                epilogue->sub_t + (size_t) (col + j) * epilogue->ld_sub_t + row;
+            for (int i = 0; i < rows; i++) c[(size_t) i * ldc + j] -= sub[i];
+        }
+    }
+}
+
+/**
+ * @brief Умножает упакованные блоки и записывает плитки в C
+ *
+ * @param kernel Микроядро
+ * @param mc Строк в блоке
+ * @param nc Столбцов в блоке
+ * @param kc Длина общей размерности блока
+ * @param pack_a Упакованная A
+ * @param pack_b Упакованная B
+ * @param C Начало блока результата
+ * @param ldc Шаг строки C
+ * @param accumulate Флаг накопления
+ * @param epilogue Эпилог для последнего блока по k или NULL
+ * @param row Первая строка блока в C
+ * @param col Первый столбец блока в C
+ */
+static void gemm_macro_kernel (const GemmKernel* kernel, int mc, int nc, int kc,
+                               const MATRIX_TYPE* pack_a, const MATRIX_TYPE* pack_b,
+                               MATRIX_TYPE* C, int ldc, int accumulate,
+                               const GemmEpilogue* epilogue, int row, int col) {
+    const int   mr = kernel->mr;
+    const int   nr = kernel->nr;
+    MATRIX_TYPE edge[GEMM_MAX_MR * GEMM_MAX_NR];   // Плитка для краев
+
+    for (int jr = 0; jr < nc; jr += nr) {
+        const int          cols = (nc - jr < nr) ? nc - jr : nr;
+        const MATRIX_TYPE* b    = pack_b + (size_t) jr * kc;
+        for (int ir = 0; ir < mc; ir += mr) {
+            const int          rows = (mc - ir < mr) ? mc - ir : mr;
+            const MATRIX_TYPE* a    = pack_a + (size_t) ir * kc;
+            MATRIX_TYPE*       c    = C + (size_t) ir * ldc + jr;
+
+            if (rows == mr && cols == nr) {
+                kernel->kernel (kc, a, b, c, ldc, accumulate);
+            } else {
+                // Краевая плитка: считаем целиком и копируем нужную часть
+                kernel->kernel (kc, a, b, edge, nr, 0);
+                for (int i = 0; i < rows; i++) {
+                    MATRIX_TYPE* c_i = c + (size_t) i * ldc;
+                    for (int j = 0; j < cols; j++) {
+                        if (accumulate) c_i[j] += edge[i * nr + j];
+                        else c_i[j] = edge[i * nr + j];
+                    }
+                }
+            }
+            if (epilogue)
+                gemm_apply_epilogue (epilogue, rows, cols, row + ir, col + jr, c, ldc);
+        }
+    }
+}
+
+/**
+ * @brief Умножение без упаковки для маленьких матриц
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param alpha Множитель произведения
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param trans_a 1, если A хранится транспонированной
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param trans_b 1, если B хранится транспонированной
+ * @param beta Множитель прежнего C
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ * @param epilogue Эпилог или NULL
+ */
+static void gemm_small (int m, int n, int k, MATRIX_TYPE alpha, const MATRIX_TYPE* A,
+                        int lda, int trans_a, const MATRIX_TYPE* B, int ldb,
+                        int trans_b, MATRIX_TYPE beta, MATRIX_TYPE* C, int ldc,
+                        const GemmEpilogue* epilogue) {
+    for (int row = 0; row < m; row++) {
+        MATRIX_TYPE* c = C + (size_t) row * ldc;
+        for (int col = 0; col < n; col++) c[col] = beta == 0 ? 0 : beta * c[col];
+        for (int p = 0; p < k; p++) {
+            const MATRIX_TYPE a_p = alpha * *gemm_at (A, lda, trans_a, row, p);
+            if (trans_b) {
+                for (int col = 0; col < n; col++)
+                    c[col] += a_p * B[(size_t) col * ldb + p];
+            } else {
+                const MATRIX_TYPE* b = B + (size_t) p * ldb;
+                for (int col = 0; col < n; col++) c[col] += a_p * b[col];
+            }
+        }
+        if (epilogue) gemm_apply_epilogue (epilogue, 1, n, row, 0, c, ldc);
+    }
+}
+
+/**
+ * @struct GemmContext
+ * @brief Общее состояние задач одного умножения
+ */
+typedef struct {
+    const GemmKernel*   kernel;     ///< Микроядро
+    int                 m;          ///< Строк в A и C
+    int                 k;          ///< Общая размерность
+    const MATRIX_TYPE*  A;          ///< Элементы A
+    int                 lda;        ///< Шаг строки A
+    int                 trans_a;    ///< A хранится транспонированной
+    const MATRIX_TYPE*  B;          ///< Элементы B
+    int                 ldb;        ///< Шаг строки B
+    int                 trans_b;    ///< B хранится транспонированной
+    MATRIX_TYPE*        C;          ///< Элементы C
+    int                 ldc;        ///< Шаг строки C
+    MATRIX_TYPE         alpha;      ///< Множитель произведения
+    MATRIX_TYPE         beta;       ///< Множитель прежнего C
+    int                 jc;         ///< Первый столбец текущего блока B
+    int                 nc;         ///< Столбцов в текущем блоке B
+    int                 pc;         ///< Начало текущего блока по k
+    int                 kc;         ///< Длина текущего блока по k
+    int                 chunk;      ///< Ширина полосы столбцов одной задачи
+    int                 chunks;     ///< Полос в блоке B
+    MATRIX_TYPE*        pack_b;     ///< Упакованный блок B
+    MATRIX_TYPE**       pack_a;     ///< Буферы упаковки A по потокам
+    const GemmEpilogue* epilogue;   ///< Эпилог или NULL
+} GemmContext;
+
+/**
+ * @brief Задача: упаковать полосу столбцов блока B
+ *
+ * @param arg Контекст умножения
+ * @param task Номер полосы
+ * @param worker Номер потока (не используется)
+ */
+static void gemm_pack_b_task (void* arg, int task, int worker) {
+    GemmContext* ctx  = arg;
+    const int    jr   = task * ctx->chunk;
+    const int    cols = (ctx->nc - jr < ctx->chunk) ? ctx->nc - jr : ctx->chunk;
+
+    (void) worker;
+    gemm_pack_b (ctx->kc, cols,
+                 gemm_at (ctx->B, ctx->ldb, ctx->trans_b, ctx->pc, ctx->jc + jr),
+                 ctx->ldb, ctx->trans_b, ctx->kernel->nr,
+                 ctx->pack_b + (size_t) jr * ctx->kc);
+}
+
+/**
+ * @brief Задача: плитки результата для блока строк и полосы столбцов
+ *
+ * Плитки каждой задачи выровнены по MR и NR так же, как в
+ * последовательном проходе, поэтому результат не зависит от числа потоков.
+ * На первом блоке по k задача умножает свой блок C на beta (при beta = 0
+ * микроядро перезаписывает блок без чтения).
+ *
+ * @param arg Контекст умножения
+ * @param task Номер задачи (блок строк * chunks + полоса)
+ * @param worker Номер потока, выбирает буфер упаковки A
+ */
+static void gemm_compute_task (void* arg, int task, int worker) {
+    GemmContext* ctx  = arg;
+    const int    ic   = (task / ctx->chunks) * GEMM_MC;
+    const int    jr   = (task % ctx->chunks) * ctx->chunk;
+    const int    mc   = (ctx->m - ic < GEMM_MC) ? ctx->m - ic : GEMM_MC;
+    const int    cols = (ctx->nc - jr < ctx->chunk) ? ctx->nc - jr : ctx->chunk;
+
+    MATRIX_TYPE* c = ctx->C + (size_t) ic * ctx->ldc + ctx->jc + jr;
+
+    if (ctx->pc == 0 && ctx->beta != 0 && ctx->beta != 1) {
+        for (int i = 0; i < mc; i++) {
+            MATRIX_TYPE* c_i = c + (size_t) i * ctx->ldc;
+            for (int j = 0; j < cols; j++) c_i[j] *= ctx->beta;
+        }
+    }
+    gemm_pack_a (mc, ctx->kc, ctx->alpha,
+                 gemm_at (ctx->A, ctx->lda, ctx->trans_a, ic, ctx->pc), ctx->lda,
+                 ctx->trans_a, ctx->kernel->mr, ctx->pack_a[worker]);
+    gemm_macro_kernel (ctx->kernel, mc, cols, ctx->kc, ctx->pack_a[worker],
+                       ctx->pack_b + (size_t) jr * ctx->kc, c, ctx->ldc,
+                       ctx->pc > 0 || ctx->beta != 0,
+                       (ctx->pc + ctx->kc == ctx->k) ? ctx->epilogue : NULL, ic,
+                       ctx->jc + jr);
+}
+
+/**
+ * @brief Вычисляет C = A x B блочным алгоритмом
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ *
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                   const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc) {
+    return gemm_multiply_epilogue (m, n, k, A, lda, B, ldb, C, ldc, NULL);
+}
+
+/**
+ * @brief Вычисляет C = A x B + add - sub_t^T блочным алгоритмом
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ * @param epilogue Эпилог или NULL
+ *
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_epilogue (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                            const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc,
+                            const GemmEpilogue* epilogue) {
+    return gemm_multiply_trans (m, n, k, A, lda, 0, B, ldb, 0, C, ldc, epilogue);
+}
+
+/**
+ * @brief Вычисляет C = op(A) x op(B) + эпилог блочным алгоритмом
+ *
+ * Буферы упаковки выделяются в куче (см. gemm_multiply_arena).
+ *
+ * @param m Строк в op(A) и C
+ * @param n Столбцов в op(B) и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param trans_a 1, если A хранится транспонированной
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param trans_b 1, если B хранится транспонированной
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ * @param epilogue Эпилог или NULL
+ *
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_trans (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                         int trans_a, const MATRIX_TYPE* B, int ldb, int trans_b,
+                         MATRIX_TYPE* C, int ldc, const GemmEpilogue* epilogue) {
+    return gemm_multiply_arena (m, n, k, A, lda, trans_a, B, ldb, trans_b, C, ldc,
+                                epilogue, NULL);
+}
+
+/**
+ * @brief Выделяет буфер упаковки из арены или из кучи
+ *
+ * @param arena Арена или NULL
+ * @param count Число элементов
+ *
+ * @return Выровненный буфер или NULL при ошибке
+ */
+static MATRIX_TYPE* gemm_buffer (MatrixArena* arena, size_t count) {
+    void*        buffer = NULL;
+    const size_t bytes  = count * sizeof (MATRIX_TYPE);
+
+    if (arena) buffer = arena_alloc (arena, bytes);
+    else if (posix_memalign (&buffer, MATRIX_ALIGNMENT, bytes) != 0) buffer = NULL;
+    else METRICS_ALLOCATION ();
+
+    return buffer;
+}
+
+/**
+ * @brief Вычисляет C = op(A) x op(B) + эпилог с буферами из арены
+ *
+ * @param m Строк в op(A) и C
+ * @param n Столбцов в op(B) и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param trans_a 1, если A хранится транспонированной
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param trans_b 1, если B хранится транспонированной
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ * @param epilogue Эпилог или NULL
+ * @param arena Арена для буферов упаковки или NULL для кучи
+ *
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_arena (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                         int trans_a, const MATRIX_TYPE* B, int ldb, int trans_b,
+                         MATRIX_TYPE* C, int ldc, const GemmEpilogue* epilogue,
+                         MatrixArena* arena) {
+    return gemm_multiply_scaled (m, n, k, 1, A, lda, trans_a, B, ldb, trans_b, 0, C,
+                                 ldc, epilogue, arena);
+}
+
+/**
+ * @brief Вычисляет C = alpha * op(A) x op(B) + beta * C + эпилог
+ *
+ * Маленькие произведения (меньше GEMM_PARALLEL_THRESHOLD) выполняются в
+ * вызывающем потоке, остальные делят плитки результата между потоками
+ * пула (см. thread_pool.h). Транспонирование операндов учитывается при
+ * упаковке панелей.
+ *
+ * @param m Строк в op(A) и C
+ * @param n Столбцов в op(B) и C
+ * @param k Общая размерность
+ * @param alpha Множитель произведения
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param trans_a 1, если A хранится транспонированной
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param trans_b 1, если B хранится транспонированной
+ * @param beta Множитель прежнего C (0 - C не читается)
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ * @param epilogue Эпилог или NULL
+ * @param arena Арена для буферов упаковки или NULL для кучи
+ *
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_scaled (int m, int n, int k, MATRIX_TYPE alpha,
+                          const MATRIX_TYPE* A, int lda, int trans_a,
+                          const MATRIX_TYPE* B, int ldb, int trans_b,
+                          MATRIX_TYPE beta, MATRIX_TYPE* C, int ldc,
+                          const GemmEpilogue* epilogue, MatrixArena* arena) {
+    GemmContext  ctx = {.kernel   = simd_ops ()->gemm,
+                        .m        = m,
+                        .k        = k,
+                        .A        = A,
+                        .lda      = lda,
+                        .trans_a  = trans_a,
+                        .B        = B,
+                        .ldb      = ldb,
+                        .trans_b  = trans_b,
+                        .C        = C,
+                        .ldc      = ldc,
+                        .alpha    = alpha,
+                        .beta     = beta,
+                        .epilogue = epilogue};
+    MATRIX_TYPE* pack_a[THREAD_POOL_MAX_THREADS] = {NULL};
+    ArenaMark    mark    = arena_mark (arena);   // Позиция арены до буферов
+    int          threads = 1;   // Потоков для этого умножения
+    int          res     = 0;   // Результат выполнения
+    char         packed  = 0;   // Флаг блочного пути с упаковкой
+
+    if (m > 0 && n > 0) {
+        if ((long long) m * n * k <= GEMM_SMALL_THRESHOLD) {
+            gemm_small (m, n, k, alpha, A, lda, trans_a, B, ldb, trans_b, beta, C,
+                        ldc, epilogue);
+        } else {
+            packed = 1;
+        }
+    }
+
+    if (packed) {
+        const int mr = ctx.kernel->mr;
+        const int nr = ctx.kernel->nr;
+        const int mc = m < GEMM_MC ? m : GEMM_MC;
+        const int nc = n < GEMM_NC ? n : GEMM_NC;
+        const int kc = k < GEMM_KC ? k : GEMM_KC;
+
+        if ((long long) m * n * k >= GEMM_PARALLEL_THRESHOLD)
+            threads = thread_pool_threads ();
+
+        // Буферы упаковки по фактическим размерам, округленным до плитки
+        const size_t size_a = (size_t) ((mc + mr - 1) / mr * mr) * kc;
+        const size_t size_b = (size_t) ((nc + nr - 1) / nr * nr) * kc;
+
+        for (int i = 0; i < threads && res == 0; i++) {
+            pack_a[i] = gemm_buffer (arena, size_a);
+            if (pack_a[i] == NULL) res = -1;
+        }
+        if (res == 0) ctx.pack_b = gemm_buffer (arena, size_b);
+        if (ctx.pack_b == NULL) res = -1;
+        ctx.pack_a = pack_a;
+    }
+
+    for (int jc = 0; packed && res == 0 && jc < n; jc += GEMM_NC) {
+        const int nr       = ctx.kernel->nr;
+        const int m_blocks = (m + GEMM_MC - 1) / GEMM_MC;
+        ctx.jc             = jc;
+        ctx.nc             = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+
+        // Полосы столбцов: около двух задач на поток, ширина кратна NR
+        ctx.chunks = (2 * threads + m_blocks - 1) / m_blocks;
+        if (threads == 1) ctx.chunks = 1;
+        ctx.chunk  = (ctx.nc + ctx.chunks - 1) / ctx.chunks;
+        ctx.chunk  = (ctx.chunk + nr - 1) / nr * nr;
+        ctx.chunks = (ctx.nc + ctx.chunk - 1) / ctx.chunk;
+
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            ctx.pc = pc;
+            ctx.kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            if (threads > 1) {
+                thread_pool_run (ctx.chunks, gemm_pack_b_task, &ctx);
+                thread_pool_run (m_blocks * ctx.chunks, gemm_compute_task, &ctx);
+            } else {
+                gemm_pack_b_task (&ctx, 0, 0);
+                for (int task = 0; task < m_blocks; task++) {
+                    gemm_compute_task (&ctx, task, 0);
+                }
+            }
+        }
+    }
+
+    if (arena) arena_reset (arena, mark);
+    else {
+        for (int i = 0; i < threads; i++) free (pack_a[i]);
+        free (ctx.pack_b);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Применяет эпилог к C без произведения
+ *
+ * C обходится плитками TRANSPOSE_TILE x TRANSPOSE_TILE: столбец плитки
+ * читает из sub_t подряд TRANSPOSE_TILE элементов, и строки sub_t,
+ * нужные плитке, остаются в кэше, пока плитка не обработана.
+ *
+ * @param m Строк в C
+ * @param n Столбцов в C
+ * @param epilogue Слагаемые эпилога
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ */
+void gemm_epilogue (int m, int n, const GemmEpilogue* epilogue, MATRIX_TYPE* C,
+                    int ldc) {
+    for (int row = 0; epilogue && row < m; row += TRANSPOSE_TILE) {
+        const int rows = m - row < TRANSPOSE_TILE ? m - row : TRANSPOSE_TILE;
+        for (int col = 0; col < n; col += TRANSPOSE_TILE) {
+            const int cols = n - col < TRANSPOSE_TILE ? n - col : TRANSPOSE_TILE;
+            gemm_apply_epilogue (epilogue, rows, cols, row, col,
+                                 C + (size_t) row * ldc + col, ldc);
+        }
+    }
+}
+
+/**
+ * @brief Эталонное умножение тройным циклом i-j-k
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ */
+void gemm_reference (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                     const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc) {
+    for (int row = 0; row < m; row++) {
+        for (int col = 0; col < n; col++) {
+            MATRIX_TYPE sum = 0;
+            for (int p = 0; p < k; p++) {
+                sum += A[(size_t) row * lda + p] * B[(size_t) p * ldb + col];
+            }
+            C[(size_t) row * ldc + col] = sum;
+        }
+    }
+}
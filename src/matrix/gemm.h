@@ -0,0 +1,240 @@
+/**
+ * @file gemm.h
+ * @brief Блочное умножение матриц с упаковкой панелей
+ *
+ * @details
+ * Реализация в духе BLIS/GotoBLAS:
+ * - Блок B размером GEMM_KC x GEMM_NC упаковывается в панели по NR столбцов
+ * - Блок A размером GEMM_MC x GEMM_KC упаковывается в панели по MR строк
+ * - Микроядро вычисляет плитку MR x NR результата в регистрах; реализация
+ *   выбирается во время выполнения (см. simd.h)
+ * - Неполные плитки на краях дополняются нулями при упаковке и
+ *   записываются через временную плитку
+ *
+ * Точность: результат отличается от эталонного цикла gemm_reference только
+ * порядком суммирования, поэтому для каждого элемента выполняется
+ * |C - C_ref| <= GEMM_TOLERANCE (k) * sum_p |A[i][p]| * |B[p][j]|.
+ *
+ * @see matrix.h
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include "../../include/config.h"
+#include "arena.h"
+
+#include <float.h>
+
+/** Максимальное число строк плитки микроядра */
+#define GEMM_MAX_MR 16
+
+/** Максимальное число столбцов плитки микроядра */
+#define GEMM_MAX_NR 32
+
+/**
+ * @brief Относительная погрешность блочного умножения по сравнению с эталоном
+ * @param k Длина скалярного произведения
+ */
+#define GEMM_TOLERANCE(k) (2.0 * (double) (k) * DBL_EPSILON)
+
+/**
+ * @brief Микроядро: плитка MR x NR по упакованным панелям
+ * @param kc Длина панелей
+ * @param a Панель A (kc столбцов по MR элементов)
+ * @param b Панель B (kc строк по NR элементов)
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки результата
+ * @param accumulate 0 - записать результат, иначе прибавить к плитке
+ */
+typedef void (*gemm_kernel_fn) (int kc, const MATRIX_TYPE* a, const MATRIX_TYPE* b,
+                                MATRIX_TYPE* c, int ldc, int accumulate);
+
+/**
+ * @struct GemmKernel
+ * @brief Описание микроядра и размеров его плитки
+ */
+typedef struct {
+    const char*    name;     ///< Имя реализации
+    int            mr;       ///< Строк в плитке
+    int            nr;       ///< Столбцов в плитке
+    gemm_kernel_fn kernel;   ///< Функция микроядра
+} GemmKernel;
+
+/**
+ * @brief Микроядро float: плитка MR x NR по упакованным панелям
+ * @param kc Длина панелей
+ * @param a Панель A (kc столбцов по MR элементов)
+ * @param b Панель B (kc строк по NR элементов)
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки результата
+ * @param accumulate 0 - записать результат, иначе прибавить к плитке
+ */
+typedef void (*gemm_kernel_f32_fn) (int kc, const float* a, const float* b, float* c,
+                                    int ldc, int accumulate);
+
+/**
+ * @struct GemmKernelF32
+ * @brief Описание микроядра float (typed.h) и размеров его плитки
+ */
+typedef struct {
+    const char*        name;     ///< Имя реализации
+    int                mr;       ///< Строк в плитке
+    int                nr;       ///< Столбцов в плитке
+    gemm_kernel_f32_fn kernel;   ///< Функция микроядра
+} GemmKernelF32;
+
+/**
+ * @struct GemmEpilogue
+ * @brief Слагаемые, применяемые к плитке результата сразу после умножения
+ *
+ * Итог: C[i][j] = (A x B)[i][j] + add[i][j] - sub_t[j][i]. Порядок операций
+ * совпадает с последовательными add_matrices и subtract_matrices, поэтому
+ * результат совпадает с ними побитово. Любой из указателей может быть NULL.
+ */
+typedef struct {
+    const MATRIX_TYPE* add;        ///< Прибавляемая матрица m x n или NULL
+    int                ld_add;     ///< Шаг строки add
+    const MATRIX_TYPE* sub_t;      ///< Вычитаемая транспонированная n x m или NULL
+    int                ld_sub_t;   ///< Шаг строки sub_t
+} GemmEpilogue;
+
+/**
+ * @brief Вычисляет C = A x B блочным алгоритмом
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Столбцов в A и строк в B
+ * @param A Элементы A с шагом lda
+ * @param lda Шаг строки A
+ * @param B Элементы B с шагом ldb
+ * @param ldb Шаг строки B
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ * @note C не должна пересекаться с A и B
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                   const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc);
+
+/**
+ * @brief Вычисляет C = A x B + add - sub_t^T за один проход по C
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Столбцов в A и строк в B
+ * @param A Элементы A с шагом lda
+ * @param lda Шаг строки A
+ * @param B Элементы B с шагом ldb
+ * @param ldb Шаг строки B
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ * @param epilogue Слагаемые эпилога или NULL
+ * @note C не должна пересекаться с A, B и матрицами эпилога
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_epilogue (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                            const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc,
+                            const GemmEpilogue* epilogue);
+
+/**
+ * @brief Вычисляет C = op(A) x op(B) с эпилогом, op - транспонирование
+ * @param m Строк в op(A) и C
+ * @param n Столбцов в op(B) и C
+ * @param k Столбцов в op(A) и строк в op(B)
+ * @param A Элементы A с шагом lda (k x m при trans_a)
+ * @param lda Шаг строки A
+ * @param trans_a 1, если A хранится транспонированной
+ * @param B Элементы B с шагом ldb (n x k при trans_b)
+ * @param ldb Шаг строки B
+ * @param trans_b 1, если B хранится транспонированной
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ * @param epilogue Слагаемые эпилога или NULL
+ * @note Транспонирование выполняется при упаковке панелей, без копий
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_trans (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                         int trans_a, const MATRIX_TYPE* B, int ldb, int trans_b,
+                         MATRIX_TYPE* C, int ldc, const GemmEpilogue* epilogue);
+
+/**
+ * @brief Вычисляет C = op(A) x op(B) с эпилогом, буферы упаковки - из арены
+ * @param m Строк в op(A) и C
+ * @param n Столбцов в op(B) и C
+ * @param k Столбцов в op(A) и строк в op(B)
+ * @param A Элементы A с шагом lda (k x m при trans_a)
+ * @param lda Шаг строки A
+ * @param trans_a 1, если A хранится транспонированной
+ * @param B Элементы B с шагом ldb (n x k при trans_b)
+ * @param ldb Шаг строки B
+ * @param trans_b 1, если B хранится транспонированной
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ * @param epilogue Слагаемые эпилога или NULL
+ * @param arena Арена или NULL для выделения в куче
+ * @note Позиция арены восстанавливается перед выходом
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_arena (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                         int trans_a, const MATRIX_TYPE* B, int ldb, int trans_b,
+                         MATRIX_TYPE* C, int ldc, const GemmEpilogue* epilogue,
+                         MatrixArena* arena);
+
+/**
+ * @brief Вычисляет C = alpha * op(A) x op(B) + beta * C с эпилогом
+ * @param m Строк в op(A) и C
+ * @param n Столбцов в op(B) и C
+ * @param k Столбцов в op(A) и строк в op(B)
+ * @param alpha Множитель произведения
+ * @param A Элементы A с шагом lda (k x m при trans_a)
+ * @param lda Шаг строки A
+ * @param trans_a 1, если A хранится транспонированной
+ * @param B Элементы B с шагом ldb (n x k при trans_b)
+ * @param ldb Шаг строки B
+ * @param trans_b 1, если B хранится транспонированной
+ * @param beta Множитель прежнего содержимого C
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ * @param epilogue Слагаемые эпилога или NULL (не умножаются на alpha)
+ * @param arena Арена или NULL для выделения в куче
+ * @note При beta = 0 содержимое C не читается, поэтому оно может быть
+ *       неинициализированным. C не должна пересекаться с A, B и
+ *       матрицами эпилога
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int gemm_multiply_scaled (int m, int n, int k, MATRIX_TYPE alpha,
+                          const MATRIX_TYPE* A, int lda, int trans_a,
+                          const MATRIX_TYPE* B, int ldb, int trans_b,
+                          MATRIX_TYPE beta, MATRIX_TYPE* C, int ldc,
+                          const GemmEpilogue* epilogue, MatrixArena* arena);
+
+/**
+ * @brief Вычисляет C += add - sub_t^T без умножения, плитками
+ * @param m Строк в C
+ * @param n Столбцов в C
+ * @param epilogue Слагаемые эпилога
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ * @note Плитки TRANSPOSE_TILE x TRANSPOSE_TILE обрабатываются тем же кодом,
+ *       что эпилог умножения, поэтому результат совпадает с add_matrices и
+ *       subtract_matrices побитово. add может совпадать с C, sub_t не должна
+ *       пересекаться с C
+ */
+void gemm_epilogue (int m, int n, const GemmEpilogue* epilogue, MATRIX_TYPE* C,
+                    int ldc);
+
+/**
+ * @brief Эталонное умножение тройным циклом i-j-k
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Столбцов в A и строк в B
+ * @param A Элементы A с шагом lda
+ * @param lda Шаг строки A
+ * @param B Элементы B с шагом ldb
+ * @param ldb Шаг строки B
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ */
+void gemm_reference (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                     const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc);
+
+#endif   // GEMM_H
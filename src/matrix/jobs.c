@@ -0,0 +1,433 @@
+/**
+ * @file jobs.c
+ * @brief Реализация пакетного режима
+ *
+ * @details
+ * Манифест читается целиком в один буфер; строки и поля разделяются в нем
+ * нулевыми символами, и задания ссылаются на поля без копирования.
+ * Различные входные файлы собираются в таблицу при разборе, поэтому файл,
+ * упомянутый несколькими заданиями, загружается один раз.
+ *
+ * @see jobs.h
+ */
+
+#include "jobs.h"
+
+#include "../parallel/thread_pool.h"
+#include "expr.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @struct JobsRun
+ * @brief Общий аргумент задач пула при выполнении заданий
+ */
+typedef struct {
+    JobManifest* manifest;    ///< Манифест
+    int          precision;   ///< Точность записи результатов
+    MatrixCache* cache;       ///< Кэш результатов или NULL
+} JobsRun;
+
+/**
+ * @brief Монотонное время в секундах
+ *
+ * @return Время
+ */
+static double jobs_now (void) {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Читает файл целиком в строку
+ *
+ * @param filename Имя файла
+ * @return Строка, завершенная нулем (освобождается free), или NULL
+ */
+static char* jobs_read_text (const char* filename) {
+    FILE* file = fopen (filename, "rb");
+    char* text = NULL;
+    long  size = -1;
+
+    if (file && fseek (file, 0, SEEK_END) == 0) size = ftell (file);
+    if (size >= 0 && fseek (file, 0, SEEK_SET) == 0)
+        text = malloc ((size_t) size + 1);
+    if (text) {
+        if (fread (text, 1, (size_t) size, file) == (size_t) size) text[size] = '\0';
+        else {
+            free (text);
+            text = NULL;
+        }
+    }
+    if (file) fclose (file);
+
+    return text;
+}
+
+/**
+ * @brief Выделяет следующее поле строки
+ *
+ * @param cursor Позиция в строке; сдвигается за поле
+ * @return Поле, завершенное нулем, или NULL в конце строки
+ */
+static char* jobs_next_field (char** cursor) {
+    char* field = *cursor;
+
+    while (*field == ' ' || *field == '\t' || *field == '\r') field++;
+    if (*field == '\0') field = NULL;
+    else {
+        char* end = field;
+        while (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\r') end++;
+        *cursor = *end != '\0' ? end + 1 : end;
+        *end    = '\0';
+    }
+
+    return field;
+}
+
+/**
+ * @brief Находит входной файл в таблице манифеста или добавляет его
+ *
+ * @param manifest Манифест
+ * @param file Имя файла
+ * @param capacity Емкость таблицы файлов
+ * @return Номер файла или -1 при ошибке выделения памяти
+ */
+static int jobs_file_index (JobManifest* manifest, const char* file, int* capacity) {
+    int index = -1;
+
+    for (int i = 0; i < manifest->file_count && index < 0; i++) {
+        if (strcmp (manifest->files[i], file) == 0) index = i;
+    }
+
+    if (index < 0 && manifest->file_count == *capacity) {
+        const int    grown = *capacity ? *capacity * 2 : JOBS_MAX_INPUTS;
+        const char** files =
+            realloc (manifest->files, (size_t) grown * sizeof (*files));
+        if (files) {
+            manifest->files = files;
+            *capacity       = grown;
+        }
+    }
+    if (index < 0 && manifest->file_count < *capacity) {
+        index                  = manifest->file_count++;
+        manifest->files[index] = file;
+    }
+
+    return index;
+}
+
+/**
+ * @brief Разбирает строку манифеста в задание
+ *
+ * @param manifest Манифест
+ * @param line Строка (изменяется: поля завершаются нулями)
+ * @param job Задание
+ * @param capacity Емкость таблицы файлов
+ * @return 0 при успехе, -1 при ошибке формата
+ */
+static int jobs_parse_line (JobManifest* manifest, char* line, Job* job,
+                            int* capacity) {
+    char* cursor = line;
+    char* field  = NULL;
+    int   res    = 0;
+
+    memset (job, 0, sizeof (*job));
+    job->id         = jobs_next_field (&cursor);
+    job->output     = jobs_next_field (&cursor);
+    job->expression = jobs_next_field (&cursor);
+    if (!job->expression) res = -1;
+
+    while (res == 0 && (field = jobs_next_field (&cursor)) != NULL) {
+        char* separator = strchr (field, '=');
+
+        // Вход: непустое имя, знак равенства, непустой файл
+        if (job->input_count == JOBS_MAX_INPUTS || separator == NULL ||
+            separator == field || separator[1] == '\0')
+            res = -1;
+        else {
+            *separator                   = '\0';
+            job->names[job->input_count] = field;
+            job->files[job->input_count] =
+                jobs_file_index (manifest, separator + 1, capacity);
+            if (job->files[job->input_count] < 0) res = -1;
+            job->input_count++;
+        }
+    }
+    if (job->input_count == 0) res = -1;
+
+    return res;
+}
+
+/**
+ * @brief Читает манифест
+ *
+ * @param filename Имя файла манифеста
+ * @param manifest Манифест
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int jobs_load_manifest (const char* filename, JobManifest* manifest) {
+    int res      = -1;
+    int lines    = 1;   // Верхняя оценка числа заданий
+    int capacity = 0;   // Емкость таблицы файлов
+
+    if (filename && manifest) {
+        memset (manifest, 0, sizeof (*manifest));
+        manifest->text = jobs_read_text (filename);
+        if (!manifest->text)
+            fprintf (stderr, "Ошибка чтения манифеста %s.\n", filename);
+    }
+
+    if (manifest && manifest->text) {
+        for (const char* c = manifest->text; *c != '\0'; c++) lines += *c == '\n';
+        manifest->jobs = calloc ((size_t) lines, sizeof (Job));
+        res            = manifest->jobs ? 0 : -1;
+    }
+
+    char* line = manifest && manifest->jobs ? manifest->text : NULL;
+    for (int number = 1; res == 0 && line != NULL; number++) {
+        char* end = strchr (line, '\n');
+        if (end) *end = '\0';
+
+        char* start = line;
+        while (*start == ' ' || *start == '\t' || *start == '\r') start++;
+
+        // Пустые строки и комментарии пропускаются
+        if (*start != '\0' && *start != '#') {
+            Job* job = &manifest->jobs[manifest->job_count];
+            if (jobs_parse_line (manifest, start, job, &capacity) == 0) {
+                manifest->job_count++;
+            } else {
+                res = -1;
+                fprintf (stderr, "Ошибка в строке %d манифеста %s.\n", number,
+                         filename);
+            }
+        }
+        line = end ? end + 1 : NULL;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Ключ кэша для задания
+ *
+ * Хеш каждого входа связывается с его именем, поэтому задания с одной
+ * записью выражения, но разным назначением файлов именам, различаются.
+ *
+ * @param manifest Манифест с хешами файлов
+ * @param job Задание
+ * @return Ключ
+ */
+static uint64_t jobs_cache_key (const JobManifest* manifest, const Job* job) {
+    uint64_t inputs[JOBS_MAX_INPUTS];
+
+    for (int i = 0; i < job->input_count; i++) {
+        inputs[i] =
+            matrix_cache_key (job->names[i], &manifest->hashes[job->files[i]], 1);
+    }
+
+    return matrix_cache_key (job->expression, inputs, job->input_count);
+}
+
+/**
+ * @brief Выполняет одно задание: разбор, вычисление и запись результата
+ *
+ * @param manifest Манифест с загруженными файлами
+ * @param job Задание
+ * @param precision Точность записи результата
+ * @param cache Кэш результатов или NULL
+ */
+static void jobs_execute (const JobManifest* manifest, Job* job, int precision,
+                          MatrixCache* cache) {
+    const double  start  = jobs_now ();
+    const Matrix* inputs[JOBS_MAX_INPUTS];
+    ExprGraph*    graph  = NULL;
+    Expr*         root   = NULL;
+    Matrix        result = {0};
+    uint64_t      key    = 0;
+
+    for (int i = 0; i < job->input_count; i++) {
+        inputs[i] = &manifest->matrices[job->files[i]];
+        if (!matrix_valid (inputs[i])) job->error = "загрузка входа";
+    }
+
+    if (!job->error && cache) {
+        key         = jobs_cache_key (manifest, job);
+        job->cached = matrix_cache_lookup (cache, key, &result);
+    }
+
+    if (!job->error && !job->cached) {
+        graph = expr_graph_create ();
+        root  = expr_parse (graph, job->expression, job->names, inputs,
+                            job->input_count);
+        if (!root) job->error = "разбор выражения";
+    }
+
+    if (!job->error && !job->cached) {
+        result = create_matrix (expr_rows (root), expr_cols (root));
+        if (!matrix_valid (&result) || expr_evaluate (graph, root, &result) != 0)
+            job->error = "вычисление";
+        else if (cache && matrix_cache_store (cache, key, &result) != 0)
+            job->cache_failed = 1;   // Задание выполнено, отчет покажет ошибку
+    }
+
+    if (!job->error &&
+        save_matrix_to_file_precision (&result, job->output, precision) != 0) {
+        job->error = "запись результата";
+    }
+
+    job->rows    = result.rows;
+    job->cols    = result.cols;
+    job->status  = job->error ? JOB_FAILED : JOB_DONE;
+    job->seconds = jobs_now () - start;
+
+    free_matrix (&result);
+    expr_graph_free (graph);
+}
+
+/**
+ * @brief Задача пула: загрузка одного входного файла
+ *
+ * Если у манифеста есть таблица хешей, файл сразу хешируется, пока его
+ * данные еще в кэше процессора.
+ *
+ * @param arg Манифест
+ * @param task Номер файла
+ * @param worker Номер потока (не используется)
+ */
+static void jobs_load_task (void* arg, int task, int worker) {
+    JobManifest* manifest = arg;
+
+    (void) worker;
+    manifest->matrices[task] = load_matrix_from_file (manifest->files[task]);
+    if (manifest->hashes)
+        manifest->hashes[task] = matrix_hash (&manifest->matrices[task]);
+}
+
+/**
+ * @brief Задача пула: выполнение одного задания
+ *
+ * @param arg Описание выполнения (JobsRun)
+ * @param task Номер задания
+ * @param worker Номер потока (не используется)
+ */
+static void jobs_run_task (void* arg, int task, int worker) {
+    JobsRun* run = arg;
+
+    (void) worker;
+    jobs_execute (run->manifest, &run->manifest->jobs[task], run->precision,
+                  run->cache);
+}
+
+/**
+ * @brief Загружает входные файлы и выполняет задания
+ *
+ * @param manifest Манифест
+ * @param precision Точность записи результатов
+ * @param cache Кэш результатов или NULL
+ *
+ * @return Количество неуспешных заданий или -1 при ошибке
+ */
+int jobs_run (JobManifest* manifest, int precision, MatrixCache* cache) {
+    int    failed = -1;
+    double start  = jobs_now ();
+
+    if (manifest && manifest->jobs && !manifest->matrices) {
+        manifest->matrices =
+            calloc ((size_t) manifest->file_count + 1, sizeof (Matrix));
+    }
+    if (manifest && cache && !manifest->hashes) {
+        manifest->hashes =
+            calloc ((size_t) manifest->file_count + 1, sizeof (uint64_t));
+    }
+
+    if (manifest && manifest->matrices && (!cache || manifest->hashes)) {
+        JobsRun run = {manifest, precision, cache};
+
+        if (manifest->file_count > 0)
+            thread_pool_run (manifest->file_count, jobs_load_task, manifest);
+        manifest->load_seconds = jobs_now () - start;
+
+        // Мало заданий - по очереди, чтобы пул делил умножения каждого
+        start = jobs_now ();
+        if (manifest->job_count >= thread_pool_threads ()) {
+            thread_pool_run (manifest->job_count, jobs_run_task, &run);
+        } else {
+            for (int i = 0; i < manifest->job_count; i++) jobs_run_task (&run, i, 0);
+        }
+        manifest->run_seconds = jobs_now () - start;
+
+        failed = 0;
+        for (int i = 0; i < manifest->job_count; i++) {
+            failed += manifest->jobs[i].status != JOB_DONE;
+        }
+    }
+
+    return failed;
+}
+
+/**
+ * @brief Печатает время и состояние заданий и сводку по пакету
+ *
+ * @param manifest Выполненный манифест
+ * @param stream Поток вывода
+ */
+void jobs_report (const JobManifest* manifest, FILE* stream) {
+    if (manifest && stream) {
+        const double wall   = manifest->run_seconds;
+        int          done   = 0;   // Успешных заданий
+        int          cached = 0;   // Из них взятых из кэша
+        double       total  = 0;   // Сумма времени заданий
+
+        for (int i = 0; i < manifest->job_count; i++) {
+            const Job* job = &manifest->jobs[i];
+            if (job->status == JOB_DONE) {
+                done++;
+                cached += job->cached;
+                fprintf (stream, "%s: %d x %d за %.3f мс%s%s -> %s\n", job->id,
+                         job->rows, job->cols, job->seconds * 1e3,
+                         job->cached ? " (из кэша)" : "",
+                         job->cache_failed ? " (ошибка записи в кэш)" : "",
+                         job->output);
+            } else {
+                fprintf (stream, "%s: ошибка (%s)\n", job->id,
+                         job->error ? job->error : "не выполнялось");
+            }
+            total += job->seconds;
+        }
+
+        fprintf (stream, "Заданий: %d, успешно: %d (из кэша: %d), с ошибкой: %d\n",
+                 manifest->job_count, done, cached, manifest->job_count - done);
+        fprintf (stream, "Загрузка: %d файлов за %.3f с\n", manifest->file_count,
+                 manifest->load_seconds);
+        fprintf (stream,
+                 "Выполнение: %.3f с (сумма по заданиям %.3f с), %.1f заданий/с\n",
+                 wall, total, wall > 0 ? manifest->job_count / wall : 0.0);
+    }
+}
+
+/**
+ * @brief Освобождает манифест и загруженные матрицы
+ *
+ * @param manifest Манифест или NULL
+ */
+void jobs_free (JobManifest* manifest) {
+    if (manifest) {
+        for (int i = 0; manifest->matrices && i < manifest->file_count; i++) {
+            free_matrix (&manifest->matrices[i]);
+        }
+        free (manifest->matrices);
+        free (manifest->hashes);
+        free (manifest->files);
+        free (manifest->jobs);
+        free (manifest->text);
+        memset (manifest, 0, sizeof (*manifest));
+    }
+}
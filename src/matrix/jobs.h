@@ -0,0 +1,129 @@
+/**
+ * @file jobs.h
+ * @brief Пакетный режим: много выражений над многими файлами в одном процессе
+ *
+ * @details
+ * Манифест - текстовый файл, в котором каждая непустая строка, не
+ * начинающаяся с #, описывает одно задание полями через пробелы:
+ * @code
+ * # номер  выходной файл  выражение   входы ИМЯ=ФАЙЛ
+ * job1     out/r1.txt     A*B+C-D^T   A=a.txt B=b.txt C=c.txt D=d.txt
+ * @endcode
+ * Выражение записывается без пробелов в синтаксисе expr_parse (expr.h).
+ *
+ * jobs_run выполняется в два этапа на пуле потоков (thread_pool.h):
+ * 1. Каждый различный файл загружается один раз, даже если он нужен
+ *    нескольким заданиям; файлы загружаются параллельно
+ * 2. Задания выполняются параллельно, по одному на поток: каждое строит
+ *    свое выражение (expr.h) над общими загруженными матрицами, вычисляет
+ *    его и сохраняет результат. Умножения внутри задания при этом идут в
+ *    одном потоке (вложенный вызов пула выполняется последовательно), что
+ *    для множества небольших заданий выгоднее деления каждого умножения.
+ *    Если заданий меньше, чем потоков, они выполняются по очереди, и пул
+ *    делит между потоками умножения каждого задания
+ *
+ * Если передан кэш (cache.h), каждый файл после загрузки хешируется один
+ * раз, а ключ задания строится по записи выражения и хешам входов вместе
+ * с их именами. Задание, результат которого уже есть в кэше, не
+ * вычисляется: результат загружается из кэша и сохраняется в выходной
+ * файл; вычисленные результаты записываются в кэш. Ошибка записи в кэш
+ * не делает задание неудачным, но отмечается в отчете jobs_report.
+ *
+ * Для каждого задания запоминаются состояние, размер результата и время
+ * вычисления с сохранением, для всего пакета - время загрузки и
+ * вычисления; jobs_report печатает их вместе с пропускной способностью.
+ * Загруженные матрицы живут до jobs_free, поэтому все входы пакета должны
+ * одновременно помещаться в память.
+ *
+ * @see expr.h thread_pool.h cache.h
+ */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "cache.h"
+#include "matrix.h"
+
+#include <stdio.h>
+
+/** Наибольшее число входных матриц одного задания */
+#define JOBS_MAX_INPUTS 16
+
+/**
+ * @enum JobStatus
+ * @brief Состояние задания
+ */
+typedef enum {
+    JOB_PENDING,   ///< Задание еще не выполнялось
+    JOB_DONE,      ///< Результат сохранен
+    JOB_FAILED,    ///< Ошибка загрузки входа, разбора, вычисления или записи
+} JobStatus;
+
+/**
+ * @struct Job
+ * @brief Одно задание манифеста и результат его выполнения
+ */
+typedef struct {
+    const char* id;                        ///< Номер задания
+    const char* output;                    ///< Выходной файл
+    const char* expression;                ///< Запись выражения
+    int         input_count;               ///< Количество входов
+    const char* names[JOBS_MAX_INPUTS];    ///< Имена входов в выражении
+    int         files[JOBS_MAX_INPUTS];    ///< Номера файлов в JobManifest
+    JobStatus   status;                    ///< Состояние
+    int         rows;                      ///< Строк в результате
+    int         cols;                      ///< Столбцов в результате
+    double      seconds;                   ///< Время вычисления и сохранения
+    int         cached;                    ///< 1 - результат взят из кэша
+    int         cache_failed;              ///< 1 - результат не записан в кэш
+    const char* error;                     ///< Этап, на котором произошла ошибка
+} Job;
+
+/**
+ * @struct JobManifest
+ * @brief Задания пакета и общие для них входные файлы
+ */
+typedef struct {
+    char*        text;           ///< Текст манифеста, поля указывают в него
+    Job*         jobs;           ///< Задания в порядке манифеста
+    int          job_count;      ///< Количество заданий
+    const char** files;          ///< Различные входные файлы
+    Matrix*      matrices;       ///< Загруженные файлы (после jobs_run)
+    uint64_t*    hashes;         ///< Хеши файлов (после jobs_run с кэшем)
+    int          file_count;     ///< Количество различных файлов
+    double       load_seconds;   ///< Время загрузки файлов
+    double       run_seconds;    ///< Время выполнения заданий
+} JobManifest;
+
+/**
+ * @brief Читает манифест
+ * @param filename Имя файла манифеста
+ * @param manifest Манифест (освобождается jobs_free, в том числе при ошибке)
+ * @note Ошибка в строке сообщается в stderr с номером строки
+ * @return 0 при успехе, -1 при ошибке чтения или формата
+ */
+int jobs_load_manifest (const char* filename, JobManifest* manifest);
+
+/**
+ * @brief Загружает входные файлы и выполняет задания
+ * @param manifest Манифест
+ * @param precision Точность записи результатов (output.h)
+ * @param cache Кэш результатов или NULL
+ * @return Количество неуспешных заданий или -1 при ошибке аргументов
+ */
+int jobs_run (JobManifest* manifest, int precision, MatrixCache* cache);
+
+/**
+ * @brief Печатает время и состояние заданий и сводку по пакету
+ * @param manifest Выполненный манифест
+ * @param stream Поток вывода
+ */
+void jobs_report (const JobManifest* manifest, FILE* stream);
+
+/**
+ * @brief Освобождает манифест и загруженные матрицы
+ * @param manifest Манифест или NULL
+ */
+void jobs_free (JobManifest* manifest);
+
+#endif   // JOBS_H
@@ -0,0 +1,98 @@
+/**
+ * @file loader.c
+ * @brief Реализация фоновой загрузки матриц
+ *
+ * @details
+ * Каждая загрузка выполняется своим потоком: файлов у одного выражения
+ * немного, а пул потоков занят вычислениями и не подходит для блокирующего
+ * чтения. Готовность публикуется атомарным флагом done с семантикой
+ * release/acquire, поэтому matrix_load_ready может опрашивать его без
+ * блокировок.
+ *
+ * @see loader.h
+ */
+
+#include "loader.h"
+
+#include <string.h>
+
+/**
+ * @brief Загружает файл и при необходимости меняет тип элементов
+ *
+ * @param arg Описание загрузки (MatrixLoad)
+ * @return NULL
+ */
+static void* matrix_load_run (void* arg) {
+    MatrixLoad* load   = arg;
+    Matrix      matrix = load_matrix_from_file (load->filename);
+
+    if (load->type != MATRIX_F64 && matrix_valid (&matrix)) {
+        Matrix converted = convert_matrix_type (&matrix, load->type);
+        free_matrix (&matrix);
+        matrix = converted;
+    }
+
+    load->matrix = matrix;
+    atomic_store_explicit (&load->done, 1, memory_order_release);
+
+    return NULL;
+}
+
+/**
+ * @brief Запускает загрузку файла в фоновом потоке
+ *
+ * @param load Описание загрузки
+ * @param filename Имя файла
+ * @param type Тип элементов загруженной матрицы
+ *
+ * @return 0 при успехе, -1 при ошибке аргументов
+ */
+int matrix_load_start (MatrixLoad* load, const char* filename,
+                       MatrixElementType type) {
+    int res = -1;
+
+    if (load && filename && (unsigned) type < MATRIX_ELEMENT_TYPE_COUNT) {
+        memset (load, 0, sizeof (*load));
+        load->filename = filename;
+        load->type     = type;
+        atomic_init (&load->done, 0);
+
+        load->active =
+            pthread_create (&load->thread, NULL, matrix_load_run, load) == 0;
+        if (!load->active) matrix_load_run (load);   // Без потока загружаем сразу
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Проверяет без ожидания, завершена ли загрузка
+ *
+ * @param load Описание загрузки
+ *
+ * @return 1, если матрица готова, иначе 0
+ */
+int matrix_load_ready (MatrixLoad* load) {
+    return load != NULL && atomic_load_explicit (&load->done, memory_order_acquire);
+}
+
+/**
+ * @brief Дожидается загрузки и передает матрицу вызывающему
+ *
+ * @param load Описание загрузки
+ *
+ * @return Загруженная матрица или нулевая матрица при ошибке
+ */
+Matrix matrix_load_wait (MatrixLoad* load) {
+    Matrix matrix = {0};
+
+    if (load) {
+        if (load->active) pthread_join (load->thread, NULL);
+        load->active = 0;
+        matrix       = load->matrix;   // Владение переходит вызывающему
+        memset (&load->matrix, 0, sizeof (load->matrix));
+    }
+
+    return matrix;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file loader.h
+ * @brief Фоновая загрузка матриц из файлов
+ *
+ * @details
+ * matrix_load_start запускает загрузку файла в отдельном потоке и сразу
+ * возвращается; описание MatrixLoad играет роль будущего значения.
+ * matrix_load_ready проверяет без ожидания, готова ли матрица, а
+ * matrix_load_wait дожидается потока и передает матрицу вызывающему.
+ * Несколько файлов, запущенных подряд, читаются и разбираются
+ * одновременно, а вызывающий поток тем временем может считать с уже
+ * готовыми матрицами. Если поток создать не удалось, файл загружается
+ * сразу в matrix_load_start.
+ *
+ * Загрузка идет через load_matrix_from_file; если задан тип не
+ * MATRIX_F64, матрица преобразуется к нему в том же потоке.
+ *
+ * Каждая запущенная загрузка должна быть завершена вызовом
+ * matrix_load_wait, даже если ее результат не нужен: иначе поток
+ * останется неприсоединенным, а матрица - неосвобожденной.
+ *
+ * @see matrix.h
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "matrix.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * @struct MatrixLoad
+ * @brief Фоновая загрузка одного файла
+ * @note Поля заполняются функциями модуля и не предназначены для
+ *       изменения вызывающим
+ */
+typedef struct {
+    const char*       filename;   ///< Имя загружаемого файла
+    MatrixElementType type;       ///< Тип элементов результата
+    Matrix            matrix;     ///< Загруженная матрица
+    pthread_t         thread;     ///< Поток загрузки
+    int               active;     ///< 1 - поток запущен и не присоединен
+    atomic_int        done;       ///< 1 - матрица готова
+} MatrixLoad;
+
+/**
+ * @brief Запускает загрузку файла в фоновом потоке
+ * @param load Описание загрузки
+ * @param filename Имя файла (строка должна жить до matrix_load_wait)
+ * @param type Тип элементов загруженной матрицы
+ * @return 0 при успехе, -1 при ошибке аргументов
+ */
+int matrix_load_start (MatrixLoad* load, const char* filename,
+                       MatrixElementType type);
+
+/**
+ * @brief Проверяет без ожидания, завершена ли загрузка
+ * @param load Описание загрузки
+ * @return 1, если матрица готова (в том числе с ошибкой), иначе 0
+ */
+int matrix_load_ready (MatrixLoad* load);
+
+/**
+ * @brief Дожидается загрузки и передает матрицу вызывающему
+ * @param load Описание загрузки
+ * @note Повторный вызов возвращает нулевую матрицу
+ * @return Загруженная матрица или нулевая матрица при ошибке
+ */
+Matrix matrix_load_wait (MatrixLoad* load);
+
+#endif   // LOADER_H
@@ -21,176 +21,637 @@
 
 #include "matrix.h"
 
+#include "../metrics/metrics.h"
 #include "../output/output.h"
+#include "gemm.h"
+#include "simd.h"
+#include "small.h"
+#include "strassen.h"
+#include "typed.h"
 
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Объем элементов матрицы для счетчиков байтов (metrics.h)
+ *
+ * @param matrix Матрица или NULL
+ * @return Размер rows x cols элементов в байтах
+ */
+static inline uint64_t matrix_bytes (const Matrix* matrix) {
+    return matrix ? (uint64_t) matrix->rows * matrix->cols *
+                        matrix_element_size (matrix->type)
+                  : 0;
+}
+
+/**
+ * @brief Вычисляет ведущую размерность матрицы
+ *
+ * Шаг строки округляется вверх до целого числа кэш-линий, чтобы каждая
+ * строка начиналась с выровненного адреса. Если шаг в байтах кратен
+ * MATRIX_ALIAS_PERIOD, добавляется еще одна кэш-линия: иначе при проходе по
+ * столбцу все строки отображаются в один набор кэша.
+ *
+ * @param cols Количество столбцов (должно быть > 0)
+ * @param size Размер элемента в байтах
+ * @return Шаг строки в элементах или 0 при ошибке
+ */
+int matrix_leading_dimension (int cols, size_t size) {
+    const size_t line   = MATRIX_ALIGNMENT / size;
+    size_t       stride = 0;
+
+    if (cols > 0) {
+        stride = ((size_t) cols + line - 1) / line * line;
+        if ((stride * size) % MATRIX_ALIAS_PERIOD == 0) stride += line;
+        if (stride > INT_MAX) stride = 0;   // Шаг не помещается в int
+    }
+
+    return (int) stride;
+}
+
+/**
+ * @brief Элементов в области строк блока матрицы
+ *
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param size Размер элемента в байтах
+ * @return rows * matrix_leading_dimension (cols, size) или 0 при
+ *         переполнении
+ */
+size_t matrix_capacity (int rows, int cols, size_t size) {
+    const size_t stride   = (size_t) matrix_leading_dimension (cols, size);
+    size_t       capacity = 0;
+
+    if (stride != 0 && (size_t) rows <= SIZE_MAX / size / stride)
+        capacity = (size_t) rows * stride;
+
+    return capacity;
+}
 
 /**
  * @brief Создает матрицу заданного размера
  *
+ * Выделяет один блок, выровненный по MATRIX_ALIGNMENT: в начале лежат
+ * строки элементов с шагом stride, за ними - массив указателей на строки.
+ *
  * @param rows Количество строк (должно быть > 0)
  * @param cols Количетство столбцов (должно быть > 0)
  * @return Структура Matrix при успехе, нулевая матрица при ошибке
  */
 Matrix create_matrix (int rows, int cols) {
-    Matrix mat = {0, 0, NULL};   // Инициализация пустой матрицы
-    char res = 1;   // Флаг успешности выполнения
+    return create_matrix_arena (rows, cols, NULL);
+}
 
+/**
+ * @brief Создает матрицу заданного размера в арене
+ *
+ * Раскладка та же, что у create_matrix, но блок берется из арены.
+ *
+ * @param rows Количество строк (должно быть > 0)
+ * @param cols Количество столбцов (должно быть > 0)
+ * @param arena Арена или NULL для выделения в куче
+ * @return Структура Matrix при успехе, нулевая матрица при ошибке
+ */
+Matrix create_matrix_arena (int rows, int cols, MatrixArena* arena) {
+    Matrix mat      = {0};   // Пустая матрица
+    int    stride   = 0;   // Шаг строки в элементах
+    size_t bytes    = 0;   // Размер области элементов
+    size_t pointers = 0;   // Размер массива указателей на строки
+    void*  block    = NULL;
+    char   res      = 1;   // Флаг успешности выполнения
+
+    METRICS_BEGIN (timer);
     // Проверка корректности размеров
     if (rows <= 0 || cols <= 0) res = 0;
     else {
-        mat.rows = rows;
-        mat.cols = cols;
-        mat.data = (MATRIX_TYPE**) malloc (rows * sizeof (MATRIX_TYPE*));
+        stride = matrix_leading_dimension (cols, sizeof (MATRIX_TYPE));
+        bytes  = matrix_capacity (rows, cols, sizeof (MATRIX_TYPE));
+        if (stride == 0 || bytes == 0) res = 0;   // Переполнение размера
+    }
 
-        if (mat.data == NULL) res = 0;   // Ошибка выделения
-        else {
-            // Выделение памяти под каждую строку
-            for (int row = 0; row < rows && res; row++) {
-                mat.data[row] = (MATRIX_TYPE*) malloc (cols * sizeof (MATRIX_TYPE));
-                if (mat.data[row] == NULL) res = 0;   // Ошибка выделения памяти
-            }
-        }
+    if (res) {
+        bytes *= sizeof (MATRIX_TYPE);
+        pointers = (size_t) rows * sizeof (MATRIX_TYPE*);
+        if (bytes > SIZE_MAX - pointers) res = 0;
+        else if (arena) {
+            block = arena_alloc (arena, bytes + pointers);
+            if (block == NULL) res = 0;
+        } else if (posix_memalign (&block, MATRIX_ALIGNMENT, bytes + pointers) != 0)
+            res = 0;   // Ошибка выделения памяти
+        else METRICS_ALLOCATION ();
     }
 
-    if (!res) {   // Освобождаем память в случае ошибки
-        if (mat.data != NULL) {
-            for (int row = 0; row < mat.rows; row++) {
-                if (mat.data[row] != NULL) free (mat.data[row]);
-            }
-            free (mat.data);
+    if (res) {
+        mat.rows   = rows;
+        mat.cols   = cols;
+        mat.stride = stride;
+        mat.block  = (MATRIX_TYPE*) block;
+        mat.data   = (MATRIX_TYPE**) ((char*) block + bytes);
+        mat.arena  = arena;
+
+        // Указатели на строки внутри единого блока
+        for (int row = 0; row < rows; row++) {
+            mat.data[row] = mat.block + (size_t) row * stride;
         }
-        mat.data = NULL;
-        mat.cols = 0;
-        mat.rows = 0;
     }
 
+    METRICS_END (timer, METRICS_CREATE, 0, 0);
+
     return mat;
 }
 
+/**
+ * @brief Создает представление подматрицы без копирования элементов
+ *
+ * Представление получает тип и шаг родителя, а block или elements
+ * указывают на элемент (row, col) родителя. Массив указателей на строки не
+ * создается, поэтому представление ничего не выделяет.
+ *
+ * @param parent Родительская матрица или представление
+ * @param row Первая строка подматрицы
+ * @param col Первый столбец подматрицы
+ * @param rows Количество строк подматрицы
+ * @param cols Количество столбцов подматрицы
+ *
+ * @return Представление или нулевая матрица, если блок выходит за parent
+ */
+Matrix matrix_view (const Matrix* parent, int row, int col, int rows, int cols) {
+    Matrix view = {0};   // Пустая матрица
+
+    if (matrix_valid (parent) && row >= 0 && col >= 0 && rows > 0 && cols > 0 &&
+        row <= parent->rows - rows && col <= parent->cols - cols) {
+        const size_t offset = (size_t) row * parent->stride + col;
+
+        view.rows   = rows;
+        view.cols   = cols;
+        view.stride = parent->stride;
+        view.type   = parent->type;
+        view.view   = 1;
+        if (parent->type == MATRIX_F64) view.block = parent->block + offset;
+        else {
+            view.elements = (char*) parent->elements +
+                            offset * matrix_element_size (parent->type);
+        }
+    }
+
+    return view;
+}
+
 /**
  * @brief Освобождает память занятую матрицей
  *
  * @param matrix Указатель на Matrix
  */
 void free_matrix (Matrix* matrix) {
-    if (matrix->data != NULL && matrix != NULL) {
-        for (int index_row = 0; index_row < matrix->rows; index_row++) {
-            free (matrix->data[index_row]);
-        }
-        free (matrix->data);
-        matrix->data = NULL;
-        matrix->rows = 0;
-        matrix->cols = 0;
+    if (matrix_valid (matrix)) {
+        if (matrix->view) {
+            // Элементы принадлежат родительской матрице
+        } else if (matrix->mapping) {
+            // Элементы лежат в отображении файла, указатели - отдельно
+            munmap (matrix->mapping, matrix->mapping_size);
+            free (matrix->data);
+        } else if (matrix->elements) {
+            free (matrix->elements);   // Матрица float или int32_t
+        } else if (matrix->arena == NULL) {
+            free (matrix->block);   // Указатели на строки лежат в том же блоке
+        }   // Блок из арены возвращается через arena_reset
+        matrix->data         = NULL;
+        matrix->block        = NULL;
+        matrix->rows         = 0;
+        matrix->cols         = 0;
+        matrix->stride       = 0;
+        matrix->mapping      = NULL;
+        matrix->mapping_size = 0;
+        matrix->arena        = NULL;
+        matrix->type         = MATRIX_F64;
+        matrix->elements     = NULL;
+        matrix->view         = 0;
     }
 }
 
+/** Тип элементов двоичного файла для каждого MatrixElementType */
+static const OutputElementType output_types[MATRIX_ELEMENT_TYPE_COUNT] = {
+    OUTPUT_ELEMENT_F64, OUTPUT_ELEMENT_F32, OUTPUT_ELEMENT_I32};
+
 /**
- * @brief Загружает матрицу из файла
+ * @brief Загружает матрицу из двоичного файла
+ *
+ * Если элементы файла имеют тип матрицы и порядок байтов машины, а строки
+ * выровнены по MATRIX_ALIGNMENT, блоком матрицы становится само
+ * отображение файла: выделяется только массив указателей на строки (для
+ * double). Иначе элементы копируются в обычную матрицу с преобразованием.
  *
  * @param filename Путь к файлу с матрицей
+ * @param keep_type 1 - тип элементов файла, 0 - всегда MATRIX_F64
  *
  * @return Загруженную матрицу или нулевую матрицу при ошибке
  */
-Matrix load_matrix_from_file (const char* filename) {
-    int     rows, cols;
-    double* data = NULL;
-    Matrix mat = {0, 0, NULL};   // Инициализация пустой матрицы
-    char res = 1;   // Флаг успешности выполнения
-
-    // Загрузка данных из файла через функцию из output.c
-    data = output_load_matrix_from_file (&rows, &cols, filename);
-    if (!data) res = 0;   // Ошибка загрузки
-    if (res) {
-        mat = create_matrix (rows, cols);
-        if (mat.data == NULL) res = 0;   // Ошибка создания матрицы
+static Matrix load_matrix_from_binary_file (const char* filename, int keep_type) {
+    OutputBinaryFile  file;
+    Matrix            mat       = {0};   // Пустая матрица
+    char              res       = 1;   // Флаг успешности выполнения
+    int               zero_copy = 0;
+    MatrixElementType type      = MATRIX_F64;
+
+    if (output_map_binary_file (filename, &file) != 0) res = 0;
+
+    if (res && keep_type) {
+        for (int t = 0; t < MATRIX_ELEMENT_TYPE_COUNT; t++) {
+            if (output_types[t] == file.header.element_type)
+                type = (MatrixElementType) t;
+        }
     }
 
     if (res) {
-        for (int row = 0; row < rows; row++) {
-            for (int col = 0; col < cols; col++) {
-                mat.data[row][col] = data[row * cols + col];
+        const size_t size = matrix_element_size (type);
+        zero_copy         = !file.swapped && file.header.tile == 0 &&
+                    file.header.element_type == output_types[type] &&
+                    size == file.header.element_size &&
+                    file.header.data_offset % MATRIX_ALIGNMENT == 0 &&
+                    (file.header.stride * size) % MATRIX_ALIGNMENT == 0;
+    }
+
+    if (res && zero_copy && type != MATRIX_F64) {
+        // Массив указателей на строки не нужен
+        mat.rows         = (int) file.header.rows;
+        mat.cols         = (int) file.header.cols;
+        mat.stride       = (int) file.header.stride;
+        mat.type         = type;
+        mat.elements     = (void*) file.data;
+        mat.mapping      = file.mapping;
+        mat.mapping_size = file.size;
+    } else if (res && zero_copy) {
+        mat.data = malloc ((size_t) file.header.rows * sizeof (MATRIX_TYPE*));
+        if (!mat.data) res = 0;
+        else {
+            METRICS_ALLOCATION ();
+            mat.rows         = (int) file.header.rows;
+            mat.cols         = (int) file.header.cols;
+            mat.stride       = (int) file.header.stride;
+            mat.block        = (MATRIX_TYPE*) file.data;
+            mat.mapping      = file.mapping;
+            mat.mapping_size = file.size;
+            for (int row = 0; row < mat.rows; row++) {
+                mat.data[row] = mat.block + (size_t) row * mat.stride;
             }
         }
+    } else if (res && type != MATRIX_F64) {
+        mat = create_matrix_typed ((int) file.header.rows, (int) file.header.cols,
+                                   type);
+        if (mat.elements == NULL ||
+            output_read_binary_typed (&file, mat.stride, mat.elements) != 0)
+            res = 0;
+    } else if (res) {
+        mat = create_matrix ((int) file.header.rows, (int) file.header.cols);
+        if (mat.data == NULL ||
+            output_read_binary_elements (&file, mat.stride, mat.block) != 0)
+            res = 0;
     }
 
-    if (data) free (data);
+    // Отображение теперь принадлежит матрице
+    if (res && zero_copy) file.mapping = NULL;
+    output_unmap_binary_file (&file);
+
+    if (!res) free_matrix (&mat);
+
+    return mat;
+}
 
-    if (!res && mat.data != NULL) {
-        free_matrix (&mat);
-        mat.data = NULL;
-        mat.rows = 0;
-        mat.cols = 0;
+/**
+ * @brief Загружает матрицу из файла
+ *
+ * Формат определяется по сигнатуре файла. Элементы текстового файла
+ * читаются сразу в выровненный блок матрицы без промежуточного буфера.
+ *
+ * @param filename Путь к файлу с матрицей
+ * @param keep_type 1 - тип элементов двоичного файла, 0 - MATRIX_F64
+ *
+ * @return Загруженную матрицу или нулевую матрицу при ошибке
+ */
+static Matrix matrix_load (const char* filename, int keep_type) {
+    int    rows, cols;
+    FILE*  file   = NULL;
+    Matrix mat    = {0};   // Пустая матрица
+    char   res    = 1;   // Флаг успешности выполнения
+    int    binary = output_is_binary_file (filename);
+    METRICS_BEGIN (timer);
+
+    if (binary) {
+        mat = load_matrix_from_binary_file (filename, keep_type);
+    } else {
+        // Чтение заголовка через функцию из output.c
+        file = output_open_matrix_file (filename, &rows, &cols);
+        if (!file) res = 0;   // Ошибка загрузки
     }
 
+    if (res && !binary) {
+        mat = create_matrix (rows, cols);
+        if (mat.data == NULL) res = 0;   // Ошибка создания матрицы
+    }
+
+    if (res && !binary) {
+        if (output_read_matrix_elements (file, rows, cols, mat.stride, mat.block) !=
+            0)
+            res = 0;
+    }
+
+    if (file) fclose (file);
+
+    if (!res && mat.data != NULL) free_matrix (&mat);
+
+    METRICS_END (timer, METRICS_LOAD,
+                 matrix_valid (&mat) ? metrics_file_size (filename) : 0, 0);
+
     return mat;
 }
 
+/**
+ * @brief Загружает матрицу из файла
+ *
+ * @param filename Путь к файлу с матрицей
+ *
+ * @return Загруженную матрицу или нулевую матрицу при ошибке
+ */
+Matrix load_matrix_from_file (const char* filename) {
+    return matrix_load (filename, 0);
+}
+
+/**
+ * @brief Загружает матрицу, сохраняя тип элементов двоичного файла
+ *
+ * @param filename Путь к файлу с матрицей
+ *
+ * @return Загруженную матрицу или нулевую матрицу при ошибке
+ */
+Matrix load_matrix_typed (const char* filename) {
+    return matrix_load (filename, 1);
+}
+
+/**
+ * @brief Представляет матрицу любого типа как матрицу double
+ *
+ * Текстовый вывод работает только с double, поэтому матрица float или
+ * int32_t преобразуется во временную копию.
+ *
+ * @param matrix Матрица или NULL
+ * @param wide Временная копия (освобождается вызывающим)
+ * @return matrix, &wide или NULL при ошибке
+ */
+static const Matrix* matrix_as_f64 (const Matrix* matrix, Matrix* wide) {
+    const Matrix* res = NULL;
+
+    if (matrix && matrix->type == MATRIX_F64 && matrix->block) res = matrix;
+    else if (matrix_valid (matrix)) {
+        *wide = convert_matrix_type (matrix, MATRIX_F64);
+        if (wide->data) res = wide;
+    }
+
+    return res;
+}
+
 /**
  * @brief Выводит матрицу в консоль
  *
  * @param matrix Указатель на матрицу для вывода
  */
 void print_matrix (const Matrix* matrix) {
-    double* data = NULL;
-    char    res  = 1;
+    Matrix        wide   = {0};
+    const Matrix* source = matrix_as_f64 (matrix, &wide);
 
     // Проверка входных данных
-    if (!matrix || !matrix->data) res = 0;
+    if (source) {
+        output_print_matrix_strided (source->rows, source->cols, source->stride,
+                                     source->block);
+    }
 
-    if (res) {
-        data = malloc (matrix->rows * matrix->cols * sizeof (double));
-        if (!data) res = 0;
+    free_matrix (&wide);
+}
+
+/**
+ * @brief Сохраняет матрицу в файл
+ *
+ * @param matrix Указатель на сохраняемую матрицу
+ * @param filename Имя выходного файла
+ *
+ * @return Возвращает -1 при ошибке и 0 при успешной отработке функции
+ */
+int save_matrix_to_file (const Matrix* matrix, const char* filename) {
+    Matrix        wide   = {0};
+    const Matrix* source = matrix_as_f64 (matrix, &wide);
+    int           result = -1;
+    METRICS_BEGIN (timer);
+
+    // Проверка входных данных
+    if (source) {
+        result = output_save_matrix_to_file_strided (
+            source->rows, source->cols, source->stride, source->block, filename);
     }
 
-    if (res) {
-        for (int row = 0; row < matrix->rows; row++) {
-            for (int col = 0; col < matrix->cols; col++) {
-                data[row * matrix->cols + col] = matrix->data[row][col];
-            }
-        }
-        // Вызов функции вывода
-        output_print_matrix (matrix->rows, matrix->cols, data);
+    free_matrix (&wide);
+
+    METRICS_END (timer, METRICS_SAVE, 0,
+                 result == 0 ? metrics_file_size (filename) : 0);
+
+    return result;
+}
+
+/**
+ * @brief Сохраняет матрицу в файл с заданной точностью
+ *
+ * @param matrix Указатель на сохраняемую матрицу
+ * @param filename Имя выходного файла
+ * @param precision Знаков после точки или OUTPUT_PRECISION_LOSSLESS
+ *
+ * @return Возвращает -1 при ошибке и 0 при успешной отработке функции
+ */
+int save_matrix_to_file_precision (const Matrix* matrix, const char* filename,
+                                   int precision) {
+    Matrix        wide   = {0};
+    const Matrix* source = matrix_as_f64 (matrix, &wide);
+    int           result = -1;
+    METRICS_BEGIN (timer);
+
+    // Проверка входных данных
+    if (source) {
+        result = output_save_matrix_to_file_precision (source->rows, source->cols,
+                                                       source->stride, source->block,
+                                                       filename, precision);
     }
 
-    if (data) free (data);
+    free_matrix (&wide);
+
+    METRICS_END (timer, METRICS_SAVE, 0,
+                 result == 0 ? metrics_file_size (filename) : 0);
+
+    return result;
 }
 
 /**
- * @brief Сохраняет матрицу в файл
+ * @brief Сохраняет матрицу в двоичный файл
+ *
+ * Элементы пишутся в типе матрицы, поэтому load_matrix_typed возвращает
+ * матрицу того же типа.
  *
  * @param matrix Указатель на сохраняемую матрицу
  * @param filename Имя выходного файла
  *
  * @return Возвращает -1 при ошибке и 0 при успешной отработке функции
  */
-int save_matrix_to_file (const Matrix* matrix, const char* filename) {
-    double* data   = NULL;
-    int     result = -1;
-    char    res    = 1;
+int save_matrix_to_binary_file (const Matrix* matrix, const char* filename) {
+    int result = -1;
+    METRICS_BEGIN (timer);
 
     // Проверка входных данных
-    if (!matrix || !matrix->data) res = 0;
+    if (matrix_valid (matrix)) {
+        result = output_save_binary_file_typed (
+            matrix->rows, matrix->cols, matrix->stride,
+            matrix->type == MATRIX_F64 ? (const void*) matrix->block
+                                       : matrix->elements,
+            output_types[matrix->type], filename);
+    }
 
-    if (res) {
-        data = malloc (matrix->rows * matrix->cols * sizeof (double));
-        if (!data) res = 0;
+    METRICS_END (timer, METRICS_SAVE, 0,
+                 result == 0 ? metrics_file_size (filename) : 0);
+
+    return result;
+}
+
+/**
+ * @brief Преобразует текстовый файл матрицы в двоичный и наоборот
+ *
+ * @param source Исходный файл
+ * @param destination Выходной файл
+ *
+ * @return Возвращает -1 при ошибке и 0 при успешной отработке функции
+ */
+int convert_matrix_file (const char* source, const char* destination) {
+    const int binary = output_is_binary_file (source);
+    Matrix    mat    = load_matrix_typed (source);
+    int       result = -1;
+
+    if (matrix_valid (&mat)) {
+        // Текст пишется без потерь, чтобы преобразование было обратимым
+        result = binary ? save_matrix_to_file_precision (&mat, destination,
+                                                         OUTPUT_PRECISION_LOSSLESS)
+                        : save_matrix_to_binary_file (&mat, destination);
     }
 
+    free_matrix (&mat);
+
+    return result;
+}
+
+/**
+ * @brief Диапазон адресов элементов матрицы
+ *
+ * @param matrix Матрица любого типа
+ * @param first Адрес первого элемента
+ * @param last Адрес за последним элементом
+ *
+ * @return 1, если у матрицы есть элементы, иначе 0
+ */
+static int matrix_extent (const Matrix* matrix, const char** first,
+                          const char** last) {
+    const char* base = matrix->type == MATRIX_F64 ? (const char*) matrix->block
+                                                  : (const char*) matrix->elements;
+    int         res  = base != NULL && matrix->rows > 0 && matrix->cols > 0;
+
     if (res) {
-        for (int row = 0; row < matrix->rows; row++) {
-            for (int col = 0; col < matrix->cols; col++) {
-                data[row * matrix->cols + col] = matrix->data[row][col];
-            }
-        }
-        result =
-            output_save_matrix_to_file (matrix->rows, matrix->cols, data, filename);
+        const size_t count =
+            (size_t) (matrix->rows - 1) * matrix->stride + matrix->cols;
+        *first = base;
+        *last  = base + count * matrix_element_size (matrix->type);
     }
 
-    if (data) free (data);
+    return res;
+}
 
-    return result;
+/**
+ * @brief Проверяет, есть ли общий элемент у двух матриц с одним шагом
+ *
+ * Элемент (i, j) матрицы A совпадает с элементом (i', j') матрицы B, если
+ * смещение B относительно A равно (i - i') * stride + (j - j'). Так как
+ * столбцов не больше шага, разность строк - частное смещения на stride
+ * или на единицу больше. Так соседние блоки столбцов одной матрицы
+ * (представления matrix_view) не считаются пересекающимися.
+ *
+ * @param A Первая матрица
+ * @param B Вторая матрица того же типа и шага
+ * @param delta Смещение первого элемента B относительно A в элементах
+ *
+ * @return 1, если у матриц есть общий элемент, иначе 0
+ */
+static int matrix_strided_overlap (const Matrix* A, const Matrix* B,
+                                   ptrdiff_t delta) {
+    const ptrdiff_t stride = A->stride;
+    ptrdiff_t       rows   = delta / stride;   // Разность строк i - i'
+    ptrdiff_t       col    = delta % stride;   // Разность столбцов j - j'
+    if (col < 0) {
+        rows -= 1;
+        col += stride;
+    }
+
+    return (rows > -B->rows && rows < A->rows && col < A->cols) ||
+           (rows + 1 > -B->rows && rows + 1 < A->rows && col - stride > -B->cols);
+}
+
+/**
+ * @brief Проверяет, пересекаются ли элементы двух матриц в памяти
+ *
+ * Матрицы одного типа с одним шагом (например, представления одной
+ * матрицы) сравниваются поэлементно, прочие - по диапазонам адресов.
+ *
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ *
+ * @return 1, если матрицы пересекаются, иначе 0
+ */
+int matrices_overlap (const Matrix* A, const Matrix* B) {
+    const char* a_first = NULL;   // Первый байт A
+    const char* a_last  = NULL;   // Байт за последним элементом A
+    const char* b_first = NULL;   // Первый байт B
+    const char* b_last  = NULL;   // Байт за последним элементом B
+    int         overlap = 0;      // Результат проверки
+
+    if (A != NULL && B != NULL && matrix_extent (A, &a_first, &a_last) &&
+        matrix_extent (B, &b_first, &b_last))
+        overlap = a_first < b_last && b_first < a_last;
+
+    if (overlap && A->type == B->type && A->stride == B->stride) {
+        const ptrdiff_t size  = (ptrdiff_t) matrix_element_size (A->type);
+        const ptrdiff_t bytes = b_first - a_first;
+        if (bytes % size == 0) overlap = matrix_strided_overlap (A, B, bytes / size);
+    }
+
+    return overlap;
+}
+
+/**
+ * @brief Проверяет, может ли поэлементная операция писать в result
+ *
+ * Запись на место операнда допустима, если элемент (i, j) результата
+ * лежит там же, где элемент (i, j) операнда: ядра читают элемент до
+ * записи. Любое другое пересечение испортило бы еще не прочитанные
+ * элементы.
+ *
+ * @param operand Операнд
+ * @param result Результат
+ *
+ * @return 1, если матрицы не пересекаются или совпадают поэлементно
+ */
+static int matrix_alias_allowed (const Matrix* operand, const Matrix* result) {
+    const int same = operand->type == result->type &&
+                     operand->stride == result->stride &&
+                     operand->block == result->block &&
+                     operand->elements == result->elements;
+
+    return same || !matrices_overlap (operand, result);
 }
 
 /**
@@ -211,26 +672,40 @@ int add_matrices (const Matrix* A, const Matrix* B, Matrix* result) {
     char cols_match = 0;   // Флаг совпадения числа столбцов
     char pointers_valid = 0;   // Флаг для указателей
 
+    METRICS_BEGIN (timer);
+
     // Проверка указателей
     pointers_valid = (A != NULL) && (B != NULL) && (result != NULL);
 
     if (!pointers_valid) res = -1;
     else {
         // Проверка размеров
-        rows_match = (A->rows == B->rows);
-        cols_match = (A->cols == B->cols);
+        rows_match = (A->rows == B->rows) && (result->rows >= A->rows);
+        cols_match = (A->cols == B->cols) && (result->cols >= A->cols);
         if (!rows_match || !cols_match) res = -1;
+        else if (!matrix_alias_allowed (A, result) ||
+                 !matrix_alias_allowed (B, result))
+            res = -1;   // Частичное пересечение с операндом
+        else if (typed_involved (A, B, result))
+            res = typed_binary (A, B, result, 0);   // float или int32_t
+        else if (small_add (A->rows, A->cols, A->block, A->stride, B->block,
+                            B->stride, result->block, result->stride) == 0)
+            res = 0;   // Малая матрица - развернутым ядром
         else {
-            // Выполнение сложения
+            // Выполнение сложения векторным ядром по непрерывным строкам
+            const SimdOps* ops = simd_ops ();
             for (int row = 0; row < A->rows; row++) {
-                for (int col = 0; col < A->cols; col++) {
-                    result->data[row][col] = A->data[row][col] + B->data[row][col];
-                }
+                ops->add (A->cols, A->block + (size_t) row * A->stride,
+                          B->block + (size_t) row * B->stride,
+                          result->block + (size_t) row * result->stride);
             }
             res = 0;   // Успешное завершение
         }
     }
 
+    METRICS_END (timer, METRICS_ADD, res == 0 ? 2 * matrix_bytes (A) : 0,
+                 res == 0 ? matrix_bytes (A) : 0);
+
     return res;
 }
 
@@ -252,32 +727,91 @@ int subtract_matrices (const Matrix* A, const Matrix* B, Matrix* result) {
     char cols_match     = 0;    // Флаг совпадения столбцов
     char pointers_valid = 0;    // Флаг для указателей
 
+    METRICS_BEGIN (timer);
+
     // Проверка указателей
     pointers_valid = (A != NULL) && (B != NULL) && (result != NULL);
     if (!pointers_valid) res = -1;
     else {
         // Проверка размеров
-        rows_match = (A->rows == B->rows);
-        cols_match = (A->cols == B->cols);
+        rows_match = (A->rows == B->rows) && (result->rows >= A->rows);
+        cols_match = (A->cols == B->cols) && (result->cols >= A->cols);
         if (!rows_match || !cols_match) res = -1;
+        else if (!matrix_alias_allowed (A, result) ||
+                 !matrix_alias_allowed (B, result))
+            res = -1;   // Частичное пересечение с операндом
+        else if (typed_involved (A, B, result))
+            res = typed_binary (A, B, result, 1);   // float или int32_t
+        else if (small_subtract (A->rows, A->cols, A->block, A->stride, B->block,
+                                 B->stride, result->block, result->stride) == 0)
+            res = 0;   // Малая матрица - развернутым ядром
         else {
-            // Выполнение вычитания
+            // Выполнение вычитания векторным ядром по непрерывным строкам
+            const SimdOps* ops = simd_ops ();
             for (int row = 0; row < A->rows; row++) {
-                for (int col = 0; col < A->cols; col++) {
-                    result->data[row][col] = A->data[row][col] - B->data[row][col];
-                }
+                ops->sub (A->cols, A->block + (size_t) row * A->stride,
+                          B->block + (size_t) row * B->stride,
+                          result->block + (size_t) row * result->stride);
             }
             res = 0;   // Успешное завершение
         }
     }
 
+    METRICS_END (timer, METRICS_SUBTRACT, res == 0 ? 2 * matrix_bytes (A) : 0,
+                 res == 0 ? matrix_bytes (A) : 0);
+
+    return res;
+}
+
+/**
+ * @brief Линейная комбинация на месте: Y = alpha * X + beta * Y
+ *
+ * Строки обрабатываются векторным ядром axpby за один проход по Y, без
+ * промежуточной матрицы. При beta = 0 строка Y сначала обнуляется, чтобы
+ * прежнее содержимое (в том числе NaN) не попало в результат.
+ *
+ * @param alpha Множитель X
+ * @param X Указатель на прибавляемую матрицу
+ * @param beta Множитель Y
+ * @param Y Указатель на накопитель
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int axpby_matrices (double alpha, const Matrix* X, double beta, Matrix* Y) {
+    char res            = -1;   // Флаг ошибок
+    char pointers_valid = (X != NULL) && (Y != NULL);   // Флаг для указателей
+
+    METRICS_BEGIN (timer);
+
+    if (!pointers_valid || X->rows != Y->rows || X->cols != Y->cols) res = -1;
+    else if (!matrix_alias_allowed (X, Y)) res = -1;
+    else if (typed_involved (X, Y, NULL)) res = typed_axpby (alpha, X, beta, Y);
+    else if (X->block != NULL && Y->block != NULL) {
+        const SimdOps* ops = simd_ops ();
+        for (int row = 0; row < X->rows; row++) {
+            const MATRIX_TYPE* x = X->block + (size_t) row * X->stride;
+            MATRIX_TYPE*       y = Y->block + (size_t) row * Y->stride;
+            if (beta == 0 && x != y) {
+                memset (y, 0, (size_t) X->cols * sizeof (MATRIX_TYPE));
+                ops->axpby (X->cols, alpha, x, 1, y);
+            } else {
+                ops->axpby (X->cols, alpha, x, beta, y);
+            }
+        }
+        res = 0;   // Успешное завершение
+    }
+
+    METRICS_END (timer, METRICS_ADD, res == 0 ? 2 * matrix_bytes (X) : 0,
+                 res == 0 ? matrix_bytes (X) : 0);
+
     return res;
 }
 
 /**
  * @brief Умножение двух матриц
  *
- * Выполняет матричное умножение A x B
+ * Выполняет матричное умножение A x B блочным алгоритмом с упаковкой
+ * панелей (см. gemm.h).
  *
  * @param A Указатель на первую матрицу
  * @param B Указатель на вторую матрицу
@@ -288,28 +822,341 @@ int subtract_matrices (const Matrix* A, const Matrix* B, Matrix* result) {
  * @return 0 при успехе, 1 при ошибке
  */
 int multiply_matrices (const Matrix* A, const Matrix* B, Matrix* result) {
+    return multiply_matrices_arena (A, B, result, NULL);
+}
+
+/**
+ * @brief Умножение двух матриц с буферами из арены
+ *
+ * Буферы упаковки панелей (и рабочая область Штрассена при
+ * STRASSEN_AUTO_MIN) берутся из арены, позиция которой восстанавливается
+ * перед выходом.
+ *
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param result Результирующая матрица
+ * @param arena Арена или NULL для выделения в куче
+ *
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_matrices_arena (const Matrix* A, const Matrix* B, Matrix* result,
+                             MatrixArena* arena) {
     char res            = 1;   // Флаг ошибок
     char pointers_valid = (A != NULL) && (B != NULL) && (result != NULL);
     char size_compatible =
         pointers_valid ? (A->cols == B->rows) : 0;   // Флаг совместимости размеров
 
+    if (size_compatible)
+        size_compatible = (result->rows >= A->rows) && (result->cols >= B->cols);
+
+    METRICS_BEGIN (timer);
     if (!pointers_valid || !size_compatible) res = 1;
-    else {
-        for (int row = 0; row < A->rows; row++) {
-            for (int col = 0; col < B->cols; col++) {
-                MATRIX_TYPE sum = 0;
-                for (int k = 0; k < A->cols; k++) {
-                    sum += A->data[row][k] * B->data[k][col];
-                }
-                result->data[row][col] = sum;
-            }
-        }
+    else if (matrices_overlap (A, result) || matrices_overlap (B, result))
+        res = 1;   // Результат пишется до того, как прочитаны операнды
+    else if (typed_involved (A, B, result))
+        res = typed_multiply (A, B, NULL, NULL, result) == 0 ? 0 : 1;
+    else if (small_multiply (A->rows, B->cols, A->cols, A->block, A->stride,
+                             B->block, B->stride, result->block, result->stride,
+                             NULL) == 0)
+        res = 0;   // Малые матрицы - развернутым ядром, без упаковки
+    else if (STRASSEN_AUTO_MIN > 0 && A->rows >= STRASSEN_AUTO_MIN &&
+             A->cols >= STRASSEN_AUTO_MIN && B->cols >= STRASSEN_AUTO_MIN) {
+        // Рабочая область Штрассена - из арены, если она передана
+        const size_t bytes = strassen_workspace_size (A->rows, B->cols, A->cols,
+                                                      STRASSEN_CROSSOVER);
+        ArenaMark    mark  = arena_mark (arena);
+        MATRIX_TYPE* work  = arena ? arena_alloc (arena, bytes) : NULL;
+        if ((work != NULL || arena == NULL) &&
+            strassen_multiply (A->rows, B->cols, A->cols, A->block, A->stride,
+                               B->block, B->stride, result->block, result->stride,
+                               STRASSEN_CROSSOVER, work) == 0)
+            res = 0;
+        arena_reset (arena, mark);
+    } else {
+        // Блочное умножение с упаковкой панелей (gemm.c)
+        if (gemm_multiply_arena (A->rows, B->cols, A->cols, A->block, A->stride, 0,
+                                 B->block, B->stride, 0, result->block,
+                                 result->stride, NULL, arena) == 0)
+            res = 0;
+    }
+
+    METRICS_END (timer, METRICS_MULTIPLY,
+                 res == 0 ? matrix_bytes (A) + matrix_bytes (B) : 0,
+                 res == 0 ? (uint64_t) A->rows * B->cols *
+                                matrix_element_size (result->type)
+                          : 0);
+
+    return res;
+}
+
+/**
+ * @brief Умножение с накоплением: C = alpha * A x B + beta * C
+ *
+ * @param alpha Множитель произведения
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param beta Множитель прежнего C
+ * @param C Указатель на накопитель
+ *
+ * @return 0 при успехе, 1 при ошибке
+ */
+int gemm_matrices (double alpha, const Matrix* A, const Matrix* B, double beta,
+                   Matrix* C) {
+    return gemm_matrices_arena (alpha, A, B, beta, C, NULL);
+}
+
+/**
+ * @brief Умножение с накоплением с буферами из арены
+ *
+ * beta применяется к блоку C перед накоплением в него первого блока
+ * произведения, alpha - при упаковке A (см. gemm_multiply_scaled), поэтому
+ * C читается и пишется один раз, без промежуточной матрицы A x B.
+ *
+ * @param alpha Множитель произведения
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param beta Множитель прежнего C
+ * @param C Указатель на накопитель
+ * @param arena Арена или NULL для выделения в куче
+ *
+ * @return 0 при успехе, 1 при ошибке
+ */
+int gemm_matrices_arena (double alpha, const Matrix* A, const Matrix* B, double beta,
+                         Matrix* C, MatrixArena* arena) {
+    char res             = 1;   // Флаг ошибок
+    char pointers_valid  = (A != NULL) && (B != NULL) && (C != NULL);
+    char size_compatible = pointers_valid ? (A->cols == B->rows) : 0;
+
+    if (size_compatible)
+        size_compatible = (C->rows >= A->rows) && (C->cols >= B->cols);
+
+    METRICS_BEGIN (timer);
+    if (!pointers_valid || !size_compatible) res = 1;
+    else if (matrices_overlap (A, C) || matrices_overlap (B, C)) res = 1;
+    else if (typed_involved (A, B, C))
+        res = typed_gemm (alpha, A, B, beta, C) == 0 ? 0 : 1;
+    else if (gemm_multiply_scaled (A->rows, B->cols, A->cols, alpha, A->block,
+                                   A->stride, 0, B->block, B->stride, 0, beta,
+                                   C->block, C->stride, NULL, arena) == 0)
+        res = 0;
+
+    METRICS_END (timer, METRICS_MULTIPLY,
+                 res == 0 ? matrix_bytes (A) + matrix_bytes (B) +
+                                (beta != 0 ? matrix_bytes (C) : 0)
+                          : 0,
+                 res == 0 ? matrix_bytes (C) : 0);
+
+    return res;
+}
+
+/**
+ * @brief Умножение двух матриц методом Штрассена-Винограда
+ *
+ * Рабочая область для всех уровней рекурсии выделяется один раз
+ * (см. strassen.h).
+ *
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param result Результирующая матрица
+ * @param crossover Размер перехода к обычному умножению, 0 - STRASSEN_CROSSOVER
+ *
+ * @note Число столбцов матрицы А, должно совпадать с числом строк матрицы В.
+ *
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_matrices_strassen (const Matrix* A, const Matrix* B, Matrix* result,
+                                int crossover) {
+    char res            = 1;   // Флаг ошибок
+    char pointers_valid = (A != NULL) && (B != NULL) && (result != NULL);
+    char size_compatible =
+        pointers_valid ? (A->cols == B->rows) : 0;   // Флаг совместимости размеров
+
+    if (size_compatible)
+        size_compatible = (result->rows >= A->rows) && (result->cols >= B->cols);
+
+    // Метод Штрассена-Винограда есть только для MATRIX_TYPE
+    if (pointers_valid && size_compatible && !typed_involved (A, B, result) &&
+        !matrices_overlap (A, result) && !matrices_overlap (B, result)) {
+        if (crossover <= 0) crossover = STRASSEN_CROSSOVER;
+        if (strassen_multiply (A->rows, B->cols, A->cols, A->block, A->stride,
+                               B->block, B->stride, result->block, result->stride,
+                               crossover, NULL) == 0)
+            res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Вычисляет A x B + C - D^T за один проход
+ *
+ * C и D^T применяются в эпилоге блочного умножения к каждой плитке
+ * результата, пока она в кэше (см. GemmEpilogue в gemm.h); D^T не
+ * строится, а читается из D по столбцам плитки. Если result совпадает с C,
+ * произведение накапливается в C (beta = 1), а эпилог только вычитает D^T;
+ * порядок сложения тогда другой, и результат может отличаться от
+ * раздельных операций в последнем знаке.
+ *
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param C Указатель на прибавляемую матрицу
+ * @param D Указатель на матрицу, транспонированная которой вычитается
+ * @param result Результирующая матрица
+ *
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_add_subtract_transposed (const Matrix* A, const Matrix* B,
+                                      const Matrix* C, const Matrix* D,
+                                      Matrix* result) {
+    return multiply_add_subtract_transposed_arena (A, B, C, D, result, NULL);
+}
+
+/**
+ * @brief Вычисляет A x B + C - D^T за один проход с буферами из арены
+ *
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param C Указатель на прибавляемую матрицу
+ * @param D Указатель на матрицу, транспонированная которой вычитается
+ * @param result Результирующая матрица
+ * @param arena Арена или NULL для выделения в куче
+ *
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_add_subtract_transposed_arena (const Matrix* A, const Matrix* B,
+                                            const Matrix* C, const Matrix* D,
+                                            Matrix* result, MatrixArena* arena) {
+    char res            = 1;   // Флаг ошибок
+    char pointers_valid = (A != NULL) && (B != NULL) && (C != NULL) && (D != NULL) &&
+                          (result != NULL);
+    char size_compatible = 0;   // Флаг совместимости размеров
+    char in_place        = 0;   // Флаг накопления прямо в C
+
+    if (pointers_valid) {
+        size_compatible = (A->cols == B->rows) && (C->rows == A->rows) &&
+                          (C->cols == B->cols) && (D->rows == B->cols) &&
+                          (D->cols == A->rows) && (result->rows >= A->rows) &&
+                          (result->cols >= B->cols);
+    }
+    if (size_compatible) {
+        // result может совпадать только с C
+        in_place = matrices_overlap (C, result) && matrix_alias_allowed (C, result);
+        size_compatible = !matrices_overlap (A, result) &&
+                          !matrices_overlap (B, result) &&
+                          !matrices_overlap (D, result) &&
+                          matrix_alias_allowed (C, result);
+    }
+
+    METRICS_BEGIN (timer);
+    if (size_compatible &&
+        (typed_involved (A, B, C) || typed_involved (D, result, NULL))) {
+        // float или int32_t: C - D^T записываются до накопления произведения
+        if (typed_multiply (A, B, C, D, result) == 0) res = 0;
+    } else if (size_compatible) {
+        const GemmEpilogue epilogue = {C->block, C->stride, D->block, D->stride};
+        const GemmEpilogue sub_only = {NULL, 0, D->block, D->stride};
+        // Малые матрицы - развернутым ядром, без упаковки (читает все до записи)
+        if (small_multiply (A->rows, B->cols, A->cols, A->block, A->stride,
+                            B->block, B->stride, result->block, result->stride,
+                            &epilogue) == 0 ||
+            gemm_multiply_scaled (A->rows, B->cols, A->cols, 1, A->block, A->stride,
+                                  0, B->block, B->stride, 0, in_place ? 1 : 0,
+                                  result->block, result->stride,
+                                  in_place ? &sub_only : &epilogue, arena) == 0)
+            res = 0;
+    }
+
+    METRICS_END (timer, METRICS_FUSED,
+                 res == 0 ? matrix_bytes (A) + matrix_bytes (B) + matrix_bytes (C) +
+                                matrix_bytes (D)
+                          : 0,
+                 res == 0 ? matrix_bytes (C) : 0);
+
+    return res;
+}
+
+/**
+ * @brief Прибавляет C и вычитает D^T на месте за один проход
+ *
+ * Результат обходится плитками TRANSPOSE_TILE x TRANSPOSE_TILE тем же
+ * эпилогом, что и в блочном умножении (gemm_epilogue), только без
+ * произведения: каждая плитка получает C и D^T, пока она в кэше, а D^T
+ * читается из D по столбцам плитки и не строится. Порядок операций над
+ * элементом тот же, что у add_matrices и subtract_matrices, поэтому
+ * результат совпадает с ними побитово, и при result == C (2C - D^T).
+ *
+ * @param C Указатель на прибавляемую матрицу
+ * @param D Указатель на матрицу, транспонированная которой вычитается
+ * @param result Накопитель
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int add_subtract_transposed (const Matrix* C, const Matrix* D, Matrix* result) {
+    char res            = -1;   // Флаг ошибок
+    char pointers_valid = (C != NULL) && (D != NULL) && (result != NULL);
+    char size_compatible = 0;   // Флаг совместимости размеров
+
+    METRICS_BEGIN (timer);
+
+    if (pointers_valid) {
+        size_compatible = (D->rows == C->cols) && (D->cols == C->rows) &&
+                          (result->rows >= C->rows) && (result->cols >= C->cols);
+    }
+    if (!size_compatible) res = -1;
+    else if (!matrix_alias_allowed (C, result) || matrices_overlap (D, result))
+        res = -1;   // D^T читается не в том порядке, в каком пишется result
+    else if (typed_involved (C, D, result))
+        res = typed_add_subtract_transposed (C, D, result);   // float или int32_t
+    else if (C->block != NULL && D->block != NULL && result->block != NULL) {
+        const GemmEpilogue epilogue = {C->block, C->stride, D->block, D->stride};
+        gemm_epilogue (C->rows, C->cols, &epilogue, result->block, result->stride);
         res = 0;
     }
 
+    // result - накопитель: он и читается, и пишется
+    METRICS_END (timer, METRICS_ADD,
+                 res == 0 ? matrix_bytes (C) + matrix_bytes (D) +
+                                matrix_bytes (result)
+                          : 0,
+                 res == 0 ? matrix_bytes (result) : 0);
+
     return res;
 }
 
+/**
+ * @brief Рекурсивно транспонирует блок
+ *
+ * Большее измерение делится пополам, пока блок не станет меньше
+ * TRANSPOSE_TILE x TRANSPOSE_TILE, после чего лист транспонируется
+ * векторным ядром. Так на каждом уровне иерархии памяти найдется уровень
+ * рекурсии, на котором исходный и результирующий блоки помещаются в кэш,
+ * без настройки под его размер.
+ *
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходный блок
+ * @param lds Шаг строки src
+ * @param dst Блок результата
+ * @param ldd Шаг строки dst
+ */
+static void matrix_transpose_recursive (int rows, int cols, const MATRIX_TYPE* src,
+                                        int lds, MATRIX_TYPE* dst, int ldd) {
+    if (rows <= TRANSPOSE_TILE && cols <= TRANSPOSE_TILE) {
+        simd_ops ()->transpose (rows, cols, src, lds, dst, ldd);
+    } else if (rows >= cols) {
+        // Половина кратна 8, чтобы листья делились на плитки ядра без остатка
+        const int half = (rows / 2 + 7) & ~7;
+        matrix_transpose_recursive (half, cols, src, lds, dst, ldd);
+        matrix_transpose_recursive (rows - half, cols, src + (size_t) half * lds,
+                                    lds, dst + half, ldd);
+    } else {
+        const int half = (cols / 2 + 7) & ~7;
+        matrix_transpose_recursive (rows, half, src, lds, dst, ldd);
+        matrix_transpose_recursive (rows, cols - half, src + half, lds,
+                                    dst + (size_t) half * ldd, ldd);
+    }
+}
+
 /**
  * @brief Транспонирует матрицу
  *
@@ -324,72 +1171,447 @@ Matrix transpose_matrix (const Matrix* matrix) {
     Matrix res         = {0};
     int    input_valid = 0;
 
+    METRICS_BEGIN (timer);
     // Проверка входных данных
-    input_valid = (matrix != NULL) && (matrix->rows > 0) && (matrix->cols > 0);
+    input_valid = matrix_valid (matrix) && (matrix->rows > 0) && (matrix->cols > 0);
 
-    if (input_valid) {
+    if (input_valid && matrix->type != MATRIX_F64) {
+        res = create_matrix_typed (matrix->cols, matrix->rows, matrix->type);
+        if (matrix_valid (&res) && typed_transpose (matrix, &res) != 0)
+            free_matrix (&res);
+    } else if (input_valid) {
         res = create_matrix (matrix->cols, matrix->rows);
-        if (res.data != NULL) {
-            for (int row = 0; row < matrix->rows; row++) {
-                for (int col = 0; col < matrix->cols; col++) {
-                    res.data[col][row] = matrix->data[row][col];
+        if (res.data != NULL &&
+            small_transpose (matrix->rows, matrix->cols, matrix->block,
+                             matrix->stride, res.block, res.stride) != 0) {
+            // Рекурсивное деление, листья - перестановка плиток в регистрах
+            matrix_transpose_recursive (matrix->rows, matrix->cols, matrix->block,
+                                        matrix->stride, res.block, res.stride);
+        }
+    }
+
+    METRICS_END (timer, METRICS_TRANSPOSE, matrix_bytes (&res), matrix_bytes (&res));
+
+    return res;
+}
+
+/**
+ * @brief Транспонирует квадратную матрицу на месте обменом блоков
+ *
+ * Диагональный блок транспонируется через буфер, пара блоков (I, J) и
+ * (J, I) - через буфер с обменом: оба блока проходят через векторное ядро.
+ *
+ * @param matrix Квадратная матрица
+ * @param buffer Буфер на TRANSPOSE_TILE x TRANSPOSE_TILE элементов
+ */
+static void matrix_transpose_square (Matrix* matrix, MATRIX_TYPE* buffer) {
+    const SimdOps* ops    = simd_ops ();
+    const int      n      = matrix->rows;
+    const int      stride = matrix->stride;
+
+    for (int ib = 0; ib < n; ib += TRANSPOSE_TILE) {
+        const int    rows = n - ib < TRANSPOSE_TILE ? n - ib : TRANSPOSE_TILE;
+        MATRIX_TYPE* diag = matrix->block + (size_t) ib * stride + ib;
+
+        ops->transpose (rows, rows, diag, stride, buffer, TRANSPOSE_TILE);
+        for (int i = 0; i < rows; i++) {
+            memcpy (diag + (size_t) i * stride, buffer + i * TRANSPOSE_TILE,
+                    (size_t) rows * sizeof (MATRIX_TYPE));
+        }
+
+        for (int jb = ib + TRANSPOSE_TILE; jb < n; jb += TRANSPOSE_TILE) {
+            const int    cols  = n - jb < TRANSPOSE_TILE ? n - jb : TRANSPOSE_TILE;
+            MATRIX_TYPE* upper = matrix->block + (size_t) ib * stride + jb;
+            MATRIX_TYPE* lower = matrix->block + (size_t) jb * stride + ib;
+
+            // upper (rows x cols) -> буфер, lower (cols x rows) -> upper
+            ops->transpose (rows, cols, upper, stride, buffer, TRANSPOSE_TILE);
+            ops->transpose (cols, rows, lower, stride, upper, stride);
+            for (int j = 0; j < cols; j++) {
+                memcpy (lower + (size_t) j * stride, buffer + j * TRANSPOSE_TILE,
+                        (size_t) rows * sizeof (MATRIX_TYPE));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Читает 4- или 8-байтовый элемент как целое без знака
+ * @param element Адрес элемента
+ * @param size Размер элемента
+ * @return Биты элемента
+ */
+static inline uint64_t matrix_cycle_load (const char* element, size_t size) {
+    uint64_t bits = 0;
+    uint32_t word = 0;
+
+    if (size == sizeof (uint64_t)) memcpy (&bits, element, sizeof (uint64_t));
+    else {
+        memcpy (&word, element, sizeof (uint32_t));
+        bits = word;
+    }
+
+    return bits;
+}
+
+/**
+ * @brief Записывает биты, прочитанные matrix_cycle_load
+ * @param element Адрес элемента
+ * @param size Размер элемента
+ * @param bits Биты элемента
+ */
+static inline void matrix_cycle_store (char* element, size_t size, uint64_t bits) {
+    const uint32_t word = (uint32_t) bits;
+
+    if (size == sizeof (uint64_t)) memcpy (element, &bits, sizeof (uint64_t));
+    else memcpy (element, &word, sizeof (uint32_t));
+}
+
+/**
+ * @brief Транспонирует плотный массив rows x cols на месте по циклам
+ *
+ * Элемент с индексом r * cols + c переходит на место c * rows + r.
+ * Каждый цикл перестановки обходится один раз; пройденные позиции
+ * отмечаются в битовой маске (1/64 числа элементов).
+ *
+ * @param rows Строк
+ * @param cols Столбцов
+ * @param data Элементы без промежутков между строками
+ * @param size Размер элемента: 4 или 8 байт
+ * @return 0 при успехе, -1 при ошибке выделения маски
+ */
+int matrix_transpose_cycles (int rows, int cols, void* data, size_t size) {
+    const size_t count   = (size_t) rows * cols;
+    char*        bytes   = data;
+    uint64_t*    visited = calloc ((count + 63) / 64, sizeof (uint64_t));
+    int          res     = visited ? 0 : -1;
+
+    METRICS_ALLOCATION ();
+
+    // Первый и последний элементы остаются на месте
+    for (size_t start = 1; visited && start + 1 < count; start++) {
+        if (visited[start / 64] >> (start % 64) & 1) continue;
+
+        uint64_t carried = matrix_cycle_load (bytes + start * size, size);
+        size_t   index   = start;
+        do {
+            index            = index % cols * rows + index / cols;
+            uint64_t swapped = matrix_cycle_load (bytes + index * size, size);
+            matrix_cycle_store (bytes + index * size, size, carried);
+            carried = swapped;
+            visited[index / 64] |= UINT64_C (1) << (index % 64);
+        } while (index != start);
+    }
+
+    free (visited);
+
+    return res;
+}
+
+/**
+ * @brief Транспонирует матрицу на месте
+ *
+ * Прямоугольная матрица переставляется по циклам в своем блоке: с
+ * выровненным шагом, если он помещается, иначе с плотным (stride == rows).
+ * Если блок мал и для плотной раскладки, выделяется новый блок.
+ *
+ * @param matrix Указатель на матрицу
+ *
+ * @return 0 при успехе, -1 при ошибке (матрица не меняется)
+ */
+int transpose_matrix_inplace (Matrix* matrix) {
+    MATRIX_TYPE* buffer = NULL;
+    int          res    = 0;
+
+    METRICS_BEGIN (timer);
+    if (!matrix_valid (matrix) || matrix->rows <= 0 || matrix->cols <= 0) res = -1;
+    // Представление не владеет блоком, и его нельзя переразложить
+    else if (matrix->view && matrix->rows != matrix->cols) res = -1;
+
+    if (res == 0 && matrix->type != MATRIX_F64) {
+        res = typed_transpose_inplace (matrix);   // float или int32_t
+    } else if (res == 0 && matrix->rows == matrix->cols) {
+        // Малые матрицы - развернутым ядром, без буфера
+        if (small_transpose (matrix->rows, matrix->cols, matrix->block,
+                             matrix->stride, matrix->block, matrix->stride) != 0) {
+            buffer = malloc ((size_t) TRANSPOSE_TILE * TRANSPOSE_TILE *
+                             sizeof (MATRIX_TYPE));
+            METRICS_ALLOCATION ();
+            if (buffer) matrix_transpose_square (matrix, buffer);
+            else res = -1;
+            free (buffer);
+        }
+    } else if (res == 0 && matrix->mapping) {
+        res = -1;   // Отображение файла нельзя переразложить
+    } else if (res == 0) {
+        const int    rows     = matrix->rows;
+        const int    cols     = matrix->cols;
+        const size_t size     = sizeof (MATRIX_TYPE);
+        const size_t pointers = (size_t) cols * sizeof (MATRIX_TYPE*);
+        MATRIX_TYPE* block    = matrix->block;
+        // Массив указателей всегда лежит в конце блока
+        const size_t capacity = (size_t) ((char*) matrix->data - (char*) block) +
+                                (size_t) rows * sizeof (MATRIX_TYPE*);
+        int          stride   = matrix_leading_dimension (rows, size);
+
+        // Строки без выравнивания, если выровненные не помещаются в блок
+        if (stride == 0 || (size_t) cols * stride * size + pointers > capacity)
+            stride = rows;
+
+        if ((size_t) cols * stride * size + pointers > capacity) {
+            // Не помещается и плотная раскладка: новый блок
+            Matrix transposed = create_matrix_arena (cols, rows, matrix->arena);
+            if (transposed.data == NULL) res = -1;
+            else {
+                if (small_transpose (rows, cols, block, matrix->stride,
+                                     transposed.block, transposed.stride) != 0) {
+                    matrix_transpose_recursive (rows, cols, block, matrix->stride,
+                                                transposed.block, transposed.stride);
+                }
+                free_matrix (matrix);
+                *matrix = transposed;
+            }
+        } else {
+            // Уплотнение: строки сдвигаются вниз по адресам
+            for (int row = 1; row < rows; row++) {
+                memmove (block + (size_t) row * cols,
+                         block + (size_t) row * matrix->stride,
+                         (size_t) cols * sizeof (MATRIX_TYPE));
+            }
+            res = matrix_transpose_cycles (rows, cols, block, size);
+
+            // Восстановление строк исходной матрицы при ошибке
+            const int width = res == 0 ? rows : cols;
+            const int pitch = res == 0 ? stride : matrix->stride;
+            const int lines = res == 0 ? cols : rows;
+            for (int row = lines - 1; row > 0; row--) {
+                memmove (block + (size_t) row * pitch, block + (size_t) row * width,
+                         (size_t) width * sizeof (MATRIX_TYPE));
+            }
+
+            if (res == 0) {
+                matrix->rows   = cols;
+                matrix->cols   = rows;
+                matrix->stride = stride;
+                matrix->data   = (MATRIX_TYPE**) ((char*) block + capacity -
+                                                pointers);
+                for (int row = 0; row < cols; row++) {
+                    matrix->data[row] = block + (size_t) row * stride;
                 }
             }
         }
     }
 
+    METRICS_END (timer, METRICS_TRANSPOSE, res == 0 ? matrix_bytes (matrix) : 0,
+                 res == 0 ? matrix_bytes (matrix) : 0);
+
     return res;
 }
 
+/**
+ * @brief LU-разложение с частичным выбором ведущего элемента на месте
+ *
+ * Строки переставляются обменом указателей в scratch->data, поэтому после
+ * разложения строка i верхнетреугольной U лежит в scratch->data[i].
+ * Разложение прекращается на первом нулевом столбце.
+ *
+ * @param scratch Рабочая копия квадратной матрицы
+ * @return Знак перестановки (1 или -1) или 0, если матрица вырождена
+ */
+static int matrix_lu_factor (Matrix* scratch) {
+    const int     n    = scratch->rows;
+    MATRIX_TYPE** a    = scratch->data;
+    int           sign = 1;
+
+    for (int k = 0; k < n && sign != 0; k++) {
+        // Поиск ведущего элемента в столбце k
+        int         pivot = k;
+        MATRIX_TYPE max   = a[k][k] < 0 ? -a[k][k] : a[k][k];
+        for (int i = k + 1; i < n; i++) {
+            const MATRIX_TYPE value = a[i][k] < 0 ? -a[i][k] : a[i][k];
+            if (value > max) {
+                max   = value;
+                pivot = i;
+            }
+        }
+
+        if (max == 0) sign = 0;   // Вырожденная матрица
+        else {
+            if (pivot != k) {
+                MATRIX_TYPE* row = a[k];
+                a[k]             = a[pivot];
+                a[pivot]         = row;
+                sign             = -sign;
+            }
+
+            // Исключение под диагональю
+            const MATRIX_TYPE* pivot_row = a[k];
+            for (int i = k + 1; i < n; i++) {
+                MATRIX_TYPE*      row    = a[i];
+                const MATRIX_TYPE factor = row[k] / pivot_row[k];
+                if (factor != 0) {
+                    for (int j = k + 1; j < n; j++) row[j] -= factor * pivot_row[j];
+                }
+            }
+        }
+    }
+
+    return sign;
+}
+
+/**
+ * @brief Создает рабочую копию квадратной матрицы и раскладывает её
+ *
+ * @param matrix Исходная матрица
+ * @param scratch Рабочая копия (освобождается вызывающим)
+ * @param arena Арена для рабочей копии или NULL
+ * @return Знак перестановки, 0 для вырожденной матрицы или при ошибке
+ */
+static int matrix_lu_copy (const Matrix* matrix, Matrix* scratch,
+                           MatrixArena* arena) {
+    int sign = 0;
+
+    *scratch = create_matrix_arena (matrix->rows, matrix->cols, arena);
+    if (scratch->data != NULL) {
+        for (int row = 0; row < matrix->rows; row++) {
+            memcpy (scratch->data[row], matrix->block + (size_t) row * matrix->stride,
+                    (size_t) matrix->cols * sizeof (MATRIX_TYPE));
+        }
+        sign = matrix_lu_factor (scratch);
+    }
+
+    return sign;
+}
+
 /**
  * @brief Вычисляет определитель матрицы
  *
- * Вычисляет определитель квадратной матрицы.
+ * Вычисляет определитель квадратной матрицы как произведение диагонали
+ * U из LU-разложения с частичным выбором ведущего элемента: O(n^3)
+ * операций и одна рабочая копия.
  *
  * @param matrix Указатель на квадратную матрицу
  *
- * @note Используется рекурсивный алгоритм разложения по первой строке
+ * @note Для вырожденной матрицы разложение останавливается на первом
+ * нулевом столбце
  *
  * @return 0 при ошибке или значение детерминанта
  */
 MATRIX_TYPE determinant (const Matrix* matrix) {
+    return determinant_arena (matrix, NULL);
+}
+
+/**
+ * @brief Вычисляет определитель матрицы с рабочей копией в арене
+ *
+ * @param matrix Указатель на квадратную матрицу
+ * @param arena Арена или NULL для выделения в куче
+ *
+ * @return 0 при ошибке или значение детерминанта
+ */
+MATRIX_TYPE determinant_arena (const Matrix* matrix, MatrixArena* arena) {
     MATRIX_TYPE det = 0;   // Значение квадратной матрицы
     char        is_square = 0;   // Флаг квадратности матрицы
+    Matrix      wide      = {0};   // Копия матрицы float или int32_t в double
+
+    METRICS_BEGIN (timer);
+
+    // Детерминант матриц float и int32_t считается в double
+    if (matrix_valid (matrix) && matrix->type != MATRIX_F64) {
+        wide   = convert_matrix_type (matrix, MATRIX_F64);
+        matrix = &wide;
+    }
 
     // Проверка входных данных
-    is_square =
-        (matrix != NULL) && (matrix->rows == matrix->cols) && (matrix->rows > 0);
+    is_square = (matrix != NULL) && (matrix->block != NULL) &&
+                (matrix->rows == matrix->cols) && (matrix->rows > 0);
 
     if (is_square) {
-        // Основная логика вычисления
         const int n = matrix->rows;
-        if (n == 1) det = matrix->data[0][0];
-        else if (n == 2)
-            det = matrix->data[0][0] * matrix->data[1][1] -
-                  matrix->data[0][1] * matrix->data[1][0];
-        else {
-            for (int col = 0; col < n; col++) {
-                Matrix submat = create_matrix (n - 1, n - 1);
-                if (submat.data != NULL) {
-                    // Заполнение подматрицы
-                    for (int row = 1; row < n; row++) {
-                        int subcol_index = 0;
-                        for (int k = 0; k < n; k++) {
-                            if (k != col) {
-                                submat.data[row - 1][subcol_index++] =
-                                    matrix->data[row][k];
-                            }
-                        }
-                    }
-
-                    // Рекурсивный вызов
-                    MATRIX_TYPE sub_det = determinant (&submat);
-                    det += (col % 2 == 0 ? 1 : -1) * matrix->data[0][col] * sub_det;
-                    free_matrix (&submat);
-                }
+        if (n == 1) det = MATRIX_AT (matrix, 0, 0);
+        else if (small_determinant (n, matrix->block, matrix->stride, &det) != 0) {
+            // Матрицы больше SMALL_MAX_SIZE - LU-разложением рабочей копии
+            ArenaMark mark    = arena_mark (arena);
+            Matrix    scratch = {0};
+            int       sign    = matrix_lu_copy (matrix, &scratch, arena);
+            if (sign != 0) {
+                det = sign;
+                for (int i = 0; i < n; i++) det *= scratch.data[i][i];
             }
+            free_matrix (&scratch);
+            arena_reset (arena, mark);
         }
     }
 
+    METRICS_END (timer, METRICS_DETERMINANT,
+                 is_square ? matrix_bytes (matrix) : 0, 0);
+    free_matrix (&wide);
+
     return det;
 }
+
+/**
+ * @brief Вычисляет логарифм модуля определителя и его знак
+ *
+ * Сумма логарифмов диагонали U не переполняется там, где произведение
+ * уже выходит за пределы double.
+ *
+ * @param matrix Указатель на квадратную матрицу
+ * @param sign Знак определителя: 1, -1 или 0 для вырожденной матрицы
+ *
+ * @return log|det| или -INFINITY для вырожденной матрицы и при ошибке
+ */
+double log_determinant (const Matrix* matrix, int* sign) {
+    return log_determinant_arena (matrix, sign, NULL);
+}
+
+/**
+ * @brief Вычисляет логарифм модуля определителя с рабочей копией в арене
+ *
+ * @param matrix Указатель на квадратную матрицу
+ * @param sign Знак определителя: 1, -1 или 0 для вырожденной матрицы
+ * @param arena Арена или NULL для выделения в куче
+ *
+ * @return log|det| или -INFINITY для вырожденной матрицы и при ошибке
+ */
+double log_determinant_arena (const Matrix* matrix, int* sign,
+                              MatrixArena* arena) {
+    double log_det   = -INFINITY;
+    int    det_sign  = 0;
+    Matrix wide      = {0};   // Копия матрицы float или int32_t в double
+    char   is_square = 0;
+
+    METRICS_BEGIN (timer);
+
+    // Логарифм детерминанта матриц float и int32_t считается в double
+    if (matrix_valid (matrix) && matrix->type != MATRIX_F64) {
+        wide   = convert_matrix_type (matrix, MATRIX_F64);
+        matrix = &wide;
+    }
+    is_square = (matrix != NULL) && (matrix->block != NULL) &&
+                (matrix->rows == matrix->cols) && (matrix->rows > 0);
+
+    if (is_square) {
+        ArenaMark mark    = arena_mark (arena);
+        Matrix    scratch = {0};
+        det_sign          = matrix_lu_copy (matrix, &scratch, arena);
+        if (det_sign != 0) {
+            log_det = 0;
+            for (int i = 0; i < matrix->rows; i++) {
+                const double diag = scratch.data[i][i];
+                if (diag < 0) det_sign = -det_sign;
+                log_det += log (fabs (diag));
+            }
+        }
+        free_matrix (&scratch);
+        arena_reset (arena, mark);
+    }
+
+    if (sign) *sign = det_sign;
+
+    METRICS_END (timer, METRICS_DETERMINANT,
+                 is_square ? matrix_bytes (matrix) : 0, 0);
+    free_matrix (&wide);
+
+    return log_det;
+}
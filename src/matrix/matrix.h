@@ -20,28 +20,191 @@
 #define MATRIX_H
 
 #include "../../include/config.h"
+#include "arena.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+/**
+ * @enum MatrixElementType
+ * @brief Тип элементов матрицы
+ */
+typedef enum {
+    MATRIX_F64 = 0,            ///< MATRIX_TYPE (double), доступ через data и block
+    MATRIX_F32,                ///< float, доступ через elements
+    MATRIX_I32,                ///< int32_t, доступ через elements
+    MATRIX_ELEMENT_TYPE_COUNT  ///< Количество типов
+} MatrixElementType;
+
 /**
  * @struct Matrix
  * @brief Структура, представляющая матрицы
+ *
+ * @details
+ * Элементы хранятся в одном блоке памяти, выровненном по MATRIX_ALIGNMENT.
+ * Строка row начинается с block + row * stride, а массив data содержит
+ * указатели на начала строк для совместимости с доступом data[row][col].
+ *
+ * Матрица float или int32_t (type != MATRIX_F64) хранит элементы в
+ * elements с тем же шагом stride, а data и block у нее равны NULL: функции,
+ * работающие только с MATRIX_TYPE, отвергают такую матрицу как пустую.
+ * Нулевая инициализация дает тип MATRIX_F64.
+ *
+ * Представление (matrix_view) - подматрица другой матрицы без копирования:
+ * block или elements указывают на ее первый элемент внутри родителя, шаг
+ * строки - родительский, массива data нет (доступ через MATRIX_AT), а
+ * view = 1. Операции matrix.h принимают представление и как операнд, и как
+ * результат; free_matrix не освобождает память родителя.
  */
 typedef struct {
-    int           rows;   ///< Количество строк
-    int           cols;   ///< Количество столбцов
-    MATRIX_TYPE** data;   ///< Двумерный массив данных
+    int           rows;           ///< Количество строк
+    int           cols;           ///< Количество столбцов
+    MATRIX_TYPE** data;           ///< Указатели на строки внутри block
+    MATRIX_TYPE*  block;          ///< Единый выровненный блок элементов
+    int           stride;         ///< Ведущая размерность (шаг строки в элементах)
+    void*         mapping;        ///< Отображение двоичного файла или NULL
+    size_t        mapping_size;   ///< Размер отображения в байтах
+    MatrixArena*  arena;          ///< Арена, которой принадлежит block, или NULL
+    MatrixElementType type;       ///< Тип элементов
+    void*             elements;   ///< Элементы float или int32_t, иначе NULL
+    int               view;       ///< 1 - представление, память принадлежит родителю
 } Matrix;
 
+/**
+ * @brief Доступ к элементу матрицы через единый блок
+ * @param m Указатель на матрицу
+ * @param row Номер строки
+ * @param col Номер столбца
+ */
+#define MATRIX_AT(m, row, col) ((m)->block[(size_t) (row) * (m)->stride + (col)])
+
+/**
+ * @brief Доступ к элементу матрицы float
+ * @param m Указатель на матрицу типа MATRIX_F32
+ * @param row Номер строки
+ * @param col Номер столбца
+ */
+#define MATRIX_AT_F32(m, row, col)                                                  \
+    (((float*) (m)->elements)[(size_t) (row) * (m)->stride + (col)])
+
+/**
+ * @brief Доступ к элементу матрицы int32_t
+ * @param m Указатель на матрицу типа MATRIX_I32
+ * @param row Номер строки
+ * @param col Номер столбца
+ */
+#define MATRIX_AT_I32(m, row, col)                                                  \
+    (((int32_t*) (m)->elements)[(size_t) (row) * (m)->stride + (col)])
+
+/**
+ * @brief Вычисляет ведущую размерность для заданного числа столбцов
+ * @param cols Количество столбцов
+ * @param size Размер элемента в байтах (sizeof (MATRIX_TYPE) для double)
+ * @return Шаг строки в элементах или 0 при ошибке
+ */
+int matrix_leading_dimension (int cols, size_t size);
+
+/**
+ * @brief Элементов в блоке матрицы rows x cols с шагом matrix_leading_dimension
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param size Размер элемента в байтах
+ * @return Количество элементов или 0 при переполнении
+ */
+size_t matrix_capacity (int rows, int cols, size_t size);
+
+/**
+ * @brief Транспонирует плотный массив rows x cols на месте по циклам
+ * @param rows Строк
+ * @param cols Столбцов
+ * @param data Элементы без промежутков между строками
+ * @param size Размер элемента: 4 или 8 байт
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+int matrix_transpose_cycles (int rows, int cols, void* data, size_t size);
+
 /**
  * @brief Создает новую матрицу с заданными размерами
  * @param rows Количество строк
  * @param cols Количество столбцов
+ * @note Элементы и указатели на строки размещаются одним выделением памяти
  * @return Структура Matrix при успехе или нулевая матрица при ошибке
  */
 Matrix create_matrix (int rows, int cols);
 
+/**
+ * @brief Создает представление подматрицы без копирования элементов
+ * @param parent Родительская матрица или представление любого типа
+ * @param row Первая строка подматрицы в parent
+ * @param col Первый столбец подматрицы в parent
+ * @param rows Количество строк подматрицы
+ * @param cols Количество столбцов подматрицы
+ * @note Представление действительно, пока существует родитель; изменения
+ *       элементов видны в обеих матрицах
+ * @return Представление или нулевая матрица, если блок выходит за parent
+ */
+Matrix matrix_view (const Matrix* parent, int row, int col, int rows, int cols);
+
+/**
+ * @brief Создает матрицу в арене
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param arena Арена или NULL для create_matrix
+ * @note free_matrix не освобождает память такой матрицы: она возвращается
+ *       арене через arena_reset
+ * @return Структура Matrix при успехе или нулевая матрица при ошибке
+ */
+Matrix create_matrix_arena (int rows, int cols, MatrixArena* arena);
+
+/**
+ * @brief Создает матрицу с элементами заданного типа
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param type Тип элементов; MATRIX_F64 - то же, что create_matrix
+ * @return Структура Matrix при успехе или нулевая матрица при ошибке
+ */
+Matrix create_matrix_typed (int rows, int cols, MatrixElementType type);
+
+/**
+ * @brief Проверяет, что матрица создана
+ * @param matrix Указатель на матрицу любого типа
+ * @return 1, если у матрицы есть элементы, иначе 0
+ */
+int matrix_valid (const Matrix* matrix);
+
+/**
+ * @brief Размер элемента заданного типа
+ * @param type Тип элементов
+ * @return Размер в байтах или 0 для неизвестного типа
+ */
+size_t matrix_element_size (MatrixElementType type);
+
+/**
+ * @brief Имя типа элементов
+ * @param type Тип элементов
+ * @return "f64", "f32", "i32" или NULL для неизвестного типа
+ */
+const char* matrix_type_name (MatrixElementType type);
+
+/**
+ * @brief Определяет тип элементов по имени
+ * @param name Имя: "f64", "f32" или "i32"
+ * @param type Найденный тип
+ * @return 0 при успехе, -1 для неизвестного имени
+ */
+int matrix_type_from_name (const char* name, MatrixElementType* type);
+
+/**
+ * @brief Преобразует матрицу к другому типу элементов
+ * @param matrix Указатель на матрицу
+ * @param type Тип элементов результата
+ * @note Дробные значения округляются к ближайшему целому при переходе к
+ *       int32_t, значения вне диапазона насыщаются, NaN дает 0
+ * @return Новая матрица или нулевая матрица при ошибке
+ */
+Matrix convert_matrix_type (const Matrix* matrix, MatrixElementType type);
+
 /**
  * @brief Освобождает память, выделенную под матрицу
  * @param matrix Указатель на матрицу
@@ -49,12 +212,42 @@ Matrix create_matrix (int rows, int cols);
 void free_matrix (Matrix* matrix);
 
 /**
- * @brief Загружает матрицу из текстового файла
+ * @brief Загружает матрицу из текстового или двоичного файла
  * @param filename Имя файла
+ * @note Формат определяется по сигнатуре. Двоичный файл с элементами double
+ *       в порядке байтов машины и выровненными строками отображается в
+ *       память без копирования; изменения матрицы в файл не попадают
  * @return Загруженную матрицу или нулевую матицу в случае ошибки
  */
 Matrix load_matrix_from_file (const char* filename);
 
+/**
+ * @brief Загружает матрицу, сохраняя тип элементов двоичного файла
+ * @param filename Имя файла
+ * @note Двоичный файл float или int32_t дает матрицу MATRIX_F32 или
+ *       MATRIX_I32 (без копирования, если порядок байтов и выравнивание
+ *       позволяют); остальные файлы загружаются как load_matrix_from_file
+ * @return Загруженную матрицу или нулевую матицу в случае ошибки
+ */
+Matrix load_matrix_typed (const char* filename);
+
+/**
+ * @brief Сохраняет матрицу в двоичный файл (формат описан в output.h)
+ * @param matrix Указатель на матрицу
+ * @param filename Имя файла
+ * @note Элементы записываются в типе матрицы
+ * @return 0 в случае успеха, -1 в случае ошибки
+ */
+int save_matrix_to_binary_file (const Matrix* matrix, const char* filename);
+
+/**
+ * @brief Преобразует файл матрицы в другой формат
+ * @param source Исходный файл, текстовый или двоичный
+ * @param destination Файл в противоположном формате
+ * @return 0 в случае успеха, -1 в случае ошибки
+ */
+int convert_matrix_file (const char* source, const char* destination);
+
 /**
  * @brief Выводит матрицу в консоль
  * @param matrix Указатель на матрицу для вывода
@@ -69,11 +262,35 @@ void print_matrix (const Matrix* matrix);
  */
 int save_matrix_to_file (const Matrix* matrix, const char* filename);
 
+/**
+ * @brief Сохраняет матрицу в текстовый файл с заданной точностью
+ * @param matrix Указатель на матрицу
+ * @param filename Имя файла
+ * @param precision Знаков после точки или OUTPUT_PRECISION_LOSSLESS (output.h)
+ *                  для записи, которая загружается обратно без потерь
+ * @return 0 в случае успеха, -1 в случае ошибки
+ */
+int save_matrix_to_file_precision (const Matrix* matrix, const char* filename,
+                                   int precision);
+
+/**
+ * @brief Проверяет, пересекаются ли элементы двух матриц в памяти
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @note Матрицы одного типа и шага (представления одной матрицы)
+ *       сравниваются поэлементно, прочие - по диапазонам адресов от первого
+ *       до последнего элемента
+ * @return 1, если матрицы пересекаются, иначе 0
+ */
+int matrices_overlap (const Matrix* A, const Matrix* B);
+
 /**
  * @brief Складывает две матрицы
  * @param A Указатель на первую матрицу
  * @param B Указатель на вторую матрицу
  * @param result Результирующая матрица
+ * @note result может совпадать с A или B (сложение на месте); частичное
+ *       пересечение с операндом - ошибка
  * @return 0 при успехе, -1 при ошибке
  */
 int add_matrices (const Matrix* A, const Matrix* B, Matrix* result);
@@ -83,19 +300,129 @@ int add_matrices (const Matrix* A, const Matrix* B, Matrix* result);
  * @param A Указатель на первую матрицу
  * @param B Указатель на вторую матрицу
  * @param result Результирующая матрица
+ * @note Правила совпадения result с операндами - как у add_matrices
  * @return 0 при успехе, -1 при ошибке
  */
 int subtract_matrices (const Matrix* A, const Matrix* B, Matrix* result);
 
+/**
+ * @brief Линейная комбинация на месте: Y = alpha * X + beta * Y
+ * @param alpha Множитель X
+ * @param X Указатель на прибавляемую матрицу
+ * @param beta Множитель Y; при 0 прежнее содержимое Y не читается
+ * @param Y Указатель на накопитель того же размера и типа
+ * @note Y может совпадать с X; частичное пересечение - ошибка. Для int32_t
+ *       alpha и beta должны быть целыми
+ * @return 0 при успехе, -1 при ошибке
+ */
+int axpby_matrices (double alpha, const Matrix* X, double beta, Matrix* Y);
+
 /**
  * @brief Умножает две матрицы
  * @param A Указатель на первую матрицу
  * @param B Указатель на вторую матрицу
- * @param result Выводная матрица
+ * @param result Выводная матрица, не пересекающаяся с A и B
  * @return 0 при успехе, 1 при ошибке
  */
 int multiply_matrices (const Matrix* A, const Matrix* B, Matrix* result);
 
+/**
+ * @brief Умножает две матрицы, беря буферы упаковки из арены
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param result Выводная матрица
+ * @param arena Арена или NULL для выделения в куче
+ * @note После прогрева повторные умножения той же формы не обращаются к куче
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_matrices_arena (const Matrix* A, const Matrix* B, Matrix* result,
+                             MatrixArena* arena);
+
+/**
+ * @brief Умножение с накоплением: C = alpha * A x B + beta * C
+ * @param alpha Множитель произведения
+ * @param A Указатель на первую матрицу (m x k)
+ * @param B Указатель на вторую матрицу (k x n)
+ * @param beta Множитель прежнего C; при 0 содержимое C не читается
+ * @param C Указатель на накопитель не меньше m x n
+ * @note C не должна пересекаться с A и B. Для int32_t alpha и beta должны
+ *       быть целыми
+ * @return 0 при успехе, 1 при ошибке
+ */
+int gemm_matrices (double alpha, const Matrix* A, const Matrix* B, double beta,
+                   Matrix* C);
+
+/**
+ * @brief Умножение с накоплением, буферы упаковки - из арены
+ * @param alpha Множитель произведения
+ * @param A Указатель на первую матрицу (m x k)
+ * @param B Указатель на вторую матрицу (k x n)
+ * @param beta Множитель прежнего C
+ * @param C Указатель на накопитель не меньше m x n
+ * @param arena Арена или NULL для выделения в куче
+ * @return 0 при успехе, 1 при ошибке
+ */
+int gemm_matrices_arena (double alpha, const Matrix* A, const Matrix* B, double beta,
+                         Matrix* C, MatrixArena* arena);
+
+/**
+ * @brief Умножает матрицы методом Штрассена-Винограда
+ * @param A Указатель на первую матрицу
+ * @param B Указатель на вторую матрицу
+ * @param result Выводная матрица
+ * @param crossover Размер перехода к обычному умножению, 0 - STRASSEN_CROSSOVER
+ * @note Погрешность выше, чем у multiply_matrices (см. strassen.h)
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_matrices_strassen (const Matrix* A, const Matrix* B, Matrix* result,
+                                int crossover);
+
+/**
+ * @brief Вычисляет A x B + C - D^T за один проход без промежуточных матриц
+ * @param A Указатель на первую матрицу (m x k)
+ * @param B Указатель на вторую матрицу (k x n)
+ * @param C Указатель на прибавляемую матрицу (m x n)
+ * @param D Указатель на матрицу, транспонированная которой вычитается (n x m)
+ * @param result Выводная матрица, не пересекающаяся с A, B и D
+ * @note Если result не совпадает с C, результат побитово совпадает с
+ *       последовательностью multiply_matrices, add_matrices, transpose_matrix
+ *       и subtract_matrices. result может совпадать с C: тогда произведение
+ *       накапливается прямо в C (beta = 1), порядок сложения другой, и
+ *       результат может отличаться от раздельных операций в последнем знаке
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_add_subtract_transposed (const Matrix* A, const Matrix* B,
+                                      const Matrix* C, const Matrix* D,
+                                      Matrix* result);
+
+/**
+ * @brief Вычисляет A x B + C - D^T, беря буферы упаковки из арены
+ * @param A Указатель на первую матрицу (m x k)
+ * @param B Указатель на вторую матрицу (k x n)
+ * @param C Указатель на прибавляемую матрицу (m x n)
+ * @param D Указатель на матрицу, транспонированная которой вычитается (n x m)
+ * @param result Выводная матрица, не пересекающаяся с A, B и D
+ * @param arena Арена или NULL для выделения в куче
+ * @return 0 при успехе, 1 при ошибке
+ */
+int multiply_add_subtract_transposed_arena (const Matrix* A, const Matrix* B,
+                                            const Matrix* C, const Matrix* D,
+                                            Matrix* result, MatrixArena* arena);
+
+/**
+ * @brief Прибавляет C и вычитает D^T на месте: result = result + C - D^T
+ * @param C Указатель на прибавляемую матрицу (m x n)
+ * @param D Указатель на матрицу, транспонированная которой вычитается (n x m)
+ * @param result Накопитель не меньше m x n, не пересекающийся с D; может
+ *               совпадать с C
+ * @note Один проход плитками, D^T не строится. Каждый элемент читается до
+ *       записи, поэтому результат побитово совпадает с add_matrices,
+ *       transpose_matrix и subtract_matrices и на месте: при result == C
+ *       получается 2C - D^T, как add_matrices (C, C) и subtract_matrices
+ * @return 0 при успехе, -1 при ошибке
+ */
+int add_subtract_transposed (const Matrix* C, const Matrix* D, Matrix* result);
+
 /**
  * @brief Транспонирует матрицу
  * @param matrix Указатель на матрицу
@@ -103,12 +430,52 @@ int multiply_matrices (const Matrix* A, const Matrix* B, Matrix* result);
  */
 Matrix transpose_matrix (const Matrix* matrix);
 
+/**
+ * @brief Транспонирует матрицу на месте, без второй матрицы
+ * @param matrix Указатель на матрицу
+ * @note Квадратная матрица транспонируется обменом блоков. Прямоугольная
+ *       уплотняется до шага cols, переставляется по циклам перестановки и
+ *       раскладывается в том же блоке с выровненным шагом, если он
+ *       помещается, иначе с плотным (stride == rows). Если блок мал и для
+ *       плотной раскладки, матрица переносится в новый блок. Отображенная
+ *       из файла матрица и прямоугольное представление не транспонируются
+ *       (-1, матрица не меняется)
+ * @return 0 при успехе, -1 при ошибке
+ */
+int transpose_matrix_inplace (Matrix* matrix);
+
 /**
  * @brief Вычисляет детерминант квадратной матрицы
  * @param matrix Указатель на квадратную матрицу
- * @note Использует рекурсивный алгоритм
+ * @note Использует LU-разложение с частичным выбором ведущего элемента, O(n^3)
  * @return Значение детерминанта матрицы или 0 при ошибке
  */
 MATRIX_TYPE determinant (const Matrix* matrix);
 
+/**
+ * @brief Вычисляет детерминант с рабочей копией LU-разложения в арене
+ * @param matrix Указатель на квадратную матрицу
+ * @param arena Арена или NULL для выделения в куче
+ * @return Значение детерминанта матрицы или 0 при ошибке
+ */
+MATRIX_TYPE determinant_arena (const Matrix* matrix, MatrixArena* arena);
+
+/**
+ * @brief Вычисляет логарифм модуля детерминанта и его знак
+ * @param matrix Указатель на квадратную матрицу
+ * @param sign Знак детерминанта: 1, -1 или 0 для вырожденной матрицы
+ * @note Не переполняется для больших матриц, в отличие от determinant()
+ * @return log|det| или -INFINITY для вырожденной матрицы и при ошибке
+ */
+double log_determinant (const Matrix* matrix, int* sign);
+
+/**
+ * @brief Вычисляет log|det| с рабочей копией LU-разложения в арене
+ * @param matrix Указатель на квадратную матрицу
+ * @param sign Знак детерминанта: 1, -1 или 0 для вырожденной матрицы
+ * @param arena Арена или NULL для выделения в куче
+ * @return log|det| или -INFINITY для вырожденной матрицы и при ошибке
+ */
+double log_determinant_arena (const Matrix* matrix, int* sign, MatrixArena* arena);
+
 #endif   // MATRIX_H
@@ -0,0 +1,336 @@
+/**
+ * @file ooc.c
+ * @brief Реализация умножения матриц, не помещающихся в память
+ *
+ * @details
+ * Блок C хранится как q столбцов по p плиток: столбец плиток j - это
+ * матрица (p * tile) x tile с шагом tile, а плитка (i, j) лежит в нем
+ * подряд и записывается одним pwrite. Так же подряд читаются p плиток A
+ * одного столбца k, поэтому вклад A(:, k) x B(k, j) в столбец j блока
+ * считается одним вызовом gemm_multiply. Крайние плитки дополнены
+ * нулями, и их можно умножать как полные.
+ *
+ * @see ooc.h
+ */
+
+#include "ooc.h"
+
+#include "../output/output.h"
+#include "gemm.h"
+#include "simd.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert (sizeof (MATRIX_TYPE) == sizeof (double),
+                "Плиточные файлы хранят double");
+
+/**
+ * @struct OocLoad
+ * @brief Чтение плиток одного шага k
+ */
+typedef struct {
+    const OutputTiledFile* a;            ///< Файл A
+    const OutputTiledFile* b;            ///< Файл B
+    int                    row;          ///< Первая строка плиток A
+    int                    col;          ///< Первый столбец плиток B
+    int                    block_rows;   ///< Плиток A
+    int                    block_cols;   ///< Плиток B
+    int                    k;            ///< Столбец плиток A и строка плиток B
+    MATRIX_TYPE*           a_tiles;      ///< Буфер плиток A
+    MATRIX_TYPE*           b_tiles;      ///< Буфер плиток B
+    int                    res;          ///< 0 при успехе
+} OocLoad;
+
+/**
+ * @brief Память, которую занимает умножение блоками p x q плиток
+ *
+ * @param tile Сторона плитки
+ * @param block_rows Строк плиток в блоке C
+ * @param block_cols Столбцов плиток в блоке C
+ * @return Размер в байтах
+ */
+size_t ooc_memory (int tile, int block_rows, int block_cols) {
+    const size_t tiles = (size_t) block_rows * block_cols + 3 * (size_t) block_rows +
+                         2 * (size_t) block_cols;
+
+    return tiles * tile * tile * sizeof (MATRIX_TYPE);
+}
+
+/**
+ * @brief Выбирает наибольший блок C, помещающийся в бюджет памяти
+ *
+ * Сначала берется наибольший квадратный блок; если он упирается в
+ * размер C по одному измерению, остаток бюджета отдается другому.
+ *
+ * @param tile Сторона плитки
+ * @param tile_rows Строк плиток в C
+ * @param tile_cols Столбцов плиток в C
+ * @param budget Бюджет памяти в байтах
+ * @param block_rows Строк плиток в блоке
+ * @param block_cols Столбцов плиток в блоке
+ * @return 0 при успехе, -1 если не помещается блок 1 x 1
+ */
+int ooc_block_shape (int tile, int tile_rows, int tile_cols, size_t budget,
+                     int* block_rows, int* block_cols) {
+    const size_t tile_bytes = (size_t) tile * tile * sizeof (MATRIX_TYPE);
+    const size_t tiles      = tile > 0 ? budget / tile_bytes : 0;
+    size_t       p = 1, q = 1;
+    int          res = 0;
+
+    if (tile <= 0 || tile_rows <= 0 || tile_cols <= 0 || tiles < 6) {
+        res = -1;
+    } else {
+        // s^2 + 5s <= tiles
+        while ((p + 1) * (p + 1) + 5 * (p + 1) <= tiles) p++;
+        q = p;
+        if (p > (size_t) tile_rows) p = (size_t) tile_rows;
+        if (q > (size_t) tile_cols) q = (size_t) tile_cols;
+
+        // p * q + 3p + 2q <= tiles
+        if (q < (size_t) tile_cols) q = (tiles - 3 * p) / (p + 2);
+        if (q > (size_t) tile_cols) q = (size_t) tile_cols;
+        if (p < (size_t) tile_rows) p = (tiles - 2 * q) / (q + 3);
+        if (p > (size_t) tile_rows) p = (size_t) tile_rows;
+
+        *block_rows = (int) p;
+        *block_cols = (int) q;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Переписывает двоичный файл матрицы в плиточный
+ *
+ * @param source Двоичный файл
+ * @param destination Плиточный файл
+ * @param tile Сторона плитки или 0 для OOC_TILE
+ * @return 0 при успехе, -1 при ошибке
+ */
+int ooc_tile_file (const char* source, const char* destination, int tile) {
+    OutputBinaryFile src    = {0};
+    OutputTiledFile  dst    = {.fd = -1};
+    MATRIX_TYPE*     buffer = NULL;
+    int              res    = 0;
+
+    if (tile == 0) tile = OOC_TILE;
+
+    if (tile < 0 || output_map_binary_file (source, &src) != 0) res = -1;
+    else if (output_create_tiled_file (destination, (int) src.header.rows,
+                                       (int) src.header.cols, tile, &dst) != 0)
+        res = -1;
+
+    if (res == 0) {
+        buffer = malloc ((size_t) tile * tile * sizeof (MATRIX_TYPE));
+        if (!buffer) res = -1;
+    }
+
+    for (int i = 0; res == 0 && i < dst.tile_rows; i++) {
+        for (int j = 0; res == 0 && j < dst.tile_cols; j++) {
+            const int row  = i * tile;
+            const int col  = j * tile;
+            const int rows = (int) src.header.rows - row < tile
+                                 ? (int) src.header.rows - row
+                                 : tile;
+            const int cols = (int) src.header.cols - col < tile
+                                 ? (int) src.header.cols - col
+                                 : tile;
+
+            // Крайние плитки дополняются нулями
+            if (rows < tile || cols < tile)
+                memset (buffer, 0, (size_t) tile * tile * sizeof (MATRIX_TYPE));
+            res = output_read_binary_block (&src, row, col, rows, cols, tile,
+                                            buffer);
+            if (res == 0) res = output_write_tile (&dst, i, j, buffer);
+        }
+    }
+
+    if (dst.fd >= 0 && output_close_tiled_file (&dst) != 0) res = -1;
+    if (src.mapping) output_unmap_binary_file (&src);
+    free (buffer);
+
+    if (res != 0) fprintf (stderr, "Ошибка записи плиточного файла.\n");
+
+    return res;
+}
+
+/**
+ * @brief Читает плитки одного шага k
+ *
+ * @param arg Описание чтения (OocLoad)
+ * @return NULL
+ */
+static void* ooc_load (void* arg) {
+    OocLoad*     load = arg;
+    const size_t size = (size_t) load->a->header.tile * load->a->header.tile;
+
+    load->res = 0;
+    for (int i = 0; load->res == 0 && i < load->block_rows; i++) {
+        load->res = output_read_tile (load->a, load->row + i, load->k,
+                                      load->a_tiles + i * size);
+    }
+    for (int j = 0; load->res == 0 && j < load->block_cols; j++) {
+        load->res = output_read_tile (load->b, load->k, load->col + j,
+                                      load->b_tiles + j * size);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Вычисляет один блок C, читая следующий шаг k во время умножения
+ *
+ * @param a Файл A
+ * @param loads Описания чтения для двух буферов
+ * @param c Блок C (столбцы плиток подряд)
+ * @param product Промежуточное произведение на p плиток
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int ooc_multiply_block (const OutputTiledFile* a, OocLoad loads[2],
+                               MATRIX_TYPE* c, MATRIX_TYPE* product) {
+    const int    tile   = (int) a->header.tile;
+    const size_t size   = (size_t) tile * tile;
+    const int    rows   = loads[0].block_rows * tile;
+    pthread_t    thread;
+    int          active = 0;   // Чтение следующего шага выполняется потоком
+    int          res    = 0;
+
+    memset (c, 0, (size_t) loads[0].block_rows * loads[0].block_cols * size *
+                      sizeof (MATRIX_TYPE));
+
+    loads[0].k = 0;
+    ooc_load (&loads[0]);
+    res = loads[0].res;
+
+    for (int k = 0; res == 0 && k < a->tile_cols; k++) {
+        OocLoad* current = &loads[k & 1];
+        OocLoad* next    = &loads[(k + 1) & 1];
+
+        if (k + 1 < a->tile_cols) {
+            next->k = k + 1;
+            active  = pthread_create (&thread, NULL, ooc_load, next) == 0;
+            if (!active) ooc_load (next);   // Без потока читаем сразу
+        }
+
+        for (int j = 0; res == 0 && j < current->block_cols; j++) {
+            MATRIX_TYPE* column = c + (size_t) j * current->block_rows * size;
+
+            const MATRIX_TYPE* b_tile = current->b_tiles + j * size;
+
+            if (gemm_multiply (rows, tile, tile, current->a_tiles, tile, b_tile, tile,
+                               product, tile) != 0)
+                res = -1;
+            for (int row = 0; res == 0 && row < rows; row++) {
+                MATRIX_TYPE* line = column + (size_t) row * tile;
+                simd_ops ()->add (tile, line, product + (size_t) row * tile, line);
+            }
+        }
+
+        if (active) pthread_join (thread, NULL);
+        active = 0;
+        if (res == 0 && k + 1 < a->tile_cols) res = next->res;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Вычисляет C = A x B по плиточным файлам
+ *
+ * @param a_file Плиточный файл A
+ * @param b_file Плиточный файл B
+ * @param c_file Плиточный файл результата
+ * @param budget Бюджет памяти в байтах или 0 для OOC_MEMORY_BUDGET
+ * @return 0 при успехе, -1 при ошибке
+ */
+int ooc_multiply (const char* a_file, const char* b_file, const char* c_file,
+                  size_t budget) {
+    OutputTiledFile a = {.fd = -1}, b = {.fd = -1}, c = {.fd = -1};
+    OocLoad         loads[2];
+    MATRIX_TYPE*    buffer = NULL;
+    void*           memory = NULL;
+    int             p = 0, q = 0, tile = 0;
+    int             res = 0;
+
+    if (budget == 0) budget = OOC_MEMORY_BUDGET;
+
+    if (output_open_tiled_file (a_file, &a) != 0 ||
+        output_open_tiled_file (b_file, &b) != 0) {
+        res = -1;
+    } else if (a.header.cols != b.header.rows || a.header.tile != b.header.tile) {
+        fprintf (stderr, "Размеры или плитки матриц не согласованы.\n");
+        res = -1;
+    } else {
+        tile = (int) a.header.tile;
+        if (ooc_block_shape (tile, a.tile_rows, b.tile_cols, budget, &p, &q) != 0) {
+            fprintf (stderr, "Бюджет памяти меньше шести плиток.\n");
+            res = -1;
+        }
+    }
+
+    if (res == 0 && output_create_tiled_file (c_file, (int) a.header.rows,
+                                              (int) b.header.cols, tile, &c) != 0)
+        res = -1;
+
+    if (res == 0) {
+        const size_t bytes = ooc_memory (tile, p, q);
+        if (posix_memalign (&memory, MATRIX_ALIGNMENT, bytes) != 0) {
+            memory = NULL;
+            res    = -1;
+            fprintf (stderr, "Ошибка выделения памяти.\n");
+        }
+    }
+
+    if (res == 0) {
+        const size_t size = (size_t) tile * tile;
+        buffer            = memory;
+        for (int i = 0; i < 2; i++) {
+            loads[i] = (OocLoad) {.a          = &a,
+                                  .b          = &b,
+                                  .block_rows = p,
+                                  .block_cols = q,
+                                  .a_tiles    = buffer + (size_t) p * q * size +
+                                             (size_t) i * (p + q) * size,
+                                  .res        = 0};
+            loads[i].b_tiles = loads[i].a_tiles + (size_t) p * size;
+        }
+    }
+
+    // Блоки C по строкам блоков; последние блоки могут быть неполными
+    for (int row = 0; res == 0 && row < c.tile_rows; row += p) {
+        for (int col = 0; res == 0 && col < c.tile_cols; col += q) {
+            const size_t size        = (size_t) tile * tile;
+            const int    block_rows  = c.tile_rows - row < p ? c.tile_rows - row : p;
+            const int    block_cols  = c.tile_cols - col < q ? c.tile_cols - col : q;
+            MATRIX_TYPE* product     = loads[1].b_tiles + (size_t) q * size;
+
+            for (int i = 0; i < 2; i++) {
+                loads[i].row        = row;
+                loads[i].col        = col;
+                loads[i].block_rows = block_rows;
+                loads[i].block_cols = block_cols;
+            }
+
+            res = ooc_multiply_block (&a, loads, buffer, product);
+            for (int j = 0; res == 0 && j < block_cols; j++) {
+                for (int i = 0; res == 0 && i < block_rows; i++) {
+                    res = output_write_tile (
+                        &c, row + i, col + j,
+                        buffer + ((size_t) j * block_rows + i) * size);
+                }
+            }
+        }
+    }
+
+    if (res != 0) fprintf (stderr, "Ошибка умножения плиточных матриц.\n");
+
+    if (a.fd >= 0) output_close_tiled_file (&a);
+    if (b.fd >= 0) output_close_tiled_file (&b);
+    if (c.fd >= 0 && output_close_tiled_file (&c) != 0) res = -1;
+    free (memory);
+
+    return res;
+}
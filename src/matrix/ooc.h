@@ -0,0 +1,73 @@
+/**
+ * @file ooc.h
+ * @brief Умножение матриц, не помещающихся в память (out-of-core)
+ *
+ * @details
+ * Операнды и результат хранятся в плиточных двоичных файлах (output.h):
+ * каждая плитка tile x tile читается одним pread. Произведение
+ * C = A x B считается блоками C из p x q плиток. Для блока по очереди
+ * читаются столбец из p плиток A и строка из q плиток B с тем же
+ * номером k; пока они умножаются, отдельный поток уже читает плитки
+ * следующего k во второй буфер. Готовый блок C записывается в файл.
+ *
+ * В памяти одновременно находятся p * q плиток C, по два буфера на p
+ * плиток A и q плиток B и p плиток промежуточного произведения, то есть
+ * p * q + 3p + 2q плиток. Форма блока выбирается наибольшей, которая
+ * помещается в бюджет памяти: чем больше блок, тем реже перечитываются A
+ * (n / q раз) и B (m / p раз).
+ *
+ * @see output.h gemm.h
+ */
+
+#ifndef OOC_H
+#define OOC_H
+
+#include "../../include/config.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Память, которую занимает умножение блоками p x q плиток
+ * @param tile Сторона плитки
+ * @param block_rows Строк плиток в блоке C (p)
+ * @param block_cols Столбцов плиток в блоке C (q)
+ * @return Размер в байтах
+ */
+size_t ooc_memory (int tile, int block_rows, int block_cols);
+
+/**
+ * @brief Выбирает наибольший блок C, помещающийся в бюджет памяти
+ * @param tile Сторона плитки
+ * @param tile_rows Строк плиток в C
+ * @param tile_cols Столбцов плиток в C
+ * @param budget Бюджет памяти в байтах
+ * @param block_rows Строк плиток в блоке
+ * @param block_cols Столбцов плиток в блоке
+ * @return 0 при успехе, -1 если в бюджет не помещается даже блок 1 x 1
+ */
+int ooc_block_shape (int tile, int tile_rows, int tile_cols, size_t budget,
+                     int* block_rows, int* block_cols);
+
+/**
+ * @brief Переписывает двоичный файл матрицы в плиточный
+ * @param source Двоичный файл (построчный или плиточный, любой тип)
+ * @param destination Плиточный файл double
+ * @param tile Сторона плитки или 0 для OOC_TILE
+ * @note Исходный файл отображается в память и читается плитками, поэтому
+ *       он может быть больше оперативной памяти
+ * @return 0 при успехе, -1 при ошибке
+ */
+int ooc_tile_file (const char* source, const char* destination, int tile);
+
+/**
+ * @brief Вычисляет C = A x B по плиточным файлам
+ * @param a_file Плиточный файл A
+ * @param b_file Плиточный файл B с той же стороной плитки
+ * @param c_file Плиточный файл результата (перезаписывается)
+ * @param budget Бюджет памяти в байтах или 0 для OOC_MEMORY_BUDGET
+ * @return 0 при успехе, -1 при ошибке
+ */
+int ooc_multiply (const char* a_file, const char* b_file, const char* c_file,
+                  size_t budget);
+
+#endif   // OOC_H
@@ -0,0 +1,392 @@
+/**
+ * @file simd.c
+ * @brief Скалярные ядра и выбор векторной реализации
+ *
+ * @details
+ * Уровень определяется один раз через pthread_once: сначала по cpuid
+ * выбирается лучший поддерживаемый уровень, затем, если задана переменная
+ * MATRIX_SIMD, он понижается или повышается до запрошенного (но не выше
+ * поддерживаемого процессором).
+ *
+ * @see simd.h
+ */
+
+#include "simd.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Строк в плитке переносимого микроядра */
+#define SCALAR_MR 4
+
+/** Столбцов в плитке переносимого микроядра */
+#define SCALAR_NR 8
+
+/**
+ * @brief Переносимое микроядро 4 x 8
+ *
+ * Накопители лежат в локальном массиве фиксированного размера, что
+ * позволяет компилятору держать их в регистрах.
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void gemm_kernel_scalar (int kc, const MATRIX_TYPE* restrict a,
+                                const MATRIX_TYPE* restrict b,
+                                MATRIX_TYPE* restrict c, int ldc, int accumulate) {
+    MATRIX_TYPE acc[SCALAR_MR][SCALAR_NR] = {{0}};
+
+    for (int p = 0; p < kc; p++) {
+        const MATRIX_TYPE* a_p = a + p * SCALAR_MR;
+        const MATRIX_TYPE* b_p = b + p * SCALAR_NR;
+        for (int i = 0; i < SCALAR_MR; i++) {
+            for (int j = 0; j < SCALAR_NR; j++) acc[i][j] += a_p[i] * b_p[j];
+        }
+    }
+
+    for (int i = 0; i < SCALAR_MR; i++) {
+        MATRIX_TYPE* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            for (int j = 0; j < SCALAR_NR; j++) c_i[j] += acc[i][j];
+        } else {
+            for (int j = 0; j < SCALAR_NR; j++) c_i[j] = acc[i][j];
+        }
+    }
+}
+
+static const GemmKernel scalar_kernel = {"scalar", SCALAR_MR, SCALAR_NR,
+                                         gemm_kernel_scalar};
+
+/**
+ * @brief Переносимое микроядро float 4 x 8
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void gemm_kernel_scalar_f32 (int kc, const float* restrict a,
+                                    const float* restrict b, float* restrict c,
+                                    int ldc, int accumulate) {
+    float acc[SCALAR_MR][SCALAR_NR] = {{0}};
+
+    for (int p = 0; p < kc; p++) {
+        const float* a_p = a + p * SCALAR_MR;
+        const float* b_p = b + p * SCALAR_NR;
+        for (int i = 0; i < SCALAR_MR; i++) {
+            for (int j = 0; j < SCALAR_NR; j++) acc[i][j] += a_p[i] * b_p[j];
+        }
+    }
+
+    for (int i = 0; i < SCALAR_MR; i++) {
+        float* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            for (int j = 0; j < SCALAR_NR; j++) c_i[j] += acc[i][j];
+        } else {
+            for (int j = 0; j < SCALAR_NR; j++) c_i[j] = acc[i][j];
+        }
+    }
+}
+
+static const GemmKernelF32 scalar_kernel_f32 = {"scalar", SCALAR_MR, SCALAR_NR,
+                                                gemm_kernel_scalar_f32};
+
+/** Размер плитки скалярного транспонирования */
+#define SCALAR_TRANSPOSE_TILE 8
+
+static const char* const level_names[SIMD_LEVEL_COUNT] = {"scalar", "sse2", "avx2",
+                                                          "avx512"};
+
+static const SimdOps* active_ops = NULL;   // Активная таблица
+static pthread_once_t ops_once   = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Скалярное сложение строки
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void scalar_add (int n, const MATRIX_TYPE* a, const MATRIX_TYPE* b,
+                        MATRIX_TYPE* r) {
+    for (int i = 0; i < n; i++) r[i] = a[i] + b[i];
+}
+
+/**
+ * @brief Скалярное вычитание строки
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void scalar_sub (int n, const MATRIX_TYPE* a, const MATRIX_TYPE* b,
+                        MATRIX_TYPE* r) {
+    for (int i = 0; i < n; i++) r[i] = a[i] - b[i];
+}
+
+/**
+ * @brief Скалярное вычитание произведения строк
+ *
+ * @param n Количество элементов
+ * @param a Первый множитель
+ * @param b Второй множитель
+ * @param r Накопитель: r[i] -= a[i] * b[i]
+ */
+static void scalar_mul_sub (int n, const MATRIX_TYPE* a, const MATRIX_TYPE* b,
+                            MATRIX_TYPE* r) {
+    for (int i = 0; i < n; i++) r[i] -= a[i] * b[i];
+}
+
+/**
+ * @brief Скалярное пакетное умножение
+ *
+ * @param len Длина отрезка
+ * @param m Строк в a и c
+ * @param n Столбцов в b и c
+ * @param k Столбцов в a и строк в b
+ * @param a Отрезки a
+ * @param lda Шаг отрезков a
+ * @param b Отрезки b
+ * @param ldb Шаг отрезков b
+ * @param c Отрезки результата
+ * @param ldc Шаг отрезков c
+ */
+static void scalar_batch_gemm (int len, int m, int n, int k, const MATRIX_TYPE* a,
+                               size_t lda, const MATRIX_TYPE* b, size_t ldb,
+                               MATRIX_TYPE* c, size_t ldc) {
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            MATRIX_TYPE* r = c + ((size_t) i * n + j) * ldc;
+            for (int l = 0; l < len; l++) r[l] = 0;
+            for (int p = 0; p < k; p++) {
+                const MATRIX_TYPE* x = a + ((size_t) i * k + p) * lda;
+                const MATRIX_TYPE* y = b + ((size_t) p * n + j) * ldb;
+                for (int l = 0; l < len; l++) r[l] += x[l] * y[l];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Скалярное транспонирование блока плитками 8 x 8
+ *
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходный блок
+ * @param lds Шаг строки src
+ * @param dst Блок результата
+ * @param ldd Шаг строки dst
+ */
+static void scalar_transpose (int rows, int cols, const MATRIX_TYPE* src, int lds,
+                              MATRIX_TYPE* dst, int ldd) {
+    for (int ib = 0; ib < rows; ib += SCALAR_TRANSPOSE_TILE) {
+        const int i_end =
+            (rows - ib < SCALAR_TRANSPOSE_TILE) ? rows : ib + SCALAR_TRANSPOSE_TILE;
+        for (int jb = 0; jb < cols; jb += SCALAR_TRANSPOSE_TILE) {
+            const int j_end = (cols - jb < SCALAR_TRANSPOSE_TILE)
+                                  ? cols
+                                  : jb + SCALAR_TRANSPOSE_TILE;
+            for (int i = ib; i < i_end; i++) {
+                for (int j = jb; j < j_end; j++) {
+                    dst[(size_t) j * ldd + i] = src[(size_t) i * lds + j];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Скалярное сложение строки float
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void scalar_add_f32 (int n, const float* a, const float* b, float* r) {
+    for (int i = 0; i < n; i++) r[i] = a[i] + b[i];
+}
+
+/**
+ * @brief Скалярное вычитание строки float
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void scalar_sub_f32 (int n, const float* a, const float* b, float* r) {
+    for (int i = 0; i < n; i++) r[i] = a[i] - b[i];
+}
+
+/**
+ * @brief Скалярное накопление строки float
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void scalar_axpy_f32 (int n, float alpha, const float* x, float* y) {
+    for (int i = 0; i < n; i++) y[i] += alpha * x[i];
+}
+
+/**
+ * @brief Скалярное накопление строки int32_t по модулю 2^32
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void scalar_axpy_i32 (int n, int32_t alpha, const int32_t* x, int32_t* y) {
+    for (int i = 0; i < n; i++) {
+        y[i] = (int32_t) ((uint32_t) y[i] + (uint32_t) alpha * (uint32_t) x[i]);
+    }
+}
+
+/**
+ * @brief Скалярная линейная комбинация строк
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель x
+ * @param x Прибавляемая строка
+ * @param beta Множитель y
+ * @param y Накопитель: y[i] = alpha * x[i] + beta * y[i]
+ */
+static void scalar_axpby (int n, MATRIX_TYPE alpha, const MATRIX_TYPE* x,
+                          MATRIX_TYPE beta, MATRIX_TYPE* y) {
+    for (int i = 0; i < n; i++) y[i] = alpha * x[i] + beta * y[i];
+}
+
+/**
+ * @brief Таблица скалярного уровня
+ *
+ * @return Таблица реализаций
+ */
+const SimdOps* simd_scalar_ops (void) {
+    static const SimdOps ops = {
+        SIMD_SCALAR,    "scalar",          &scalar_kernel,    scalar_add,
+        scalar_sub,     scalar_mul_sub,    scalar_batch_gemm, scalar_transpose,
+        scalar_add_f32, scalar_sub_f32,    scalar_axpy_f32,   scalar_axpy_i32,
+        scalar_axpby,   &scalar_kernel_f32,
+    };
+    return &ops;
+}
+
+/**
+ * @brief Определяет лучший уровень, поддерживаемый процессором
+ *
+ * @return Уровень
+ */
+SimdLevel simd_detect_level (void) {
+    SimdLevel level = SIMD_SCALAR;
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("sse2")) level = SIMD_SSE2;
+    if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+        level = SIMD_AVX2;
+    if (__builtin_cpu_supports ("avx512f")) level = SIMD_AVX512;
+#endif
+
+    return level;
+}
+
+/**
+ * @brief Возвращает имя уровня
+ *
+ * @param level Уровень
+ * @return Имя или NULL
+ */
+const char* simd_level_name (SimdLevel level) {
+    return (level >= SIMD_SCALAR && level < SIMD_LEVEL_COUNT) ? level_names[level]
+                                                              : NULL;
+}
+
+/**
+ * @brief Возвращает таблицу для заданного уровня
+ *
+ * @param level Уровень
+ * @return Таблица или NULL, если уровень недоступен
+ */
+const SimdOps* simd_ops_for_level (SimdLevel level) {
+    const SimdOps* ops = NULL;
+
+    if (level >= SIMD_SCALAR && level <= simd_detect_level ()) {
+        switch (level) {
+        case SIMD_SCALAR: ops = simd_scalar_ops (); break;
+        case SIMD_SSE2: ops = simd_sse2_ops (); break;
+        case SIMD_AVX2: ops = simd_avx2_ops (); break;
+        case SIMD_AVX512: ops = simd_avx512_ops (); break;
+        default: break;
+        }
+    }
+
+    return ops;
+}
+
+/**
+ * @brief Выбирает уровень по cpuid и переменной окружения
+ */
+static void simd_init (void) {
+    SimdLevel   level     = simd_detect_level ();
+    const char* requested = getenv (SIMD_ENV_VAR);
+
+    if (requested && *requested) {
+        int found = 0;
+        for (int i = 0; i < SIMD_LEVEL_COUNT; i++) {
+            if (strcmp (requested, level_names[i]) == 0) {
+                found = 1;
+                if ((SimdLevel) i <= level) level = (SimdLevel) i;
+                else
+                    fprintf (stderr, "%s=%s не поддерживается процессором.\n",
+                             SIMD_ENV_VAR, requested);
+            }
+        }
+        if (!found) fprintf (stderr, "Неизвестное значение %s.\n", SIMD_ENV_VAR);
+    }
+
+    // Уровень может быть не собран для текущей архитектуры
+    while (simd_ops_for_level (level) == NULL && level > SIMD_SCALAR) level--;
+    active_ops = simd_ops_for_level (level);
+}
+
+/**
+ * @brief Возвращает активную таблицу реализаций
+ *
+ * @return Таблица реализаций
+ */
+const SimdOps* simd_ops (void) {
+    pthread_once (&ops_once, simd_init);
+    return active_ops;
+}
+
+/**
+ * @brief Принудительно устанавливает активный уровень
+ *
+ * @param level Уровень
+ * @return 0 при успехе, -1 если уровень недоступен
+ */
+int simd_set_level (SimdLevel level) {
+    const SimdOps* ops = simd_ops_for_level (level);
+    int            res = -1;
+
+    pthread_once (&ops_once, simd_init);
+    if (ops) {
+        active_ops = ops;
+        res        = 0;
+    }
+
+    return res;
+}
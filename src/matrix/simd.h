@@ -0,0 +1,200 @@
+/**
+ * @file simd.h
+ * @brief Векторные ядра и выбор реализации во время выполнения
+ *
+ * @details
+ * Для каждого уровня набора инструкций (скалярный C, SSE2, AVX2+FMA,
+ * AVX-512) существует таблица SimdOps с реализациями:
+ * - микроядра умножения (см. gemm.h)
+ * - поэлементного сложения и вычитания строки
+ * - вычитания произведения строк и пакетного умножения (см. batch.h)
+ * - транспонирования прямоугольного блока
+ * - сложения, вычитания и axpy строк float, axpy строк int32_t и
+ *   микроядра умножения float (typed.h)
+ *
+ * Лучший уровень выбирается один раз при первом обращении по результатам
+ * cpuid. Переменная окружения MATRIX_SIMD (scalar, sse2, avx2, avx512)
+ * принудительно задает уровень; если процессор его не поддерживает,
+ * используется лучший доступный.
+ *
+ * @see gemm.h
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "../../include/config.h"
+#include "gemm.h"
+
+#include <stdint.h>
+
+/** Имя переменной окружения для принудительного выбора уровня */
+#define SIMD_ENV_VAR "MATRIX_SIMD"
+
+/**
+ * @enum SimdLevel
+ * @brief Уровни векторных расширений по возрастанию
+ */
+typedef enum {
+    SIMD_SCALAR = 0,   ///< Переносимый C
+    SIMD_SSE2,         ///< SSE2, 128 бит
+    SIMD_AVX2,         ///< AVX2 и FMA, 256 бит
+    SIMD_AVX512,       ///< AVX-512F, 512 бит
+    SIMD_LEVEL_COUNT   ///< Количество уровней
+} SimdLevel;
+
+/**
+ * @brief Поэлементная операция над строкой: r[i] = a[i] op b[i]
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+typedef void (*simd_binary_fn) (int n, const MATRIX_TYPE* a, const MATRIX_TYPE* b,
+                                MATRIX_TYPE* r);
+
+/** Кратность длины отрезка в пакетном умножении */
+#define SIMD_BATCH_LANES 8
+
+/**
+ * @brief Пакетное умножение len матриц с чередованием элементов
+ *
+ * Элемент (i, j) матрицы x всех len матриц - отрезок x + (i * cols + j) * ldx;
+ * для каждой матрицы отрезка c = a x b. Накопители держатся в регистрах
+ * для нескольких столбцов c сразу, поэтому каждый элемент a читается
+ * один раз на блок столбцов, а c записывается один раз.
+ *
+ * @param len Длина отрезка, кратная SIMD_BATCH_LANES
+ * @param m Строк в a и c
+ * @param n Столбцов в b и c
+ * @param k Столбцов в a и строк в b
+ * @param a Отрезки a
+ * @param lda Шаг отрезков a
+ * @param b Отрезки b
+ * @param ldb Шаг отрезков b
+ * @param c Отрезки результата
+ * @param ldc Шаг отрезков c
+ */
+typedef void (*simd_batch_gemm_fn) (int len, int m, int n, int k,
+                                    const MATRIX_TYPE* a, size_t lda,
+                                    const MATRIX_TYPE* b, size_t ldb, MATRIX_TYPE* c,
+                                    size_t ldc);
+
+/**
+ * @brief Транспонирование блока: dst[j][i] = src[i][j]
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходный блок
+ * @param lds Шаг строки src
+ * @param dst Блок результата
+ * @param ldd Шаг строки dst
+ */
+typedef void (*simd_transpose_fn) (int rows, int cols, const MATRIX_TYPE* src,
+                                   int lds, MATRIX_TYPE* dst, int ldd);
+
+/**
+ * @brief Поэлементная операция над строкой float: r[i] = a[i] op b[i]
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+typedef void (*simd_binary_f32_fn) (int n, const float* a, const float* b,
+                                    float* r);
+
+/**
+ * @brief Накопление строки float: y[i] += alpha * x[i]
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель
+ */
+typedef void (*simd_axpy_f32_fn) (int n, float alpha, const float* x, float* y);
+
+/**
+ * @brief Накопление строки int32_t по модулю 2^32: y[i] += alpha * x[i]
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель
+ */
+typedef void (*simd_axpy_i32_fn) (int n, int32_t alpha, const int32_t* x,
+                                  int32_t* y);
+
+/**
+ * @brief Линейная комбинация строк: y[i] = alpha * x[i] + beta * y[i]
+ * @param n Количество элементов
+ * @param alpha Множитель x
+ * @param x Прибавляемая строка
+ * @param beta Множитель y
+ * @param y Накопитель; может совпадать с x
+ */
+typedef void (*simd_axpby_fn) (int n, MATRIX_TYPE alpha, const MATRIX_TYPE* x,
+                               MATRIX_TYPE beta, MATRIX_TYPE* y);
+
+/**
+ * @struct SimdOps
+ * @brief Таблица реализаций для одного уровня
+ */
+typedef struct {
+    SimdLevel            level;        ///< Уровень
+    const char*          name;         ///< Имя уровня
+    const GemmKernel*    gemm;         ///< Микроядро умножения
+    simd_binary_fn       add;          ///< Сложение строк
+    simd_binary_fn       sub;          ///< Вычитание строк
+    simd_binary_fn       mul_sub;      ///< Накопление r[i] -= a[i] * b[i]
+    simd_batch_gemm_fn   batch_gemm;   ///< Пакетное умножение (batch.h)
+    simd_transpose_fn    transpose;    ///< Транспонирование блока
+    simd_binary_f32_fn   add_f32;      ///< Сложение строк float
+    simd_binary_f32_fn   sub_f32;      ///< Вычитание строк float
+    simd_axpy_f32_fn     axpy_f32;     ///< Накопление y += alpha * x для float
+    simd_axpy_i32_fn     axpy_i32;     ///< Накопление y += alpha * x для int32_t
+    simd_axpby_fn        axpby;        ///< y = alpha * x + beta * y
+    const GemmKernelF32* gemm_f32;     ///< Микроядро умножения float
+} SimdOps;
+
+/**
+ * @brief Возвращает активную таблицу реализаций
+ * @note При первом вызове определяет уровень процессора и читает MATRIX_SIMD
+ * @return Таблица реализаций
+ */
+const SimdOps* simd_ops (void);
+
+/**
+ * @brief Возвращает таблицу для заданного уровня
+ * @param level Уровень
+ * @return Таблица или NULL, если уровень не собран или не поддерживается
+ */
+const SimdOps* simd_ops_for_level (SimdLevel level);
+
+/**
+ * @brief Определяет лучший уровень, поддерживаемый процессором
+ * @return Уровень
+ */
+SimdLevel simd_detect_level (void);
+
+/**
+ * @brief Принудительно устанавливает активный уровень
+ * @param level Уровень
+ * @note Не должна вызываться параллельно с матричными операциями
+ * @return 0 при успехе, -1 если уровень недоступен
+ */
+int simd_set_level (SimdLevel level);
+
+/**
+ * @brief Возвращает имя уровня
+ * @param level Уровень
+ * @return Строка с именем или NULL для неизвестного уровня
+ */
+const char* simd_level_name (SimdLevel level);
+
+/**
+ * @brief Таблицы отдельных уровней (simd_*.c)
+ * @return Таблица или NULL, если уровень не собран для этой архитектуры
+ */
+const SimdOps* simd_scalar_ops (void);
+const SimdOps* simd_sse2_ops (void);
+const SimdOps* simd_avx2_ops (void);
+const SimdOps* simd_avx512_ops (void);
+
+#endif   // SIMD_H
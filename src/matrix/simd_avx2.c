@@ -0,0 +1,433 @@
+/**
+ * @file simd_avx2.c
+ * @brief Ядра AVX2 + FMA (256 бит, 4 элемента double)
+ *
+ * @details
+ * Файл собирается с -mavx2 -mfma. Функции вызываются только после проверки
+ * cpuid в simd.c, поэтому остальной код программы остается совместимым со
+ * старыми процессорами.
+ *
+ * @see simd.h
+ */
+
+#include "simd.h"
+
+#include <stddef.h>
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+#include <immintrin.h>
+
+_Static_assert (sizeof (MATRIX_TYPE) == sizeof (double),
+                "Ядра AVX2 рассчитаны на MATRIX_TYPE = double");
+
+/** Строк в плитке микроядра */
+#define AVX2_MR 6
+
+/** Столбцов в плитке микроядра */
+#define AVX2_NR 8
+
+/** Строк в плитке микроядра float */
+#define AVX2_MR_F32 6
+
+/** Столбцов в плитке микроядра float */
+#define AVX2_NR_F32 16
+
+/** Размер блока транспонирования для локальности кэша */
+#define AVX2_TRANSPOSE_BLOCK 32
+
+/** Столбцов результата на блок накопителей пакетного умножения */
+#define AVX2_BATCH_NR 4
+
+/**
+ * @brief Микроядро 6 x 8: 12 регистров-накопителей, FMA
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void avx2_gemm_kernel (int kc, const double* restrict a,
+                              const double* restrict b, double* restrict c, int ldc,
+                              int accumulate) {
+    __m256d acc[AVX2_MR][2];
+
+#pragma GCC unroll 6
+    for (int i = 0; i < AVX2_MR; i++) {
+        acc[i][0] = _mm256_setzero_pd ();
+        acc[i][1] = _mm256_setzero_pd ();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m256d b0 = _mm256_loadu_pd (b);
+        const __m256d b1 = _mm256_loadu_pd (b + 4);
+#pragma GCC unroll 6
+        for (int i = 0; i < AVX2_MR; i++) {
+            const __m256d a_i = _mm256_broadcast_sd (a + i);
+            acc[i][0]         = _mm256_fmadd_pd (a_i, b0, acc[i][0]);
+            acc[i][1]         = _mm256_fmadd_pd (a_i, b1, acc[i][1]);
+        }
+        a += AVX2_MR;
+        b += AVX2_NR;
+    }
+
+#pragma GCC unroll 6
+    for (int i = 0; i < AVX2_MR; i++) {
+        double* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_pd (acc[i][0], _mm256_loadu_pd (c_i));
+            acc[i][1] = _mm256_add_pd (acc[i][1], _mm256_loadu_pd (c_i + 4));
+        }
+        _mm256_storeu_pd (c_i, acc[i][0]);
+        _mm256_storeu_pd (c_i + 4, acc[i][1]);
+    }
+}
+
+static const GemmKernel avx2_kernel = {"avx2", AVX2_MR, AVX2_NR, avx2_gemm_kernel};
+
+/**
+ * @brief Микроядро float 6 x 16: 12 регистров-накопителей, FMA
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void avx2_gemm_kernel_f32 (int kc, const float* restrict a,
+                                  const float* restrict b, float* restrict c,
+                                  int ldc, int accumulate) {
+    __m256 acc[AVX2_MR_F32][2];
+
+#pragma GCC unroll 6
+    for (int i = 0; i < AVX2_MR_F32; i++) {
+        acc[i][0] = _mm256_setzero_ps ();
+        acc[i][1] = _mm256_setzero_ps ();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m256 b0 = _mm256_loadu_ps (b);
+        const __m256 b1 = _mm256_loadu_ps (b + 8);
+#pragma GCC unroll 6
+        for (int i = 0; i < AVX2_MR_F32; i++) {
+            const __m256 a_i = _mm256_broadcast_ss (a + i);
+            acc[i][0]        = _mm256_fmadd_ps (a_i, b0, acc[i][0]);
+            acc[i][1]        = _mm256_fmadd_ps (a_i, b1, acc[i][1]);
+        }
+        a += AVX2_MR_F32;
+        b += AVX2_NR_F32;
+    }
+
+#pragma GCC unroll 6
+    for (int i = 0; i < AVX2_MR_F32; i++) {
+        float* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_ps (acc[i][0], _mm256_loadu_ps (c_i));
+            acc[i][1] = _mm256_add_ps (acc[i][1], _mm256_loadu_ps (c_i + 8));
+        }
+        _mm256_storeu_ps (c_i, acc[i][0]);
+        _mm256_storeu_ps (c_i + 8, acc[i][1]);
+    }
+}
+
+static const GemmKernelF32 avx2_kernel_f32 = {"avx2", AVX2_MR_F32, AVX2_NR_F32,
+                                              avx2_gemm_kernel_f32};
+
+/**
+ * @brief Сложение строки
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx2_add (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd (r + i, _mm256_add_pd (_mm256_loadu_pd (a + i),
+                                                _mm256_loadu_pd (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] + b[i];
+}
+
+/**
+ * @brief Вычитание строки
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx2_sub (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd (r + i, _mm256_sub_pd (_mm256_loadu_pd (a + i),
+                                                _mm256_loadu_pd (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] - b[i];
+}
+
+/**
+ * @brief Вычитание произведения строк через FMA
+ *
+ * @param n Количество элементов
+ * @param a Первый множитель
+ * @param b Второй множитель
+ * @param r Накопитель: r[i] -= a[i] * b[i]
+ */
+static void avx2_mul_sub (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd (r + i, _mm256_fnmadd_pd (_mm256_loadu_pd (a + i),
+                                                   _mm256_loadu_pd (b + i),
+                                                   _mm256_loadu_pd (r + i)));
+    }
+    for (; i < n; i++) r[i] -= a[i] * b[i];
+}
+
+/**
+ * @brief Пакетное умножение: FMA, по 4 матрицы в регистре
+ *
+ * Для каждых 4 матриц отрезка строка c считается блоками по
+ * AVX2_BATCH_NR столбцов, накопители блока - в регистрах.
+ *
+ * @param len Длина отрезка, кратная SIMD_BATCH_LANES
+ * @param m Строк в a и c
+ * @param n Столбцов в b и c
+ * @param k Столбцов в a и строк в b
+ * @param a Отрезки a
+ * @param lda Шаг отрезков a
+ * @param b Отрезки b
+ * @param ldb Шаг отрезков b
+ * @param c Отрезки результата
+ * @param ldc Шаг отрезков c
+ */
+static void avx2_batch_gemm (int len, int m, int n, int k, const double* a,
+                             size_t lda, const double* b, size_t ldb, double* c,
+                             size_t ldc) {
+    for (int l = 0; l < len; l += 4) {
+        for (int i = 0; i < m; i++) {
+            const double* ai = a + (size_t) i * k * lda + l;
+            double*       ci = c + (size_t) i * n * ldc + l;
+            int           j  = 0;
+            for (; j + AVX2_BATCH_NR <= n; j += AVX2_BATCH_NR) {
+                __m256d c0 = _mm256_setzero_pd (), c1 = c0, c2 = c0, c3 = c0;
+                for (int p = 0; p < k; p++) {
+                    const __m256d va = _mm256_loadu_pd (ai + p * lda);
+                    const double* bp = b + ((size_t) p * n + j) * ldb + l;
+                    c0 = _mm256_fmadd_pd (va, _mm256_loadu_pd (bp), c0);
+                    c1 = _mm256_fmadd_pd (va, _mm256_loadu_pd (bp + ldb), c1);
+                    c2 = _mm256_fmadd_pd (va, _mm256_loadu_pd (bp + 2 * ldb), c2);
+                    c3 = _mm256_fmadd_pd (va, _mm256_loadu_pd (bp + 3 * ldb), c3);
+                }
+                _mm256_storeu_pd (ci + j * ldc, c0);
+                _mm256_storeu_pd (ci + (j + 1) * ldc, c1);
+                _mm256_storeu_pd (ci + (j + 2) * ldc, c2);
+                _mm256_storeu_pd (ci + (j + 3) * ldc, c3);
+            }
+            for (; j < n; j++) {
+                const double* bj  = b + (size_t) j * ldb + l;
+                const size_t  bn  = (size_t) n * ldb;   // Шаг строки b
+                __m256d       acc = _mm256_setzero_pd ();
+                for (int p = 0; p < k; p++) {
+                    const __m256d va = _mm256_loadu_pd (ai + p * lda);
+                    const __m256d vb = _mm256_loadu_pd (bj + p * bn);
+                    acc              = _mm256_fmadd_pd (va, vb, acc);
+                }
+                _mm256_storeu_pd (ci + j * ldc, acc);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Транспонирует плитку 4 x 4 в регистрах
+ *
+ * @param src Начало плитки
+ * @param lds Шаг строки src
+ * @param dst Начало плитки результата
+ * @param ldd Шаг строки dst
+ */
+static inline void avx2_transpose_4x4 (const double* src, int lds, double* dst,
+                                       int ldd) {
+    const __m256d r0 = _mm256_loadu_pd (src);
+    const __m256d r1 = _mm256_loadu_pd (src + lds);
+    const __m256d r2 = _mm256_loadu_pd (src + 2 * (size_t) lds);
+    const __m256d r3 = _mm256_loadu_pd (src + 3 * (size_t) lds);
+
+    const __m256d t0 = _mm256_unpacklo_pd (r0, r1);   // r0_0 r1_0 r0_2 r1_2
+    const __m256d t1 = _mm256_unpackhi_pd (r0, r1);   // r0_1 r1_1 r0_3 r1_3
+    const __m256d t2 = _mm256_unpacklo_pd (r2, r3);
+    const __m256d t3 = _mm256_unpackhi_pd (r2, r3);
+
+    _mm256_storeu_pd (dst, _mm256_permute2f128_pd (t0, t2, 0x20));
+    _mm256_storeu_pd (dst + ldd, _mm256_permute2f128_pd (t1, t3, 0x20));
+    _mm256_storeu_pd (dst + 2 * (size_t) ldd, _mm256_permute2f128_pd (t0, t2, 0x31));
+    _mm256_storeu_pd (dst + 3 * (size_t) ldd, _mm256_permute2f128_pd (t1, t3, 0x31));
+}
+
+/**
+ * @brief Транспонирование блока плитками 4 x 4 в регистрах
+ *
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходный блок
+ * @param lds Шаг строки src
+ * @param dst Блок результата
+ * @param ldd Шаг строки dst
+ */
+static void avx2_transpose (int rows, int cols, const double* src, int lds,
+                            double* dst, int ldd) {
+    for (int ib = 0; ib < rows; ib += AVX2_TRANSPOSE_BLOCK) {
+        const int i_end = (rows - ib < AVX2_TRANSPOSE_BLOCK) ? rows
+                                                             : ib + AVX2_TRANSPOSE_BLOCK;
+        for (int jb = 0; jb < cols; jb += AVX2_TRANSPOSE_BLOCK) {
+            const int j_end = (cols - jb < AVX2_TRANSPOSE_BLOCK)
+                                  ? cols
+                                  : jb + AVX2_TRANSPOSE_BLOCK;
+            int i = ib;
+            for (; i + 4 <= i_end; i += 4) {
+                int j = jb;
+                for (; j + 4 <= j_end; j += 4) {
+                    avx2_transpose_4x4 (src + (size_t) i * lds + j, lds,
+                                        dst + (size_t) j * ldd + i, ldd);
+                }
+                for (; j < j_end; j++) {
+                    for (int ii = i; ii < i + 4; ii++) {
+                        dst[(size_t) j * ldd + ii] = src[(size_t) ii * lds + j];
+                    }
+                }
+            }
+            for (; i < i_end; i++) {
+                for (int j = jb; j < j_end; j++) {
+                    dst[(size_t) j * ldd + i] = src[(size_t) i * lds + j];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Сложение строки float
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx2_add_f32 (int n, const float* a, const float* b, float* r) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps (r + i, _mm256_add_ps (_mm256_loadu_ps (a + i),
+                                                _mm256_loadu_ps (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] + b[i];
+}
+
+/**
+ * @brief Вычитание строки float
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx2_sub_f32 (int n, const float* a, const float* b, float* r) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps (r + i, _mm256_sub_ps (_mm256_loadu_ps (a + i),
+                                                _mm256_loadu_ps (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] - b[i];
+}
+
+/**
+ * @brief Накопление строки float через FMA
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void avx2_axpy_f32 (int n, float alpha, const float* x, float* y) {
+    const __m256 va = _mm256_set1_ps (alpha);
+    int          i  = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps (y + i, _mm256_fmadd_ps (va, _mm256_loadu_ps (x + i),
+                                                  _mm256_loadu_ps (y + i)));
+    }
+    for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+/**
+ * @brief Накопление строки int32_t по модулю 2^32
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void avx2_axpy_i32 (int n, int32_t alpha, const int32_t* x, int32_t* y) {
+    const __m256i va = _mm256_set1_epi32 (alpha);
+    int           i  = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i vx = _mm256_loadu_si256 ((const __m256i*) (x + i));
+        const __m256i vy = _mm256_loadu_si256 ((const __m256i*) (y + i));
+        _mm256_storeu_si256 ((__m256i*) (y + i),
+                             _mm256_add_epi32 (vy, _mm256_mullo_epi32 (va, vx)));
+    }
+    for (; i < n; i++) {
+        y[i] = (int32_t) ((uint32_t) y[i] + (uint32_t) alpha * (uint32_t) x[i]);
+    }
+}
+
+/**
+ * @brief Линейная комбинация строк через FMA
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель x
+ * @param x Прибавляемая строка
+ * @param beta Множитель y
+ * @param y Накопитель: y[i] = alpha * x[i] + beta * y[i]
+ */
+static void avx2_axpby (int n, double alpha, const double* x, double beta,
+                        double* y) {
+    const __m256d va = _mm256_set1_pd (alpha);
+    const __m256d vb = _mm256_set1_pd (beta);
+    int           i  = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d by = _mm256_mul_pd (vb, _mm256_loadu_pd (y + i));
+        _mm256_storeu_pd (y + i, _mm256_fmadd_pd (va, _mm256_loadu_pd (x + i), by));
+    }
+    for (; i < n; i++) y[i] = alpha * x[i] + beta * y[i];
+}
+
+/**
+ * @brief Таблица уровня AVX2
+ *
+ * @return Таблица реализаций
+ */
+const SimdOps* simd_avx2_ops (void) {
+    static const SimdOps ops = {
+        SIMD_AVX2, "avx2", &avx2_kernel, avx2_add, avx2_sub, avx2_mul_sub,
+        avx2_batch_gemm, avx2_transpose, avx2_add_f32, avx2_sub_f32, avx2_axpy_f32,
+        avx2_axpy_i32, avx2_axpby, &avx2_kernel_f32,
+    };
+    return &ops;
+}
+
+#else
+
+/**
+ * @brief Уровень AVX2 не собран для этой архитектуры
+ *
+ * @return NULL
+ */
+const SimdOps* simd_avx2_ops (void) {
+    return NULL;
+}
+
+#endif
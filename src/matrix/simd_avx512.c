@@ -0,0 +1,494 @@
+/**
+ * @file simd_avx512.c
+ * @brief Ядра AVX-512F (512 бит, 8 элементов double)
+ *
+ * @details
+ * Файл собирается с -mavx512f. Функции вызываются только после проверки
+ * cpuid в simd.c.
+ *
+ * @see simd.h
+ */
+
+#include "simd.h"
+
+#include <stddef.h>
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+_Static_assert (sizeof (MATRIX_TYPE) == sizeof (double),
+                "Ядра AVX-512 рассчитаны на MATRIX_TYPE = double");
+
+/** Строк в плитке микроядра */
+#define AVX512_MR 12
+
+/** Столбцов в плитке микроядра */
+#define AVX512_NR 16
+
+/** Строк в плитке микроядра float */
+#define AVX512_MR_F32 12
+
+/** Столбцов в плитке микроядра float */
+#define AVX512_NR_F32 32
+
+/** Размер блока транспонирования для локальности кэша */
+#define AVX512_TRANSPOSE_BLOCK 64
+
+/** Столбцов результата на блок накопителей пакетного умножения */
+#define AVX512_BATCH_NR 4
+
+/**
+ * @brief Микроядро 12 x 16: 24 регистра-накопителя, FMA
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void avx512_gemm_kernel (int kc, const double* restrict a,
+                                const double* restrict b, double* restrict c,
+                                int ldc, int accumulate) {
+    __m512d acc[AVX512_MR][2];
+
+#pragma GCC unroll 12
+    for (int i = 0; i < AVX512_MR; i++) {
+        acc[i][0] = _mm512_setzero_pd ();
+        acc[i][1] = _mm512_setzero_pd ();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m512d b0 = _mm512_loadu_pd (b);
+        const __m512d b1 = _mm512_loadu_pd (b + 8);
+#pragma GCC unroll 12
+        for (int i = 0; i < AVX512_MR; i++) {
+            const __m512d a_i = _mm512_set1_pd (a[i]);
+            acc[i][0]         = _mm512_fmadd_pd (a_i, b0, acc[i][0]);
+            acc[i][1]         = _mm512_fmadd_pd (a_i, b1, acc[i][1]);
+        }
+        a += AVX512_MR;
+        b += AVX512_NR;
+    }
+
+#pragma GCC unroll 12
+    for (int i = 0; i < AVX512_MR; i++) {
+        double* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_pd (acc[i][0], _mm512_loadu_pd (c_i));
+            acc[i][1] = _mm512_add_pd (acc[i][1], _mm512_loadu_pd (c_i + 8));
+        }
+        _mm512_storeu_pd (c_i, acc[i][0]);
+        _mm512_storeu_pd (c_i + 8, acc[i][1]);
+    }
+}
+
+static const GemmKernel avx512_kernel = {"avx512", AVX512_MR, AVX512_NR,
+                                         avx512_gemm_kernel};
+
+/**
+ * @brief Микроядро float 12 x 32: 24 регистра-накопителя, FMA
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void avx512_gemm_kernel_f32 (int kc, const float* restrict a,
+                                    const float* restrict b, float* restrict c,
+                                    int ldc, int accumulate) {
+    __m512 acc[AVX512_MR_F32][2];
+
+#pragma GCC unroll 12
+    for (int i = 0; i < AVX512_MR_F32; i++) {
+        acc[i][0] = _mm512_setzero_ps ();
+        acc[i][1] = _mm512_setzero_ps ();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m512 b0 = _mm512_loadu_ps (b);
+        const __m512 b1 = _mm512_loadu_ps (b + 16);
+#pragma GCC unroll 12
+        for (int i = 0; i < AVX512_MR_F32; i++) {
+            const __m512 a_i = _mm512_set1_ps (a[i]);
+            acc[i][0]        = _mm512_fmadd_ps (a_i, b0, acc[i][0]);
+            acc[i][1]        = _mm512_fmadd_ps (a_i, b1, acc[i][1]);
+        }
+        a += AVX512_MR_F32;
+        b += AVX512_NR_F32;
+    }
+
+#pragma GCC unroll 12
+    for (int i = 0; i < AVX512_MR_F32; i++) {
+        float* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_ps (acc[i][0], _mm512_loadu_ps (c_i));
+            acc[i][1] = _mm512_add_ps (acc[i][1], _mm512_loadu_ps (c_i + 16));
+        }
+        _mm512_storeu_ps (c_i, acc[i][0]);
+        _mm512_storeu_ps (c_i + 16, acc[i][1]);
+    }
+}
+
+static const GemmKernelF32 avx512_kernel_f32 = {
+    "avx512", AVX512_MR_F32, AVX512_NR_F32, avx512_gemm_kernel_f32};
+
+/**
+ * @brief Сложение строки, хвост обрабатывается маской
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx512_add (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd (r + i, _mm512_add_pd (_mm512_loadu_pd (a + i),
+                                                _mm512_loadu_pd (b + i)));
+    }
+    if (i < n) {
+        const __mmask8 mask = (__mmask8) ((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd (r + i, mask,
+                               _mm512_add_pd (_mm512_maskz_loadu_pd (mask, a + i),
+                                              _mm512_maskz_loadu_pd (mask, b + i)));
+    }
+}
+
+/**
+ * @brief Вычитание строки, хвост обрабатывается маской
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx512_sub (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd (r + i, _mm512_sub_pd (_mm512_loadu_pd (a + i),
+                                                _mm512_loadu_pd (b + i)));
+    }
+    if (i < n) {
+        const __mmask8 mask = (__mmask8) ((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd (r + i, mask,
+                               _mm512_sub_pd (_mm512_maskz_loadu_pd (mask, a + i),
+                                              _mm512_maskz_loadu_pd (mask, b + i)));
+    }
+}
+
+/**
+ * @brief Вычитание произведения строк через FMA, хвост - маской
+ *
+ * @param n Количество элементов
+ * @param a Первый множитель
+ * @param b Второй множитель
+ * @param r Накопитель: r[i] -= a[i] * b[i]
+ */
+static void avx512_mul_sub (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd (r + i, _mm512_fnmadd_pd (_mm512_loadu_pd (a + i),
+                                                   _mm512_loadu_pd (b + i),
+                                                   _mm512_loadu_pd (r + i)));
+    }
+    if (i < n) {
+        const __mmask8 mask = (__mmask8) ((1u << (n - i)) - 1);
+        const __m512d  va   = _mm512_maskz_loadu_pd (mask, a + i);
+        const __m512d  vb   = _mm512_maskz_loadu_pd (mask, b + i);
+        const __m512d  acc  = _mm512_maskz_loadu_pd (mask, r + i);
+        _mm512_mask_storeu_pd (r + i, mask, _mm512_fnmadd_pd (va, vb, acc));
+    }
+}
+
+/**
+ * @brief Пакетное умножение: FMA, по 8 матриц в регистре
+ *
+ * Для каждых 8 матриц отрезка строка c считается блоками по
+ * AVX512_BATCH_NR столбцов, накопители блока - в регистрах.
+ *
+ * @param len Длина отрезка, кратная SIMD_BATCH_LANES
+ * @param m Строк в a и c
+ * @param n Столбцов в b и c
+ * @param k Столбцов в a и строк в b
+ * @param a Отрезки a
+ * @param lda Шаг отрезков a
+ * @param b Отрезки b
+ * @param ldb Шаг отрезков b
+ * @param c Отрезки результата
+ * @param ldc Шаг отрезков c
+ */
+static void avx512_batch_gemm (int len, int m, int n, int k, const double* a,
+                               size_t lda, const double* b, size_t ldb, double* c,
+                               size_t ldc) {
+    for (int l = 0; l < len; l += 8) {
+        for (int i = 0; i < m; i++) {
+            const double* ai = a + (size_t) i * k * lda + l;
+            double*       ci = c + (size_t) i * n * ldc + l;
+            int           j  = 0;
+            for (; j + AVX512_BATCH_NR <= n; j += AVX512_BATCH_NR) {
+                __m512d c0 = _mm512_setzero_pd (), c1 = c0, c2 = c0, c3 = c0;
+                for (int p = 0; p < k; p++) {
+                    const __m512d va = _mm512_loadu_pd (ai + p * lda);
+                    const double* bp = b + ((size_t) p * n + j) * ldb + l;
+                    c0 = _mm512_fmadd_pd (va, _mm512_loadu_pd (bp), c0);
+                    c1 = _mm512_fmadd_pd (va, _mm512_loadu_pd (bp + ldb), c1);
+                    c2 = _mm512_fmadd_pd (va, _mm512_loadu_pd (bp + 2 * ldb), c2);
+                    c3 = _mm512_fmadd_pd (va, _mm512_loadu_pd (bp + 3 * ldb), c3);
+                }
+                _mm512_storeu_pd (ci + j * ldc, c0);
+                _mm512_storeu_pd (ci + (j + 1) * ldc, c1);
+                _mm512_storeu_pd (ci + (j + 2) * ldc, c2);
+                _mm512_storeu_pd (ci + (j + 3) * ldc, c3);
+            }
+            for (; j < n; j++) {
+                const double* bj  = b + (size_t) j * ldb + l;
+                const size_t  bn  = (size_t) n * ldb;   // Шаг строки b
+                __m512d       acc = _mm512_setzero_pd ();
+                for (int p = 0; p < k; p++) {
+                    const __m512d va = _mm512_loadu_pd (ai + p * lda);
+                    const __m512d vb = _mm512_loadu_pd (bj + p * bn);
+                    acc              = _mm512_fmadd_pd (va, vb, acc);
+                }
+                _mm512_storeu_pd (ci + j * ldc, acc);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Транспонирует плитку 8 x 8 в регистрах
+ *
+ * Сначала unpack переставляет пары элементов соседних строк, затем два
+ * уровня shuffle_f64x2 собирают 128-битные полосы в столбцы.
+ *
+ * @param src Начало плитки
+ * @param lds Шаг строки src
+ * @param dst Начало плитки результата
+ * @param ldd Шаг строки dst
+ */
+static inline void avx512_transpose_8x8 (const double* src, int lds, double* dst,
+                                         int ldd) {
+    __m512d r[8], t[8], u[8];
+
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++) r[i] = _mm512_loadu_pd (src + (size_t) i * lds);
+
+#pragma GCC unroll 4
+    for (int i = 0; i < 4; i++) {
+        t[2 * i]     = _mm512_unpacklo_pd (r[2 * i], r[2 * i + 1]);
+        t[2 * i + 1] = _mm512_unpackhi_pd (r[2 * i], r[2 * i + 1]);
+    }
+
+    // u[0], u[4]: столбцы 0 и 4; u[1], u[5]: 2 и 6; u[2], u[6]: 1 и 5; u[3], u[7]: 3 и 7
+    u[0] = _mm512_shuffle_f64x2 (t[0], t[2], 0x88);
+    u[1] = _mm512_shuffle_f64x2 (t[0], t[2], 0xDD);
+    u[2] = _mm512_shuffle_f64x2 (t[1], t[3], 0x88);
+    u[3] = _mm512_shuffle_f64x2 (t[1], t[3], 0xDD);
+    u[4] = _mm512_shuffle_f64x2 (t[4], t[6], 0x88);
+    u[5] = _mm512_shuffle_f64x2 (t[4], t[6], 0xDD);
+    u[6] = _mm512_shuffle_f64x2 (t[5], t[7], 0x88);
+    u[7] = _mm512_shuffle_f64x2 (t[5], t[7], 0xDD);
+
+    _mm512_storeu_pd (dst, _mm512_shuffle_f64x2 (u[0], u[4], 0x88));
+    _mm512_storeu_pd (dst + 1 * (size_t) ldd, _mm512_shuffle_f64x2 (u[2], u[6], 0x88));
+    _mm512_storeu_pd (dst + 2 * (size_t) ldd, _mm512_shuffle_f64x2 (u[1], u[5], 0x88));
+    _mm512_storeu_pd (dst + 3 * (size_t) ldd, _mm512_shuffle_f64x2 (u[3], u[7], 0x88));
+    _mm512_storeu_pd (dst + 4 * (size_t) ldd, _mm512_shuffle_f64x2 (u[0], u[4], 0xDD));
+    _mm512_storeu_pd (dst + 5 * (size_t) ldd, _mm512_shuffle_f64x2 (u[2], u[6], 0xDD));
+    _mm512_storeu_pd (dst + 6 * (size_t) ldd, _mm512_shuffle_f64x2 (u[1], u[5], 0xDD));
+    _mm512_storeu_pd (dst + 7 * (size_t) ldd, _mm512_shuffle_f64x2 (u[3], u[7], 0xDD));
+}
+
+/**
+ * @brief Транспонирование блока плитками 8 x 8 в регистрах
+ *
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходный блок
+ * @param lds Шаг строки src
+ * @param dst Блок результата
+ * @param ldd Шаг строки dst
+ */
+static void avx512_transpose (int rows, int cols, const double* src, int lds,
+                              double* dst, int ldd) {
+    for (int ib = 0; ib < rows; ib += AVX512_TRANSPOSE_BLOCK) {
+        const int i_end = (rows - ib < AVX512_TRANSPOSE_BLOCK)
+                              ? rows
+                              : ib + AVX512_TRANSPOSE_BLOCK;
+        for (int jb = 0; jb < cols; jb += AVX512_TRANSPOSE_BLOCK) {
+            const int j_end = (cols - jb < AVX512_TRANSPOSE_BLOCK)
+                                  ? cols
+                                  : jb + AVX512_TRANSPOSE_BLOCK;
+            int i = ib;
+            for (; i + 8 <= i_end; i += 8) {
+                int j = jb;
+                for (; j + 8 <= j_end; j += 8) {
+                    avx512_transpose_8x8 (src + (size_t) i * lds + j, lds,
+                                          dst + (size_t) j * ldd + i, ldd);
+                }
+                for (; j < j_end; j++) {
+                    for (int ii = i; ii < i + 8; ii++) {
+                        dst[(size_t) j * ldd + ii] = src[(size_t) ii * lds + j];
+                    }
+                }
+            }
+            for (; i < i_end; i++) {
+                for (int j = jb; j < j_end; j++) {
+                    dst[(size_t) j * ldd + i] = src[(size_t) i * lds + j];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Сложение строки float, хвост обрабатывается маской
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx512_add_f32 (int n, const float* a, const float* b, float* r) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps (r + i, _mm512_add_ps (_mm512_loadu_ps (a + i),
+                                                _mm512_loadu_ps (b + i)));
+    }
+    if (i < n) {
+        const __mmask16 mask = (__mmask16) ((1u << (n - i)) - 1);
+        _mm512_mask_storeu_ps (r + i, mask,
+                               _mm512_add_ps (_mm512_maskz_loadu_ps (mask, a + i),
+                                              _mm512_maskz_loadu_ps (mask, b + i)));
+    }
+}
+
+/**
+ * @brief Вычитание строки float, хвост обрабатывается маской
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void avx512_sub_f32 (int n, const float* a, const float* b, float* r) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps (r + i, _mm512_sub_ps (_mm512_loadu_ps (a + i),
+                                                _mm512_loadu_ps (b + i)));
+    }
+    if (i < n) {
+        const __mmask16 mask = (__mmask16) ((1u << (n - i)) - 1);
+        _mm512_mask_storeu_ps (r + i, mask,
+                               _mm512_sub_ps (_mm512_maskz_loadu_ps (mask, a + i),
+                                              _mm512_maskz_loadu_ps (mask, b + i)));
+    }
+}
+
+/**
+ * @brief Накопление строки float через FMA, хвост - маской
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void avx512_axpy_f32 (int n, float alpha, const float* x, float* y) {
+    const __m512 va = _mm512_set1_ps (alpha);
+    int          i  = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps (y + i, _mm512_fmadd_ps (va, _mm512_loadu_ps (x + i),
+                                                  _mm512_loadu_ps (y + i)));
+    }
+    if (i < n) {
+        const __mmask16 mask = (__mmask16) ((1u << (n - i)) - 1);
+        const __m512    vx   = _mm512_maskz_loadu_ps (mask, x + i);
+        const __m512    vy   = _mm512_maskz_loadu_ps (mask, y + i);
+        _mm512_mask_storeu_ps (y + i, mask, _mm512_fmadd_ps (va, vx, vy));
+    }
+}
+
+/**
+ * @brief Накопление строки int32_t по модулю 2^32, хвост - маской
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void avx512_axpy_i32 (int n, int32_t alpha, const int32_t* x, int32_t* y) {
+    const __m512i va = _mm512_set1_epi32 (alpha);
+    int           i  = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512i vx = _mm512_loadu_si512 (x + i);
+        const __m512i vy = _mm512_loadu_si512 (y + i);
+        _mm512_storeu_si512 (y + i,
+                             _mm512_add_epi32 (vy, _mm512_mullo_epi32 (va, vx)));
+    }
+    if (i < n) {
+        const __mmask16 mask = (__mmask16) ((1u << (n - i)) - 1);
+        const __m512i   vx   = _mm512_maskz_loadu_epi32 (mask, x + i);
+        const __m512i   vy   = _mm512_maskz_loadu_epi32 (mask, y + i);
+        const __m512i   sum  = _mm512_add_epi32 (vy, _mm512_mullo_epi32 (va, vx));
+        _mm512_mask_storeu_epi32 (y + i, mask, sum);
+    }
+}
+
+/**
+ * @brief Линейная комбинация строк через FMA, хвост - маской
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель x
+ * @param x Прибавляемая строка
+ * @param beta Множитель y
+ * @param y Накопитель: y[i] = alpha * x[i] + beta * y[i]
+ */
+static void avx512_axpby (int n, double alpha, const double* x, double beta,
+                          double* y) {
+    const __m512d va = _mm512_set1_pd (alpha);
+    const __m512d vb = _mm512_set1_pd (beta);
+    int           i  = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d by = _mm512_mul_pd (vb, _mm512_loadu_pd (y + i));
+        _mm512_storeu_pd (y + i, _mm512_fmadd_pd (va, _mm512_loadu_pd (x + i), by));
+    }
+    if (i < n) {
+        const __mmask8 mask = (__mmask8) ((1u << (n - i)) - 1);
+        const __m512d  vx   = _mm512_maskz_loadu_pd (mask, x + i);
+        const __m512d  vy   = _mm512_maskz_loadu_pd (mask, y + i);
+        _mm512_mask_storeu_pd (y + i, mask,
+                               _mm512_fmadd_pd (va, vx, _mm512_mul_pd (vb, vy)));
+    }
+}
+
+/**
+ * @brief Таблица уровня AVX-512
+ *
+ * @return Таблица реализаций
+ */
+const SimdOps* simd_avx512_ops (void) {
+    static const SimdOps ops = {
+        SIMD_AVX512,    "avx512",          &avx512_kernel,   avx512_add,
+        avx512_sub,     avx512_mul_sub,    avx512_batch_gemm, avx512_transpose,
+        avx512_add_f32, avx512_sub_f32,    avx512_axpy_f32,   avx512_axpy_i32,
+        avx512_axpby,   &avx512_kernel_f32,
+    };
+    return &ops;
+}
+
+#else
+
+/**
+ * @brief Уровень AVX-512 не собран для этой архитектуры
+ *
+ * @return NULL
+ */
+const SimdOps* simd_avx512_ops (void) {
+    return NULL;
+}
+
+#endif
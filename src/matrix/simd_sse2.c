@@ -0,0 +1,430 @@
+/**
+ * @file simd_sse2.c
+ * @brief Ядра SSE2 (128 бит, 2 элемента double)
+ *
+ * @details
+ * Файл собирается с -msse2. Если макрос __SSE2__ не определен (другая
+ * архитектура), таблица уровня отсутствует и simd_sse2_ops возвращает NULL.
+ *
+ * @see simd.h
+ */
+
+#include "simd.h"
+
+#include <stddef.h>
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+_Static_assert (sizeof (MATRIX_TYPE) == sizeof (double),
+                "Ядра SSE2 рассчитаны на MATRIX_TYPE = double");
+
+/** Строк в плитке микроядра */
+#define SSE2_MR 4
+
+/** Столбцов в плитке микроядра */
+#define SSE2_NR 4
+
+/** Строк в плитке микроядра float */
+#define SSE2_MR_F32 4
+
+/** Столбцов в плитке микроядра float */
+#define SSE2_NR_F32 8
+
+/** Размер блока транспонирования для локальности кэша */
+#define SSE2_TRANSPOSE_BLOCK 32
+
+/** Столбцов результата на блок накопителей пакетного умножения */
+#define SSE2_BATCH_NR 4
+
+/**
+ * @brief Микроядро 4 x 4: 8 регистров-накопителей по 2 элемента
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void sse2_gemm_kernel (int kc, const double* restrict a,
+                              const double* restrict b, double* restrict c, int ldc,
+                              int accumulate) {
+    __m128d acc[SSE2_MR][2];
+
+#pragma GCC unroll 4
+    for (int i = 0; i < SSE2_MR; i++) {
+        acc[i][0] = _mm_setzero_pd ();
+        acc[i][1] = _mm_setzero_pd ();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m128d b0 = _mm_loadu_pd (b);
+        const __m128d b1 = _mm_loadu_pd (b + 2);
+#pragma GCC unroll 4
+        for (int i = 0; i < SSE2_MR; i++) {
+            const __m128d a_i = _mm_set1_pd (a[i]);
+            acc[i][0]         = _mm_add_pd (acc[i][0], _mm_mul_pd (a_i, b0));
+            acc[i][1]         = _mm_add_pd (acc[i][1], _mm_mul_pd (a_i, b1));
+        }
+        a += SSE2_MR;
+        b += SSE2_NR;
+    }
+
+#pragma GCC unroll 4
+    for (int i = 0; i < SSE2_MR; i++) {
+        double* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm_add_pd (acc[i][0], _mm_loadu_pd (c_i));
+            acc[i][1] = _mm_add_pd (acc[i][1], _mm_loadu_pd (c_i + 2));
+        }
+        _mm_storeu_pd (c_i, acc[i][0]);
+        _mm_storeu_pd (c_i + 2, acc[i][1]);
+    }
+}
+
+static const GemmKernel sse2_kernel = {"sse2", SSE2_MR, SSE2_NR, sse2_gemm_kernel};
+
+/**
+ * @brief Микроядро float 4 x 8: 8 регистров-накопителей по 4 элемента
+ *
+ * @param kc Длина панелей
+ * @param a Упакованная панель A
+ * @param b Упакованная панель B
+ * @param c Плитка результата
+ * @param ldc Шаг строки плитки
+ * @param accumulate Флаг накопления
+ */
+static void sse2_gemm_kernel_f32 (int kc, const float* restrict a,
+                                  const float* restrict b, float* restrict c,
+                                  int ldc, int accumulate) {
+    __m128 acc[SSE2_MR_F32][2];
+
+#pragma GCC unroll 4
+    for (int i = 0; i < SSE2_MR_F32; i++) {
+        acc[i][0] = _mm_setzero_ps ();
+        acc[i][1] = _mm_setzero_ps ();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        const __m128 b0 = _mm_loadu_ps (b);
+        const __m128 b1 = _mm_loadu_ps (b + 4);
+#pragma GCC unroll 4
+        for (int i = 0; i < SSE2_MR_F32; i++) {
+            const __m128 a_i = _mm_set1_ps (a[i]);
+            acc[i][0]        = _mm_add_ps (acc[i][0], _mm_mul_ps (a_i, b0));
+            acc[i][1]        = _mm_add_ps (acc[i][1], _mm_mul_ps (a_i, b1));
+        }
+        a += SSE2_MR_F32;
+        b += SSE2_NR_F32;
+    }
+
+#pragma GCC unroll 4
+    for (int i = 0; i < SSE2_MR_F32; i++) {
+        float* c_i = c + (size_t) i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm_add_ps (acc[i][0], _mm_loadu_ps (c_i));
+            acc[i][1] = _mm_add_ps (acc[i][1], _mm_loadu_ps (c_i + 4));
+        }
+        _mm_storeu_ps (c_i, acc[i][0]);
+        _mm_storeu_ps (c_i + 4, acc[i][1]);
+    }
+}
+
+static const GemmKernelF32 sse2_kernel_f32 = {"sse2", SSE2_MR_F32, SSE2_NR_F32,
+                                              sse2_gemm_kernel_f32};
+
+/**
+ * @brief Сложение строки
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void sse2_add (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd (r + i, _mm_add_pd (_mm_loadu_pd (a + i), _mm_loadu_pd (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] + b[i];
+}
+
+/**
+ * @brief Вычитание строки
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void sse2_sub (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd (r + i, _mm_sub_pd (_mm_loadu_pd (a + i), _mm_loadu_pd (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] - b[i];
+}
+
+/**
+ * @brief Вычитание произведения строк
+ *
+ * @param n Количество элементов
+ * @param a Первый множитель
+ * @param b Второй множитель
+ * @param r Накопитель: r[i] -= a[i] * b[i]
+ */
+static void sse2_mul_sub (int n, const double* a, const double* b, double* r) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d ab = _mm_mul_pd (_mm_loadu_pd (a + i), _mm_loadu_pd (b + i));
+        _mm_storeu_pd (r + i, _mm_sub_pd (_mm_loadu_pd (r + i), ab));
+    }
+    for (; i < n; i++) r[i] -= a[i] * b[i];
+}
+
+/**
+ * @brief Пакетное умножение: по 2 матрицы в регистре
+ *
+ * Для каждых 2 матриц отрезка строка c считается блоками по
+ * SSE2_BATCH_NR столбцов, накопители блока - в регистрах.
+ *
+ * @param len Длина отрезка, кратная SIMD_BATCH_LANES
+ * @param m Строк в a и c
+ * @param n Столбцов в b и c
+ * @param k Столбцов в a и строк в b
+ * @param a Отрезки a
+ * @param lda Шаг отрезков a
+ * @param b Отрезки b
+ * @param ldb Шаг отрезков b
+ * @param c Отрезки результата
+ * @param ldc Шаг отрезков c
+ */
+static void sse2_batch_gemm (int len, int m, int n, int k, const double* a,
+                             size_t lda, const double* b, size_t ldb, double* c,
+                             size_t ldc) {
+    for (int l = 0; l < len; l += 2) {
+        for (int i = 0; i < m; i++) {
+            const double* ai = a + (size_t) i * k * lda + l;
+            double*       ci = c + (size_t) i * n * ldc + l;
+            int           j  = 0;
+            for (; j + SSE2_BATCH_NR <= n; j += SSE2_BATCH_NR) {
+                __m128d c0 = _mm_setzero_pd (), c1 = c0, c2 = c0, c3 = c0;
+                for (int p = 0; p < k; p++) {
+                    const __m128d va = _mm_loadu_pd (ai + p * lda);
+                    const double* bp = b + ((size_t) p * n + j) * ldb + l;
+                    const __m128d b0 = _mm_loadu_pd (bp);
+                    const __m128d b1 = _mm_loadu_pd (bp + ldb);
+                    const __m128d b2 = _mm_loadu_pd (bp + 2 * ldb);
+                    const __m128d b3 = _mm_loadu_pd (bp + 3 * ldb);
+                    c0               = _mm_add_pd (c0, _mm_mul_pd (va, b0));
+                    c1               = _mm_add_pd (c1, _mm_mul_pd (va, b1));
+                    c2               = _mm_add_pd (c2, _mm_mul_pd (va, b2));
+                    c3               = _mm_add_pd (c3, _mm_mul_pd (va, b3));
+                }
+                _mm_storeu_pd (ci + j * ldc, c0);
+                _mm_storeu_pd (ci + (j + 1) * ldc, c1);
+                _mm_storeu_pd (ci + (j + 2) * ldc, c2);
+                _mm_storeu_pd (ci + (j + 3) * ldc, c3);
+            }
+            for (; j < n; j++) {
+                const double* bj  = b + (size_t) j * ldb + l;
+                const size_t  bn  = (size_t) n * ldb;   // Шаг строки b
+                __m128d       acc = _mm_setzero_pd ();
+                for (int p = 0; p < k; p++) {
+                    const __m128d va = _mm_loadu_pd (ai + p * lda);
+                    const __m128d vb = _mm_loadu_pd (bj + p * bn);
+                    acc              = _mm_add_pd (acc, _mm_mul_pd (va, vb));
+                }
+                _mm_storeu_pd (ci + j * ldc, acc);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Транспонирование блока плитками 2 x 2 в регистрах
+ *
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходный блок
+ * @param lds Шаг строки src
+ * @param dst Блок результата
+ * @param ldd Шаг строки dst
+ */
+static void sse2_transpose (int rows, int cols, const double* src, int lds,
+                            double* dst, int ldd) {
+    for (int ib = 0; ib < rows; ib += SSE2_TRANSPOSE_BLOCK) {
+        const int i_end = (rows - ib < SSE2_TRANSPOSE_BLOCK) ? rows
+                                                             : ib + SSE2_TRANSPOSE_BLOCK;
+        for (int jb = 0; jb < cols; jb += SSE2_TRANSPOSE_BLOCK) {
+            const int j_end = (cols - jb < SSE2_TRANSPOSE_BLOCK)
+                                  ? cols
+                                  : jb + SSE2_TRANSPOSE_BLOCK;
+            int i = ib;
+            for (; i + 2 <= i_end; i += 2) {
+                const double* s0 = src + (size_t) i * lds;
+                const double* s1 = s0 + lds;
+                int           j  = jb;
+                for (; j + 2 <= j_end; j += 2) {
+                    const __m128d r0 = _mm_loadu_pd (s0 + j);
+                    const __m128d r1 = _mm_loadu_pd (s1 + j);
+                    _mm_storeu_pd (dst + (size_t) j * ldd + i, _mm_unpacklo_pd (r0, r1));
+                    _mm_storeu_pd (dst + (size_t) (j + 1) * ldd + i,
+                                   _mm_unpackhi_pd (r0, r1));
+                }
+                for (; j < j_end; j++) {
+                    dst[(size_t) j * ldd + i]     = s0[j];
+                    dst[(size_t) j * ldd + i + 1] = s1[j];
+                }
+            }
+            for (; i < i_end; i++) {
+                for (int j = jb; j < j_end; j++) {
+                    dst[(size_t) j * ldd + i] = src[(size_t) i * lds + j];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Сложение строки float
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void sse2_add_f32 (int n, const float* a, const float* b, float* r) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps (r + i,
+                       _mm_add_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] + b[i];
+}
+
+/**
+ * @brief Вычитание строки float
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ */
+static void sse2_sub_f32 (int n, const float* a, const float* b, float* r) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps (r + i,
+                       _mm_sub_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+    }
+    for (; i < n; i++) r[i] = a[i] - b[i];
+}
+
+/**
+ * @brief Накопление строки float
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void sse2_axpy_f32 (int n, float alpha, const float* x, float* y) {
+    const __m128 va = _mm_set1_ps (alpha);
+    int          i  = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps (y + i, _mm_add_ps (_mm_loadu_ps (y + i),
+                                          _mm_mul_ps (va, _mm_loadu_ps (x + i))));
+    }
+    for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+/**
+ * @brief Младшие 32 бита произведений 32-битных целых
+ *
+ * В SSE2 нет pmulld: четные и нечетные элементы умножаются pmuludq
+ * отдельно, младшие половины произведений собираются обратно.
+ *
+ * @param a Первый множитель
+ * @param b Второй множитель
+ * @return a * b по модулю 2^32
+ */
+static inline __m128i sse2_mullo_epi32 (__m128i a, __m128i b) {
+    const __m128i even = _mm_mul_epu32 (a, b);
+    const __m128i odd =
+        _mm_mul_epu32 (_mm_srli_epi64 (a, 32), _mm_srli_epi64 (b, 32));
+    return _mm_unpacklo_epi32 (_mm_shuffle_epi32 (even, _MM_SHUFFLE (0, 0, 2, 0)),
+                               _mm_shuffle_epi32 (odd, _MM_SHUFFLE (0, 0, 2, 0)));
+}
+
+/**
+ * @brief Накопление строки int32_t по модулю 2^32
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель
+ * @param x Прибавляемая строка
+ * @param y Накопитель: y[i] += alpha * x[i]
+ */
+static void sse2_axpy_i32 (int n, int32_t alpha, const int32_t* x, int32_t* y) {
+    const __m128i va = _mm_set1_epi32 (alpha);
+    int           i  = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i vx = _mm_loadu_si128 ((const __m128i*) (x + i));
+        const __m128i vy = _mm_loadu_si128 ((const __m128i*) (y + i));
+        _mm_storeu_si128 ((__m128i*) (y + i),
+                          _mm_add_epi32 (vy, sse2_mullo_epi32 (va, vx)));
+    }
+    for (; i < n; i++) {
+        y[i] = (int32_t) ((uint32_t) y[i] + (uint32_t) alpha * (uint32_t) x[i]);
+    }
+}
+
+/**
+ * @brief Линейная комбинация строк
+ *
+ * @param n Количество элементов
+ * @param alpha Множитель x
+ * @param x Прибавляемая строка
+ * @param beta Множитель y
+ * @param y Накопитель: y[i] = alpha * x[i] + beta * y[i]
+ */
+static void sse2_axpby (int n, double alpha, const double* x, double beta,
+                        double* y) {
+    const __m128d va = _mm_set1_pd (alpha);
+    const __m128d vb = _mm_set1_pd (beta);
+    int           i  = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d ax = _mm_mul_pd (va, _mm_loadu_pd (x + i));
+        const __m128d by = _mm_mul_pd (vb, _mm_loadu_pd (y + i));
+        _mm_storeu_pd (y + i, _mm_add_pd (ax, by));
+    }
+    for (; i < n; i++) y[i] = alpha * x[i] + beta * y[i];
+}
+
+/**
+ * @brief Таблица уровня SSE2
+ *
+ * @return Таблица реализаций
+ */
+const SimdOps* simd_sse2_ops (void) {
+    static const SimdOps ops = {
+        SIMD_SSE2, "sse2", &sse2_kernel, sse2_add, sse2_sub, sse2_mul_sub,
+        sse2_batch_gemm, sse2_transpose, sse2_add_f32, sse2_sub_f32, sse2_axpy_f32,
+        sse2_axpy_i32, sse2_axpby, &sse2_kernel_f32,
+    };
+    return &ops;
+}
+
+#else
+
+/**
+ * @brief Уровень SSE2 не собран для этой архитектуры
+ *
+ * @return NULL
+ */
+const SimdOps* simd_sse2_ops (void) {
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,358 @@
+/**
+ * @file small.c
+ * @brief Реализация развернутых ядер для матриц 2 x 2, 3 x 3 и 4 x 4
+ *
+ * @details
+ * Тело каждого ядра записано один раз как встраиваемая функция от размера
+ * n; функции small_*_2, small_*_3 и small_*_4 вызывают его с константой,
+ * и после встраивания циклы с директивой unroll разворачиваются
+ * полностью, а элементы матриц остаются в регистрах. Выбор ядра по
+ * размеру - один switch на вызов.
+ *
+ * @see small.h
+ */
+
+#include "small.h"
+
+#include <stddef.h>
+
+/** Тело ядра встраивается всегда, чтобы размер n стал константой */
+#define SMALL_INLINE static inline __attribute__ ((always_inline))
+
+/**
+ * @brief Тело умножения n x n с эпилогом
+ *
+ * @param n Размер матриц
+ * @param a Элементы a
+ * @param lda Шаг строки a
+ * @param b Элементы b
+ * @param ldb Шаг строки b
+ * @param c Элементы результата
+ * @param ldc Шаг строки c
+ * @param epilogue Слагаемые эпилога или NULL
+ */
+SMALL_INLINE void small_multiply_n (const int n, const MATRIX_TYPE* a, int lda,
+                                   const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* c,
+                                   int ldc, const GemmEpilogue* epilogue) {
+    MATRIX_TYPE x[SMALL_MAX_SIZE][SMALL_MAX_SIZE];   // Копия a
+    MATRIX_TYPE y[SMALL_MAX_SIZE][SMALL_MAX_SIZE];   // Копия b
+    MATRIX_TYPE r[SMALL_MAX_SIZE][SMALL_MAX_SIZE];   // Результат
+
+#pragma GCC unroll 4
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+        for (int j = 0; j < n; j++) {
+            x[i][j] = a[(size_t) i * lda + j];
+            y[i][j] = b[(size_t) i * ldb + j];
+        }
+    }
+
+#pragma GCC unroll 4
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+        for (int j = 0; j < n; j++) {
+            MATRIX_TYPE s = x[i][0] * y[0][j];
+#pragma GCC unroll 4
+            for (int p = 1; p < n; p++) s += x[i][p] * y[p][j];
+            r[i][j] = s;
+        }
+    }
+
+    // Эпилог в порядке add_matrices, затем subtract_matrices
+    if (epilogue && epilogue->add) {
+#pragma GCC unroll 4
+        for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+            for (int j = 0; j < n; j++)
+                r[i][j] += epilogue->add[(size_t) i * epilogue->ld_add + j];
+        }
+    }
+    if (epilogue && epilogue->sub_t) {
+#pragma GCC unroll 4
+        for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+            for (int j = 0; j < n; j++)
+                r[i][j] -= epilogue->sub_t[(size_t) j * epilogue->ld_sub_t + i];
+        }
+    }
+
+#pragma GCC unroll 4
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+        for (int j = 0; j < n; j++) c[(size_t) i * ldc + j] = r[i][j];
+    }
+}
+
+/**
+ * @brief Тело поэлементной операции n x n: r = a + sign * b
+ *
+ * @param n Размер матриц
+ * @param sign 1 для сложения, -1 для вычитания
+ * @param a Элементы a
+ * @param lda Шаг строки a
+ * @param b Элементы b
+ * @param ldb Шаг строки b
+ * @param r Элементы результата
+ * @param ldr Шаг строки r
+ */
+SMALL_INLINE void small_binary_n (const int n, const int sign, const MATRIX_TYPE* a,
+                                 int lda, const MATRIX_TYPE* b, int ldb,
+                                 MATRIX_TYPE* r, int ldr) {
+    MATRIX_TYPE t[SMALL_MAX_SIZE][SMALL_MAX_SIZE];   // Результат
+
+#pragma GCC unroll 4
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+        for (int j = 0; j < n; j++) {
+            const MATRIX_TYPE x = a[(size_t) i * lda + j];
+            const MATRIX_TYPE y = b[(size_t) i * ldb + j];
+            t[i][j]             = sign > 0 ? x + y : x - y;
+        }
+    }
+
+#pragma GCC unroll 4
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+        for (int j = 0; j < n; j++) r[(size_t) i * ldr + j] = t[i][j];
+    }
+}
+
+/**
+ * @brief Тело транспонирования n x n
+ *
+ * @param n Размер матрицы
+ * @param src Исходные элементы
+ * @param lds Шаг строки src
+ * @param dst Элементы результата
+ * @param ldd Шаг строки dst
+ */
+SMALL_INLINE void small_transpose_n (const int n, const MATRIX_TYPE* src, int lds,
+                                    MATRIX_TYPE* dst, int ldd) {
+    MATRIX_TYPE t[SMALL_MAX_SIZE][SMALL_MAX_SIZE];   // Копия src
+
+#pragma GCC unroll 4
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+        for (int j = 0; j < n; j++) t[i][j] = src[(size_t) i * lds + j];
+    }
+
+#pragma GCC unroll 4
+    for (int i = 0; i < n; i++) {
+#pragma GCC unroll 4
+        for (int j = 0; j < n; j++) dst[(size_t) j * ldd + i] = t[i][j];
+    }
+}
+
+/** Определяет ядро операции для размера N через общее тело */
+#define SMALL_DEFINE_KERNELS(N)                                                     \
+    static void small_multiply_##N (const MATRIX_TYPE* a, int lda,                  \
+                                    const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* c,  \
+                                    int ldc, const GemmEpilogue* epilogue) {        \
+        small_multiply_n (N, a, lda, b, ldb, c, ldc, epilogue);                     \
+    }                                                                               \
+    static void small_binary_##N (int sign, const MATRIX_TYPE* a, int lda,          \
+                                  const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* r,    \
+                                  int ldr) {                                        \
+        if (sign > 0) small_binary_n (N, 1, a, lda, b, ldb, r, ldr);                \
+        else small_binary_n (N, -1, a, lda, b, ldb, r, ldr);                        \
+    }                                                                               \
+    static void small_transpose_##N (const MATRIX_TYPE* src, int lds,               \
+                                     MATRIX_TYPE* dst, int ldd) {                   \
+        small_transpose_n (N, src, lds, dst, ldd);                                  \
+    }
+
+SMALL_DEFINE_KERNELS (2)
+SMALL_DEFINE_KERNELS (3)
+SMALL_DEFINE_KERNELS (4)
+
+#undef SMALL_DEFINE_KERNELS
+
+/**
+ * @brief Проверяет, есть ли ядро для квадратной матрицы
+ *
+ * @param rows Строк
+ * @param cols Столбцов
+ *
+ * @return 1 для квадратных матриц от 2 до SMALL_MAX_SIZE
+ */
+static int small_supported (int rows, int cols) {
+    return rows == cols && rows >= 2 && rows <= SMALL_MAX_SIZE;
+}
+
+/**
+ * @brief Умножает квадратные матрицы: c = a x b с эпилогом
+ *
+ * @param m Строк в a и c
+ * @param n Столбцов в b и c
+ * @param k Столбцов в a и строк в b
+ * @param a Элементы a
+ * @param lda Шаг строки a
+ * @param b Элементы b
+ * @param ldb Шаг строки b
+ * @param c Элементы результата
+ * @param ldc Шаг строки c
+ * @param epilogue Слагаемые эпилога или NULL
+ *
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_multiply (int m, int n, int k, const MATRIX_TYPE* a, int lda,
+                    const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* c, int ldc,
+                    const GemmEpilogue* epilogue) {
+    int res = -1;
+
+    if (small_supported (m, n) && k == n) {
+        switch (n) {
+            case 2: small_multiply_2 (a, lda, b, ldb, c, ldc, epilogue); break;
+            case 3: small_multiply_3 (a, lda, b, ldb, c, ldc, epilogue); break;
+            default: small_multiply_4 (a, lda, b, ldb, c, ldc, epilogue); break;
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Поэлементная операция над квадратными матрицами
+ *
+ * @param sign 1 для сложения, -1 для вычитания
+ * @param rows Строк в матрицах
+ * @param cols Столбцов в матрицах
+ * @param a Элементы a
+ * @param lda Шаг строки a
+ * @param b Элементы b
+ * @param ldb Шаг строки b
+ * @param r Элементы результата
+ * @param ldr Шаг строки r
+ *
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+static int small_binary (int sign, int rows, int cols, const MATRIX_TYPE* a, int lda,
+                         const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* r, int ldr) {
+    int res = -1;
+
+    if (small_supported (rows, cols)) {
+        switch (rows) {
+            case 2: small_binary_2 (sign, a, lda, b, ldb, r, ldr); break;
+            case 3: small_binary_3 (sign, a, lda, b, ldb, r, ldr); break;
+            default: small_binary_4 (sign, a, lda, b, ldb, r, ldr); break;
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Складывает квадратные матрицы: r = a + b
+ *
+ * @param rows Строк в матрицах
+ * @param cols Столбцов в матрицах
+ * @param a Элементы a
+ * @param lda Шаг строки a
+ * @param b Элементы b
+ * @param ldb Шаг строки b
+ * @param r Элементы результата
+ * @param ldr Шаг строки r
+ *
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_add (int rows, int cols, const MATRIX_TYPE* a, int lda,
+               const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* r, int ldr) {
+    return small_binary (1, rows, cols, a, lda, b, ldb, r, ldr);
+}
+
+/**
+ * @brief Вычитает квадратные матрицы: r = a - b
+ *
+ * @param rows Строк в матрицах
+ * @param cols Столбцов в матрицах
+ * @param a Элементы a
+ * @param lda Шаг строки a
+ * @param b Элементы b
+ * @param ldb Шаг строки b
+ * @param r Элементы результата
+ * @param ldr Шаг строки r
+ *
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_subtract (int rows, int cols, const MATRIX_TYPE* a, int lda,
+                    const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* r, int ldr) {
+    return small_binary (-1, rows, cols, a, lda, b, ldb, r, ldr);
+}
+
+/**
+ * @brief Транспонирует квадратную матрицу
+ *
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходные элементы
+ * @param lds Шаг строки src
+ * @param dst Элементы результата
+ * @param ldd Шаг строки dst
+ *
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_transpose (int rows, int cols, const MATRIX_TYPE* src, int lds,
+                     MATRIX_TYPE* dst, int ldd) {
+    int res = -1;
+
+    if (small_supported (rows, cols)) {
+        switch (rows) {
+            case 2: small_transpose_2 (src, lds, dst, ldd); break;
+            case 3: small_transpose_3 (src, lds, dst, ldd); break;
+            default: small_transpose_4 (src, lds, dst, ldd); break;
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Вычисляет детерминант квадратной матрицы в замкнутой форме
+ *
+ * 3 x 3 - разложение по первой строке. 4 x 4 - разложение Лапласа по
+ * первым двум строкам: сумма произведений шести миноров 2 x 2 верхней
+ * пары строк на дополнительные миноры нижней пары (40 умножений вместо
+ * построения рабочей копии).
+ *
+ * @param n Размер матрицы
+ * @param a Элементы
+ * @param lda Шаг строки a
+ * @param det Детерминант
+ *
+ * @return 0 при успехе, -1, если для размера нет ядра
+ */
+int small_determinant (int n, const MATRIX_TYPE* a, int lda, MATRIX_TYPE* det) {
+    const MATRIX_TYPE* r0  = a;
+    const MATRIX_TYPE* r1  = a + lda;
+    const MATRIX_TYPE* r2  = n > 2 ? a + 2 * (size_t) lda : NULL;
+    const MATRIX_TYPE* r3  = n > 3 ? a + 3 * (size_t) lda : NULL;
+    int                res = 0;
+
+    if (n == 2) *det = r0[0] * r1[1] - r0[1] * r1[0];
+    else if (n == 3) {
+        *det = r0[0] * (r1[1] * r2[2] - r1[2] * r2[1]) -
+               r0[1] * (r1[0] * r2[2] - r1[2] * r2[0]) +
+               r0[2] * (r1[0] * r2[1] - r1[1] * r2[0]);
+    } else if (n == 4) {
+        // Миноры 2 x 2 строк 0-1 и 2-3 по парам столбцов
+        const MATRIX_TYPE u01 = r0[0] * r1[1] - r0[1] * r1[0];
+        const MATRIX_TYPE u02 = r0[0] * r1[2] - r0[2] * r1[0];
+        const MATRIX_TYPE u03 = r0[0] * r1[3] - r0[3] * r1[0];
+        const MATRIX_TYPE u12 = r0[1] * r1[2] - r0[2] * r1[1];
+        const MATRIX_TYPE u13 = r0[1] * r1[3] - r0[3] * r1[1];
+        const MATRIX_TYPE u23 = r0[2] * r1[3] - r0[3] * r1[2];
+        const MATRIX_TYPE l01 = r2[0] * r3[1] - r2[1] * r3[0];
+        const MATRIX_TYPE l02 = r2[0] * r3[2] - r2[2] * r3[0];
+        const MATRIX_TYPE l03 = r2[0] * r3[3] - r2[3] * r3[0];
+        const MATRIX_TYPE l12 = r2[1] * r3[2] - r2[2] * r3[1];
+        const MATRIX_TYPE l13 = r2[1] * r3[3] - r2[3] * r3[1];
+        const MATRIX_TYPE l23 = r2[2] * r3[3] - r2[3] * r3[2];
+
+        *det = u01 * l23 - u02 * l13 + u03 * l12 + u12 * l03 - u13 * l02 + u23 * l01;
+    } else res = -1;
+
+    return res;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file small.h
+ * @brief Развернутые ядра для квадратных матриц 2 x 2, 3 x 3 и 4 x 4
+ *
+ * @details
+ * Для матриц нескольких элементов общие алгоритмы тратят больше времени
+ * на подготовку, чем на арифметику: блочное умножение упаковывает панели
+ * и выделяет под них память, детерминант строит рабочую копию для
+ * LU-разложения, а поэлементные операции вызывают ядро на каждую строку.
+ * Ядра этого модуля полностью развернуты для размеров 2, 3 и 4 и не
+ * выделяют память; публичные функции matrix.h выбирают их сами.
+ *
+ * Каждая функция возвращает -1, если для размеров операндов ядра нет, и
+ * тогда вызывающий использует общий алгоритм. Результат считается в
+ * локальных переменных и записывается в конце, поэтому он может
+ * совпадать с любым из операндов.
+ *
+ * Произведение суммирует слагаемые в порядке возрастания k, как
+ * классическое умножение. Детерминанты 3 x 3 и 4 x 4 считаются разложением
+ * по минорам без выбора главного элемента; для плохо обусловленных матриц
+ * они отличаются от LU-разложения в пределах обычной погрешности.
+ *
+ * @see matrix.h gemm.h
+ */
+
+#ifndef SMALL_H
+#define SMALL_H
+
+#include "../../include/config.h"
+#include "gemm.h"
+
+/** Наибольший размер матриц с развернутыми ядрами */
+#define SMALL_MAX_SIZE 4
+
+/**
+ * @brief Умножает квадратные матрицы: c = a x b с эпилогом
+ * @param m Строк в a и c
+ * @param n Столбцов в b и c
+ * @param k Столбцов в a и строк в b
+ * @param a Элементы a с шагом lda
+ * @param lda Шаг строки a
+ * @param b Элементы b с шагом ldb
+ * @param ldb Шаг строки b
+ * @param c Элементы результата с шагом ldc
+ * @param ldc Шаг строки c
+ * @param epilogue Слагаемые эпилога (gemm.h) или NULL
+ * @note Ядра есть только для m = n = k от 2 до SMALL_MAX_SIZE
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_multiply (int m, int n, int k, const MATRIX_TYPE* a, int lda,
+                    const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* c, int ldc,
+                    const GemmEpilogue* epilogue);
+
+/**
+ * @brief Складывает квадратные матрицы: r = a + b
+ * @param rows Строк в матрицах
+ * @param cols Столбцов в матрицах
+ * @param a Элементы a с шагом lda
+ * @param lda Шаг строки a
+ * @param b Элементы b с шагом ldb
+ * @param ldb Шаг строки b
+ * @param r Элементы результата с шагом ldr
+ * @param ldr Шаг строки r
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_add (int rows, int cols, const MATRIX_TYPE* a, int lda,
+               const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* r, int ldr);
+
+/**
+ * @brief Вычитает квадратные матрицы: r = a - b
+ * @param rows Строк в матрицах
+ * @param cols Столбцов в матрицах
+ * @param a Элементы a с шагом lda
+ * @param lda Шаг строки a
+ * @param b Элементы b с шагом ldb
+ * @param ldb Шаг строки b
+ * @param r Элементы результата с шагом ldr
+ * @param ldr Шаг строки r
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_subtract (int rows, int cols, const MATRIX_TYPE* a, int lda,
+                    const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* r, int ldr);
+
+/**
+ * @brief Транспонирует квадратную матрицу: dst[j][i] = src[i][j]
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходные элементы с шагом lds
+ * @param lds Шаг строки src
+ * @param dst Элементы результата с шагом ldd
+ * @param ldd Шаг строки dst
+ * @return 0 при успехе, -1, если для размеров нет ядра
+ */
+int small_transpose (int rows, int cols, const MATRIX_TYPE* src, int lds,
+                     MATRIX_TYPE* dst, int ldd);
+
+/**
+ * @brief Вычисляет детерминант квадратной матрицы в замкнутой форме
+ * @param n Размер матрицы
+ * @param a Элементы с шагом lda
+ * @param lda Шаг строки a
+ * @param det Детерминант
+ * @return 0 при успехе, -1, если для размера нет ядра
+ */
+int small_determinant (int n, const MATRIX_TYPE* a, int lda, MATRIX_TYPE* det);
+
+#endif   // SMALL_H
@@ -0,0 +1,575 @@
+/**
+ * @file sparse.c
+ * @brief Реализация разреженных матриц в формате CSR
+ *
+ * @details
+ * Умножения с плотным результатом считают его по строкам: строка i
+ * результата зависит только от строки i левого множителя, поэтому
+ * полосы строк раздаются потокам пула без синхронизации, если объем
+ * работы не меньше GEMM_PARALLEL_THRESHOLD.
+ *
+ * sparse_multiply - алгоритм Густавсона в два прохода. Символьный проход
+ * считает число элементов каждой строки результата с помощью массива
+ * отметок по столбцам, после чего память выделяется один раз. Численный
+ * проход накапливает строку в плотном массиве длины n, собирает номера
+ * затронутых столбцов, сортирует их и переносит значения в результат.
+ *
+ * Сложение и вычитание сливают упорядоченные строки операндов, тоже в два
+ * прохода: подсчет и заполнение.
+ *
+ * @see sparse.h
+ */
+
+#include "sparse.h"
+
+#include "../parallel/thread_pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Полос строк на поток при параллельном умножении */
+#define SPARSE_TASKS_PER_THREAD 4
+
+/**
+ * @struct SparseProduct
+ * @brief Аргументы умножения с плотным результатом
+ */
+typedef struct SparseProduct {
+    const SparseMatrix* sparse;   ///< Разреженный множитель
+    const Matrix*       dense;    ///< Плотный множитель
+    Matrix*             result;   ///< Результат
+    int                 rows;     ///< Строк результата
+    int                 chunk;    ///< Строк в полосе
+    /** Вычисляет одну строку результата */
+    void (*row_fn) (const struct SparseProduct* product, int row);
+} SparseProduct;
+
+/**
+ * @brief Проверяет разреженную матрицу
+ *
+ * @param matrix Матрица
+ *
+ * @return 1, если матрица создана
+ */
+static int sparse_valid (const SparseMatrix* matrix) {
+    return matrix != NULL && matrix->row_ptr != NULL && matrix->rows > 0 &&
+           matrix->cols > 0;
+}
+
+/**
+ * @brief Проверяет плотную матрицу
+ *
+ * @param matrix Матрица
+ *
+ * @return 1, если матрица создана
+ */
+static int dense_valid (const Matrix* matrix) {
+    return matrix != NULL && matrix->block != NULL && matrix->rows > 0 &&
+           matrix->cols > 0;
+}
+
+/**
+ * @brief Создает разреженную матрицу
+ *
+ * Блок содержит values (выровнен по MATRIX_ALIGNMENT), затем row_ptr и
+ * col_idx.
+ *
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param nnz Количество элементов
+ *
+ * @return Матрица или нулевая структура при ошибке
+ */
+SparseMatrix sparse_create (int rows, int cols, size_t nnz) {
+    SparseMatrix mat   = {0, 0, 0, NULL, NULL, NULL};
+    void*        block = NULL;
+    size_t       ptr_bytes = 0;   // Размер row_ptr
+    size_t       bytes     = 0;   // Размер блока
+    char         res       = 1;   // Флаг успешности выполнения
+
+    if (rows <= 0 || cols <= 0 || nnz > SIZE_MAX / 2 / sizeof (MATRIX_TYPE))
+        res = 0;
+    else {
+        ptr_bytes = ((size_t) rows + 1) * sizeof (size_t);
+        bytes     = nnz * (sizeof (MATRIX_TYPE) + sizeof (int)) + ptr_bytes;
+        if (posix_memalign (&block, MATRIX_ALIGNMENT, bytes) != 0) res = 0;
+    }
+
+    if (res) {
+        mat.rows    = rows;
+        mat.cols    = cols;
+        mat.nnz     = nnz;
+        mat.values  = block;
+        mat.row_ptr = (size_t*) (mat.values + nnz);
+        mat.col_idx = (int*) (mat.row_ptr + rows + 1);
+        memset (mat.row_ptr, 0, ptr_bytes);
+    }
+
+    return mat;
+}
+
+/**
+ * @brief Освобождает память разреженной матрицы
+ *
+ * @param matrix Матрица или NULL
+ */
+void sparse_free (SparseMatrix* matrix) {
+    if (matrix != NULL && matrix->row_ptr != NULL) {
+        free (matrix->values);   // row_ptr и col_idx лежат в том же блоке
+        matrix->rows    = 0;
+        matrix->cols    = 0;
+        matrix->nnz     = 0;
+        matrix->values  = NULL;
+        matrix->row_ptr = NULL;
+        matrix->col_idx = NULL;
+    }
+}
+
+/**
+ * @brief Считает ненулевые элементы плотной матрицы
+ *
+ * @param matrix Матрица
+ *
+ * @return Количество элементов
+ */
+static size_t dense_nonzeros (const Matrix* matrix) {
+    size_t count = 0;
+
+    for (int row = 0; row < matrix->rows; row++) {
+        const MATRIX_TYPE* a = matrix->block + (size_t) row * matrix->stride;
+        for (int col = 0; col < matrix->cols; col++) count += (a[col] != 0);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Доля ненулевых элементов плотной матрицы
+ *
+ * @param matrix Плотная матрица
+ *
+ * @return Число от 0 до 1 или -1 при ошибке
+ */
+double matrix_density (const Matrix* matrix) {
+    double density = -1;
+
+    if (dense_valid (matrix)) {
+        density = (double) dense_nonzeros (matrix) /
+                  ((double) matrix->rows * (double) matrix->cols);
+    }
+
+    return density;
+}
+
+/**
+ * @brief Преобразует плотную матрицу в CSR
+ *
+ * @param matrix Плотная матрица
+ * @param max_density Наибольшая доля ненулевых элементов
+ *
+ * @return Разреженная матрица или нулевая структура
+ */
+SparseMatrix sparse_from_dense (const Matrix* matrix, double max_density) {
+    SparseMatrix mat = {0, 0, 0, NULL, NULL, NULL};
+    size_t       nnz = 0;
+
+    if (dense_valid (matrix)) {
+        nnz = dense_nonzeros (matrix);
+        if ((double) nnz <=
+            max_density * (double) matrix->rows * (double) matrix->cols)
+            mat = sparse_create (matrix->rows, matrix->cols, nnz);
+    }
+
+    if (mat.row_ptr != NULL) {
+        size_t p = 0;   // Следующий элемент
+        for (int row = 0; row < matrix->rows; row++) {
+            const MATRIX_TYPE* a = matrix->block + (size_t) row * matrix->stride;
+            for (int col = 0; col < matrix->cols; col++) {
+                if (a[col] != 0) {
+                    mat.values[p]  = a[col];
+                    mat.col_idx[p] = col;
+                    p++;
+                }
+            }
+            mat.row_ptr[row + 1] = p;
+        }
+    }
+
+    return mat;
+}
+
+/**
+ * @brief Преобразует разреженную матрицу в плотную
+ *
+ * @param matrix Разреженная матрица
+ *
+ * @return Плотная матрица или нулевая матрица при ошибке
+ */
+Matrix sparse_to_dense (const SparseMatrix* matrix) {
+    Matrix mat = {0, 0, NULL, NULL, 0, NULL, 0, NULL, MATRIX_F64, NULL, 0};
+
+    if (sparse_valid (matrix)) mat = create_matrix (matrix->rows, matrix->cols);
+
+    if (mat.data != NULL) {
+        for (int row = 0; row < mat.rows; row++) {
+            MATRIX_TYPE* r = mat.block + (size_t) row * mat.stride;
+            memset (r, 0, (size_t) mat.cols * sizeof (MATRIX_TYPE));
+            for (size_t p = matrix->row_ptr[row]; p < matrix->row_ptr[row + 1]; p++)
+                r[matrix->col_idx[p]] = matrix->values[p];
+        }
+    }
+
+    return mat;
+}
+
+/**
+ * @brief Строка произведения разреженной матрицы на плотную
+ *
+ * Строка результата - сумма строк B, взятых с весами из строки A.
+ *
+ * @param product Аргументы умножения
+ * @param row Номер строки
+ */
+static void sparse_dense_row (const SparseProduct* product, int row) {
+    const SparseMatrix* A = product->sparse;
+    const Matrix*       B = product->dense;
+    const int           n = B->cols;
+    const Matrix*       C = product->result;
+    MATRIX_TYPE* restrict r = C->block + (size_t) row * C->stride;
+
+    memset (r, 0, (size_t) n * sizeof (MATRIX_TYPE));
+    for (size_t p = A->row_ptr[row]; p < A->row_ptr[row + 1]; p++) {
+        const size_t                offset = (size_t) A->col_idx[p] * B->stride;
+        const MATRIX_TYPE           v      = A->values[p];
+        const MATRIX_TYPE* restrict b      = B->block + offset;
+        for (int j = 0; j < n; j++) r[j] += v * b[j];
+    }
+}
+
+/**
+ * @brief Строка произведения плотной матрицы на разреженную
+ *
+ * К строке результата прибавляются строки B с весами из строки A;
+ * нулевые веса пропускаются.
+ *
+ * @param product Аргументы умножения
+ * @param row Номер строки
+ */
+static void dense_sparse_row (const SparseProduct* product, int row) {
+    const Matrix*       A = product->dense;
+    const SparseMatrix* B = product->sparse;
+    const Matrix*       C = product->result;
+    const MATRIX_TYPE*  a = A->block + (size_t) row * A->stride;
+    MATRIX_TYPE*        r = C->block + (size_t) row * C->stride;
+
+    memset (r, 0, (size_t) B->cols * sizeof (MATRIX_TYPE));
+    for (int k = 0; k < A->cols; k++) {
+        if (a[k] == 0) continue;
+        for (size_t p = B->row_ptr[k]; p < B->row_ptr[k + 1]; p++)
+            r[B->col_idx[p]] += a[k] * B->values[p];
+    }
+}
+
+/**
+ * @brief Задача пула: полоса строк произведения
+ *
+ * @param arg Аргументы умножения (SparseProduct)
+ * @param task Номер полосы
+ * @param worker Номер потока
+ */
+static void sparse_product_task (void* arg, int task, int worker) {
+    const SparseProduct* product = arg;
+    const int            first   = task * product->chunk;
+    const int last = first + product->chunk < product->rows ? first + product->chunk
+                                                            : product->rows;
+
+    (void) worker;
+    for (int row = first; row < last; row++) product->row_fn (product, row);
+}
+
+/**
+ * @brief Считает произведение с плотным результатом, при большом объеме - на пуле
+ *
+ * @param product Аргументы умножения; chunk заполняется здесь
+ * @param work Число умножений-сложений
+ */
+static void sparse_product_run (SparseProduct* product, double work) {
+    int threads = 1;   // Потоков для этого умножения
+
+    if (work >= (double) GEMM_PARALLEL_THRESHOLD) threads = thread_pool_threads ();
+
+    if (threads > 1 && product->rows > 1) {
+        int tasks      = threads * SPARSE_TASKS_PER_THREAD;
+        product->chunk = (product->rows + tasks - 1) / tasks;
+        tasks          = (product->rows + product->chunk - 1) / product->chunk;
+        thread_pool_run (tasks, sparse_product_task, product);
+    } else {
+        product->chunk = product->rows;
+        sparse_product_task (product, 0, 0);
+    }
+}
+
+/**
+ * @brief Умножает разреженную матрицу на плотную
+ *
+ * @param A Разреженная матрица m x k
+ * @param B Плотная матрица k x n
+ * @param result Плотная матрица не меньше m x n
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int sparse_multiply_dense (const SparseMatrix* A, const Matrix* B, Matrix* result) {
+    int res = -1;
+
+    if (sparse_valid (A) && dense_valid (B) && dense_valid (result) &&
+        A->cols == B->rows && result->rows >= A->rows && result->cols >= B->cols) {
+        SparseProduct product = {A, B, result, A->rows, 0, sparse_dense_row};
+        sparse_product_run (&product, (double) A->nnz * B->cols);
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Умножает плотную матрицу на разреженную
+ *
+ * @param A Плотная матрица m x k
+ * @param B Разреженная матрица k x n
+ * @param result Плотная матрица не меньше m x n
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int dense_multiply_sparse (const Matrix* A, const SparseMatrix* B, Matrix* result) {
+    int res = -1;
+
+    if (dense_valid (A) && sparse_valid (B) && dense_valid (result) &&
+        A->cols == B->rows && result->rows >= A->rows && result->cols >= B->cols) {
+        SparseProduct product = {B, A, result, A->rows, 0, dense_sparse_row};
+        sparse_product_run (&product, (double) A->rows * B->nnz);
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Сравнивает номера столбцов для qsort
+ *
+ * @param a Первый номер
+ * @param b Второй номер
+ *
+ * @return Знак разности
+ */
+static int sparse_compare_index (const void* a, const void* b) {
+    const int x = *(const int*) a, y = *(const int*) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Умножает две разреженные матрицы
+ *
+ * @param A Разреженная матрица m x k
+ * @param B Разреженная матрица k x n
+ *
+ * @return Разреженная матрица m x n или нулевая структура при ошибке
+ */
+SparseMatrix sparse_multiply (const SparseMatrix* A, const SparseMatrix* B) {
+    SparseMatrix mat    = {0, 0, 0, NULL, NULL, NULL};
+    size_t*      counts = NULL;   // Элементов в строках результата
+    int*         marker = NULL;   // Строка, в которой столбец уже встречен
+    MATRIX_TYPE* acc    = NULL;   // Плотная строка-накопитель
+    size_t       nnz    = 0;
+    char         res    = 0;      // Флаг успешности выполнения
+
+    if (sparse_valid (A) && sparse_valid (B) && A->cols == B->rows) {
+        counts = malloc ((size_t) A->rows * sizeof (size_t));
+        marker = malloc ((size_t) B->cols * sizeof (int));
+        acc    = malloc ((size_t) B->cols * sizeof (MATRIX_TYPE));
+        res    = counts && marker && acc;
+    }
+
+    // Символьный проход: число элементов каждой строки
+    if (res) {
+        for (int j = 0; j < B->cols; j++) marker[j] = -1;
+        for (int i = 0; i < A->rows; i++) {
+            size_t count = 0;
+            for (size_t p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+                const int k = A->col_idx[p];
+                for (size_t q = B->row_ptr[k]; q < B->row_ptr[k + 1]; q++) {
+                    if (marker[B->col_idx[q]] != i) {
+                        marker[B->col_idx[q]] = i;
+                        count++;
+                    }
+                }
+            }
+            counts[i] = count;
+            nnz += count;
+        }
+        mat = sparse_create (A->rows, B->cols, nnz);
+        res = mat.row_ptr != NULL;
+    }
+
+    // Численный проход: накопление строки и перенос по возрастанию столбцов
+    if (res) {
+        for (int j = 0; j < B->cols; j++) marker[j] = -1;
+        for (int i = 0; i < A->rows; i++) {
+            const size_t start = mat.row_ptr[i];
+            int*         cols  = mat.col_idx + start;
+            size_t       count = 0;
+
+            mat.row_ptr[i + 1] = start + counts[i];
+            for (size_t p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++) {
+                const int         k = A->col_idx[p];
+                const MATRIX_TYPE v = A->values[p];
+                for (size_t q = B->row_ptr[k]; q < B->row_ptr[k + 1]; q++) {
+                    const int j = B->col_idx[q];
+                    if (marker[j] != i) {
+                        marker[j]       = i;
+                        cols[count++]   = j;
+                        acc[j]          = v * B->values[q];
+                    } else {
+                        acc[j] += v * B->values[q];
+                    }
+                }
+            }
+            qsort (cols, count, sizeof (int), sparse_compare_index);
+            for (size_t p = 0; p < count; p++) mat.values[start + p] = acc[cols[p]];
+        }
+    }
+
+    free (counts);
+    free (marker);
+    free (acc);
+
+    return mat;
+}
+
+/**
+ * @brief Сливает две разреженные матрицы: A + sign * B
+ *
+ * @param A Первая матрица
+ * @param B Вторая матрица того же размера
+ * @param sign 1 для сложения, -1 для вычитания
+ *
+ * @return Результат или нулевая структура при ошибке
+ */
+static SparseMatrix sparse_combine (const SparseMatrix* A, const SparseMatrix* B,
+                                    MATRIX_TYPE sign) {
+    SparseMatrix mat = {0, 0, 0, NULL, NULL, NULL};
+    size_t       nnz = 0;
+
+    if (sparse_valid (A) && sparse_valid (B) && A->rows == B->rows &&
+        A->cols == B->cols) {
+        // Подсчет элементов объединения строк
+        for (int i = 0; i < A->rows; i++) {
+            size_t p = A->row_ptr[i], q = B->row_ptr[i];
+            while (p < A->row_ptr[i + 1] && q < B->row_ptr[i + 1]) {
+                if (A->col_idx[p] <= B->col_idx[q]) {
+                    if (A->col_idx[p] == B->col_idx[q]) q++;
+                    p++;
+                } else {
+                    q++;
+                }
+                nnz++;
+            }
+            nnz += (A->row_ptr[i + 1] - p) + (B->row_ptr[i + 1] - q);
+        }
+        mat = sparse_create (A->rows, A->cols, nnz);
+    }
+
+    if (mat.row_ptr != NULL) {
+        size_t out = 0;   // Следующий элемент результата
+        for (int i = 0; i < A->rows; i++) {
+            size_t       p = A->row_ptr[i], q = B->row_ptr[i];
+            const size_t p_end = A->row_ptr[i + 1], q_end = B->row_ptr[i + 1];
+            while (p < p_end || q < q_end) {
+                if (q == q_end || (p < p_end && A->col_idx[p] < B->col_idx[q])) {
+                    mat.col_idx[out] = A->col_idx[p];
+                    mat.values[out]  = A->values[p++];
+                } else if (p == p_end || B->col_idx[q] < A->col_idx[p]) {
+                    mat.col_idx[out] = B->col_idx[q];
+                    mat.values[out]  = sign * B->values[q++];
+                } else {
+                    mat.col_idx[out] = A->col_idx[p];
+                    mat.values[out]  = A->values[p++] + sign * B->values[q++];
+                }
+                out++;
+            }
+            mat.row_ptr[i + 1] = out;
+        }
+    }
+
+    return mat;
+}
+
+/**
+ * @brief Складывает две разреженные матрицы
+ *
+ * @param A Первая матрица
+ * @param B Вторая матрица
+ *
+ * @return Сумма или нулевая структура при ошибке
+ */
+SparseMatrix sparse_add (const SparseMatrix* A, const SparseMatrix* B) {
+    return sparse_combine (A, B, 1);
+}
+
+/**
+ * @brief Вычитает разреженные матрицы
+ *
+ * @param A Уменьшаемое
+ * @param B Вычитаемое
+ *
+ * @return Разность или нулевая структура при ошибке
+ */
+SparseMatrix sparse_subtract (const SparseMatrix* A, const SparseMatrix* B) {
+    return sparse_combine (A, B, -1);
+}
+
+/**
+ * @brief Транспонирует разреженную матрицу
+ *
+ * Сортировка подсчетом по столбцам: row_ptr результата - префиксные
+ * суммы числа элементов в столбцах. Строки исходной матрицы обходятся по
+ * возрастанию, поэтому номера столбцов в строках результата тоже
+ * возрастают.
+ *
+ * @param matrix Разреженная матрица
+ *
+ * @return Транспонированная матрица или нулевая структура при ошибке
+ */
+SparseMatrix sparse_transpose (const SparseMatrix* matrix) {
+    SparseMatrix mat  = {0, 0, 0, NULL, NULL, NULL};
+    size_t*      next = NULL;   // Следующая позиция в строках результата
+
+    if (sparse_valid (matrix)) {
+        mat  = sparse_create (matrix->cols, matrix->rows, matrix->nnz);
+        next = malloc ((size_t) matrix->cols * sizeof (size_t));
+    }
+
+    if (mat.row_ptr != NULL && next != NULL) {
+        for (size_t p = 0; p < matrix->nnz; p++)
+            mat.row_ptr[matrix->col_idx[p] + 1]++;
+        for (int col = 0; col < matrix->cols; col++) {
+            mat.row_ptr[col + 1] += mat.row_ptr[col];
+            next[col] = mat.row_ptr[col];
+        }
+        for (int row = 0; row < matrix->rows; row++) {
+            const size_t end = matrix->row_ptr[row + 1];
+            for (size_t p = matrix->row_ptr[row]; p < end; p++) {
+                const size_t dst = next[matrix->col_idx[p]]++;
+                mat.col_idx[dst] = row;
+                mat.values[dst]  = matrix->values[p];
+            }
+        }
+    } else {
+        sparse_free (&mat);
+    }
+
+    free (next);
+
+    return mat;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file sparse.h
+ * @brief Разреженные матрицы в формате CSR
+ *
+ * @details
+ * Матрица в формате CSR (compressed sparse row) хранит только ненулевые
+ * элементы: values и col_idx перечисляют их по строкам, а row_ptr[row] -
+ * номер первого элемента строки row (row_ptr[rows] = nnz). Номера
+ * столбцов внутри строки возрастают; все функции модуля сохраняют этот
+ * порядок и полагаются на него.
+ *
+ * Умножение с разреженным множителем тратит время только на ненулевые
+ * элементы: sparse_multiply_dense выполняет nnz(A) x n умножений-сложений
+ * вместо m x k x n у multiply_matrices. Для матриц с долей ненулевых
+ * элементов выше нескольких процентов блочное умножение (gemm.h) быстрее,
+ * поэтому sparse_from_dense принимает порог плотности, а main выбирает
+ * разреженный путь по SPARSE_DENSITY_THRESHOLD (config.h).
+ *
+ * Транспонированная матрица в CSR совпадает с исходной в формате CSC
+ * (compressed sparse column), поэтому sparse_transpose служит и
+ * преобразованием CSR -> CSC.
+ *
+ * @see matrix.h
+ */
+
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "../../include/config.h"
+#include "matrix.h"
+
+#include <stddef.h>
+
+/**
+ * @struct SparseMatrix
+ * @brief Разреженная матрица в формате CSR
+ *
+ * @details
+ * values, row_ptr и col_idx лежат в одном блоке памяти, начало которого -
+ * values. Нулевая структура (row_ptr == NULL) обозначает ошибку.
+ */
+typedef struct {
+    int          rows;      ///< Количество строк
+    int          cols;      ///< Количество столбцов
+    size_t       nnz;       ///< Количество хранимых элементов
+    MATRIX_TYPE* values;    ///< Значения элементов по строкам
+    size_t*      row_ptr;   ///< Начала строк в values, rows + 1 элемент
+    int*         col_idx;   ///< Номера столбцов элементов
+} SparseMatrix;
+
+/**
+ * @brief Создает разреженную матрицу с местом под nnz элементов
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param nnz Количество элементов
+ * @note row_ptr заполнен нулями, values и col_idx не инициализированы
+ * @return Матрица или нулевая структура при ошибке
+ */
+SparseMatrix sparse_create (int rows, int cols, size_t nnz);
+
+/**
+ * @brief Освобождает память разреженной матрицы
+ * @param matrix Матрица или NULL
+ */
+void sparse_free (SparseMatrix* matrix);
+
+/**
+ * @brief Доля ненулевых элементов плотной матрицы
+ * @param matrix Плотная матрица
+ * @return Число от 0 до 1 или -1 при ошибке
+ */
+double matrix_density (const Matrix* matrix);
+
+/**
+ * @brief Преобразует плотную матрицу в CSR
+ * @param matrix Плотная матрица
+ * @param max_density Наибольшая доля ненулевых элементов; 1 - без порога
+ * @note Матрица плотнее max_density не преобразуется: возвращается нулевая
+ *       структура, как при ошибке
+ * @return Разреженная матрица или нулевая структура
+ */
+SparseMatrix sparse_from_dense (const Matrix* matrix, double max_density);
+
+/**
+ * @brief Преобразует разреженную матрицу в плотную
+ * @param matrix Разреженная матрица
+ * @return Плотная матрица или нулевая матрица при ошибке
+ */
+Matrix sparse_to_dense (const SparseMatrix* matrix);
+
+/**
+ * @brief Умножает разреженную матрицу на плотную: result = A x B
+ * @param A Разреженная матрица m x k
+ * @param B Плотная матрица k x n
+ * @param result Плотная матрица не меньше m x n
+ * @note При n = 1 это умножение матрицы на вектор (SpMV)
+ * @return 0 при успехе, -1 при ошибке
+ */
+int sparse_multiply_dense (const SparseMatrix* A, const Matrix* B, Matrix* result);
+
+/**
+ * @brief Умножает плотную матрицу на разреженную: result = A x B
+ * @param A Плотная матрица m x k
+ * @param B Разреженная матрица k x n
+ * @param result Плотная матрица не меньше m x n
+ * @note Нулевые элементы A пропускаются
+ * @return 0 при успехе, -1 при ошибке
+ */
+int dense_multiply_sparse (const Matrix* A, const SparseMatrix* B, Matrix* result);
+
+/**
+ * @brief Умножает две разреженные матрицы (SpGEMM)
+ * @param A Разреженная матрица m x k
+ * @param B Разреженная матрица k x n
+ * @note Элементы, сократившиеся до нуля, остаются в структуре результата
+ * @return Разреженная матрица m x n или нулевая структура при ошибке
+ */
+SparseMatrix sparse_multiply (const SparseMatrix* A, const SparseMatrix* B);
+
+/**
+ * @brief Складывает две разреженные матрицы
+ * @param A Первая матрица
+ * @param B Вторая матрица того же размера
+ * @return Сумма или нулевая структура при ошибке
+ */
+SparseMatrix sparse_add (const SparseMatrix* A, const SparseMatrix* B);
+
+/**
+ * @brief Вычитает разреженные матрицы: A - B
+ * @param A Уменьшаемое
+ * @param B Вычитаемое того же размера
+ * @return Разность или нулевая структура при ошибке
+ */
+SparseMatrix sparse_subtract (const SparseMatrix* A, const SparseMatrix* B);
+
+/**
+ * @brief Транспонирует разреженную матрицу (CSR -> CSC)
+ * @param matrix Разреженная матрица
+ * @return Транспонированная матрица в CSR или нулевая структура при ошибке
+ */
+SparseMatrix sparse_transpose (const SparseMatrix* matrix);
+
+#endif   // SPARSE_H
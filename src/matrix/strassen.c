@@ -0,0 +1,330 @@
+/**
+ * @file strassen.c
+ * @brief Реализация умножения методом Штрассена-Винограда
+ *
+ * @details
+ * Блоки A, B и C (m/2 x k/2, k/2 x n/2, m/2 x n/2):
+ * - S1 = A21 + A22, S2 = S1 - A11, S3 = A11 - A21, S4 = A12 - S2
+ * - T1 = B12 - B11, T2 = B22 - T1, T3 = B22 - B12, T4 = T2 - B21
+ * - P1 = A11 B11, P2 = A12 B21, P3 = S4 B22, P4 = A22 T4,
+ *   P5 = S1 T1, P6 = S2 T2, P7 = S3 T3
+ * - C11 = P1 + P2, C12 = P1 + P6 + P5 + P3,
+ *   C21 = P1 + P6 + P7 - P4, C22 = P1 + P6 + P7 + P5
+ *
+ * Порядок шагов в strassen_recursive выбран так, что промежуточные
+ * результаты хранятся в четвертях C и в двух временных блоках X и Y.
+ *
+ * @see strassen.h
+ */
+
+#include "strassen.h"
+
+#include "simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Выравнивание временных блоков в элементах */
+#define STRASSEN_ALIGN (MATRIX_ALIGNMENT / sizeof (MATRIX_TYPE))
+
+/**
+ * @brief Округляет количество элементов вверх до выравнивания
+ *
+ * @param count Количество элементов
+ * @return Округленное количество
+ */
+static size_t strassen_round (size_t count) {
+    return (count + STRASSEN_ALIGN - 1) / STRASSEN_ALIGN * STRASSEN_ALIGN;
+}
+
+/**
+ * @brief Проверяет, нужно ли переходить к обычному умножению
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param crossover Порог
+ * @return 1 для базового случая
+ */
+static int strassen_is_base (int m, int n, int k, int crossover) {
+    return m <= crossover || n <= crossover || k <= crossover;
+}
+
+/**
+ * @brief Множитель роста погрешности
+ *
+ * @param levels Число уровней рекурсии
+ * @return 12^levels
+ */
+double strassen_growth (int levels) {
+    double growth = 1.0;
+    for (int i = 0; i < levels; i++) growth *= 12.0;
+    return growth;
+}
+
+/**
+ * @brief Число уровней рекурсии
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param crossover Порог
+ * @return Число уровней
+ */
+int strassen_levels (int m, int n, int k, int crossover) {
+    int levels = 0;
+
+    if (crossover < 1) crossover = 1;
+    while (!strassen_is_base (m, n, k, crossover)) {
+        m /= 2;
+        n /= 2;
+        k /= 2;
+        levels++;
+    }
+
+    return levels;
+}
+
+/**
+ * @brief Размер рабочей области в элементах
+ *
+ * На уровне нужны X (m/2 x max(k/2, n/2)) и Y (k/2 x n/2); семь
+ * подзадач выполняются по очереди и делят область следующего уровня.
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param crossover Порог
+ * @return Количество элементов
+ */
+size_t strassen_workspace_size (int m, int n, int k, int crossover) {
+    size_t size = 0;
+
+    if (crossover < 1) crossover = 1;
+    while (!strassen_is_base (m, n, k, crossover)) {
+        const int hm = m / 2, hn = n / 2, hk = k / 2;
+        size += strassen_round ((size_t) hm * (hk > hn ? hk : hn));
+        size += strassen_round ((size_t) hk * hn);
+        m = hm;
+        n = hn;
+        k = hk;
+    }
+
+    return size;
+}
+
+/**
+ * @brief Поэлементное сложение блоков: c = a + b
+ *
+ * @param rows Строк
+ * @param cols Столбцов
+ * @param a Первый блок
+ * @param lda Шаг строки a
+ * @param b Второй блок
+ * @param ldb Шаг строки b
+ * @param c Результат
+ * @param ldc Шаг строки c
+ */
+static void block_add (int rows, int cols, const MATRIX_TYPE* a, int lda,
+                       const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* c, int ldc) {
+    const SimdOps* ops = simd_ops ();
+    for (int i = 0; i < rows; i++) {
+        ops->add (cols, a + (size_t) i * lda, b + (size_t) i * ldb, c + (size_t) i * ldc);
+    }
+}
+
+/**
+ * @brief Поэлементное вычитание блоков: c = a - b
+ *
+ * @param rows Строк
+ * @param cols Столбцов
+ * @param a Первый блок
+ * @param lda Шаг строки a
+ * @param b Второй блок
+ * @param ldb Шаг строки b
+ * @param c Результат
+ * @param ldc Шаг строки c
+ */
+static void block_sub (int rows, int cols, const MATRIX_TYPE* a, int lda,
+                       const MATRIX_TYPE* b, int ldb, MATRIX_TYPE* c, int ldc) {
+    const SimdOps* ops = simd_ops ();
+    for (int i = 0; i < rows; i++) {
+        ops->sub (cols, a + (size_t) i * lda, b + (size_t) i * ldb, c + (size_t) i * ldc);
+    }
+}
+
+/**
+ * @brief Досчитывает отщепленные нечетные строку, столбец и слой по k
+ *
+ * Четная часть C (2hm x 2hn) уже содержит произведение четных частей A и B.
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ */
+static void strassen_peel (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                           const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc) {
+    const int me = m & ~1, ne = n & ~1, ke = k & ~1;
+
+    // Ранг-1 поправка от последнего столбца A и последней строки B
+    if (k != ke) {
+        const MATRIX_TYPE* b_row = B + (size_t) ke * ldb;
+        for (int i = 0; i < me; i++) {
+            const MATRIX_TYPE a_ik = A[(size_t) i * lda + ke];
+            MATRIX_TYPE*      c    = C + (size_t) i * ldc;
+            for (int j = 0; j < ne; j++) c[j] += a_ik * b_row[j];
+        }
+    }
+
+    // Последний столбец C
+    if (n != ne) {
+        for (int i = 0; i < me; i++) {
+            const MATRIX_TYPE* a   = A + (size_t) i * lda;
+            MATRIX_TYPE        sum = 0;
+            for (int p = 0; p < k; p++) sum += a[p] * B[(size_t) p * ldb + ne];
+            C[(size_t) i * ldc + ne] = sum;
+        }
+    }
+
+    // Последняя строка C
+    if (m != me) {
+        const MATRIX_TYPE* a = A + (size_t) me * lda;
+        MATRIX_TYPE*       c = C + (size_t) me * ldc;
+        memset (c, 0, (size_t) n * sizeof (MATRIX_TYPE));
+        for (int p = 0; p < k; p++) {
+            const MATRIX_TYPE* b = B + (size_t) p * ldb;
+            for (int j = 0; j < n; j++) c[j] += a[p] * b[j];
+        }
+    }
+}
+
+/**
+ * @brief Один уровень рекурсии Штрассена-Винограда
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ * @param crossover Порог
+ * @param ws Рабочая область этого и следующих уровней
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int strassen_recursive (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                               const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C,
+                               int ldc, int crossover, MATRIX_TYPE* ws) {
+    int res = 0;
+
+    if (strassen_is_base (m, n, k, crossover)) {
+        res = gemm_multiply (m, n, k, A, lda, B, ldb, C, ldc);
+    } else {
+        const int hm = m / 2, hn = n / 2, hk = k / 2;
+
+        const MATRIX_TYPE* A11 = A;
+        const MATRIX_TYPE* A12 = A + hk;
+        const MATRIX_TYPE* A21 = A + (size_t) hm * lda;
+        const MATRIX_TYPE* A22 = A21 + hk;
+        const MATRIX_TYPE* B11 = B;
+        const MATRIX_TYPE* B12 = B + hn;
+        const MATRIX_TYPE* B21 = B + (size_t) hk * ldb;
+        const MATRIX_TYPE* B22 = B21 + hn;
+        MATRIX_TYPE*       C11 = C;
+        MATRIX_TYPE*       C12 = C + hn;
+        MATRIX_TYPE*       C21 = C + (size_t) hm * ldc;
+        MATRIX_TYPE*       C22 = C21 + hn;
+
+        // Временные блоки уровня и область для подзадач
+        const int    ldx  = hk > hn ? hk : hn;
+        const int    ldy  = hn;
+        MATRIX_TYPE* X    = ws;
+        MATRIX_TYPE* Y    = X + strassen_round ((size_t) hm * ldx);
+        MATRIX_TYPE* next = Y + strassen_round ((size_t) hk * ldy);
+
+#define STRASSEN_MUL(a, la, b, lb, c, lc)                                           \
+    if (res == 0)                                                                   \
+    res = strassen_recursive (hm, hn, hk, a, la, b, lb, c, lc, crossover, next)
+
+        block_sub (hm, hk, A11, lda, A21, lda, X, ldx);        // S3
+        block_sub (hk, hn, B22, ldb, B12, ldb, Y, ldy);        // T3
+        STRASSEN_MUL (X, ldx, Y, ldy, C21, ldc);               // P7
+        block_add (hm, hk, A21, lda, A22, lda, X, ldx);        // S1
+        block_sub (hk, hn, B12, ldb, B11, ldb, Y, ldy);        // T1
+        STRASSEN_MUL (X, ldx, Y, ldy, C22, ldc);               // P5
+        block_sub (hm, hk, X, ldx, A11, lda, X, ldx);          // S2
+        block_sub (hk, hn, B22, ldb, Y, ldy, Y, ldy);          // T2
+        STRASSEN_MUL (X, ldx, Y, ldy, C12, ldc);               // P6
+        block_sub (hm, hk, A12, lda, X, ldx, X, ldx);          // S4
+        STRASSEN_MUL (X, ldx, B22, ldb, C11, ldc);             // P3
+        STRASSEN_MUL (A11, lda, B11, ldb, X, ldx);             // P1
+        block_add (hm, hn, X, ldx, C12, ldc, C12, ldc);        // U2 = P1 + P6
+        block_add (hm, hn, C12, ldc, C21, ldc, C21, ldc);      // U3 = U2 + P7
+        block_add (hm, hn, C12, ldc, C22, ldc, C12, ldc);      // U4 = U2 + P5
+        block_add (hm, hn, C21, ldc, C22, ldc, C22, ldc);      // U7 = U3 + P5
+        block_add (hm, hn, C12, ldc, C11, ldc, C12, ldc);      // U5 = U4 + P3
+        block_sub (hk, hn, Y, ldy, B21, ldb, Y, ldy);          // T4
+        STRASSEN_MUL (A22, lda, Y, ldy, C11, ldc);             // P4
+        block_sub (hm, hn, C21, ldc, C11, ldc, C21, ldc);      // U6 = U3 - P4
+        STRASSEN_MUL (A12, lda, B21, ldb, C11, ldc);           // P2
+        block_add (hm, hn, X, ldx, C11, ldc, C11, ldc);        // U1 = P1 + P2
+
+#undef STRASSEN_MUL
+
+        if (res == 0) strassen_peel (m, n, k, A, lda, B, ldb, C, ldc);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Вычисляет C = A x B методом Штрассена-Винограда
+ *
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param A Элементы A
+ * @param lda Шаг строки A
+ * @param B Элементы B
+ * @param ldb Шаг строки B
+ * @param C Элементы C
+ * @param ldc Шаг строки C
+ * @param crossover Порог перехода к gemm
+ * @param workspace Рабочая область или NULL
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int strassen_multiply (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                       const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc,
+                       int crossover, MATRIX_TYPE* workspace) {
+    void*  owned = NULL;   // Рабочая область, выделенная здесь
+    size_t size  = 0;
+    int    res   = 0;
+
+    if (crossover < 1) crossover = 1;
+    size = strassen_workspace_size (m, n, k, crossover);
+
+    if (workspace == NULL && size > 0) {
+        if (posix_memalign (&owned, MATRIX_ALIGNMENT, size * sizeof (MATRIX_TYPE)) ==
+            0)
+            workspace = owned;
+        else res = -1;
+    }
+
+    if (res == 0) {
+        res = strassen_recursive (m, n, k, A, lda, B, ldb, C, ldc, crossover,
+                                  workspace);
+    }
+
+    free (owned);
+
+    return res;
+}
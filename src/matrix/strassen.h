@@ -0,0 +1,88 @@
+/**
+ * @file strassen.h
+ * @brief Умножение матриц методом Штрассена-Винограда
+ *
+ * @details
+ * Вариант Винограда (7 умножений и 15 сложений блоков на уровень) с
+ * расписанием Boyer-Dumas-Pernet-Zhou: на каждом уровне нужны только два
+ * временных блока X и Y, которые берутся из заранее выделенной рабочей
+ * области. Рекурсия продолжается, пока все размеры больше crossover,
+ * после чего используется обычное блочное умножение (gemm.h). Нечетные
+ * размеры отщепляются: последняя строка, столбец и ранг-1 поправка
+ * считаются отдельно за O(n^2).
+ *
+ * Точность: на каждом уровне рекурсии оценка погрешности растет примерно
+ * в 12 раз (Higham, "Accuracy and Stability of Numerical Algorithms",
+ * 23.2.2), поэтому проверяется нормированная ошибка
+ * max|C - C_ref| <= STRASSEN_TOLERANCE (k, levels) * max|A| * max|B|.
+ * Для данных из [-1, 1] и 1-3 уровней она составляет 1e-13..1e-12 против
+ * 1e-15..1e-14 у классического алгоритма при допуске 1e-10.
+ *
+ * @see gemm.h
+ */
+
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include "../../include/config.h"
+#include "gemm.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Допуск нормированной ошибки относительно классического умножения
+ * @param k Общая размерность
+ * @param levels Число уровней рекурсии (strassen_levels)
+ */
+#define STRASSEN_TOLERANCE(k, levels)                                               \
+    (GEMM_TOLERANCE (k) * strassen_growth (levels))
+
+/**
+ * @brief Множитель роста погрешности: 12 на каждый уровень
+ * @param levels Число уровней рекурсии
+ * @return 12^levels
+ */
+double strassen_growth (int levels);
+
+/**
+ * @brief Число уровней рекурсии для заданных размеров
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param crossover Размер, начиная с которого используется gemm
+ * @return Число уровней (0 - обычное умножение)
+ */
+int strassen_levels (int m, int n, int k, int crossover);
+
+/**
+ * @brief Размер рабочей области в элементах
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param crossover Размер, начиная с которого используется gemm
+ * @return Количество элементов MATRIX_TYPE
+ */
+size_t strassen_workspace_size (int m, int n, int k, int crossover);
+
+/**
+ * @brief Вычисляет C = A x B методом Штрассена-Винограда
+ * @param m Строк в A и C
+ * @param n Столбцов в B и C
+ * @param k Общая размерность
+ * @param A Элементы A с шагом lda
+ * @param lda Шаг строки A
+ * @param B Элементы B с шагом ldb
+ * @param ldb Шаг строки B
+ * @param C Элементы C с шагом ldc
+ * @param ldc Шаг строки C
+ * @param crossover Размер, начиная с которого используется gemm
+ * @param workspace Рабочая область из strassen_workspace_size элементов
+ *                  или NULL, чтобы выделить её внутри
+ * @note C не должна пересекаться с A и B
+ * @return 0 при успехе, -1 при ошибке
+ */
+int strassen_multiply (int m, int n, int k, const MATRIX_TYPE* A, int lda,
+                       const MATRIX_TYPE* B, int ldb, MATRIX_TYPE* C, int ldc,
+                       int crossover, MATRIX_TYPE* workspace);
+
+#endif   // STRASSEN_H
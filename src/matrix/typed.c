@@ -0,0 +1,892 @@
+/**
+ * @file typed.c
+ * @brief Матрицы float и int32_t: создание, преобразование и ядра
+ *
+ * @details
+ * Целочисленная арифметика выполняется над uint32_t и приводится обратно к
+ * int32_t, поэтому переполнение дает остаток по модулю 2^32, а не
+ * неопределенное поведение. Транспонирование не различает float и
+ * int32_t и переставляет 32-битные слова.
+ *
+ * @see typed.h matrix.h
+ */
+
+#include "typed.h"
+
+#include "../metrics/metrics.h"
+#include "../parallel/thread_pool.h"
+#include "simd.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert (sizeof (float) == sizeof (uint32_t) &&
+                    sizeof (int32_t) == sizeof (uint32_t),
+                "транспонирование переставляет 32-битные слова");
+
+/**
+ * Длина отрезка целочисленных ядер: цикл с постоянным числом итераций
+ * компилятор превращает в векторные инструкции и при -O2
+ */
+#define TYPED_I32_RUN 16
+
+static const char* const type_names[MATRIX_ELEMENT_TYPE_COUNT] = {"f64", "f32",
+                                                                  "i32"};
+
+/**
+ * @brief Размер элемента заданного типа
+ *
+ * @param type Тип элементов
+ * @return Размер в байтах или 0 для неизвестного типа
+ */
+size_t matrix_element_size (MatrixElementType type) {
+    size_t size = 0;
+
+    switch (type) {
+    case MATRIX_F64: size = sizeof (MATRIX_TYPE); break;
+    case MATRIX_F32: size = sizeof (float); break;
+    case MATRIX_I32: size = sizeof (int32_t); break;
+    default: break;
+    }
+
+    return size;
+}
+
+/**
+ * @brief Имя типа элементов
+ *
+ * @param type Тип элементов
+ * @return Строка с именем или NULL для неизвестного типа
+ */
+const char* matrix_type_name (MatrixElementType type) {
+    return (type >= 0 && type < MATRIX_ELEMENT_TYPE_COUNT) ? type_names[type]
+                                                            : NULL;
+}
+
+/**
+ * @brief Определяет тип элементов по имени
+ *
+ * @param name Имя типа
+ * @param type Найденный тип
+ * @return 0 при успехе, -1 для неизвестного имени
+ */
+int matrix_type_from_name (const char* name, MatrixElementType* type) {
+    int res = -1;
+
+    for (int i = 0; name && type && res != 0 && i < MATRIX_ELEMENT_TYPE_COUNT; i++) {
+        if (strcmp (name, type_names[i]) == 0) {
+            *type = (MatrixElementType) i;
+            res   = 0;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Проверяет, что матрица создана
+ *
+ * @param matrix Указатель на матрицу
+ * @return 1, если у матрицы есть элементы, иначе 0
+ */
+int matrix_valid (const Matrix* matrix) {
+    return matrix != NULL && (matrix->block != NULL || matrix->elements != NULL);
+}
+
+/**
+ * @brief Создает матрицу с элементами заданного типа
+ *
+ * @param rows Количество строк (должно быть > 0)
+ * @param cols Количество столбцов (должно быть > 0)
+ * @param type Тип элементов
+ * @return Структура Matrix при успехе, нулевая матрица при ошибке
+ */
+Matrix create_matrix_typed (int rows, int cols, MatrixElementType type) {
+    Matrix       mat      = {0};
+    const size_t size     = matrix_element_size (type);
+    size_t       capacity = 0;
+    void*        block    = NULL;
+
+    if (type == MATRIX_F64) mat = create_matrix (rows, cols);
+    else if (size != 0 && rows > 0 && cols > 0) {
+        METRICS_BEGIN (timer);
+        capacity = matrix_capacity (rows, cols, size);
+        if (capacity != 0 &&
+            posix_memalign (&block, MATRIX_ALIGNMENT, capacity * size) == 0) {
+            METRICS_ALLOCATION ();
+            mat.rows     = rows;
+            mat.cols     = cols;
+            mat.stride   = matrix_leading_dimension (cols, size);
+            mat.type     = type;
+            mat.elements = block;
+        }
+        METRICS_END (timer, METRICS_CREATE, 0, 0);
+    }
+
+    return mat;
+}
+
+/**
+ * @brief Начало строки матрицы любого типа
+ *
+ * @param matrix Матрица
+ * @param row Номер строки
+ * @return Адрес первого элемента строки
+ */
+static inline void* typed_row (const Matrix* matrix, int row) {
+    char* base = matrix->type == MATRIX_F64 ? (char*) matrix->block
+                                            : (char*) matrix->elements;
+    return base + (size_t) row * matrix->stride * matrix_element_size (matrix->type);
+}
+
+/**
+ * @brief Округляет double до int32_t с насыщением
+ *
+ * @param value Значение
+ * @return Ближайшее целое, INT32_MIN/INT32_MAX вне диапазона, 0 для NaN
+ */
+static int32_t typed_round_i32 (double value) {
+    int32_t res = 0;
+
+    if (isnan (value)) res = 0;
+    else if (value >= (double) INT32_MAX) res = INT32_MAX;
+    else if (value <= (double) INT32_MIN) res = INT32_MIN;
+    else res = (int32_t) lrint (value);
+
+    return res;
+}
+
+/**
+ * @brief Преобразует строку элементов одного типа в другой
+ *
+ * @param n Количество элементов
+ * @param from Тип исходных элементов
+ * @param src Исходная строка
+ * @param to Тип результата
+ * @param dst Строка результата
+ */
+static void typed_convert_row (int n, MatrixElementType from, const void* src,
+                               MatrixElementType to, void* dst) {
+    for (int j = 0; j < n; j++) {
+        double value = 0;
+        switch (from) {
+        case MATRIX_F64: value = ((const MATRIX_TYPE*) src)[j]; break;
+        case MATRIX_F32: value = ((const float*) src)[j]; break;
+        default: value = ((const int32_t*) src)[j]; break;
+        }
+        switch (to) {
+        case MATRIX_F64: ((MATRIX_TYPE*) dst)[j] = value; break;
+        case MATRIX_F32: ((float*) dst)[j] = (float) value; break;
+        default: ((int32_t*) dst)[j] = typed_round_i32 (value); break;
+        }
+    }
+}
+
+/**
+ * @brief Преобразует матрицу к другому типу элементов
+ *
+ * Значения проходят через double, который точно представляет и float, и
+ * int32_t; при одинаковом типе строки копируются.
+ *
+ * @param matrix Указатель на матрицу
+ * @param type Тип элементов результата
+ * @return Новая матрица или нулевая матрица при ошибке
+ */
+Matrix convert_matrix_type (const Matrix* matrix, MatrixElementType type) {
+    Matrix res = {0};
+
+    if (matrix_valid (matrix)) res = create_matrix_typed (matrix->rows, matrix->cols,
+                                                         type);
+
+    if (matrix_valid (&res)) {
+        const size_t size = matrix_element_size (type);
+        for (int row = 0; row < matrix->rows; row++) {
+            if (matrix->type == type) {
+                memcpy (typed_row (&res, row), typed_row (matrix, row),
+                        (size_t) matrix->cols * size);
+            } else {
+                typed_convert_row (matrix->cols, matrix->type,
+                                   typed_row (matrix, row), type,
+                                   typed_row (&res, row));
+            }
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Проверяет, что все матрицы созданы и имеют тип float или int32_t
+ *
+ * @param type Ожидаемый тип
+ * @param matrices Матрицы; NULL пропускаются
+ * @param count Количество матриц
+ * @return 1, если условие выполнено
+ */
+static int typed_same (MatrixElementType type, const Matrix* const* matrices,
+                       int count) {
+    int same = type == MATRIX_F32 || type == MATRIX_I32;
+
+    for (int i = 0; same && i < count; i++) {
+        if (matrices[i] != NULL)
+            same = matrices[i]->type == type && matrices[i]->elements != NULL;
+    }
+
+    return same;
+}
+
+/**
+ * @brief Поэлементная операция над строкой int32_t по модулю 2^32
+ *
+ * @param n Количество элементов
+ * @param a Первый операнд
+ * @param b Второй операнд
+ * @param r Результат
+ * @param subtract 1 - вычитание, 0 - сложение
+ */
+static void typed_binary_i32 (int n, const int32_t* a, const int32_t* b, int32_t* r,
+                              int subtract) {
+    const uint32_t sign = subtract ? UINT32_MAX : 1;   // b * sign = -b или b
+    int            j    = 0;
+
+    // Отрезок читается целиком до записи, поэтому r может совпадать с a или b
+    for (; j + TYPED_I32_RUN <= n; j += TYPED_I32_RUN) {
+        uint32_t v[TYPED_I32_RUN];
+        for (int l = 0; l < TYPED_I32_RUN; l++) {
+            v[l] = (uint32_t) a[j + l] + sign * (uint32_t) b[j + l];
+        }
+        for (int l = 0; l < TYPED_I32_RUN; l++) r[j + l] = (int32_t) v[l];
+    }
+    for (; j < n; j++) r[j] = (int32_t) ((uint32_t) a[j] + sign * (uint32_t) b[j]);
+}
+
+/**
+ * @brief Поэлементная операция: result = A + B или A - B
+ *
+ * @param A Первый операнд
+ * @param B Второй операнд
+ * @param result Результат
+ * @param subtract 1 - вычитание, 0 - сложение
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_binary (const Matrix* A, const Matrix* B, Matrix* result, int subtract) {
+    const Matrix* const operands[] = {A, B, result};
+    const SimdOps*      ops        = simd_ops ();
+    int                 res        = -1;
+
+    if (typed_same (A->type, operands, 3)) {
+        for (int row = 0; row < A->rows; row++) {
+            if (A->type == MATRIX_F32) {
+                const simd_binary_f32_fn fn = subtract ? ops->sub_f32 : ops->add_f32;
+                fn (A->cols, typed_row (A, row), typed_row (B, row),
+                    typed_row (result, row));
+            } else {
+                typed_binary_i32 (A->cols, typed_row (A, row), typed_row (B, row),
+                                  typed_row (result, row), subtract);
+            }
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Прибавляет C и вычитает D^T на месте: result = result + C - D^T
+ *
+ * Плитка результата сначала получает C строками, затем D^T столбцами:
+ * строка D дает столбец плитки и читается подряд.
+ *
+ * @param C Прибавляемая матрица
+ * @param D Матрица, транспонированная которой вычитается
+ * @param result Накопитель
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_add_subtract_transposed (const Matrix* C, const Matrix* D,
+                                   Matrix* result) {
+    const Matrix* const operands[] = {C, D, result};
+    const int           m          = C->rows;
+    const int           n          = C->cols;
+    int                 res        = -1;
+
+    if (typed_same (C->type, operands, 3)) {
+        for (int row = 0; row < m; row += TRANSPOSE_TILE) {
+            const int last = m - row < TRANSPOSE_TILE ? m : row + TRANSPOSE_TILE;
+            for (int col = 0; col < n; col += TRANSPOSE_TILE) {
+                const int end = n - col < TRANSPOSE_TILE ? n : col + TRANSPOSE_TILE;
+                if (C->type == MATRIX_F32) {
+                    for (int i = row; i < last; i++) {
+                        float*       r = typed_row (result, i);
+                        const float* c = typed_row (C, i);
+                        for (int j = col; j < end; j++) r[j] += c[j];
+                    }
+                    for (int j = col; j < end; j++) {
+                        const float* d = typed_row (D, j);
+                        for (int i = row; i < last; i++)
+                            ((float*) typed_row (result, i))[j] -= d[i];
+                    }
+                } else {
+                    // Беззнаковая арифметика: переполнение по модулю 2^32
+                    for (int i = row; i < last; i++) {
+                        uint32_t*       r = typed_row (result, i);
+                        const uint32_t* c = typed_row (C, i);
+                        for (int j = col; j < end; j++) r[j] += c[j];
+                    }
+                    for (int j = col; j < end; j++) {
+                        const uint32_t* d = typed_row (D, j);
+                        for (int i = row; i < last; i++)
+                            ((uint32_t*) typed_row (result, i))[j] -= d[i];
+                    }
+                }
+            }
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Проверяет, что множитель годится для матрицы int32_t
+ *
+ * @param value Множитель
+ * @return 1, если value - целое из диапазона int32_t
+ */
+static int typed_integral (double value) {
+    return value >= INT32_MIN && value <= INT32_MAX && value == floor (value);
+}
+
+/**
+ * @brief Умножает строку матрицы на число: r[j] = beta * r[j]
+ *
+ * @param matrix Матрица float или int32_t
+ * @param row Номер строки
+ * @param n Количество элементов
+ * @param beta Множитель (для int32_t - целый); при 0 строка обнуляется
+ *             без чтения
+ */
+static void typed_scale_row (const Matrix* matrix, int row, int n, double beta) {
+    if (matrix->type == MATRIX_F32) {
+        float*      r = typed_row (matrix, row);
+        const float b = (float) beta;
+        for (int j = 0; j < n; j++) r[j] = beta == 0 ? 0.0f : b * r[j];
+    } else {
+        int32_t*       r = typed_row (matrix, row);
+        const uint32_t b = (uint32_t) (int32_t) beta;
+        for (int j = 0; j < n; j++) r[j] = (int32_t) (b * (uint32_t) r[j]);
+    }
+}
+
+/**
+ * @brief Линейная комбинация: Y = alpha * X + beta * Y
+ *
+ * Строка Y умножается на beta, затем накапливается ядром axpy_f32 или
+ * axpy_i32. Если X и Y - одни и те же элементы, строка умножается на
+ * alpha + beta за один проход.
+ *
+ * @param alpha Множитель X
+ * @param X Прибавляемая матрица
+ * @param beta Множитель Y
+ * @param Y Накопитель того же размера и типа
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_axpby (double alpha, const Matrix* X, double beta, Matrix* Y) {
+    const Matrix* const operands[] = {X, Y};
+    const SimdOps*      ops        = simd_ops ();
+    int                 res        = -1;
+
+    if (typed_same (X->type, operands, 2) &&
+        (X->type == MATRIX_F32 ||
+         (typed_integral (alpha) && typed_integral (beta)))) {
+        for (int row = 0; row < X->rows; row++) {
+            const void* x = typed_row (X, row);
+            void*       y = typed_row (Y, row);
+            if (x == y) typed_scale_row (Y, row, X->cols, alpha + beta);
+            else {
+                if (beta != 1) typed_scale_row (Y, row, X->cols, beta);
+                if (X->type == MATRIX_F32)
+                    ops->axpy_f32 (X->cols, (float) alpha, x, y);
+                else
+                    ops->axpy_i32 (X->cols, (int32_t) alpha, x, y);
+            }
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @struct TypedMultiplyTask
+ * @brief Аргументы умножения для задач пула
+ */
+typedef struct {
+    const Matrix* A;        ///< Матрица m x k
+    const Matrix* B;        ///< Матрица k x n
+    const Matrix* C;        ///< Прибавляемая матрица или NULL
+    const Matrix* D;        ///< Вычитаемая транспонированная или NULL
+    Matrix*       result;   ///< Результат
+    double        alpha;    ///< Множитель произведения
+    double        beta;     ///< Множитель прежнего результата (без C и D)
+} TypedMultiplyTask;
+
+/**
+ * @brief Записывает в строки результата C - D^T или beta * result
+ *
+ * @param task Аргументы умножения
+ * @param first Первая строка
+ * @param last Строка после последней
+ */
+static void typed_multiply_init (const TypedMultiplyTask* task, int first,
+                                 int last) {
+    const Matrix* C = task->C;
+    const Matrix* D = task->D;
+    const int     n = task->B->cols;
+
+    for (int i = first; i < last; i++) {
+        if (C == NULL && D == NULL) {
+            if (task->beta != 1) typed_scale_row (task->result, i, n, task->beta);
+        } else if (task->result->type == MATRIX_F32) {
+            float* r = typed_row (task->result, i);
+            for (int j = 0; j < n; j++) {
+                r[j] = (C ? MATRIX_AT_F32 (C, i, j) : 0.0f) -
+                       (D ? MATRIX_AT_F32 (D, j, i) : 0.0f);
+            }
+        } else {
+            int32_t* r = typed_row (task->result, i);
+            for (int j = 0; j < n; j++) {
+                const uint32_t add = C ? (uint32_t) MATRIX_AT_I32 (C, i, j) : 0;
+                const uint32_t sub = D ? (uint32_t) MATRIX_AT_I32 (D, j, i) : 0;
+                r[j]               = (int32_t) (add - sub);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Задача пула: строки результата TYPED_MC * task ..
+ *
+ * Для каждого блока B размером TYPED_KC x TYPED_NC все строки задачи
+ * накапливают вклад блока строками: r[i][jb..] += a[i][p] * b[p][jb..].
+ *
+ * @param arg Аргументы умножения (TypedMultiplyTask)
+ * @param task Номер полосы строк
+ * @param worker Номер потока
+ */
+static void typed_multiply_task (void* arg, int task, int worker) {
+    const TypedMultiplyTask* op    = arg;
+    const SimdOps*           ops   = simd_ops ();
+    const Matrix*            A     = op->A;
+    const Matrix*            B     = op->B;
+    const int                first = task * TYPED_MC;
+    const int last = (A->rows - first < TYPED_MC) ? A->rows : first + TYPED_MC;
+    const int     n      = B->cols;
+    const int     k      = A->cols;
+    const float   alpha  = (float) op->alpha;
+    const int32_t ialpha = A->type == MATRIX_I32 ? (int32_t) op->alpha : 0;
+
+    (void) worker;
+
+    typed_multiply_init (op, first, last);
+    for (int jb = 0; jb < n; jb += TYPED_NC) {
+        const int jn = (n - jb < TYPED_NC) ? n - jb : TYPED_NC;
+        for (int pb = 0; pb < k; pb += TYPED_KC) {
+            const int pn = (k - pb < TYPED_KC) ? k - pb : TYPED_KC;
+            for (int i = first; i < last; i++) {
+                for (int p = pb; p < pb + pn; p++) {
+                    if (A->type == MATRIX_F32) {
+                        ops->axpy_f32 (jn, alpha * MATRIX_AT_F32 (A, i, p),
+                                       &MATRIX_AT_F32 (B, p, jb),
+                                       &MATRIX_AT_F32 (op->result, i, jb));
+                    } else {
+                        const uint32_t a = (uint32_t) MATRIX_AT_I32 (A, i, p);
+                        ops->axpy_i32 (jn, (int32_t) ((uint32_t) ialpha * a),
+                                       &MATRIX_AT_I32 (B, p, jb),
+                                       &MATRIX_AT_I32 (op->result, i, jb));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @struct TypedPackedTask
+ * @brief Общее состояние блочного умножения float с упаковкой панелей
+ */
+typedef struct {
+    const TypedMultiplyTask* op;       ///< Аргументы умножения
+    const GemmKernelF32*     kernel;   ///< Микроядро
+    int                      mb;       ///< Строк результата в одной задаче
+    int                      jc;       ///< Первый столбец текущего блока B
+    int                      nc;       ///< Столбцов в текущем блоке B
+    int                      pc;       ///< Начало текущего блока по k
+    int                      kc;       ///< Длина текущего блока по k
+    float*                   pack_b;   ///< Упакованный блок B
+    float**                  pack_a;   ///< Буферы упаковки A по потокам
+} TypedPackedTask;
+
+/**
+ * @brief Упаковывает блок A (mc x kc) float в панели по mr строк
+ *
+ * Строки за пределами блока заполняются нулями, alpha учитывается при
+ * упаковке.
+ *
+ * @param mc Строк в блоке
+ * @param kc Столбцов в блоке
+ * @param alpha Множитель элементов
+ * @param A Начало блока
+ * @param lda Шаг строки A
+ * @param mr Высота панели
+ * @param pack Буфер упаковки
+ */
+static void typed_pack_a_f32 (int mc, int kc, float alpha, const float* A, int lda,
+                              int mr, float* pack) {
+    for (int ir = 0; ir < mc; ir += mr) {
+        const int rows = (mc - ir < mr) ? mc - ir : mr;
+        for (int i = 0; i < mr; i++) {
+            if (i < rows) {
+                const float* src = A + (size_t) (ir + i) * lda;
+                for (int p = 0; p < kc; p++) pack[p * mr + i] = alpha * src[p];
+            } else {
+                for (int p = 0; p < kc; p++) pack[p * mr + i] = 0;
+            }
+        }
+        pack += (size_t) kc * mr;
+    }
+}
+
+/**
+ * @brief Упаковывает блок B (kc x nc) float в панели по nr столбцов
+ *
+ * @param kc Строк в блоке
+ * @param nc Столбцов в блоке
+ * @param B Начало блока
+ * @param ldb Шаг строки B
+ * @param nr Ширина панели
+ * @param pack Буфер упаковки
+ */
+static void typed_pack_b_f32 (int kc, int nc, const float* B, int ldb, int nr,
+                              float* pack) {
+    for (int jr = 0; jr < nc; jr += nr) {
+        const int cols = (nc - jr < nr) ? nc - jr : nr;
+        for (int p = 0; p < kc; p++) {
+            const float* src = B + (size_t) p * ldb + jr;
+            float*       dst = pack + (size_t) p * nr;
+            int          j   = 0;
+            for (; j < cols; j++) dst[j] = src[j];
+            for (; j < nr; j++) dst[j] = 0;
+        }
+        pack += (size_t) kc * nr;
+    }
+}
+
+/**
+ * @brief Задача пула: блок строк результата для текущих блоков B
+ *
+ * Упаковывает свои строки A и прибавляет к результату плитки микроядра;
+ * краевые плитки считаются во временный буфер, как в gemm.c.
+ *
+ * @param arg Состояние умножения (TypedPackedTask)
+ * @param task Номер блока строк
+ * @param worker Номер потока, выбирает буфер упаковки A
+ */
+static void typed_packed_task (void* arg, int task, int worker) {
+    const TypedPackedTask* ctx    = arg;
+    const GemmKernelF32*   kernel = ctx->kernel;
+    const Matrix*          A      = ctx->op->A;
+    Matrix*                result = ctx->op->result;
+    const int              ic     = task * ctx->mb;
+    const int              mc     = (A->rows - ic < ctx->mb) ? A->rows - ic
+                                                                : ctx->mb;
+    const int              mr     = kernel->mr;
+    const int              nr     = kernel->nr;
+    float*                 pack_a = ctx->pack_a[worker];
+    float                  edge[GEMM_MAX_MR * GEMM_MAX_NR];   // Плитка для краев
+
+    typed_pack_a_f32 (mc, ctx->kc, (float) ctx->op->alpha,
+                      &MATRIX_AT_F32 (A, ic, ctx->pc), A->stride, mr, pack_a);
+    for (int jr = 0; jr < ctx->nc; jr += nr) {
+        const int    cols = (ctx->nc - jr < nr) ? ctx->nc - jr : nr;
+        const float* b    = ctx->pack_b + (size_t) jr * ctx->kc;
+        for (int ir = 0; ir < mc; ir += mr) {
+            const int    rows = (mc - ir < mr) ? mc - ir : mr;
+            const float* a    = pack_a + (size_t) ir * ctx->kc;
+            float*       c    = &MATRIX_AT_F32 (result, ic + ir, ctx->jc + jr);
+
+            if (rows == mr && cols == nr) {
+                kernel->kernel (ctx->kc, a, b, c, result->stride, 1);
+            } else {
+                kernel->kernel (ctx->kc, a, b, edge, nr, 0);
+                for (int i = 0; i < rows; i++) {
+                    float* c_i = c + (size_t) i * result->stride;
+                    for (int j = 0; j < cols; j++) c_i[j] += edge[i * nr + j];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Умножение float блоками с упаковкой панелей и микроядром
+ *
+ * Повторяет gemm.c для float: блок B размером TYPED_KC x TYPED_NC
+ * упаковывается в панели по NR столбцов, задачи пула упаковывают свои
+ * TYPED_MC строк A (с округлением вниз до MR) и накапливают плитки
+ * микроядра уровня simd_ops ()->gemm_f32 прямо в результате. C - D^T или
+ * beta * result записываются в результат до умножения.
+ *
+ * @param op Аргументы умножения
+ * @return 0 при успехе, -1 при ошибке выделения памяти
+ */
+static int typed_multiply_packed (const TypedMultiplyTask* op) {
+    TypedPackedTask ctx = {.op = op, .kernel = simd_ops ()->gemm_f32};
+    float*          pack_a[THREAD_POOL_MAX_THREADS] = {NULL};
+    const Matrix*   A       = op->A;
+    const Matrix*   B       = op->B;
+    const int       mr      = ctx.kernel->mr;
+    const int       nr      = ctx.kernel->nr;
+    const double    work    = (double) A->rows * B->cols * A->cols;
+    int             threads = 1;    // Потоков для этого умножения
+    int             res     = 0;    // Результат выполнения
+
+    ctx.mb = TYPED_MC / mr * mr;
+    if (ctx.mb == 0) ctx.mb = mr;
+    if (work >= (double) GEMM_PARALLEL_THRESHOLD) threads = thread_pool_threads ();
+
+    const int    tasks  = (A->rows + ctx.mb - 1) / ctx.mb;
+    const size_t size_a = (size_t) ctx.mb * TYPED_KC;
+    const size_t size_b = (size_t) ((TYPED_NC + nr - 1) / nr * nr) * TYPED_KC;
+
+    for (int i = 0; i < threads && res == 0; i++) {
+        if (posix_memalign ((void**) &pack_a[i], MATRIX_ALIGNMENT,
+                            size_a * sizeof (float)) != 0) {
+            pack_a[i] = NULL;
+            res       = -1;
+        }
+    }
+    if (res == 0 && posix_memalign ((void**) &ctx.pack_b, MATRIX_ALIGNMENT,
+                                    size_b * sizeof (float)) != 0) {
+        ctx.pack_b = NULL;
+        res        = -1;
+    }
+    ctx.pack_a = pack_a;
+
+    if (res == 0) typed_multiply_init (op, 0, A->rows);
+    for (int jc = 0; res == 0 && jc < B->cols; jc += TYPED_NC) {
+        ctx.jc = jc;
+        ctx.nc = (B->cols - jc < TYPED_NC) ? B->cols - jc : TYPED_NC;
+        for (int pc = 0; pc < A->cols; pc += TYPED_KC) {
+            ctx.pc = pc;
+            ctx.kc = (A->cols - pc < TYPED_KC) ? A->cols - pc : TYPED_KC;
+            typed_pack_b_f32 (ctx.kc, ctx.nc, &MATRIX_AT_F32 (B, pc, jc), B->stride,
+                              nr, ctx.pack_b);
+            if (threads > 1 && tasks > 1) {
+                thread_pool_run (tasks, typed_packed_task, &ctx);
+            } else {
+                for (int t = 0; t < tasks; t++) typed_packed_task (&ctx, t, 0);
+            }
+        }
+    }
+
+    for (int i = 0; i < threads; i++) free (pack_a[i]);
+    free (ctx.pack_b);
+
+    return res;
+}
+
+/**
+ * @brief Выполняет умножение по полосам строк
+ *
+ * float больше GEMM_SMALL_THRESHOLD умножается с упаковкой панелей
+ * (typed_multiply_packed), остальное - накоплением строк. Полосы по
+ * TYPED_MC строк результата - независимые задачи пула потоков, если объем
+ * работы не меньше GEMM_PARALLEL_THRESHOLD.
+ *
+ * @param task Аргументы умножения
+ * @return 0 при успехе, -1 при разных типах, пустой матрице или ошибке
+ *         выделения памяти
+ */
+static int typed_multiply_run (TypedMultiplyTask* task) {
+    const Matrix* const operands[] = {task->A, task->B, task->C, task->D,
+                                      task->result};
+    const Matrix*       A          = task->A;
+    int                 res        = -1;
+
+    if (typed_same (A->type, operands, 5) &&
+        (A->type == MATRIX_F32 ||
+         (typed_integral (task->alpha) && typed_integral (task->beta)))) {
+        const int    tasks = (A->rows + TYPED_MC - 1) / TYPED_MC;
+        const double work  = (double) A->rows * task->B->cols * A->cols;
+        if (A->type == MATRIX_F32 && work > (double) GEMM_SMALL_THRESHOLD) {
+            res = typed_multiply_packed (task);   // Упаковка и микроядро
+        } else if (tasks > 1 && work >= (double) GEMM_PARALLEL_THRESHOLD &&
+                   thread_pool_threads () > 1) {
+            thread_pool_run (tasks, typed_multiply_task, task);
+            res = 0;
+        } else {
+            for (int t = 0; t < tasks; t++) typed_multiply_task (task, t, 0);
+            res = 0;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Умножение: result = A x B + C - D^T
+ *
+ * @param A Матрица m x k
+ * @param B Матрица k x n
+ * @param C Прибавляемая матрица или NULL
+ * @param D Вычитаемая транспонированная матрица или NULL
+ * @param result Результат
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_multiply (const Matrix* A, const Matrix* B, const Matrix* C,
+                    const Matrix* D, Matrix* result) {
+    TypedMultiplyTask task = {A, B, C, D, result, 1, 0};
+
+    return typed_multiply_run (&task);
+}
+
+/**
+ * @brief Умножение с накоплением: result = alpha * A x B + beta * result
+ *
+ * @param alpha Множитель произведения
+ * @param A Матрица m x k
+ * @param B Матрица k x n
+ * @param beta Множитель прежнего результата
+ * @param result Накопитель m x n
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_gemm (double alpha, const Matrix* A, const Matrix* B, double beta,
+                Matrix* result) {
+    TypedMultiplyTask task = {A, B, NULL, NULL, result, alpha, beta};
+
+    return typed_multiply_run (&task);
+}
+
+/**
+ * @brief Транспонирует блок 32-битных слов плитками
+ *
+ * @param rows Строк в src
+ * @param cols Столбцов в src
+ * @param src Исходный блок
+ * @param lds Шаг строки src
+ * @param dst Блок результата
+ * @param ldd Шаг строки dst
+ */
+static void typed_transpose_block (int rows, int cols, const uint32_t* src, int lds,
+                                   uint32_t* dst, int ldd) {
+    for (int ib = 0; ib < rows; ib += TRANSPOSE_TILE) {
+        const int i_end = (rows - ib < TRANSPOSE_TILE) ? rows : ib + TRANSPOSE_TILE;
+        for (int jb = 0; jb < cols; jb += TRANSPOSE_TILE) {
+            const int j_end = (cols - jb < TRANSPOSE_TILE) ? cols
+                                                           : jb + TRANSPOSE_TILE;
+            for (int i = ib; i < i_end; i++) {
+                for (int j = jb; j < j_end; j++) {
+                    dst[(size_t) j * ldd + i] = src[(size_t) i * lds + j];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Транспонирует матрицу в новую матрицу того же типа
+ *
+ * @param matrix Исходная матрица
+ * @param result Матрица cols x rows
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_transpose (const Matrix* matrix, Matrix* result) {
+    const Matrix* const operands[] = {matrix, result};
+    int                 res        = -1;
+
+    if (typed_same (matrix->type, operands, 2) && result->rows == matrix->cols &&
+        result->cols == matrix->rows) {
+        typed_transpose_block (matrix->rows, matrix->cols, matrix->elements,
+                               matrix->stride, result->elements, result->stride);
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Транспонирует матрицу на месте
+ *
+ * Квадратная матрица транспонируется обменом элементов пар плиток,
+ * прямоугольная - уплотнением строк, обходом циклов перестановки и
+ * раскладкой строк в том же блоке: с выровненным шагом, если он
+ * помещается в rows * stride элементов, иначе с плотным (stride == rows).
+ *
+ * @param matrix Матрица float или int32_t
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_transpose_inplace (Matrix* matrix) {
+    const Matrix* const operands[] = {matrix};
+    int                 res        = typed_same (matrix->type, operands, 1) ? 0 : -1;
+
+    if (res == 0 && matrix->rows == matrix->cols) {
+        uint32_t* a = matrix->elements;
+        const int n = matrix->rows;
+        const int s = matrix->stride;
+        for (int ib = 0; ib < n; ib += TRANSPOSE_TILE) {
+            const int i_end = (n - ib < TRANSPOSE_TILE) ? n : ib + TRANSPOSE_TILE;
+            for (int jb = ib; jb < n; jb += TRANSPOSE_TILE) {
+                const int j_end = (n - jb < TRANSPOSE_TILE) ? n
+                                                             : jb + TRANSPOSE_TILE;
+                for (int i = ib; i < i_end; i++) {
+                    for (int j = (jb > i + 1) ? jb : i + 1; j < j_end; j++) {
+                        const uint32_t value  = a[(size_t) i * s + j];
+                        a[(size_t) i * s + j] = a[(size_t) j * s + i];
+                        a[(size_t) j * s + i] = value;
+                    }
+                }
+            }
+        }
+    } else if (res == 0) {
+        const int rows   = matrix->rows;
+        const int cols   = matrix->cols;
+        int       stride = matrix_leading_dimension (rows, sizeof (uint32_t));
+        uint32_t* block  = matrix->elements;
+
+        // Плотная раскладка всегда помещается в блок, выровненная - не всегда
+        if (stride == 0 || (size_t) cols * stride > (size_t) rows * matrix->stride)
+            stride = rows;
+
+        // Отображение файла нельзя переразложить
+        if (matrix->mapping) res = -1;
+
+        if (res == 0) {
+            // Уплотнение: строки сдвигаются вниз по адресам
+            for (int row = 1; row < rows; row++) {
+                memmove (block + (size_t) row * cols,
+                         block + (size_t) row * matrix->stride,
+                         (size_t) cols * sizeof (uint32_t));
+            }
+            res = matrix_transpose_cycles (rows, cols, block, sizeof (uint32_t));
+
+            // Восстановление строк исходной матрицы при ошибке
+            const int width = res == 0 ? rows : cols;
+            const int pitch = res == 0 ? stride : matrix->stride;
+            const int lines = res == 0 ? cols : rows;
+            for (int row = lines - 1; row > 0; row--) {
+                memmove (block + (size_t) row * pitch, block + (size_t) row * width,
+                         (size_t) width * sizeof (uint32_t));
+            }
+        }
+
+        if (res == 0) {
+            matrix->rows   = cols;
+            matrix->cols   = rows;
+            matrix->stride = stride;
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file typed.h
+ * @brief Ядра для матриц float и int32_t
+ *
+ * @details
+ * Матрица с типом MATRIX_F32 или MATRIX_I32 хранит элементы в одном
+ * выровненном блоке elements с шагом строки stride в элементах своего
+ * типа; у новой матрицы строка также начинается с кэш-линии. Массива
+ * указателей на строки нет. Блок рассчитан только на свою раскладку;
+ * прямоугольная матрица транспонируется на месте в том же блоке, с плотным
+ * шагом (stride == rows), если выровненный не помещается.
+ *
+ * Создание, преобразование типов и имена типов объявлены в matrix.h, а
+ * ядра этого модуля вызываются из публичных операций matrix.h, когда хотя
+ * бы один операнд не MATRIX_F64. Все операнды одной операции должны иметь
+ * один тип, иначе операция возвращает ошибку.
+ *
+ * - float: поэлементные операции используют векторные ядра simd.h
+ *   (add_f32, sub_f32). Умножение устроено как в gemm.c: блок B размером
+ *   TYPED_KC x TYPED_NC упаковывается в панели, строки A упаковываются
+ *   задачами пула, а плитки считает микроядро float своего уровня
+ *   (SimdOps::gemm_f32); произведение накапливается в float. Малые
+ *   произведения (до GEMM_SMALL_THRESHOLD) идут без упаковки, ядром
+ *   axpy_f32 по строкам результата
+ * - int32_t: арифметика по модулю 2^32 (как у беззнаковых целых), без
+ *   неопределенного поведения при переполнении; умножение идет по строкам
+ *   результата в порядке i-p-j блоками TYPED_KC x TYPED_NC с ядром
+ *   axpy_i32, так что блок B остается в кэше для всех строк
+ *
+ * Транспонирование оперирует 32-битными словами и одинаково для обоих
+ * типов. Детерминант считается в double через временную копию.
+ *
+ * @see matrix.h simd.h
+ */
+
+#ifndef TYPED_H
+#define TYPED_H
+
+#include "matrix.h"
+
+/** Столбцов B в блоке умножения float и int32_t */
+#define TYPED_NC 512
+
+/** Строк B в блоке умножения float и int32_t */
+#define TYPED_KC 256
+
+/** Строк результата в одной задаче пула (для float - кратно MR вниз) */
+#define TYPED_MC 64
+
+/**
+ * @brief Проверяет, есть ли среди операндов матрица не MATRIX_F64
+ * @param A Операнд или NULL
+ * @param B Операнд или NULL
+ * @param C Операнд или NULL
+ * @return 1, если хотя бы у одной матрицы тип float или int32_t
+ */
+static inline int typed_involved (const Matrix* A, const Matrix* B,
+                                  const Matrix* C) {
+    return (A && A->type != MATRIX_F64) || (B && B->type != MATRIX_F64) ||
+           (C && C->type != MATRIX_F64);
+}
+
+/**
+ * @brief Поэлементная операция: result = A + B или A - B
+ * @param A Первый операнд
+ * @param B Второй операнд того же размера
+ * @param result Результат не меньше A; может совпадать с A или B
+ * @param subtract 1 - вычитание, 0 - сложение
+ * @return 0 при успехе, -1 при разных типах или пустой матрице
+ */
+int typed_binary (const Matrix* A, const Matrix* B, Matrix* result, int subtract);
+
+/**
+ * @brief Прибавляет C и вычитает D^T на месте: result = result + C - D^T
+ * @param C Прибавляемая матрица m x n; может совпадать с result
+ * @param D Матрица n x m, транспонированная которой вычитается
+ * @param result Накопитель m x n, не пересекающийся с D
+ * @note Один проход плитками TRANSPOSE_TILE x TRANSPOSE_TILE, D^T не
+ *       строится; результат совпадает с typed_binary, примененной дважды
+ * @return 0 при успехе, -1 при разных типах или пустой матрице
+ */
+int typed_add_subtract_transposed (const Matrix* C, const Matrix* D,
+                                   Matrix* result);
+
+/**
+ * @brief Умножение: result = A x B + C - D^T
+ * @param A Матрица m x k
+ * @param B Матрица k x n
+ * @param C Прибавляемая матрица m x n или NULL
+ * @param D Матрица n x m, транспонированная которой вычитается, или NULL
+ * @param result Результат не меньше m x n, отличный от A, B и D
+ * @note C и D^T записываются в result до накопления произведения, поэтому
+ *       result может совпадать с C
+ * @return 0 при успехе, -1 при разных типах или пустой матрице
+ */
+int typed_multiply (const Matrix* A, const Matrix* B, const Matrix* C,
+                    const Matrix* D, Matrix* result);
+
+/**
+ * @brief Умножение с накоплением: result = alpha * A x B + beta * result
+ * @param alpha Множитель произведения
+ * @param A Матрица m x k
+ * @param B Матрица k x n
+ * @param beta Множитель прежнего результата (0 - результат не читается)
+ * @param result Накопитель m x n, отличный от A и B
+ * @note Для int32_t alpha и beta должны быть целыми
+ * @return 0 при успехе, -1 при разных типах, пустой матрице или дробном
+ *         множителе для int32_t
+ */
+int typed_gemm (double alpha, const Matrix* A, const Matrix* B, double beta,
+                Matrix* result);
+
+/**
+ * @brief Линейная комбинация: Y = alpha * X + beta * Y
+ * @param alpha Множитель X
+ * @param X Прибавляемая матрица
+ * @param beta Множитель Y
+ * @param Y Накопитель того же размера и типа; может совпадать с X
+ * @note Для int32_t alpha и beta должны быть целыми
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_axpby (double alpha, const Matrix* X, double beta, Matrix* Y);
+
+/**
+ * @brief Транспонирует матрицу в новую матрицу того же типа
+ * @param matrix Исходная матрица
+ * @param result Матрица cols x rows того же типа
+ * @return 0 при успехе, -1 при ошибке
+ */
+int typed_transpose (const Matrix* matrix, Matrix* result);
+
+/**
+ * @brief Транспонирует матрицу на месте
+ * @param matrix Матрица float или int32_t
+ * @note Матрица, отображенная из файла, транспонируется на месте только
+ *       если она квадратная
+ * @return 0 при успехе, -1 при ошибке (матрица не меняется)
+ */
+int typed_transpose_inplace (Matrix* matrix);
+
+#endif   // TYPED_H
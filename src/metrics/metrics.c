@@ -0,0 +1,312 @@
+/**
+ * @file metrics.c
+ * @brief Реализация счетчиков и гистограмм задержек
+ *
+ * @details
+ * Счетчики - атомарные 64-битные целые, обновляемые с memory_order_relaxed:
+ * порядок между разными счетчиками не нужен, важна только целостность
+ * каждого. Наименьшее и наибольшее время обновляются циклом
+ * сравнения-обмена, который в обычном случае (новое значение не рекорд)
+ * не выполняет ни одной записи. Нулевое наименьшее время означает, что
+ * вызовов не было, поэтому длительности округляются вверх до 1 нс.
+ *
+ * Выделения памяти считаются в счетчике потока (_Thread_local); замер
+ * берет разность счетчика на начало и конец, поэтому вложенные операции
+ * учитываются и во внешней.
+ *
+ * @see metrics.h
+ */
+
+#include "metrics.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/**
+ * @struct MetricsCounters
+ * @brief Атомарные счетчики одной операции
+ */
+typedef struct {
+    _Atomic uint64_t calls;                        ///< Число вызовов
+    _Atomic uint64_t total_ns;                     ///< Суммарное время
+    _Atomic uint64_t min_ns;                       ///< Наименьшее время
+    _Atomic uint64_t max_ns;                       ///< Наибольшее время
+    _Atomic uint64_t bytes_read;                   ///< Прочитано байтов
+    _Atomic uint64_t bytes_written;                ///< Записано байтов
+    _Atomic uint64_t allocations;                  ///< Выделений памяти
+    _Atomic uint64_t histogram[METRICS_BUCKETS];   ///< Корзины задержек
+} MetricsCounters;
+
+/** Счетчики всех операций */
+static MetricsCounters metrics_counters[METRICS_OP_COUNT];
+
+/** Выделений памяти в текущем потоке */
+static _Thread_local uint64_t metrics_thread_allocations;
+
+/** Файл для вывода при завершении программы */
+static const char* metrics_exit_file;
+
+/** Имена операций в выводе, в порядке MetricsOp */
+static const char* const metrics_names[METRICS_OP_COUNT] = {
+    "create",      "load",        "save",         "add",        "subtract",
+    "multiply",    "fused",       "transpose",    "determinant", "parse_text",
+    "format_text", "map_binary",  "write_binary", "read_tile",  "write_tile",
+    "hash"};
+
+/**
+ * @brief Монотонное время в наносекундах
+ * @return Время
+ */
+static uint64_t metrics_now (void) {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief Номер корзины гистограммы для длительности
+ * @param ns Длительность в наносекундах
+ * @return Номер корзины: floor (log2 (ns)), не больше METRICS_BUCKETS - 1
+ */
+static int metrics_bucket (uint64_t ns) {
+    int bucket = ns > 1 ? 63 - __builtin_clzll (ns) : 0;
+
+    return bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1;
+}
+
+/**
+ * @brief Проверяет, собраны ли точки замера
+ *
+ * @return 1 при сборке с MATRIX_METRICS
+ */
+int metrics_enabled (void) {
+#ifdef MATRIX_METRICS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Имя операции
+ *
+ * @param op Операция
+ *
+ * @return Имя или NULL
+ */
+const char* metrics_name (MetricsOp op) {
+    return (unsigned) op < METRICS_OP_COUNT ? metrics_names[op] : NULL;
+}
+
+/**
+ * @brief Начинает замер
+ *
+ * @return Время начала и счетчик выделений потока
+ */
+MetricsTimer metrics_begin (void) {
+    MetricsTimer timer = {metrics_now (), metrics_thread_allocations};
+
+    return timer;
+}
+
+/**
+ * @brief Добавляет замер к счетчикам операции
+ *
+ * @param timer Начало замера
+ * @param op Операция
+ * @param read Прочитано байтов
+ * @param written Записано байтов
+ */
+void metrics_end (const MetricsTimer* timer, MetricsOp op, uint64_t read,
+                  uint64_t written) {
+    const uint64_t elapsed     = metrics_now () - timer->start_ns;
+    const uint64_t ns          = elapsed > 0 ? elapsed : 1;   // 0 - нет вызовов
+    const uint64_t allocations = metrics_thread_allocations - timer->allocations;
+
+    if ((unsigned) op < METRICS_OP_COUNT) {
+        const memory_order relaxed = memory_order_relaxed;
+        MetricsCounters*   c       = &metrics_counters[op];
+        uint64_t           min     = atomic_load_explicit (&c->min_ns, relaxed);
+        uint64_t           max     = atomic_load_explicit (&c->max_ns, relaxed);
+
+        // Неудачный обмен перечитывает текущее значение в min или max
+        while ((min == 0 || ns < min) &&
+               !atomic_compare_exchange_weak_explicit (&c->min_ns, &min, ns, relaxed,
+                                                       relaxed)) {
+        }
+        while (ns > max &&
+               !atomic_compare_exchange_weak_explicit (&c->max_ns, &max, ns, relaxed,
+                                                       relaxed)) {
+        }
+
+        atomic_fetch_add_explicit (&c->calls, 1, relaxed);
+        atomic_fetch_add_explicit (&c->total_ns, ns, relaxed);
+        atomic_fetch_add_explicit (&c->bytes_read, read, relaxed);
+        atomic_fetch_add_explicit (&c->bytes_written, written, relaxed);
+        atomic_fetch_add_explicit (&c->allocations, allocations, relaxed);
+        atomic_fetch_add_explicit (&c->histogram[metrics_bucket (ns)], 1, relaxed);
+    }
+}
+
+/**
+ * @brief Отмечает выделение памяти в текущем потоке
+ */
+void metrics_count_allocation (void) {
+    metrics_thread_allocations++;
+}
+
+/**
+ * @brief Копирует накопленные данные операции
+ *
+ * @param op Операция
+ * @param snapshot Копия
+ *
+ * @return 0 при успехе, -1 для неизвестной операции
+ */
+int metrics_snapshot (MetricsOp op, MetricsSnapshot* snapshot) {
+    int res = -1;
+
+    if ((unsigned) op < METRICS_OP_COUNT && snapshot != NULL) {
+        MetricsCounters* c      = &metrics_counters[op];
+        snapshot->calls         = atomic_load (&c->calls);
+        snapshot->total_ns      = atomic_load (&c->total_ns);
+        snapshot->min_ns        = atomic_load (&c->min_ns);
+        snapshot->max_ns        = atomic_load (&c->max_ns);
+        snapshot->bytes_read    = atomic_load (&c->bytes_read);
+        snapshot->bytes_written = atomic_load (&c->bytes_written);
+        snapshot->allocations   = atomic_load (&c->allocations);
+        for (int i = 0; i < METRICS_BUCKETS; i++) {
+            snapshot->histogram[i] = atomic_load (&c->histogram[i]);
+        }
+        res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Обнуляет накопленные данные всех операций
+ */
+void metrics_reset (void) {
+    for (int op = 0; op < METRICS_OP_COUNT; op++) {
+        MetricsCounters* c = &metrics_counters[op];
+        atomic_store (&c->calls, 0);
+        atomic_store (&c->total_ns, 0);
+        atomic_store (&c->min_ns, 0);
+        atomic_store (&c->max_ns, 0);
+        atomic_store (&c->bytes_read, 0);
+        atomic_store (&c->bytes_written, 0);
+        atomic_store (&c->allocations, 0);
+        for (int i = 0; i < METRICS_BUCKETS; i++) atomic_store (&c->histogram[i], 0);
+    }
+}
+
+/**
+ * @brief Выводит накопленные данные в JSON
+ *
+ * Корзины гистограммы выводятся только непустые, с нижней границей
+ * from_ns.
+ *
+ * @param out Поток вывода
+ *
+ * @return 0 при успехе, -1 при ошибке записи
+ */
+int metrics_dump (FILE* out) {
+    MetricsSnapshot s;
+    int             first = 1;   // Первая операция в списке
+
+    fprintf (out, "{\"enabled\": %s, \"operations\": [",
+             metrics_enabled () ? "true" : "false");
+
+    for (int op = 0; op < METRICS_OP_COUNT; op++) {
+        metrics_snapshot ((MetricsOp) op, &s);
+        if (s.calls == 0) continue;
+
+        fprintf (out,
+                 "%s\n  {\"op\": \"%s\", \"calls\": %llu, \"total_ns\": %llu, "
+                 "\"min_ns\": %llu, \"max_ns\": %llu, \"mean_ns\": %llu, "
+                 "\"bytes_read\": %llu, \"bytes_written\": %llu, "
+                 "\"allocations\": %llu, \"histogram\": [",
+                 first ? "" : ",", metrics_names[op], (unsigned long long) s.calls,
+                 (unsigned long long) s.total_ns, (unsigned long long) s.min_ns,
+                 (unsigned long long) s.max_ns,
+                 (unsigned long long) (s.total_ns / s.calls),
+                 (unsigned long long) s.bytes_read,
+                 (unsigned long long) s.bytes_written,
+                 (unsigned long long) s.allocations);
+        first = 0;
+
+        int first_bucket = 1;
+        for (int i = 0; i < METRICS_BUCKETS; i++) {
+            if (s.histogram[i] == 0) continue;
+            fprintf (out, "%s{\"from_ns\": %llu, \"count\": %llu}",
+                     first_bucket ? "" : ", ", i ? 1ull << i : 0ull,
+                     (unsigned long long) s.histogram[i]);
+            first_bucket = 0;
+        }
+        fprintf (out, "]}");
+    }
+    fprintf (out, "%s]}\n", first ? "" : "\n");
+
+    return ferror (out) ? -1 : 0;
+}
+
+/**
+ * @brief Выводит накопленные данные в JSON-файл
+ *
+ * @param filename Имя файла
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int metrics_dump_file (const char* filename) {
+    FILE* out = filename ? fopen (filename, "w") : NULL;
+    int   res = -1;
+
+    if (out) {
+        res = metrics_dump (out);
+        if (fclose (out) != 0) res = -1;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Обработчик atexit
+ */
+static void metrics_dump_on_exit (void) {
+    if (metrics_exit_file && metrics_dump_file (metrics_exit_file) != 0)
+        fprintf (stderr, "Ошибка записи метрик в %s.\n", metrics_exit_file);
+}
+
+/**
+ * @brief Выводит данные в файл при завершении программы
+ *
+ * @param filename Имя файла
+ *
+ * @return 0 при успехе, -1 при ошибке регистрации
+ */
+int metrics_dump_at_exit (const char* filename) {
+    int res = 0;
+
+    if (metrics_exit_file == NULL && atexit (metrics_dump_on_exit) != 0) res = -1;
+    if (res == 0) metrics_exit_file = filename;
+
+    return res;
+}
+
+/**
+ * @brief Размер файла
+ *
+ * @param filename Имя файла
+ *
+ * @return Размер в байтах или 0
+ */
+uint64_t metrics_file_size (const char* filename) {
+    struct stat info;
+
+    return filename && stat (filename, &info) == 0 ? (uint64_t) info.st_size : 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file metrics.h
+ * @brief Счетчики и гистограммы задержек матричных операций
+ *
+ * @details
+ * Для каждой операции (MetricsOp) накапливаются число вызовов, суммарное,
+ * наименьшее и наибольшее время, гистограмма задержек, прочитанные и
+ * записанные байты и число выделений памяти в куче. Точки замера
+ * расставлены в matrix.c, output.c и cache.c макросами METRICS_BEGIN и
+ * METRICS_END.
+ *
+ * Замеры включаются при сборке флагом MATRIX_METRICS (make METRICS=1).
+ * Без него макросы раскрываются в пустые выражения и их аргументы не
+ * вычисляются, так что операции не тратят на замеры ни одной инструкции.
+ * С ним замер стоит двух чтений монотонных часов и нескольких атомарных
+ * сложений без блокировок, поэтому операции можно вызывать из разных
+ * потоков.
+ *
+ * Гистограмма логарифмическая: корзина i считает вызовы длительностью
+ * [2^i, 2^(i+1)) наносекунд, последняя - все более долгие.
+ *
+ * Накопленные данные выводятся в JSON функцией metrics_dump по запросу
+ * или при завершении программы (metrics_dump_at_exit).
+ *
+ * @see matrix.h output.h
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** Число корзин гистограммы задержек */
+#define METRICS_BUCKETS 40
+
+/**
+ * @enum MetricsOp
+ * @brief Измеряемые операции
+ */
+typedef enum {
+    METRICS_CREATE,          ///< create_matrix
+    METRICS_LOAD,            ///< load_matrix_from_file
+    METRICS_SAVE,            ///< Сохранение в текстовый или двоичный файл
+    METRICS_ADD,             ///< add_matrices, axpby_matrices, прибавление C - D^T
+    METRICS_SUBTRACT,        ///< subtract_matrices
+    METRICS_MULTIPLY,        ///< multiply_matrices и gemm_matrices
+    METRICS_FUSED,           ///< multiply_add_subtract_transposed
+    METRICS_TRANSPOSE,       ///< transpose_matrix и transpose_matrix_inplace
+    METRICS_DETERMINANT,     ///< determinant и log_determinant
+    METRICS_PARSE_TEXT,      ///< Разбор элементов текстового файла
+    METRICS_FORMAT_TEXT,     ///< Запись текстового файла
+    METRICS_MAP_BINARY,      ///< Отображение двоичного файла
+    METRICS_WRITE_BINARY,    ///< Запись двоичного файла
+    METRICS_READ_TILE,       ///< Чтение плитки плиточного файла
+    METRICS_WRITE_TILE,      ///< Запись плитки плиточного файла
+    METRICS_HASH,            ///< matrix_hash
+    METRICS_OP_COUNT         ///< Число операций
+} MetricsOp;
+
+/**
+ * @struct MetricsSnapshot
+ * @brief Накопленные данные одной операции
+ */
+typedef struct {
+    uint64_t calls;                        ///< Число вызовов
+    uint64_t total_ns;                     ///< Суммарное время
+    uint64_t min_ns;                       ///< Наименьшее время (0 без вызовов)
+    uint64_t max_ns;                       ///< Наибольшее время
+    uint64_t bytes_read;                   ///< Прочитано байтов
+    uint64_t bytes_written;                ///< Записано байтов
+    uint64_t allocations;                  ///< Выделений памяти в куче
+    uint64_t histogram[METRICS_BUCKETS];   ///< Вызовы по корзинам задержек
+} MetricsSnapshot;
+
+/**
+ * @struct MetricsTimer
+ * @brief Начало замера
+ */
+typedef struct {
+    uint64_t start_ns;      ///< Время начала
+    uint64_t allocations;   ///< Выделений в потоке к началу замера
+} MetricsTimer;
+
+#ifdef MATRIX_METRICS
+
+/**
+ * @brief Начинает замер операции
+ * @param timer Имя переменной замера
+ */
+#define METRICS_BEGIN(timer) MetricsTimer timer = metrics_begin ()
+
+/**
+ * @brief Завершает замер и добавляет его к операции
+ * @param timer Переменная из METRICS_BEGIN
+ * @param op Операция
+ * @param read Прочитано байтов
+ * @param written Записано байтов
+ */
+#define METRICS_END(timer, op, read, written)                                  \
+    metrics_end (&(timer), (op), (uint64_t) (read), (uint64_t) (written))
+
+/** Отмечает выделение памяти в куче в текущем потоке */
+#define METRICS_ALLOCATION() metrics_count_allocation ()
+
+#else
+
+#define METRICS_BEGIN(timer)
+#define METRICS_END(timer, op, read, written) ((void) 0)
+#define METRICS_ALLOCATION() ((void) 0)
+
+#endif   // MATRIX_METRICS
+
+/**
+ * @brief Проверяет, собраны ли точки замера
+ * @return 1 при сборке с MATRIX_METRICS, иначе 0
+ */
+int metrics_enabled (void);
+
+/**
+ * @brief Имя операции в выводе
+ * @param op Операция
+ * @return Имя или NULL для неизвестной операции
+ */
+const char* metrics_name (MetricsOp op);
+
+/**
+ * @brief Начинает замер (используется через METRICS_BEGIN)
+ * @return Начало замера
+ */
+MetricsTimer metrics_begin (void);
+
+/**
+ * @brief Завершает замер (используется через METRICS_END)
+ * @param timer Начало замера
+ * @param op Операция
+ * @param read Прочитано байтов
+ * @param written Записано байтов
+ */
+void metrics_end (const MetricsTimer* timer, MetricsOp op, uint64_t read,
+                  uint64_t written);
+
+/**
+ * @brief Отмечает выделение памяти (используется через METRICS_ALLOCATION)
+ */
+void metrics_count_allocation (void);
+
+/**
+ * @brief Копирует накопленные данные операции
+ * @param op Операция
+ * @param snapshot Копия
+ * @note Счетчики читаются по отдельности, поэтому при одновременных
+ *       замерах копия может быть не согласована между полями
+ * @return 0 при успехе, -1 для неизвестной операции
+ */
+int metrics_snapshot (MetricsOp op, MetricsSnapshot* snapshot);
+
+/**
+ * @brief Обнуляет накопленные данные всех операций
+ */
+void metrics_reset (void);
+
+/**
+ * @brief Выводит накопленные данные в JSON
+ * @param out Поток вывода
+ * @note Выводятся только операции, которые вызывались
+ * @return 0 при успехе, -1 при ошибке записи
+ */
+int metrics_dump (FILE* out);
+
+/**
+ * @brief Выводит накопленные данные в JSON-файл
+ * @param filename Имя файла
+ * @return 0 при успехе, -1 при ошибке
+ */
+int metrics_dump_file (const char* filename);
+
+/**
+ * @brief Выводит данные в файл при завершении программы (atexit)
+ * @param filename Имя файла; строка должна жить до завершения программы
+ * @note Повторный вызов меняет только имя файла
+ * @return 0 при успехе, -1 если обработчик не удалось зарегистрировать
+ */
+int metrics_dump_at_exit (const char* filename);
+
+/**
+ * @brief Размер файла для подсчета байтов ввода-вывода
+ * @param filename Имя файла
+ * @return Размер в байтах или 0, если файл недоступен
+ */
+uint64_t metrics_file_size (const char* filename);
+
+#endif   // METRICS_H
@@ -0,0 +1,372 @@
+/**
+ * @file format.c
+ * @brief Реализация быстрого форматирования чисел
+ *
+ * @details
+ * format_shortest следует алгоритму Schubfach (R. Giulietti, "The
+ * Schubfach way to render doubles"): для v = c 2^q вычисляются
+ * приближения v, границ интервала округления и их произведений на 10^-k
+ * одной 126-битной константой, после чего выбирается кратчайшая
+ * десятичная запись из интервала.
+ *
+ * @see format.h format_pow10.h
+ */
+
+#include "format.h"
+
+#include "format_pow10.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/** Число бит мантиссы double без скрытой единицы */
+#define FORMAT_MANTISSA_BITS 52
+
+/** Наименьшая двоичная степень денормализованного double */
+#define FORMAT_Q_MIN (-1074)
+
+/** Скрытая единица нормализованной мантиссы */
+#define FORMAT_C_MIN (UINT64_C (1) << FORMAT_MANTISSA_BITS)
+
+/** Младшие 63 бита */
+#define FORMAT_MASK_63 (UINT64_MAX >> 1)
+
+/** Степени десяти, помещающиеся в uint64_t */
+static const uint64_t format_pow10_u64[] = {1,
+                                            10,
+                                            100,
+                                            1000,
+                                            10000,
+                                            100000,
+                                            1000000,
+                                            10000000,
+                                            100000000,
+                                            1000000000,
+                                            10000000000,
+                                            100000000000,
+                                            1000000000000,
+                                            10000000000000,
+                                            100000000000000,
+                                            1000000000000000,
+                                            10000000000000000,
+                                            100000000000000000,
+                                            1000000000000000000,
+                                            10000000000000000000u};
+
+/** Пары цифр 00..99 для печати по две цифры за шаг */
+static const char format_digit_pairs[] = "00010203040506070809"
+                                         "10111213141516171819"
+                                         "20212223242526272829"
+                                         "30313233343536373839"
+                                         "40414243444546474849"
+                                         "50515253545556575859"
+                                         "60616263646566676869"
+                                         "70717273747576777879"
+                                         "80818283848586878889"
+                                         "90919293949596979899";
+
+/**
+ * @brief Количество десятичных цифр числа
+ *
+ * @param n Число
+ * @return Количество цифр, не меньше 1
+ */
+static int format_digit_count (uint64_t n) {
+    int count = 1;
+
+    while (count < 20 && n >= format_pow10_u64[count]) count++;
+
+    return count;
+}
+
+/**
+ * @brief Печатает ровно count младших десятичных цифр числа с ведущими нулями
+ *
+ * @param n Число
+ * @param count Количество цифр
+ * @param buffer Буфер
+ */
+static void format_digits (uint64_t n, int count, char* buffer) {
+    while (count >= 2) {
+        count -= 2;
+        memcpy (buffer + count, format_digit_pairs + 2 * (n % 100), 2);
+        n /= 100;
+    }
+    if (count == 1) buffer[0] = (char) ('0' + n % 10);
+}
+
+/**
+ * @brief Печатает число с фиксированным числом знаков после точки
+ *
+ * @param value Число
+ * @param precision Знаков после точки
+ * @param buffer Буфер
+ * @return Количество записанных символов
+ */
+size_t format_fixed (double value, int precision, char* buffer) {
+    uint64_t bits;
+    size_t   length = 0;
+
+    memcpy (&bits, &value, sizeof bits);
+
+    if (precision < 0) precision = 0;
+    if (precision > FORMAT_MAX_PRECISION) precision = FORMAT_MAX_PRECISION;
+
+    const int      negative = (int) (bits >> 63);
+    const int      biased   = (int) (bits >> FORMAT_MANTISSA_BITS) & 0x7FF;
+    const uint64_t fraction = bits & (FORMAT_C_MIN - 1);
+    const uint64_t c        = biased ? fraction | FORMAT_C_MIN : fraction;
+    const int      q        = biased ? biased - 1075 : FORMAT_Q_MIN;
+
+    // v = c 2^q; целая часть должна поместиться в uint64_t, а дробь,
+    // умноженная на 10^precision, - в 128 бит
+    if (biased == 0x7FF || q > 11 || precision > FORMAT_FAST_PRECISION) {
+        length = (size_t) snprintf (buffer, FORMAT_BUFFER_SIZE, "%.*f", precision,
+                                    value);
+    } else {
+        const uint64_t scale   = format_pow10_u64[precision];
+        uint64_t       integer = 0;
+        uint64_t       digits  = 0;
+
+        if (q >= 0) {
+            integer = c << q;
+        } else if (q >= -96) {
+            const int         shift = -q;
+            const uint64_t    mask  = shift < 64 ? (UINT64_C (1) << shift) - 1 : UINT64_MAX;
+            unsigned __int128 part  = c & mask;
+            unsigned __int128 scaled, rest, half;
+
+            integer = shift < 64 ? c >> shift : 0;
+            scaled  = part * scale;
+            digits  = (uint64_t) (scaled >> shift);
+            rest    = scaled & ((((unsigned __int128) 1) << shift) - 1);
+            half    = ((unsigned __int128) 1) << (shift - 1);
+
+            // Округление к ближайшему, при равенстве - к четной последней цифре
+            const uint64_t last = precision > 0 ? digits : integer;
+            if (rest > half || (rest == half && (last & 1))) digits++;
+            if (digits == scale) {
+                digits = 0;
+                integer++;
+            }
+        }
+        // При q < -96 значение меньше 2^-43 и округляется к нулю
+
+        if (negative) buffer[length++] = '-';
+        const int count = format_digit_count (integer);
+        format_digits (integer, count, buffer + length);
+        length += (size_t) count;
+        if (precision > 0) {
+            buffer[length++] = '.';
+            format_digits (digits, precision, buffer + length);
+            length += (size_t) precision;
+        }
+    }
+
+    return length;
+}
+
+/**
+ * @brief Старшие 64 бита произведения
+ *
+ * @param a Первый множитель
+ * @param b Второй множитель
+ * @return floor(a b / 2^64)
+ */
+static inline uint64_t format_multiply_high (uint64_t a, uint64_t b) {
+    return (uint64_t) (((unsigned __int128) a * b) >> 64);
+}
+
+/**
+ * @brief Округленное с липким битом произведение g cp / 2^127
+ *
+ * @param g1 Старшие 63 бита g
+ * @param g0 Младшие 63 бита g
+ * @param cp Множитель
+ * @return floor(g cp / 2^127), младший бит которого установлен, если
+ *         отброшенная часть ненулевая
+ */
+static inline uint64_t format_round_odd (uint64_t g1, uint64_t g0, uint64_t cp) {
+    const uint64_t x1 = format_multiply_high (g0, cp);
+    const uint64_t y0 = g1 * cp;
+    const uint64_t y1 = format_multiply_high (g1, cp);
+    const uint64_t z  = (y0 >> 1) + x1;
+    const uint64_t vb = y1 + (z >> 63);
+
+    return vb | (((z & FORMAT_MASK_63) + FORMAT_MASK_63) >> 63);
+}
+
+/**
+ * @brief Печатает десятичное число f 10^e в кратчайшем виде
+ *
+ * @param negative Знак
+ * @param f Десятичная мантисса, не ноль
+ * @param e Десятичная степень
+ * @param buffer Буфер
+ * @return Количество записанных символов
+ */
+static size_t format_decimal (int negative, uint64_t f, int e, char* buffer) {
+    size_t length = 0;
+    int    count, exponent;
+
+    while (f % 10 == 0) {
+        f /= 10;
+        e++;
+    }
+    count    = format_digit_count (f);
+    exponent = e + count - 1;   // Степень первой цифры
+
+    if (negative) buffer[length++] = '-';
+
+    if (exponent >= 0 && exponent < 17) {
+        if (count <= exponent + 1) {
+            // Целое: цифры и нули
+            format_digits (f, count, buffer + length);
+            length += (size_t) count;
+            memset (buffer + length, '0', (size_t) (exponent + 1 - count));
+            length += (size_t) (exponent + 1 - count);
+        } else {
+            format_digits (f / format_pow10_u64[count - exponent - 1], exponent + 1,
+                           buffer + length);
+            length += (size_t) exponent + 1;
+            buffer[length++] = '.';
+            format_digits (f, count - exponent - 1, buffer + length);
+            length += (size_t) (count - exponent - 1);
+        }
+    } else if (exponent < 0 && exponent >= -4) {
+        // 0.000ddd
+        buffer[length++] = '0';
+        buffer[length++] = '.';
+        memset (buffer + length, '0', (size_t) (-exponent - 1));
+        length += (size_t) (-exponent - 1);
+        format_digits (f, count, buffer + length);
+        length += (size_t) count;
+    } else {
+        // d.ddde+XX, как в printf ("%e")
+        buffer[length++] = (char) ('0' + f / format_pow10_u64[count - 1]);
+        if (count > 1) {
+            buffer[length++] = '.';
+            format_digits (f, count - 1, buffer + length);
+            length += (size_t) (count - 1);
+        }
+        buffer[length++] = 'e';
+        buffer[length++] = exponent < 0 ? '-' : '+';
+        if (exponent < 0) exponent = -exponent;
+        const int exponent_count = exponent >= 100 ? 3 : 2;
+        format_digits ((uint64_t) exponent, exponent_count, buffer + length);
+        length += (size_t) exponent_count;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Кратчайшая десятичная запись c 2^q (Schubfach)
+ *
+ * @param negative Знак
+ * @param q Двоичная степень
+ * @param c Двоичная мантисса
+ * @param dk Поправка десятичной степени (-1, если c умножено на 10)
+ * @param buffer Буфер
+ * @return Количество записанных символов
+ */
+static size_t format_schubfach (int negative, int q, uint64_t c, int dk,
+                                char* buffer) {
+    const uint64_t out = c & 1;
+    const uint64_t cb  = c << 2;
+    const uint64_t cbr = cb + 2;
+    uint64_t       cbl;
+    int            k;
+
+    // k = floor(log10 (2^q)) или floor(log10 (3/4 2^q)) на границе степеней
+    if (c != FORMAT_C_MIN || q == FORMAT_Q_MIN) {
+        cbl = cb - 2;
+        k   = (int) (((int64_t) q * INT64_C (661971961083)) >> 41);
+    } else {
+        cbl = cb - 1;
+        k   = (int) (((int64_t) q * INT64_C (661971961083) -
+                      INT64_C (274743187321)) >> 41);
+    }
+
+    const int64_t   lk  = -(int64_t) k * INT64_C (913124641741);   // -k log2(10)
+    const int       h   = q + 2 + (int) (lk >> 38);
+    const uint64_t* g   = format_pow10[k - FORMAT_POW10_MIN];
+    const uint64_t  vb  = format_round_odd (g[0], g[1], cb << h);
+    const uint64_t  vbl = format_round_odd (g[0], g[1], cbl << h);
+    const uint64_t  vbr = format_round_odd (g[0], g[1], cbr << h);
+    const uint64_t  s   = vb >> 2;
+    size_t          length = 0;
+
+    if (s >= 100) {
+        // Запись на одну цифру короче: s' = floor(s / 10)
+        const uint64_t inv10 = UINT64_C (115292150460684698) << 4;   // 2^64 / 10
+        const uint64_t sp10  = 10 * format_multiply_high (s, inv10);
+        const uint64_t tp10  = sp10 + 10;
+        const int      upin  = vbl + out <= sp10 << 2;
+        const int      wpin  = (tp10 << 2) + out <= vbr;
+
+        if (upin != wpin)
+            length = format_decimal (negative, upin ? sp10 : tp10, k + dk, buffer);
+    }
+
+    if (length == 0) {
+        const uint64_t t   = s + 1;
+        const int      uin = vbl + out <= s << 2;
+        const int      win = (t << 2) + out <= vbr;
+
+        if (uin != win) {
+            length = format_decimal (negative, uin ? s : t, k + dk, buffer);
+        } else {
+            // Обе записи в интервале: ближайшая к v, при равенстве - четная
+            const int64_t cmp     = (int64_t) (vb - ((s + t) << 1));
+            const int     nearest = cmp < 0 || (cmp == 0 && (s & 1) == 0);
+            length = format_decimal (negative, nearest ? s : t, k + dk, buffer);
+        }
+    }
+
+    return length;
+}
+
+/**
+ * @brief Печатает кратчайшую запись числа
+ *
+ * @param value Число
+ * @param buffer Буфер
+ * @return Количество записанных символов
+ */
+size_t format_shortest (double value, char* buffer) {
+    uint64_t bits;
+    size_t   length = 0;
+
+    memcpy (&bits, &value, sizeof bits);
+
+    const int      negative = (int) (bits >> 63);
+    const int      biased   = (int) (bits >> FORMAT_MANTISSA_BITS) & 0x7FF;
+    const uint64_t fraction = bits & (FORMAT_C_MIN - 1);
+
+    if (biased == 0x7FF) {
+        const char* text = fraction ? "nan" : negative ? "-inf" : "inf";
+        length           = strlen (text);
+        memcpy (buffer, text, length);
+    } else if (biased != 0) {
+        const uint64_t c     = fraction | FORMAT_C_MIN;
+        const int      shift = 1075 - biased;   // v = c 2^-shift
+
+        // Целые числа меньше 2^53 печатаются сразу: короче записи нет
+        if (shift > 0 && shift < 53 && ((c >> shift) << shift) == c)
+            length = format_decimal (negative, c >> shift, 0, buffer);
+        else
+            length = format_schubfach (negative, -shift, c, 0, buffer);
+    } else if (fraction != 0) {
+        // Денормализованные: самые маленькие мантиссы умножаются на 10
+        const int tiny = fraction < 3;
+        length         = format_schubfach (negative, FORMAT_Q_MIN,
+                                           tiny ? 10 * fraction : fraction, -tiny, buffer);
+    } else {
+        length = negative ? 2 : 1;
+        memcpy (buffer, negative ? "-0" : "0", length);
+    }
+
+    return length;
+}
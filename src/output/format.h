@@ -0,0 +1,57 @@
+/**
+ * @file format.h
+ * @brief Быстрое форматирование чисел с плавающей точкой
+ *
+ * @details
+ * Две функции заменяют printf в записи матриц:
+ * - format_fixed печатает число с фиксированным числом знаков после
+ *   точки, побитово как printf ("%.*f") при округлении к ближайшему:
+ *   значение раскладывается на целую часть и двоичную дробь, дробь
+ *   умножается на 10^precision в 128-битной арифметике и округляется к
+ *   четному. Очень большие числа и точность больше FORMAT_FAST_PRECISION
+ *   передаются snprintf
+ * - format_shortest печатает кратчайшую запись, которая читается
+ *   обратно (strtod, parse_double) в то же самое число (алгоритм
+ *   Schubfach, таблица format_pow10.h); из нескольких кратчайших
+ *   выбирается ближайшая к значению
+ *
+ * Обе функции не зависят от локали и не добавляют завершающий ноль.
+ *
+ * @see output.h parse.h
+ */
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stddef.h>
+
+/** Размер буфера, достаточный для любого результата format_fixed */
+#define FORMAT_BUFFER_SIZE 352
+
+/** Наибольшая точность, поддерживаемая format_fixed */
+#define FORMAT_MAX_PRECISION 17
+
+/** Наибольшая точность, для которой format_fixed обходится без snprintf */
+#define FORMAT_FAST_PRECISION 9
+
+/**
+ * @brief Печатает число с фиксированным числом знаков после точки
+ * @param value Число
+ * @param precision Знаков после точки, от 0 до FORMAT_MAX_PRECISION
+ * @param buffer Буфер не меньше FORMAT_BUFFER_SIZE байт
+ * @return Количество записанных символов
+ */
+size_t format_fixed (double value, int precision, char* buffer);
+
+/**
+ * @brief Печатает кратчайшую запись числа, читаемую обратно без потерь
+ * @param value Число
+ * @param buffer Буфер не меньше FORMAT_BUFFER_SIZE байт
+ * @note Результат вида 0.1, 123.25, 1e+300, inf, -inf, nan. Два
+ *       наименьших денормализованных числа печатаются двумя цифрами
+ *       (4.9e-324, 9.9e-324), как в оригинальном Schubfach
+ * @return Количество записанных символов
+ */
+size_t format_shortest (double value, char* buffer);
+
+#endif   // FORMAT_H
@@ -8,14 +8,28 @@
  * - Вывод матрицы в консоль
  * - Сохранение матрицы в файл
  * - Загрузка матрицы из файла
+ * - Отображение в память и запись двоичных файлов
  *
  * @note Все функции включают проверку входных параметров
  */
 
 #include "output.h"
 
+#include "../metrics/metrics.h"
+#include "format.h"
+#include "parse.h"
+
+#include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert (sizeof (OutputBinaryHeader) == OUTPUT_BINARY_HEADER_SIZE,
+                "Заголовок двоичного файла должен занимать 64 байта");
 
 /**
  * @brief Функция для вывода матрицы
@@ -25,15 +39,91 @@
  * @param data Указатель на массив данных
  */
 void output_print_matrix (int rows, int cols, const double* data) {
+    output_print_matrix_strided (rows, cols, cols, data);
+}
+
+/**
+ * @struct OutputWriter
+ * @brief Буферизованная запись текста
+ *
+ * Числа форматируются прямо в буфер (format.h), буфер сбрасывается в
+ * файл одним fwrite, когда в нем не остается места для еще одного числа.
+ */
+typedef struct {
+    FILE*  file;    ///< Файл
+    char*  data;    ///< Буфер на OUTPUT_WRITE_BLOCK байт
+    size_t fill;    ///< Количество байт в буфере
+    int    error;   ///< Ошибка записи
+} OutputWriter;
+
+/**
+ * @brief Сбрасывает буфер в файл
+ *
+ * @param writer Состояние записи
+ */
+static void output_writer_flush (OutputWriter* writer) {
+    if (writer->fill > 0 &&
+        fwrite (writer->data, 1, writer->fill, writer->file) != writer->fill)
+        writer->error = 1;
+    writer->fill = 0;
+}
+
+/**
+ * @brief Пишет элементы матрицы построчно, разделяя их пробелами
+ *
+ * @param file Файл
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах
+ * @param data Указатель на массив данных
+ * @param precision Знаков после точки или OUTPUT_PRECISION_LOSSLESS
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int output_write_elements (FILE* file, int rows, int cols, int stride,
+                                  const double* data, int precision) {
+    OutputWriter writer = {file, malloc (OUTPUT_WRITE_BLOCK), 0, 0};
+
+    if (!writer.data) writer.error = 1;
+
+    for (int index_row = 0; index_row < rows && !writer.error; index_row++) {
+        const double* row = data + (size_t) index_row * stride;
+        for (int index_col = 0; index_col < cols; index_col++) {
+            char* out = NULL;
+            if (writer.fill + FORMAT_BUFFER_SIZE + 2 > OUTPUT_WRITE_BLOCK)
+                output_writer_flush (&writer);
+
+            out = writer.data + writer.fill;
+            writer.fill += precision == OUTPUT_PRECISION_LOSSLESS
+                               ? format_shortest (row[index_col], out)
+                               : format_fixed (row[index_col], precision, out);
+            writer.data[writer.fill++] = ' ';
+        }
+        writer.data[writer.fill++] = '\n';
+    }
+
+    if (writer.data) output_writer_flush (&writer);
+    free (writer.data);
+
+    return writer.error ? -1 : 0;
+}
+
+/**
+ * @brief Функция для вывода матрицы с шагом строки
+ *
+ * @param rows Количество строк
+ * @param cols Количество стоблцов
+ * @param stride Шаг строки в элементах
+ * @param data Указатель на массив данных
+ */
+void output_print_matrix_strided (int rows, int cols, int stride,
+                                  const double* data) {
     if (!data) printf ("Данные матрицы отсутствуют.");
     else {
         printf ("Матрица %dx%d:\n", rows, cols);
-        for (int index_row = 0; index_row < rows; index_row++) {
-            for (int index_col = 0; index_col < cols; index_col++) {
-                printf ("%.2f ", data[index_row * cols + index_col]);
-            }
-            printf ("\n");
-        }
+        if (output_write_elements (stdout, rows, cols, stride, data,
+                                   OUTPUT_DEFAULT_PRECISION) != 0)
+            fprintf (stderr, "Ошибка вывода матрицы.\n");
     }
 }
 
@@ -49,44 +139,82 @@ void output_print_matrix (int rows, int cols, const double* data) {
  */
 int output_save_matrix_to_file (int rows, int cols, const double* data,
                                 const char* filename) {
+    return output_save_matrix_to_file_strided (rows, cols, cols, data, filename);
+}
+
+/**
+ * @brief Функция сохранения матрицы с шагом строки в файл
+ *
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах
+ * @param data Указатель на массив данных
+ * @param filename Указатель на файл для сохранения матрицы
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_matrix_to_file_strided (int rows, int cols, int stride,
+                                        const double* data, const char* filename) {
+    return output_save_matrix_to_file_precision (rows, cols, stride, data, filename,
+                                                 OUTPUT_DEFAULT_PRECISION);
+}
+
+/**
+ * @brief Функция сохранения матрицы в файл с заданной точностью
+ *
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах
+ * @param data Указатель на массив данных
+ * @param filename Указатель на файл для сохранения матрицы
+ * @param precision Знаков после точки или OUTPUT_PRECISION_LOSSLESS
+ *
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_matrix_to_file_precision (int rows, int cols, int stride,
+                                          const double* data, const char* filename,
+                                          int precision) {
     int   result = -1;
     FILE* file   = NULL;
 
-    if (data) {
+    METRICS_BEGIN (timer);
+
+    if (!data) {
+        printf ("Данные матрицы отсутствуют.\n");
+    } else if (precision < OUTPUT_PRECISION_LOSSLESS ||
+               precision > FORMAT_MAX_PRECISION) {
+        fprintf (stderr, "Неверная точность вывода: %d.\n", precision);
+    } else {
         file = fopen (filename, "w");
         if (file) {
             fprintf (file, "%d %d\n", rows, cols);
-            for (int index_row = 0; index_row < rows; index_row++) {
-                for (int index_col = 0; index_col < cols; index_col++) {
-                    fprintf (file, "%.2f ", data[index_row * cols + index_col]);
-                }
-                fprintf (file, "\n");
-            }
-            result = 0;
+            result =
+                output_write_elements (file, rows, cols, stride, data, precision);
         } else {
             fprintf (stderr, "Ошибка открытия файла.\n");
         }
-    } else {
-        printf ("Данные матрицы отсутствуют.\n");
     }
 
-    if (file) fclose (file);
+    METRICS_END (timer, METRICS_FORMAT_TEXT,
+                 result == 0 ? (uint64_t) rows * cols * sizeof (double) : 0,
+                 result == 0 ? (uint64_t) ftell (file) : 0);
+
+    if (file && fclose (file) != 0) result = -1;
 
     return result;
 }
 
 /**
- * @brief Загружает матрицу из файла
+ * @brief Открывает файл матрицы и читает заголовок с размерами
  *
+ * @param filename Указатель на файл с матрицей для чтения
  * @param rows Количество строк
  * @param cols Количество столбцов
- * @param filename Указатель на файл с матрицей для чтения
- * @return NULL при ошибке или указатель на созданную матрицу
+ * @return Открытый файл или NULL при ошибке
  */
-double* output_load_matrix_from_file (int* rows, int* cols, const char* filename) {
-    FILE*   file = NULL;
-    double* data = NULL;
-    int     res  = 1;
+FILE* output_open_matrix_file (const char* filename, int* rows, int* cols) {
+    FILE* file = NULL;
+    int   res  = 1;
 
     file = fopen (filename, "r");
     if (!file) {
@@ -95,26 +223,175 @@ double* output_load_matrix_from_file (int* rows, int* cols, const char* filename
     }
 
     if (res) {
-        if (fscanf (file, "%d %d", rows, cols) != 2) {
+        if (fscanf (file, "%d %d", rows, cols) != 2 || *rows <= 0 || *cols <= 0) {
             fprintf (stderr, "Ошибка чтения размеров матрицы.\n");
             res = 0;
         }
     }
 
+    if (!res && file) {
+        fclose (file);
+        file = NULL;
+    }
+
+    return file;
+}
+
+/**
+ * @struct OutputReader
+ * @brief Блочное чтение текстового файла
+ *
+ * Буфер всегда содержит только целые числа до позиции safe: после нее
+ * может лежать начало числа, продолжение которого еще не прочитано.
+ */
+typedef struct {
+    FILE*  file;    ///< Файл
+    char*  data;    ///< Буфер на OUTPUT_READ_BLOCK байт
+    size_t pos;     ///< Текущая позиция
+    size_t fill;    ///< Количество прочитанных байт в буфере
+    size_t safe;    ///< Граница, до которой числа прочитаны целиком
+    int    eof;     ///< Файл прочитан до конца
+    int    error;   ///< Ошибка чтения файла
+    size_t total;   ///< Всего прочитано байт
+} OutputReader;
+
+/**
+ * @brief Переносит непрочитанный хвост в начало буфера и дочитывает файл
+ *
+ * @param reader Состояние чтения
+ */
+static void output_reader_refill (OutputReader* reader) {
+    memmove (reader->data, reader->data + reader->pos, reader->fill - reader->pos);
+    reader->fill -= reader->pos;
+    reader->pos = 0;
+
+    // Дочитываем, пока в буфере нет ни одного пробела после последнего числа
+    do {
+        const size_t count = fread (reader->data + reader->fill, 1,
+                                    OUTPUT_READ_BLOCK - reader->fill, reader->file);
+        reader->fill += count;
+        reader->total += count;
+        if (count == 0) {
+            reader->eof   = 1;
+            reader->error = ferror (reader->file);
+        }
+
+        reader->safe = reader->fill;
+        if (!reader->eof) {
+            while (reader->safe > 0 &&
+                   !parse_is_space (reader->data[reader->safe - 1]))
+                reader->safe--;
+        }
+    } while (!reader->eof && reader->safe == 0 && reader->fill < OUTPUT_READ_BLOCK);
+}
+
+/**
+ * @brief Пропускает пробелы и возвращает начало следующего числа
+ *
+ * @param reader Состояние чтения
+ * @return Указатель на число или NULL, если файл закончился
+ */
+static const char* output_reader_next (OutputReader* reader) {
+    const char* token = NULL;
+
+    while (!token && !reader->error) {
+        while (reader->pos < reader->safe &&
+               parse_is_space (reader->data[reader->pos]))
+            reader->pos++;
+
+        if (reader->pos < reader->safe) token = reader->data + reader->pos;
+        else if (reader->eof) break;
+        else output_reader_refill (reader);
+
+        // Число длиннее буфера: дочитать его некуда
+        if (!token && !reader->eof && reader->safe == 0) break;
+    }
+
+    return token;
+}
+
+/**
+ * @brief Читает элементы матрицы из открытого файла
+ *
+ * Файл читается блоками по OUTPUT_READ_BLOCK байт, числа разбираются
+ * parse_double прямо в буфере: без стандартного ввода-вывода на каждый
+ * элемент, без зависимости от локали и с тем же результатом, что strtod.
+ *
+ * @param file Файл, позиционированный на первом элементе
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в буфере в элементах
+ * @param data Буфер для элементов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_matrix_elements (FILE* file, int rows, int cols, int stride,
+                                 double* data) {
+    OutputReader reader = {file, NULL, 0, 0, 0, 0, 0, 0};
+    int          res    = 1;
+
+    METRICS_BEGIN (timer);
+
+    if (!file || !data) res = 0;
+    else {
+        reader.data = malloc (OUTPUT_READ_BLOCK);
+        if (!reader.data) res = 0;
+        else METRICS_ALLOCATION ();
+    }
+
+    for (int index_row = 0; index_row < rows && res; index_row++) {
+        double* row = data + (size_t) index_row * stride;
+        for (int index_col = 0; index_col < cols && res; index_col++) {
+            const char* token = output_reader_next (&reader);
+            size_t      count = 0;
+
+            if (token) {
+                count = parse_double (token, reader.data + reader.safe,
+                                      &row[index_col]);
+                reader.pos += count;
+            }
+            if (count == 0) {
+                res = 0;
+                fprintf (stderr, "%s: строка %d, столбец %d.\n",
+                         !token && reader.eof && !reader.error
+                             ? "Недостаточно элементов матрицы"
+                             : "Ошибка чтения элемента матрицы",
+                         index_row + 1, index_col + 1);
+            }
+        }
+    }
+
+    free (reader.data);
+
+    METRICS_END (timer, METRICS_PARSE_TEXT, reader.total,
+                 res ? (uint64_t) rows * cols * sizeof (double) : 0);
+
+    return res ? 0 : -1;
+}
+
+/**
+ * @brief Загружает матрицу из файла
+ *
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param filename Указатель на файл с матрицей для чтения
+ * @return NULL при ошибке или указатель на созданную матрицу
+ */
+double* output_load_matrix_from_file (int* rows, int* cols, const char* filename) {
+    FILE*   file = NULL;
+    double* data = NULL;
+    int     res  = 1;
+
+    file = output_open_matrix_file (filename, rows, cols);
+    if (!file) res = 0;
+
     if (res) {
-        data = (double*) malloc ((*rows) * (*cols) * sizeof (double));
+        data = (double*) malloc ((size_t) (*rows) * (*cols) * sizeof (double));
         if (!data) res = 0;
     }
 
     if (res) {
-        for (int index_row = 0; index_row < *rows && res; index_row++) {
-            for (int index_col = 0; index_col < *cols && res; index_col++) {
-                if (fscanf (file, "%lf", &data[index_row * (*cols) + index_col]) !=
-                    1) {
-                    fprintf (stderr, "Ошибка чтения элементов матрицы.\n");
-                    res = 0;
-                }
-            }
+        if (output_read_matrix_elements (file, *rows, *cols, *cols, data) != 0) {
+            res = 0;
         }
     }
 
@@ -127,3 +404,659 @@ double* output_load_matrix_from_file (int* rows, int* cols, const char* filename
 
     return data;
 }
+
+/**
+ * @brief Проверяет сигнатуру двоичного файла
+ *
+ * @param filename Имя файла
+ * @return 1 для двоичного файла, 0 иначе
+ */
+int output_is_binary_file (const char* filename) {
+    char  magic[sizeof (((OutputBinaryHeader*) 0)->magic)];
+    FILE* file = fopen (filename, "rb");
+    int   res  = 0;
+
+    if (file) {
+        res = fread (magic, 1, sizeof magic, file) == sizeof magic &&
+              memcmp (magic, OUTPUT_BINARY_MAGIC, sizeof magic) == 0;
+        fclose (file);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Переставляет байты полей заголовка
+ *
+ * @param header Заголовок
+ */
+static void output_swap_header (OutputBinaryHeader* header) {
+    header->version      = __builtin_bswap32 (header->version);
+    header->endian       = __builtin_bswap32 (header->endian);
+    header->element_type = __builtin_bswap32 (header->element_type);
+    header->element_size = __builtin_bswap32 (header->element_size);
+    header->rows         = (int64_t) __builtin_bswap64 ((uint64_t) header->rows);
+    header->cols         = (int64_t) __builtin_bswap64 ((uint64_t) header->cols);
+    header->stride       = (int64_t) __builtin_bswap64 ((uint64_t) header->stride);
+    header->data_offset  = __builtin_bswap64 (header->data_offset);
+    header->tile         = __builtin_bswap32 (header->tile);
+}
+
+/**
+ * @brief Размер элемента заданного типа
+ *
+ * @param type Тип элементов
+ * @return Размер в байтах или 0 для неизвестного типа
+ */
+static size_t output_element_size (uint32_t type) {
+    size_t size = 0;
+
+    switch (type) {
+    case OUTPUT_ELEMENT_F64: size = sizeof (double); break;
+    case OUTPUT_ELEMENT_F32: size = sizeof (float); break;
+    case OUTPUT_ELEMENT_I32: size = sizeof (int32_t); break;
+    default: break;
+    }
+
+    return size;
+}
+
+/**
+ * @brief Количество элементов, которое занимают данные файла
+ *
+ * @param header Заголовок с проверенными размерами
+ * @return Элементов от первого до последнего, включая дополнение плиток
+ */
+static uint64_t output_element_count (const OutputBinaryHeader* header) {
+    uint64_t count = 0;
+
+    if (header->tile > 0) {
+        const uint64_t tile = header->tile;
+        count = ((uint64_t) header->rows + tile - 1) / tile *
+                (((uint64_t) header->cols + tile - 1) / tile) * tile * tile;
+    } else {
+        // Последняя строка может быть короче шага
+        count = (uint64_t) (header->rows - 1) * (uint64_t) header->stride +
+                (uint64_t) header->cols;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Проверяет заголовок по размеру файла
+ *
+ * @param header Заголовок в порядке байтов машины
+ * @param size Размер файла
+ * @return 1, если заголовок корректен
+ */
+static int output_header_valid (const OutputBinaryHeader* header, size_t size) {
+    const size_t element = output_element_size (header->element_type);
+    int          valid   = 1;
+
+    if (header->version != OUTPUT_BINARY_VERSION || element == 0 ||
+        header->element_size != element)
+        valid = 0;   // Неизвестная версия или тип элементов
+    else if (header->rows <= 0 || header->cols <= 0 || header->rows > INT_MAX ||
+             header->cols > INT_MAX || header->stride > INT_MAX)
+        valid = 0;   // Размеры не помещаются в Matrix
+    else if (header->tile > 0 ? header->stride != header->tile
+                              : header->stride < header->cols)
+        valid = 0;   // Шаг строки плитки равен ее стороне
+    else if (header->data_offset < OUTPUT_BINARY_HEADER_SIZE ||
+             header->data_offset % element != 0 || header->data_offset > size)
+        valid = 0;   // Данные перекрывают заголовок или выходят за файл
+
+    if (valid) {
+        const uint64_t available = (size - header->data_offset) / element;
+        valid                    = output_element_count (header) <= available;
+    }
+
+    return valid;
+}
+
+/**
+ * @brief Отображает двоичный файл матрицы в память
+ *
+ * @param filename Имя файла
+ * @param file Описание отображения
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_map_binary_file (const char* filename, OutputBinaryFile* file) {
+    struct stat info;
+    int         fd  = -1;
+    int         res = 0;
+
+    METRICS_BEGIN (timer);
+
+    memset (file, 0, sizeof (*file));
+
+    fd = open (filename, O_RDONLY);
+    if (fd < 0 || fstat (fd, &info) != 0) {
+        fprintf (stderr, "Ошибка чтения файла.\n");
+        res = -1;
+    } else if ((size_t) info.st_size < sizeof (OutputBinaryHeader)) {
+        fprintf (stderr, "Ошибка чтения заголовка двоичного файла.\n");
+        res = -1;
+    }
+
+    if (res == 0) {
+        file->size    = (size_t) info.st_size;
+        file->mapping = mmap (NULL, file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                              fd, 0);
+        if (file->mapping == MAP_FAILED) {
+            file->mapping = NULL;
+            fprintf (stderr, "Ошибка отображения файла в память.\n");
+            res = -1;
+        }
+    }
+
+    if (res == 0) {
+        memcpy (&file->header, file->mapping, sizeof (OutputBinaryHeader));
+        if (file->header.endian != OUTPUT_BINARY_ENDIAN)
+            output_swap_header (&file->header);
+
+        if (memcmp (file->header.magic, OUTPUT_BINARY_MAGIC,
+                    sizeof (file->header.magic)) != 0 ||
+            file->header.endian != OUTPUT_BINARY_ENDIAN ||
+            !output_header_valid (&file->header, file->size)) {
+            fprintf (stderr, "Ошибка чтения заголовка двоичного файла.\n");
+            res = -1;
+        } else {
+            file->data   = (const char*) file->mapping + file->header.data_offset;
+            file->swapped = ((const OutputBinaryHeader*) file->mapping)->endian !=
+                            OUTPUT_BINARY_ENDIAN;
+            file->native  = file->header.element_type == OUTPUT_ELEMENT_F64 &&
+                            !file->swapped;
+        }
+    }
+
+    if (fd >= 0) close (fd);   // Отображение остается действительным
+    if (res != 0) output_unmap_binary_file (file);
+
+    METRICS_END (timer, METRICS_MAP_BINARY, res == 0 ? file->size : 0, 0);
+
+    return res;
+}
+
+/**
+ * @brief Снимает отображение двоичного файла
+ *
+ * @param file Описание отображения
+ */
+void output_unmap_binary_file (OutputBinaryFile* file) {
+    if (file && file->mapping) {
+        munmap (file->mapping, file->size);
+        memset (file, 0, sizeof (*file));
+    }
+}
+
+/**
+ * @brief Преобразует подряд идущие элементы файла в double
+ *
+ * @param src Первый элемент в файле
+ * @param count Количество элементов
+ * @param header Заголовок в порядке байтов машины
+ * @param swap 1, если порядок байтов файла отличается
+ * @param dst Буфер для элементов
+ */
+static void output_convert_run (const unsigned char* src, int64_t count,
+                                const OutputBinaryHeader* header, int swap,
+                                double* dst) {
+    for (int64_t col = 0; col < count; col++, src += header->element_size) {
+        if (header->element_type == OUTPUT_ELEMENT_F64) {
+            uint64_t bits;
+            double   value;
+            memcpy (&bits, src, sizeof bits);
+            if (swap) bits = __builtin_bswap64 (bits);
+            memcpy (&value, &bits, sizeof value);
+            dst[col] = value;
+        } else {
+            uint32_t bits;
+            memcpy (&bits, src, sizeof bits);
+            if (swap) bits = __builtin_bswap32 (bits);
+            if (header->element_type == OUTPUT_ELEMENT_F32) {
+                float value;
+                memcpy (&value, &bits, sizeof value);
+                dst[col] = value;
+            } else {
+                dst[col] = (int32_t) bits;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Копирует подряд идущие элементы файла, сохраняя их тип
+ *
+ * @param src Первый элемент в файле
+ * @param count Количество элементов
+ * @param size Размер элемента: 4 или 8 байтов
+ * @param swap 1, если порядок байтов файла отличается
+ * @param dst Буфер для элементов
+ */
+static void output_copy_run (const unsigned char* src, int64_t count, size_t size,
+                             int swap, unsigned char* dst) {
+    memcpy (dst, src, (size_t) count * size);
+    for (int64_t col = 0; swap && col < count; col++, dst += size) {
+        if (size == sizeof (uint64_t)) {
+            uint64_t bits;
+            memcpy (&bits, dst, sizeof bits);
+            bits = __builtin_bswap64 (bits);
+            memcpy (dst, &bits, sizeof bits);
+        } else {
+            uint32_t bits;
+            memcpy (&bits, dst, sizeof bits);
+            bits = __builtin_bswap32 (bits);
+            memcpy (dst, &bits, sizeof bits);
+        }
+    }
+}
+
+/**
+ * @brief Копирует прямоугольный блок отображенного файла в буфер
+ *
+ * Строка блока разбивается на отрезки, лежащие в файле подряд: в
+ * построчном файле это вся строка, в плиточном - часть строки в одной
+ * плитке.
+ *
+ * @param file Описание отображения
+ * @param row Первая строка блока
+ * @param col Первый столбец блока
+ * @param rows Строк в блоке
+ * @param cols Столбцов в блоке
+ * @param stride Шаг строки в буфере в элементах
+ * @param data Буфер для элементов
+ * @param typed 1 - элементы типа файла, 0 - преобразование в double
+ * @return 0 при успехе, -1 при ошибке
+ */
+static int output_read_runs (const OutputBinaryFile* file, int row, int col,
+                             int rows, int cols, int stride, void* data,
+                             int typed) {
+    const OutputBinaryHeader* header = &file->header;
+    const int                 swap   = file->swapped;
+    const size_t  size      = typed ? header->element_size : sizeof (double);
+    const int64_t tile      = header->tile;
+    const int64_t tile_cols = tile > 0 ? (header->cols + tile - 1) / tile : 0;
+    int           res       = 0;
+
+    if (!data || output_element_size (header->element_type) == 0 || row < 0 ||
+        col < 0 || rows < 0 || cols < 0 || row + rows > header->rows ||
+        col + cols > header->cols)
+        res = -1;
+
+    for (int64_t i = row; res == 0 && i < row + rows; i++) {
+        unsigned char* dst = (unsigned char*) data + (size_t) (i - row) * stride *
+                                                         size;
+
+        for (int64_t j = col; j < col + cols;) {
+            int64_t offset = i * header->stride + j;
+            int64_t run    = col + cols - j;
+
+            if (tile > 0) {
+                offset = ((i / tile) * tile_cols + j / tile) * tile * tile +
+                         (i % tile) * tile + j % tile;
+                if (run > tile - j % tile) run = tile - j % tile;
+            }
+
+            const unsigned char* src = (const unsigned char*) file->data +
+                                       (size_t) offset * header->element_size;
+            if (typed || file->native)
+                output_copy_run (src, run, size, swap, dst);
+            else output_convert_run (src, run, header, swap, (double*) dst);
+            dst += (size_t) run * size;
+            j += run;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Копирует прямоугольный блок отображенного файла в буфер double
+ *
+ * @param file Описание отображения
+ * @param row Первая строка блока
+ * @param col Первый столбец блока
+ * @param rows Строк в блоке
+ * @param cols Столбцов в блоке
+ * @param stride Шаг строки в буфере в элементах
+ * @param data Буфер для элементов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_binary_block (const OutputBinaryFile* file, int row, int col,
+                              int rows, int cols, int stride, double* data) {
+    return output_read_runs (file, row, col, rows, cols, stride, data, 0);
+}
+
+/**
+ * @brief Копирует элементы отображенного файла без преобразования типа
+ *
+ * @param file Описание отображения
+ * @param stride Шаг строки в буфере в элементах типа файла
+ * @param data Буфер для элементов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_binary_typed (const OutputBinaryFile* file, int stride,
+                              void* data) {
+    return output_read_runs (file, 0, 0, (int) file->header.rows,
+                             (int) file->header.cols, stride, data, 1);
+}
+
+/**
+ * @brief Копирует элементы отображенного файла в буфер double
+ *
+ * @param file Описание отображения
+ * @param stride Шаг строки в буфере в элементах
+ * @param data Буфер для элементов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_binary_elements (const OutputBinaryFile* file, int stride,
+                                 double* data) {
+    return output_read_binary_block (file, 0, 0, (int) file->header.rows,
+                                     (int) file->header.cols, stride, data);
+}
+
+/**
+ * @brief Сохраняет матрицу в двоичный файл
+ *
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах
+ * @param data Указатель на массив данных
+ * @param filename Имя файла
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_binary_file_strided (int rows, int cols, int stride,
+                                     const double* data, const char* filename) {
+    return output_save_binary_file_typed (rows, cols, stride, data,
+                                          OUTPUT_ELEMENT_F64, filename);
+}
+
+/**
+ * @brief Сохраняет матрицу с элементами заданного типа в двоичный файл
+ *
+ * Файл сразу создается нужного размера (ftruncate) и заполняется через
+ * отображение в память; строки копируются целиком, шаг строки сохраняется.
+ *
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах
+ * @param data Указатель на массив элементов типа type
+ * @param type Тип элементов
+ * @param filename Имя файла
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_binary_file_typed (int rows, int cols, int stride, const void* data,
+                                   OutputElementType type, const char* filename) {
+    const size_t       element = output_element_size (type);
+    OutputBinaryHeader header  = {.version      = OUTPUT_BINARY_VERSION,
+                                  .endian       = OUTPUT_BINARY_ENDIAN,
+                                  .element_type = type,
+                                  .element_size = (uint32_t) element,
+                                  .rows         = rows,
+                                  .cols         = cols,
+                                  .stride       = stride,
+                                  .data_offset  = OUTPUT_BINARY_HEADER_SIZE};
+    size_t size    = 0;
+    void*  mapping = MAP_FAILED;
+    int    fd      = -1;
+    int    res     = 0;
+
+    METRICS_BEGIN (timer);
+
+    if (!data || element == 0 || rows <= 0 || cols <= 0 || stride < cols) {
+        printf ("Данные матрицы отсутствуют.\n");
+        res = -1;
+    }
+
+    if (res == 0) {
+        memcpy (header.magic, OUTPUT_BINARY_MAGIC, sizeof (header.magic));
+        size = OUTPUT_BINARY_HEADER_SIZE +
+               ((size_t) (rows - 1) * stride + cols) * element;
+        fd = open (filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate (fd, (off_t) size) != 0) {
+            fprintf (stderr, "Ошибка открытия файла.\n");
+            res = -1;
+        }
+    }
+
+    if (res == 0) {
+        mapping = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            fprintf (stderr, "Ошибка отображения файла в память.\n");
+            res = -1;
+        }
+    }
+
+    if (res == 0) {
+        memcpy (mapping, &header, sizeof header);
+        // Элементы одним копированием, включая хвосты строк до шага
+        memcpy ((char*) mapping + OUTPUT_BINARY_HEADER_SIZE, data,
+                size - OUTPUT_BINARY_HEADER_SIZE);
+        if (munmap (mapping, size) != 0) res = -1;
+    }
+
+    if (fd >= 0 && close (fd) != 0) res = -1;
+
+    METRICS_END (timer, METRICS_WRITE_BINARY, res == 0 ? size : 0,
+                 res == 0 ? size : 0);
+
+    return res;
+}
+
+/**
+ * @brief Переносит байты между файлом и буфером до конца или ошибки
+ *
+ * @param fd Дескриптор файла
+ * @param buffer Буфер
+ * @param size Количество байтов
+ * @param offset Смещение в файле
+ * @param write 1 - запись (pwrite), 0 - чтение (pread)
+ * @return 0 при успехе, -1 при ошибке или конце файла
+ */
+static int output_transfer (int fd, void* buffer, size_t size, off_t offset,
+                            int write) {
+    char* p   = buffer;
+    int   res = 0;
+
+    // pread и pwrite могут перенести меньше запрошенного
+    while (res == 0 && size > 0) {
+        const ssize_t done = write ? pwrite (fd, p, size, offset)
+                                   : pread (fd, p, size, offset);
+        if (done <= 0) {
+            res = -1;
+        } else {
+            p += done;
+            size -= (size_t) done;
+            offset += done;
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Заполняет число плиток по заголовку
+ *
+ * @param file Описание плиточного файла с заголовком
+ */
+static void output_count_tiles (OutputTiledFile* file) {
+    const int64_t tile = file->header.tile;
+
+    file->tile_rows = (int) ((file->header.rows + tile - 1) / tile);
+    file->tile_cols = (int) ((file->header.cols + tile - 1) / tile);
+}
+
+/**
+ * @brief Создает плиточный файл, заполненный нулями
+ *
+ * @param filename Имя файла
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param tile Сторона плитки
+ * @param file Описание открытого файла
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_create_tiled_file (const char* filename, int rows, int cols, int tile,
+                              OutputTiledFile* file) {
+    int res = 0;
+
+    memset (file, 0, sizeof (*file));
+    file->fd = -1;
+
+    if (rows <= 0 || cols <= 0 || tile <= 0) {
+        fprintf (stderr, "Неверные размеры плиточной матрицы.\n");
+        res = -1;
+    } else {
+        OutputBinaryHeader* header = &file->header;
+        memcpy (header->magic, OUTPUT_BINARY_MAGIC, sizeof (header->magic));
+        header->version      = OUTPUT_BINARY_VERSION;
+        header->endian       = OUTPUT_BINARY_ENDIAN;
+        header->element_type = OUTPUT_ELEMENT_F64;
+        header->element_size = sizeof (double);
+        header->rows         = rows;
+        header->cols         = cols;
+        header->stride       = tile;
+        header->data_offset  = OUTPUT_BINARY_HEADER_SIZE;
+        header->tile         = (uint32_t) tile;
+        output_count_tiles (file);
+
+        const off_t size = (off_t) (OUTPUT_BINARY_HEADER_SIZE +
+                                    output_element_count (header) * sizeof (double));
+        file->fd = open (filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file->fd < 0 || ftruncate (file->fd, size) != 0 ||
+            output_transfer (file->fd, header, sizeof (*header), 0, 1) != 0) {
+            fprintf (stderr, "Ошибка открытия файла.\n");
+            res = -1;
+        }
+    }
+
+    if (res != 0) output_close_tiled_file (file);
+
+    return res;
+}
+
+/**
+ * @brief Открывает плиточный файл для чтения
+ *
+ * @param filename Имя файла
+ * @param file Описание открытого файла
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_open_tiled_file (const char* filename, OutputTiledFile* file) {
+    struct stat info;
+    int         res = 0;
+
+    memset (file, 0, sizeof (*file));
+    file->fd = open (filename, O_RDONLY);
+
+    if (file->fd < 0 || fstat (file->fd, &info) != 0 ||
+        output_transfer (file->fd, &file->header, sizeof (file->header), 0, 0) !=
+            0) {
+        fprintf (stderr, "Ошибка чтения файла.\n");
+        res = -1;
+    } else if (memcmp (file->header.magic, OUTPUT_BINARY_MAGIC,
+                       sizeof (file->header.magic)) != 0 ||
+               file->header.endian != OUTPUT_BINARY_ENDIAN ||
+               !output_header_valid (&file->header, (size_t) info.st_size)) {
+        fprintf (stderr, "Ошибка чтения заголовка двоичного файла.\n");
+        res = -1;
+    } else if (file->header.tile == 0 ||
+               file->header.element_type != OUTPUT_ELEMENT_F64) {
+        fprintf (stderr, "Файл не является плиточным файлом double.\n");
+        res = -1;
+    } else {
+        output_count_tiles (file);
+    }
+
+    if (res != 0) output_close_tiled_file (file);
+
+    return res;
+}
+
+/**
+ * @brief Смещение плитки в файле
+ *
+ * @param file Плиточный файл
+ * @param tile_row Строка плитки
+ * @param tile_col Столбец плитки
+ * @return Смещение первого элемента плитки в байтах
+ */
+static off_t output_tile_offset (const OutputTiledFile* file, int tile_row,
+                                 int tile_col) {
+    const off_t tile = file->header.tile;
+
+    return (off_t) file->header.data_offset +
+           ((off_t) tile_row * file->tile_cols + tile_col) * tile * tile *
+               (off_t) sizeof (double);
+}
+
+/**
+ * @brief Читает плитку
+ *
+ * @param file Открытый плиточный файл
+ * @param tile_row Строка плитки
+ * @param tile_col Столбец плитки
+ * @param data Буфер на tile * tile элементов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_tile (const OutputTiledFile* file, int tile_row, int tile_col,
+                      double* data) {
+    const size_t tile = file->header.tile;
+    int          res  = -1;
+
+    METRICS_BEGIN (timer);
+
+    if (tile_row >= 0 && tile_row < file->tile_rows && tile_col >= 0 &&
+        tile_col < file->tile_cols)
+        res = output_transfer (file->fd, data, tile * tile * sizeof (double),
+                               output_tile_offset (file, tile_row, tile_col), 0);
+
+    METRICS_END (timer, METRICS_READ_TILE,
+                 res == 0 ? tile * tile * sizeof (double) : 0, 0);
+
+    return res;
+}
+
+/**
+ * @brief Записывает плитку
+ *
+ * @param file Плиточный файл, открытый для записи
+ * @param tile_row Строка плитки
+ * @param tile_col Столбец плитки
+ * @param data Элементы плитки
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_write_tile (const OutputTiledFile* file, int tile_row, int tile_col,
+                       const double* data) {
+    const size_t tile = file->header.tile;
+    int          res  = -1;
+
+    METRICS_BEGIN (timer);
+
+    if (tile_row >= 0 && tile_row < file->tile_rows && tile_col >= 0 &&
+        tile_col < file->tile_cols)
+        res = output_transfer (file->fd, (void*) data, tile * tile * sizeof (double),
+                               output_tile_offset (file, tile_row, tile_col), 1);
+
+    METRICS_END (timer, METRICS_WRITE_TILE, 0,
+                 res == 0 ? tile * tile * sizeof (double) : 0);
+
+    return res;
+}
+
+/**
+ * @brief Закрывает плиточный файл
+ *
+ * @param file Открытый плиточный файл
+ * @return 0 при успехе, -1 при ошибке закрытия
+ */
+int output_close_tiled_file (OutputTiledFile* file) {
+    int res = 0;
+
+    if (file && file->fd >= 0 && close (file->fd) != 0) res = -1;
+    if (file) file->fd = -1;
+
+    return res;
+}
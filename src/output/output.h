@@ -8,10 +8,24 @@
  * - Сохранение матрицы в файл
  * - Загрузка матрицы из текстового файла
  *
- * Формат файла:
+ * Текстовый формат файла:
  * Первые два числа - размеры матрицы (rows cols)
  * Затем идут элементы построчно
  *
+ * Двоичный формат файла:
+ * Заголовок OutputBinaryHeader (64 байта), затем строки элементов с шагом
+ * stride. Данные начинаются с выровненного по 64 байтам смещения, поэтому
+ * отображение файла в память (mmap) можно использовать как хранилище
+ * матрицы без копирования. Заголовок и элементы записываются в порядке
+ * байтов машины; поле endian позволяет прочитать файл и на машине с
+ * другим порядком (с копированием).
+ *
+ * Плиточный вариант двоичного формата (tile > 0) хранит матрицу квадратными
+ * плитками tile x tile: плитки идут по строкам плиток, элементы плитки -
+ * подряд по строкам, крайние плитки дополнены нулями до полного размера.
+ * Каждая плитка читается и пишется одной операцией pread/pwrite, что
+ * нужно для умножения матриц, не помещающихся в память (ooc.h).
+ *
  * @note Все функции проверяют корректность входных данных
  *
  * @see matrix.h
@@ -20,6 +34,86 @@
 #ifndef OUTPUT_H
 #define OUTPUT_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Знаков после точки при записи текстового файла по умолчанию */
+#define OUTPUT_DEFAULT_PRECISION 2
+
+/** Точность без потерь: кратчайшая запись, читаемая обратно в то же число */
+#define OUTPUT_PRECISION_LOSSLESS (-1)
+
+/** Размер буфера, которым пишется текстовый файл */
+#define OUTPUT_WRITE_BLOCK (1 << 20)
+
+/** Размер блока, которым читается текстовый файл */
+#define OUTPUT_READ_BLOCK (1 << 20)
+
+/** Сигнатура двоичного файла матрицы */
+#define OUTPUT_BINARY_MAGIC "MTXBIN\r\n"
+
+/** Версия двоичного формата */
+#define OUTPUT_BINARY_VERSION 1
+
+/** Метка порядка байтов: читается как есть только при совпадающем порядке */
+#define OUTPUT_BINARY_ENDIAN 0x01020304u
+
+/** Размер заголовка и смещение данных двоичного файла */
+#define OUTPUT_BINARY_HEADER_SIZE 64
+
+/**
+ * @enum OutputElementType
+ * @brief Тип элементов двоичного файла
+ */
+typedef enum {
+    OUTPUT_ELEMENT_F64 = 1,   ///< double
+    OUTPUT_ELEMENT_F32 = 2,   ///< float
+    OUTPUT_ELEMENT_I32 = 3,   ///< int32_t
+} OutputElementType;
+
+/**
+ * @struct OutputBinaryHeader
+ * @brief Заголовок двоичного файла матрицы
+ */
+typedef struct {
+    char     magic[8];       ///< OUTPUT_BINARY_MAGIC
+    uint32_t version;        ///< OUTPUT_BINARY_VERSION
+    uint32_t endian;         ///< OUTPUT_BINARY_ENDIAN в порядке байтов файла
+    uint32_t element_type;   ///< OutputElementType
+    uint32_t element_size;   ///< Размер элемента в байтах
+    int64_t  rows;           ///< Количество строк
+    int64_t  cols;           ///< Количество столбцов
+    int64_t  stride;         ///< Шаг строки в элементах
+    uint64_t data_offset;    ///< Смещение первого элемента от начала файла
+    uint32_t tile;           ///< Сторона плитки; 0 - строки с шагом stride
+    uint8_t  reserved[4];    ///< Зарезервировано, нули
+} OutputBinaryHeader;
+
+/**
+ * @struct OutputBinaryFile
+ * @brief Двоичный файл матрицы, отображенный в память
+ */
+typedef struct {
+    void*              mapping;   ///< Начало отображения
+    size_t             size;      ///< Размер отображения в байтах
+    OutputBinaryHeader header;    ///< Заголовок в порядке байтов машины
+    int                native;    ///< 1, если элементы - double в порядке машины
+    int                swapped;   ///< 1, если порядок байтов файла другой
+    const void*        data;      ///< Первый элемент
+} OutputBinaryFile;
+
+/**
+ * @struct OutputTiledFile
+ * @brief Открытый плиточный файл double в порядке байтов машины
+ */
+typedef struct {
+    int                fd;          ///< Дескриптор файла
+    OutputBinaryHeader header;      ///< Заголовок
+    int                tile_rows;   ///< Строк плиток
+    int                tile_cols;   ///< Столбцов плиток
+} OutputTiledFile;
+
 /**
  * @brief Выводит матрицу в консоль
  * @param rows Количество строк
@@ -28,6 +122,15 @@
  */
 void output_print_matrix (int rows, int cols, const double* data);
 
+/**
+ * @brief Выводит матрицу с произвольным шагом строки в консоль
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах (не меньше cols)
+ * @param data Указатель на массив
+ */
+void output_print_matrix_strided (int rows, int cols, int stride, const double* data);
+
 /**
  * @brief Сохраняет матрицу в файл
  * @param rows Количество строк
@@ -39,6 +142,36 @@ void output_print_matrix (int rows, int cols, const double* data);
 int output_save_matrix_to_file (int rows, int cols, const double* data,
                                 const char* filename);
 
+/**
+ * @brief Сохраняет матрицу с произвольным шагом строки в файл
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах (не меньше cols)
+ * @param data Указатель на массив
+ * @param filename Указатель на файл для сохранения матрицы
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_matrix_to_file_strided (int rows, int cols, int stride,
+                                        const double* data, const char* filename);
+
+/**
+ * @brief Сохраняет матрицу в файл с заданной точностью
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах (не меньше cols)
+ * @param data Указатель на массив
+ * @param filename Указатель на файл для сохранения матрицы
+ * @param precision Знаков после точки (от 0 до FORMAT_MAX_PRECISION) или
+ *                  OUTPUT_PRECISION_LOSSLESS
+ * @note Числа форматируются в буфер OUTPUT_WRITE_BLOCK и пишутся крупными
+ *       блоками; OUTPUT_PRECISION_LOSSLESS сохраняет кратчайшую запись,
+ *       которая загружается обратно побитово точно
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_matrix_to_file_precision (int rows, int cols, int stride,
+                                          const double* data, const char* filename,
+                                          int precision);
+
 /**
  * @brief Загружает матрицу из файла
  * @param rows Количество строк
@@ -48,4 +181,161 @@ int output_save_matrix_to_file (int rows, int cols, const double* data,
  */
 double* output_load_matrix_from_file (int* rows, int* cols, const char* filename);
 
+/**
+ * @brief Открывает файл матрицы и читает её размеры
+ * @param filename Указатель на файл для чтения матрицы
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @return Открытый файл, позиционированный на первом элементе, или NULL
+ */
+FILE* output_open_matrix_file (const char* filename, int* rows, int* cols);
+
+/**
+ * @brief Читает элементы матрицы из открытого файла в буфер с шагом строки
+ * @param file Файл, открытый output_open_matrix_file
+ * @note Числа разбираются как strtod в локали C (см. parse.h); при ошибке
+ *       сообщается строка и столбец элемента
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в буфере в элементах
+ * @param data Буфер для элементов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_matrix_elements (FILE* file, int rows, int cols, int stride,
+                                 double* data);
+
+/**
+ * @brief Проверяет, является ли файл двоичным файлом матрицы
+ * @param filename Имя файла
+ * @return 1 для двоичного файла, 0 иначе (в том числе если файла нет)
+ */
+int output_is_binary_file (const char* filename);
+
+/**
+ * @brief Отображает двоичный файл матрицы в память и проверяет заголовок
+ * @param filename Имя файла
+ * @param file Описание отображения
+ * @note Отображение копируется при записи (MAP_PRIVATE): изменения
+ *       элементов не попадают в файл
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_map_binary_file (const char* filename, OutputBinaryFile* file);
+
+/**
+ * @brief Снимает отображение двоичного файла
+ * @param file Описание отображения
+ */
+void output_unmap_binary_file (OutputBinaryFile* file);
+
+/**
+ * @brief Копирует элементы отображенного файла в буфер double
+ * @param file Описание отображения
+ * @param stride Шаг строки в буфере в элементах
+ * @param data Буфер для элементов
+ * @note Переставляет байты и преобразует тип, если native = 0
+ * @return 0 при успехе, -1 при неизвестном типе элементов
+ */
+int output_read_binary_elements (const OutputBinaryFile* file, int stride,
+                                 double* data);
+
+/**
+ * @brief Копирует прямоугольный блок отображенного файла в буфер double
+ * @param file Описание отображения (построчное или плиточное)
+ * @param row Первая строка блока
+ * @param col Первый столбец блока
+ * @param rows Строк в блоке
+ * @param cols Столбцов в блоке
+ * @param stride Шаг строки в буфере в элементах
+ * @param data Буфер для элементов
+ * @return 0 при успехе, -1 при ошибке или выходе блока за матрицу
+ */
+int output_read_binary_block (const OutputBinaryFile* file, int row, int col,
+                              int rows, int cols, int stride, double* data);
+
+/**
+ * @brief Копирует элементы отображенного файла без преобразования типа
+ * @param file Описание отображения (построчное или плиточное)
+ * @param stride Шаг строки в буфере в элементах типа файла
+ * @param data Буфер для элементов типа header.element_type
+ * @note Переставляет байты, если swapped = 1
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_binary_typed (const OutputBinaryFile* file, int stride, void* data);
+
+/**
+ * @brief Сохраняет матрицу в двоичный файл через ftruncate и mmap
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах, сохраняется в заголовке
+ * @param data Указатель на массив
+ * @param filename Имя файла
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_binary_file_strided (int rows, int cols, int stride,
+                                     const double* data, const char* filename);
+
+/**
+ * @brief Сохраняет матрицу с элементами заданного типа в двоичный файл
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param stride Шаг строки в элементах, сохраняется в заголовке
+ * @param data Указатель на массив элементов типа type
+ * @param type Тип элементов
+ * @param filename Имя файла
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_save_binary_file_typed (int rows, int cols, int stride, const void* data,
+                                   OutputElementType type, const char* filename);
+
+/**
+ * @brief Создает плиточный файл, заполненный нулями
+ * @param filename Имя файла
+ * @param rows Количество строк
+ * @param cols Количество столбцов
+ * @param tile Сторона плитки
+ * @param file Описание открытого файла
+ * @note Место под элементы выделяется ftruncate без записи
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_create_tiled_file (const char* filename, int rows, int cols, int tile,
+                              OutputTiledFile* file);
+
+/**
+ * @brief Открывает плиточный файл для чтения
+ * @param filename Имя файла
+ * @param file Описание открытого файла
+ * @note Файл должен содержать double в порядке байтов машины
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_open_tiled_file (const char* filename, OutputTiledFile* file);
+
+/**
+ * @brief Читает плитку (tile x tile элементов подряд)
+ * @param file Открытый плиточный файл
+ * @param tile_row Строка плитки
+ * @param tile_col Столбец плитки
+ * @param data Буфер на tile * tile элементов
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_read_tile (const OutputTiledFile* file, int tile_row, int tile_col,
+                      double* data);
+
+/**
+ * @brief Записывает плитку (tile x tile элементов подряд)
+ * @param file Плиточный файл, созданный output_create_tiled_file
+ * @param tile_row Строка плитки
+ * @param tile_col Столбец плитки
+ * @param data Элементы плитки
+ * @return 0 при успехе, -1 при ошибке
+ */
+int output_write_tile (const OutputTiledFile* file, int tile_row, int tile_col,
+                       const double* data);
+
+/**
+ * @brief Закрывает плиточный файл
+ * @param file Открытый плиточный файл
+ * @return 0 при успехе, -1 при ошибке закрытия
+ */
+int output_close_tiled_file (OutputTiledFile* file);
+
 #endif   // OUTPUT_H
@@ -0,0 +1,341 @@
+/**
+ * @file parse.c
+ * @brief Реализация быстрого разбора чисел с плавающей точкой
+ *
+ * @details
+ * Быстрые пути (Клингер, Эйзель-Лемир) дают результат, побитово
+ * совпадающий с strtod при округлении к ближайшему. Любой случай, в
+ * котором их точности может не хватить, передается strtod.
+ *
+ * @see parse.h parse_pow5.h
+ */
+
+#include "parse.h"
+
+#include "parse_pow5.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Наибольшее число значащих цифр, помещающееся в uint64_t */
+#define PARSE_MAX_DIGITS 19
+
+/** Наибольшая степень десяти, точно представимая в double */
+#define PARSE_EXACT_POW10 22
+
+/** Длина числа, копируемого на стек для strtod */
+#define PARSE_FALLBACK_BUFFER 128
+
+/** Точные степени десяти для алгоритма Клингера */
+static const double parse_pow10[PARSE_EXACT_POW10 + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/**
+ * @brief Читает 8 байт как число в порядке little-endian
+ *
+ * @param p Начало байтов
+ * @return Байты p[0..7], p[0] в младшем байте
+ */
+static inline uint64_t parse_load8 (const char* p) {
+    uint64_t v;
+
+    memcpy (&v, p, sizeof v);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64 (v);
+#endif
+
+    return v;
+}
+
+/**
+ * @brief Отмечает байты, не являющиеся десятичными цифрами
+ *
+ * @param v Байты, прочитанные parse_load8
+ * @return Ненулевые байты на месте нецифр; 0, если все 8 байт - цифры
+ * @note Байты после первой нецифры могут быть отмечены ошибочно
+ */
+static inline uint64_t parse_non_digits (uint64_t v) {
+    const uint64_t high = UINT64_C (0xF0F0F0F0F0F0F0F0);
+
+    // Цифра 0x30..0x39 дает 0x33: старшая тетрада 3, и +6 ее не меняет
+    return ((v & high) | (((v + UINT64_C (0x0606060606060606)) & high) >> 4)) ^
+           UINT64_C (0x3333333333333333);
+}
+
+/**
+ * @brief Переводит 8 десятичных цифр в число тремя умножениями
+ *
+ * @param v Байты, прочитанные parse_load8
+ * @return Значение от 0 до 99999999
+ */
+static inline uint64_t parse_eight_digits (uint64_t v) {
+    const uint64_t mask = UINT64_C (0x000000FF000000FF);
+    const uint64_t mul1 = UINT64_C (0x000F424000000064);   // 100 + (10^6 << 32)
+    const uint64_t mul2 = UINT64_C (0x0000271000000001);   // 1 + (10^4 << 32)
+
+    v -= UINT64_C (0x3030303030303030);
+    v = v * 10 + (v >> 8);   // Пары цифр
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+
+    return v & UINT32_MAX;
+}
+
+/**
+ * @brief Накапливает цифры в мантиссу
+ *
+ * Пока до конца данных не меньше 8 байт, цифры обрабатываются по 8 без
+ * цикла по символам: длина серии цифр - номер первой отмеченной нецифры,
+ * недостающие старшие позиции заполняются нулями.
+ *
+ * @param p Начало цифр
+ * @param end Конец данных
+ * @param w Мантисса
+ * @return Указатель на первый символ после цифр
+ */
+static inline const char* parse_digits (const char* p, const char* end,
+                                        uint64_t* w) {
+    static const uint64_t scale[8] = {1,     10,     100,     1000,
+                                      10000, 100000, 1000000, 10000000};
+    uint64_t              v        = *w;
+    int                   done     = 0;
+
+    while (!done && end - p >= 8) {
+        const uint64_t bytes = parse_load8 (p);
+        const uint64_t marks = parse_non_digits (bytes);
+
+        if (marks == 0) {
+            v = v * 100000000 + parse_eight_digits (bytes);
+            p += 8;
+        } else {
+            const int length = __builtin_ctzll (marks) >> 3;
+            if (length > 0) {
+                const uint64_t zeros   = UINT64_C (0x3030303030303030) >> (8 * length);
+                const uint64_t shifted = bytes << (64 - 8 * length) | zeros;
+                v = v * scale[length] + parse_eight_digits (shifted);
+                p += length;
+            }
+            done = 1;
+        }
+    }
+    while (!done && p < end && (unsigned) (*p - '0') < 10)
+        v = 10 * v + (uint64_t) (*p++ - '0');
+    *w = v;
+
+    return p;
+}
+
+/**
+ * @brief Собирает double из знака, смещенной степени и мантиссы
+ *
+ * @param negative Знак
+ * @param power2 Смещенная двоичная степень
+ * @param mantissa Мантисса без скрытой единицы
+ * @return Число
+ */
+static double parse_make_double (int negative, uint64_t power2, uint64_t mantissa) {
+    const uint64_t bits = (uint64_t) negative << 63 | power2 << 52 | mantissa;
+    double         value;
+
+    memcpy (&value, &bits, sizeof value);
+
+    return value;
+}
+
+/**
+ * @brief Алгоритм Эйзеля-Лемира: w * 10^q с правильным округлением
+ *
+ * @param w Ненулевая десятичная мантисса
+ * @param q Десятичная степень
+ * @param negative Знак
+ * @param value Результат
+ * @return 1 при успехе, 0 если точности приближения не хватает
+ */
+static int parse_eisel_lemire (uint64_t w, int64_t q, int negative, double* value) {
+    int res = 1;
+
+    if (q < PARSE_POW5_MIN) {
+        *value = parse_make_double (negative, 0, 0);
+    } else if (q > PARSE_POW5_MAX) {
+        *value = parse_make_double (negative, 0x7FF, 0);
+    } else {
+        const uint64_t* pow5 = parse_pow5[q - PARSE_POW5_MIN];
+        const int       lz   = __builtin_clzll (w);
+        const uint64_t  mask = UINT64_MAX >> 55;   // 52 бита мантиссы + 3
+        unsigned __int128 product;
+        uint64_t          high, low;
+
+        w <<= lz;
+        product = (unsigned __int128) w * pow5[0];
+        high    = (uint64_t) (product >> 64);
+        low     = (uint64_t) product;
+
+        // Младшие биты неоднозначны: уточняем вторым словом 5^q
+        if ((high & mask) == mask) {
+            const uint64_t second =
+                (uint64_t) (((unsigned __int128) w * pow5[1]) >> 64);
+            low += second;
+            if (second > low) high++;
+        }
+
+        // Вне этих степеней приближение 5^q неточно
+        if (low == UINT64_MAX && (q < -27 || q > 55)) res = 0;
+
+        if (res) {
+            const int upper    = (int) (high >> 63);
+            uint64_t  mantissa = high >> (upper + 9);
+            int64_t   power2 =
+                (((152170 + 65536) * q) >> 16) + 63 + upper - lz + 1023;
+
+            if (power2 <= 0) {
+                // Денормализованное число или ноль
+                if (-power2 + 1 >= 64) mantissa = 0;
+                else {
+                    mantissa >>= -power2 + 1;
+                    mantissa += mantissa & 1;
+                    mantissa >>= 1;
+                }
+                power2 = mantissa < (UINT64_C (1) << 52) ? 0 : 1;
+                *value = parse_make_double (negative, (uint64_t) power2,
+                                            mantissa & ((UINT64_C (1) << 52) - 1));
+            } else {
+                // Ровно посередине: округление к четному
+                if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+                    (mantissa << (upper + 9)) == high)
+                    mantissa &= ~UINT64_C (1);
+
+                mantissa += mantissa & 1;
+                mantissa >>= 1;
+                if (mantissa >= (UINT64_C (2) << 52)) {
+                    mantissa = UINT64_C (1) << 52;
+                    power2++;
+                }
+                mantissa &= ~(UINT64_C (1) << 52);
+
+                if (power2 >= 0x7FF) {
+                    power2   = 0x7FF;   // Переполнение: бесконечность
+                    mantissa = 0;
+                }
+                *value = parse_make_double (negative, (uint64_t) power2, mantissa);
+            }
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Разбирает число с помощью strtod
+ *
+ * @param begin Начало числа
+ * @param end Конец данных
+ * @param value Результат
+ * @return Количество символов числа или 0, если strtod разобрал не все число
+ */
+static size_t parse_fallback (const char* begin, const char* end, double* value) {
+    char        stack[PARSE_FALLBACK_BUFFER];
+    char*       copy   = stack;
+    char*       stop   = NULL;
+    const char* token  = begin;
+    size_t      length = 0;
+
+    while (token < end && !parse_is_space (*token)) token++;
+    length = (size_t) (token - begin);
+
+    // strtod требует завершающего нуля
+    if (length >= sizeof stack) copy = malloc (length + 1);
+    if (copy && length > 0) {
+        memcpy (copy, begin, length);
+        copy[length] = '\0';
+        *value       = strtod (copy, &stop);
+        if (stop != copy + length) length = 0;
+    } else {
+        length = 0;
+    }
+
+    if (copy != stack) free (copy);
+
+    return length;
+}
+
+/**
+ * @brief Разбирает число с плавающей точкой
+ *
+ * @param begin Начало числа
+ * @param end Конец данных
+ * @param value Результат
+ * @return Количество разобранных символов или 0 при ошибке
+ */
+size_t parse_double (const char* begin, const char* end, double* value) {
+    const char* p        = begin;
+    const char* digits   = NULL;
+    uint64_t    w        = 0;
+    int64_t     q        = 0;
+    int64_t     exponent = 0;
+    size_t      count    = 0;
+    int         negative = 0;
+    int         fast     = 1;   // Можно обойтись без strtod
+
+    if (p < end) {
+        negative = *p == '-';
+        p += negative | (*p == '+');
+    }
+
+    // Целая и дробная части в одну мантиссу
+    digits = p;
+    p      = parse_digits (p, end, &w);
+    count  = (size_t) (p - digits);
+    if (p < end && *p == '.') {
+        const char* fraction = ++p;
+        p                    = parse_digits (p, end, &w);
+        q                    = -(int64_t) (p - fraction);
+        count += (size_t) (p - fraction);
+    }
+    if (count == 0) fast = 0;   // inf, nan или не число
+
+    if (fast && p < end && (*p == 'e' || *p == 'E')) {
+        const char* mark     = p++;
+        int         exp_sign = 0;
+
+        if (p < end && (*p == '-' || *p == '+')) exp_sign = *p++ == '-';
+        if (p < end && (unsigned) (*p - '0') < 10) {
+            while (p < end && (unsigned) (*p - '0') < 10) {
+                if (exponent < 100000) exponent = 10 * exponent + (*p - '0');
+                p++;
+            }
+            q += exp_sign ? -exponent : exponent;
+        } else {
+            p = mark;   // "1e" или "1e+": пусть решает strtod
+        }
+    }
+
+    // Число должно заканчиваться пробелом; иначе это hex, inf или ошибка
+    if (fast && p < end && !parse_is_space (*p)) fast = 0;
+
+    // Ведущие нули не занимают места в мантиссе
+    if (fast && count > PARSE_MAX_DIGITS) {
+        const char* s = digits;
+        while (s < p && (*s == '0' || *s == '.')) {
+            if (*s == '0') count--;
+            s++;
+        }
+        if (count > PARSE_MAX_DIGITS) fast = 0;
+    }
+
+    if (fast) {
+        if (w == 0) {
+            *value = negative ? -0.0 : 0.0;
+        } else if (w <= (UINT64_C (1) << 53) && q >= -PARSE_EXACT_POW10 &&
+                   q <= PARSE_EXACT_POW10) {
+            // Оба множителя точны, одна операция округляется правильно
+            double d = (double) w;
+            d        = q < 0 ? d / parse_pow10[-q] : d * parse_pow10[q];
+            *value   = negative ? -d : d;
+        } else {
+            fast = parse_eisel_lemire (w, q, negative, value);
+        }
+    }
+
+    return fast ? (size_t) (p - begin) : parse_fallback (begin, end, value);
+}
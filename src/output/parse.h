@@ -0,0 +1,47 @@
+/**
+ * @file parse.h
+ * @brief Быстрый разбор десятичных чисел с плавающей точкой
+ *
+ * @details
+ * parse_double разбирает число в том же синтаксисе, что и strtod, и
+ * возвращает побитово тот же результат, но не зависит от локали, не
+ * требует завершающего нуля и работает в несколько раз быстрее:
+ * - до 19 значащих цифр мантисса накапливается в uint64_t
+ * - если мантисса и степень десяти точно представимы в double
+ *   (мантисса не больше 2^53, |степень| не больше 22), результат -
+ *   одно умножение или деление, округляемое аппаратно (алгоритм Клингера)
+ * - иначе используется алгоритм Эйзеля-Лемира: произведение мантиссы на
+ *   128-битное приближение 5^q (таблица parse_pow5.h) дает правильно
+ *   округленный результат почти всегда и сообщает, когда точности не
+ *   хватает
+ * - редкие оставшиеся случаи (больше 19 значащих цифр, неоднозначное
+ *   округление, inf, nan, шестнадцатеричная запись) передаются strtod
+ *
+ * @see output.h
+ */
+
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stddef.h>
+
+/**
+ * @brief Проверяет, является ли символ пробельным (как isspace в локали C)
+ * @param c Символ
+ * @return Ненулевое значение для пробела, табуляции и перевода строки
+ */
+static inline int parse_is_space (char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * @brief Разбирает число с плавающей точкой
+ * @param begin Начало числа (без ведущих пробелов)
+ * @param end Конец доступных данных
+ * @param value Результат
+ * @note Число должно заканчиваться пробельным символом или концом данных
+ * @return Количество разобранных символов или 0, если число некорректно
+ */
+size_t parse_double (const char* begin, const char* end, double* value);
+
+#endif   // PARSE_H
@@ -0,0 +1,255 @@
+/**
+ * @file thread_pool.c
+ * @brief Реализация постоянного пула потоков
+ *
+ * @details
+ * Рабочие потоки ждут на условной переменной увеличения номера поколения.
+ * Каждый вызов thread_pool_run публикует новое поколение с описанием
+ * цикла, будит рабочих и сам выполняет задачи; задачи разбираются через
+ * атомарный счетчик. Вызов завершается, когда все рабочие отчитались о
+ * выходе из цикла.
+ *
+ * @see thread_pool.h
+ */
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @struct ThreadPool
+ * @brief Состояние пула
+ */
+typedef struct {
+    pthread_mutex_t     lock;       ///< Защищает поля ниже
+    pthread_cond_t      wake;       ///< Сигнал о новом поколении
+    pthread_cond_t      done;       ///< Сигнал о завершении рабочих
+    pthread_mutex_t     run_lock;   ///< Один параллельный цикл одновременно
+    pthread_t           workers[THREAD_POOL_MAX_THREADS];
+    unsigned long       spawned_at[THREAD_POOL_MAX_THREADS];   ///< Поколение запуска
+    atomic_int          threads;      ///< Потоков всего, 0 - не настроен
+    int                 started;      ///< Запущенных рабочих потоков
+    int                 shutdown;     ///< Флаг остановки рабочих
+    unsigned long       generation;   ///< Номер текущего цикла
+    thread_pool_task_fn fn;           ///< Задача текущего цикла
+    void*               arg;          ///< Аргумент текущего цикла
+    int                 count;        ///< Число задач текущего цикла
+    atomic_int          next;         ///< Следующая свободная задача
+    int                 active;       ///< Рабочие, не завершившие цикл
+} ThreadPool;
+
+static ThreadPool pool = {
+    .lock     = PTHREAD_MUTEX_INITIALIZER,
+    .wake     = PTHREAD_COND_INITIALIZER,
+    .done     = PTHREAD_COND_INITIALIZER,
+    .run_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static pthread_once_t exit_once = PTHREAD_ONCE_INIT;
+
+static _Thread_local int inside_pool = 0;   // Поток выполняет задачу пула
+
+/**
+ * @brief Число потоков по умолчанию
+ *
+ * @return Значение MATRIX_THREADS или число процессоров
+ */
+static int thread_pool_default_threads (void) {
+    const char* env     = getenv (THREAD_POOL_ENV_VAR);
+    long        threads = 0;
+
+    if (env && *env) threads = strtol (env, NULL, 10);
+    if (threads <= 0) threads = sysconf (_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    if (threads > THREAD_POOL_MAX_THREADS) threads = THREAD_POOL_MAX_THREADS;
+
+    return (int) threads;
+}
+
+/**
+ * @brief Разбирает задачи текущего цикла
+ *
+ * @param worker Номер потока
+ */
+static void thread_pool_work (int worker) {
+    int task;
+
+    inside_pool = 1;
+    while ((task = atomic_fetch_add (&pool.next, 1)) < pool.count) {
+        pool.fn (pool.arg, task, worker);
+    }
+    inside_pool = 0;
+}
+
+/**
+ * @brief Главный цикл рабочего потока
+ *
+ * @param arg Номер потока, упакованный в указатель
+ * @return NULL
+ */
+static void* thread_pool_worker (void* arg) {
+    const int     worker = (int) (size_t) arg;
+    unsigned long seen   = 0;
+
+    pthread_mutex_lock (&pool.lock);
+    seen = pool.spawned_at[worker - 1];   // Не пропустить цикл, ради которого запущен
+    while (1) {
+        while (!pool.shutdown && pool.generation == seen) {
+            pthread_cond_wait (&pool.wake, &pool.lock);
+        }
+        if (pool.shutdown) break;
+        seen = pool.generation;
+        pthread_mutex_unlock (&pool.lock);
+
+        thread_pool_work (worker);
+
+        pthread_mutex_lock (&pool.lock);
+        if (--pool.active == 0) pthread_cond_signal (&pool.done);
+    }
+    pthread_mutex_unlock (&pool.lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Останавливает и присоединяет рабочие потоки
+ *
+ * @note Вызывается под run_lock
+ */
+static void thread_pool_stop_workers (void) {
+    pthread_mutex_lock (&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast (&pool.wake);
+    pthread_mutex_unlock (&pool.lock);
+
+    for (int i = 0; i < pool.started; i++) pthread_join (pool.workers[i], NULL);
+
+    pool.started  = 0;
+    pool.shutdown = 0;
+}
+
+/**
+ * @brief Запускает недостающие рабочие потоки
+ *
+ * @note Вызывается под run_lock. Если поток создать не удалось, пул
+ * продолжает работу с меньшим числом потоков.
+ */
+static void thread_pool_start_workers (void) {
+    const int threads = thread_pool_threads ();
+
+    while (pool.started < threads - 1) {
+        pool.spawned_at[pool.started] = pool.generation;
+        if (pthread_create (&pool.workers[pool.started], NULL, thread_pool_worker,
+                            (void*) (size_t) (pool.started + 1)) != 0)
+            break;
+        pool.started++;
+    }
+}
+
+/**
+ * @brief Регистрирует остановку пула при выходе из программы
+ */
+static void thread_pool_register_exit (void) {
+    atexit (thread_pool_shutdown);
+}
+
+/**
+ * @brief Выполняет задачи 0..count-1 на пуле
+ *
+ * @param count Количество задач
+ * @param fn Функция задачи
+ * @param arg Общий аргумент
+ * @return 0 при успехе, -1 при ошибке аргументов
+ */
+int thread_pool_run (int count, thread_pool_task_fn fn, void* arg) {
+    int res    = 0;
+    int serial = 1;   // Выполнить в вызывающем потоке
+
+    if (count < 0 || fn == NULL) res = -1;
+
+    if (res == 0 && count > 1 && !inside_pool &&
+        pthread_mutex_trylock (&pool.run_lock) == 0) {
+        pthread_once (&exit_once, thread_pool_register_exit);
+        thread_pool_start_workers ();
+        if (pool.started > 0) {
+            serial = 0;
+
+            pthread_mutex_lock (&pool.lock);
+            pool.fn     = fn;
+            pool.arg    = arg;
+            pool.count  = count;
+            pool.active = pool.started;
+            atomic_store (&pool.next, 0);
+            pool.generation++;
+            pthread_cond_broadcast (&pool.wake);
+            pthread_mutex_unlock (&pool.lock);
+
+            thread_pool_work (0);
+
+            pthread_mutex_lock (&pool.lock);
+            while (pool.active > 0) pthread_cond_wait (&pool.done, &pool.lock);
+            pthread_mutex_unlock (&pool.lock);
+        }
+        pthread_mutex_unlock (&pool.run_lock);
+    }
+
+    if (res == 0 && serial) {
+        for (int task = 0; task < count; task++) fn (arg, task, 0);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Задает число потоков пула
+ *
+ * @param threads Число потоков; 0 - значение по умолчанию
+ * @return 0 при успехе, -1 при ошибке
+ */
+int thread_pool_set_threads (int threads) {
+    int res = 0;
+
+    if (threads < 0 || threads > THREAD_POOL_MAX_THREADS || inside_pool) res = -1;
+    else {
+        pthread_mutex_lock (&pool.run_lock);
+        thread_pool_stop_workers ();
+        atomic_store (&pool.threads,
+                      threads > 0 ? threads : thread_pool_default_threads ());
+        pthread_mutex_unlock (&pool.run_lock);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Возвращает число потоков пула
+ *
+ * Внутри задачи пула возвращает 1: вложенные циклы выполняются
+ * последовательно.
+ *
+ * @return Число потоков
+ */
+int thread_pool_threads (void) {
+    int threads = atomic_load (&pool.threads);
+
+    if (threads == 0) {
+        int expected = 0;
+        threads      = thread_pool_default_threads ();
+        if (!atomic_compare_exchange_strong (&pool.threads, &expected, threads))
+            threads = expected;
+    }
+
+    return inside_pool ? 1 : threads;
+}
+
+/**
+ * @brief Останавливает рабочие потоки
+ */
+void thread_pool_shutdown (void) {
+    pthread_mutex_lock (&pool.run_lock);
+    thread_pool_stop_workers ();
+    pthread_mutex_unlock (&pool.run_lock);
+}
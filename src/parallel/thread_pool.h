@@ -0,0 +1,67 @@
+/**
+ * @file thread_pool.h
+ * @brief Постоянный пул потоков для параллельных матричных операций
+ *
+ * @details
+ * Пул создается при первом использовании и переиспользуется всеми
+ * последующими вызовами. Основная операция - параллельный цикл
+ * thread_pool_run: задачи с номерами 0..count-1 раздаются потокам через
+ * атомарный счетчик, вызывающий поток участвует в работе наравне с
+ * рабочими.
+ *
+ * Число потоков задается функцией thread_pool_set_threads или переменной
+ * окружения MATRIX_THREADS; по умолчанию равно числу процессоров.
+ *
+ * Вложенный вызов thread_pool_run из задачи, а также вызов во время
+ * работы пула из другого потока выполняются последовательно в вызывающем
+ * потоке, поэтому взаимная блокировка невозможна.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/** Имя переменной окружения с числом потоков */
+#define THREAD_POOL_ENV_VAR "MATRIX_THREADS"
+
+/** Максимальное число потоков пула */
+#define THREAD_POOL_MAX_THREADS 256
+
+/**
+ * @brief Задача параллельного цикла
+ * @param arg Общий аргумент
+ * @param task Номер задачи (0..count-1)
+ * @param worker Номер потока (0..thread_pool_threads()-1), 0 - вызывающий
+ */
+typedef void (*thread_pool_task_fn) (void* arg, int task, int worker);
+
+/**
+ * @brief Выполняет задачи 0..count-1 на пуле и ждет их завершения
+ * @param count Количество задач
+ * @param fn Функция задачи
+ * @param arg Общий аргумент
+ * @return 0 при успехе, -1 при ошибке аргументов
+ */
+int thread_pool_run (int count, thread_pool_task_fn fn, void* arg);
+
+/**
+ * @brief Задает число потоков пула (включая вызывающий)
+ * @param threads Число потоков; 0 - значение по умолчанию
+ * @note Уже запущенные рабочие потоки завершаются и создаются заново
+ * @return 0 при успехе, -1 при ошибке
+ */
+int thread_pool_set_threads (int threads);
+
+/**
+ * @brief Возвращает число потоков пула (включая вызывающий)
+ * @note Внутри задачи пула возвращает 1
+ * @return Число потоков
+ */
+int thread_pool_threads (void);
+
+/**
+ * @brief Останавливает рабочие потоки
+ * @note Вызывается автоматически при завершении программы
+ */
+void thread_pool_shutdown (void);
+
+#endif   // THREAD_POOL_H
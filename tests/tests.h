@@ -7,9 +7,17 @@
 #ifndef TESTS_H
 #define TESTS_H
 
+#include "matrix/matrix.h"
+
 #include <CUnit/CUnit.h>
+#include <stdint.h>
 #include <sys/stat.h>
 
+// Общие вспомогательные функции (tests_util.c)
+void     fill_random (Matrix* m, unsigned seed);
+uint64_t next_random (uint64_t* state);
+void     remove_cache (const char* directory);
+
 // Прототипы тестовых функций
 void test_create_and_free_matrix (void);
 void test_matrix_addition (void);
@@ -23,5 +31,22 @@ void test_file_operations_integration (void);
 // Функции регистрации тестов
 void register_matrix_tests (void);
 void register_output_tests (void);
+void register_gemm_tests (void);
+void register_simd_tests (void);
+void register_thread_pool_tests (void);
+void register_strassen_tests (void);
+void register_expr_tests (void);
+void register_parse_tests (void);
+void register_format_tests (void);
+void register_ooc_tests (void);
+void register_arena_tests (void);
+void register_metrics_tests (void);
+void register_sparse_tests (void);
+void register_batch_tests (void);
+void register_small_tests (void);
+void register_typed_tests (void);
+void register_loader_tests (void);
+void register_jobs_tests (void);
+void register_cache_tests (void);
 
 #endif
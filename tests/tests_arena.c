@@ -0,0 +1,158 @@
+/**
+ * @file tests_arena.c
+ *
+ * @brief Модуль реализации тестов для arena.c
+ */
+
+#include "matrix/arena.h"
+#include "matrix/matrix.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_arena_alloc (void) {
+    MatrixArena* arena = arena_create (1024);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (arena);
+    CU_ASSERT_EQUAL (arena_capacity (arena), 1024);
+    CU_ASSERT_EQUAL (arena_heap_allocations (arena), 1);
+
+    // Блоки выровнены и не пересекаются
+    char* a = arena_alloc (arena, 1);
+    char* b = arena_alloc (arena, 100);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (a);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (b);
+    CU_ASSERT_EQUAL ((uintptr_t) a % MATRIX_ALIGNMENT, 0);
+    CU_ASSERT_EQUAL ((uintptr_t) b % MATRIX_ALIGNMENT, 0);
+    CU_ASSERT_TRUE (b >= a + MATRIX_ALIGNMENT);
+    CU_ASSERT_EQUAL (arena_high_water (arena), 3 * MATRIX_ALIGNMENT);
+
+    // Позиция: блоки после неё переиспользуются
+    ArenaMark mark = arena_mark (arena);
+    char*     c    = arena_alloc (arena, 200);
+    arena_reset (arena, mark);
+    CU_ASSERT_PTR_EQUAL (arena_alloc (arena, 200), c);
+
+    // Блок больше куска выделяет новый кусок, не меньше блока
+    char* big = arena_alloc (arena, 5000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (big);
+    memset (big, 1, 5000);
+    CU_ASSERT_EQUAL (arena_heap_allocations (arena), 2);
+    CU_ASSERT_TRUE (arena_capacity (arena) >= 1024 + 5000);
+    CU_ASSERT_EQUAL (arena_high_water (arena), 7 * MATRIX_ALIGNMENT + 5056);
+
+    // После полного сброса тот же объем помещается без кучи
+    arena_reset (arena, (ArenaMark) {NULL, 0, 0});
+    for (int i = 0; i < 3; i++) {
+        CU_ASSERT_PTR_NOT_NULL (arena_alloc (arena, 900));
+        CU_ASSERT_PTR_NOT_NULL (arena_alloc (arena, 4000));
+        arena_reset (arena, (ArenaMark) {NULL, 0, 0});
+    }
+    CU_ASSERT_EQUAL (arena_heap_allocations (arena), 2);
+
+    arena_destroy (arena);
+    arena_destroy (NULL);
+}
+
+void test_arena_matrix (void) {
+    MatrixArena* arena = arena_create (0);
+    ArenaMark    mark  = arena_mark (arena);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (arena);
+    Matrix m = create_matrix_arena (37, 21, arena);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (m.data);
+    CU_ASSERT_PTR_EQUAL (m.arena, arena);
+    CU_ASSERT_EQUAL ((uintptr_t) m.block % MATRIX_ALIGNMENT, 0);
+    CU_ASSERT_PTR_EQUAL (m.data[36], m.block + (size_t) 36 * m.stride);
+    m.data[36][20] = 5;
+
+    // free_matrix не освобождает память арены, её возвращает arena_reset
+    free_matrix (&m);
+    CU_ASSERT_PTR_NULL (m.data);
+    arena_reset (arena, mark);
+    Matrix again = create_matrix_arena (37, 21, arena);
+    CU_ASSERT_PTR_NOT_NULL (again.data);
+    CU_ASSERT_EQUAL (arena_heap_allocations (arena), 1);
+
+    Matrix heap = create_matrix_arena (3, 3, NULL);
+    CU_ASSERT_PTR_NOT_NULL (heap.data);
+    CU_ASSERT_PTR_NULL (heap.arena);
+    free_matrix (&heap);
+
+    arena_destroy (arena);
+}
+
+void test_arena_repeated_evaluation (void) {
+    const int    n     = 200;   // Больше порога параллельного умножения
+    MatrixArena* arena = arena_create (4096);   // Растет при первом вычислении
+    Matrix       a     = create_matrix (n, n);
+    Matrix       b     = create_matrix (n, n);
+    Matrix       c     = create_matrix (n, n);
+    Matrix       d     = create_matrix (n, n);
+    Matrix       got   = create_matrix (n, n);
+    Matrix       want  = create_matrix (n, n);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (arena);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (want.data);
+    fill_random (&a, 1);
+    fill_random (&b, 2);
+    fill_random (&c, 3);
+    fill_random (&d, 4);
+
+    // Прогрев выделяет куски, повторные вычисления обходятся без кучи
+    CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&a, &b, &c, &d, &want), 0);
+    CU_ASSERT_EQUAL (
+        multiply_add_subtract_transposed_arena (&a, &b, &c, &d, &got, arena), 0);
+    const size_t warm = arena_heap_allocations (arena);
+    const size_t peak = arena_high_water (arena);
+    CU_ASSERT_TRUE (warm > 1);
+    CU_ASSERT_TRUE (peak > 4096);
+
+    int mismatches = 0;
+    for (int round = 0; round < 3; round++) {
+        CU_ASSERT_EQUAL (
+            multiply_add_subtract_transposed_arena (&a, &b, &c, &d, &got, arena), 0);
+        CU_ASSERT_EQUAL (multiply_matrices_arena (&a, &b, &got, arena), 0);
+        CU_ASSERT_EQUAL (
+            multiply_add_subtract_transposed_arena (&a, &b, &c, &d, &got, arena), 0);
+        for (int i = 0; i < n; i++) {
+            mismatches +=
+                memcmp (got.data[i], want.data[i], n * sizeof (double)) != 0;
+        }
+    }
+    CU_ASSERT_EQUAL (mismatches, 0);
+    CU_ASSERT_EQUAL (arena_heap_allocations (arena), warm);
+    CU_ASSERT_EQUAL (arena_high_water (arena), peak);
+
+    // Определитель с рабочей копией в арене совпадает с обычным
+    double det = determinant (&a);
+    CU_ASSERT_EQUAL (determinant_arena (&a, arena), det);
+    int    sign = 0, arena_sign = 0;
+    double log_det = log_determinant (&a, &sign);
+    CU_ASSERT_EQUAL (log_determinant_arena (&a, &arena_sign, arena), log_det);
+    CU_ASSERT_EQUAL (arena_sign, sign);
+    CU_ASSERT_TRUE (isfinite (log_det));
+
+    const size_t lu_warm = arena_heap_allocations (arena);
+    CU_ASSERT_EQUAL (determinant_arena (&a, arena), det);
+    CU_ASSERT_EQUAL (arena_heap_allocations (arena), lu_warm);
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&d);
+    free_matrix (&got);
+    free_matrix (&want);
+    arena_destroy (arena);
+}
+
+void register_arena_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Arena Tests", NULL, NULL);
+    CU_add_test (suite, "Bump Allocation and Marks", test_arena_alloc);
+    CU_add_test (suite, "Matrices in Arena", test_arena_matrix);
+    CU_add_test (suite, "Repeated Evaluation", test_arena_repeated_evaluation);
+}
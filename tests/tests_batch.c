@@ -0,0 +1,249 @@
+/**
+ * @file tests_batch.c
+ *
+ * @brief Модуль реализации тестов для batch.c
+ */
+
+#include "matrix/batch.h"
+#include "matrix/gemm.h"
+#include "matrix/matrix.h"
+#include "parallel/thread_pool.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Заполняет пакет псевдослучайными значениями из [-1, 1]
+static void fill_batch (MatrixBatch* batch, unsigned seed) {
+    srand (seed);
+    for (int b = 0; b < batch->count; b++) {
+        for (int i = 0; i < batch->rows; i++) {
+            for (int j = 0; j < batch->cols; j++)
+                BATCH_AT (batch, b, i, j) = 2.0 * rand () / RAND_MAX - 1.0;
+        }
+    }
+}
+
+// Наибольшее отклонение матрицы index пакета от плотной матрицы
+static double batch_difference (const MatrixBatch* batch, int index,
+                                const Matrix* expected) {
+    double diff = 0;
+    for (int i = 0; i < batch->rows; i++) {
+        for (int j = 0; j < batch->cols; j++) {
+            diff = fmax (diff, fabs (BATCH_AT (batch, index, i, j) -
+                                     MATRIX_AT (expected, i, j)));
+        }
+    }
+    return diff;
+}
+
+// Сверяет пакетное A x B + C - D^T с плотным для каждой матрицы
+static int check_fused (int count, int m, int k, int n) {
+    MatrixBatch A = batch_create (count, m, k), B = batch_create (count, k, n);
+    MatrixBatch C = batch_create (count, m, n), D = batch_create (count, n, m);
+    MatrixBatch R = batch_create (count, m, n);
+    Matrix      a = create_matrix (m, k), b = create_matrix (k, n);
+    Matrix      c = create_matrix (m, n), d = create_matrix (n, m);
+    Matrix      expected = create_matrix (m, n);
+    int         ok       = R.data != NULL && expected.data != NULL;
+
+    fill_batch (&A, 1);
+    fill_batch (&B, 2);
+    fill_batch (&C, 3);
+    fill_batch (&D, 4);
+    ok = ok && batch_multiply_add_subtract_transposed (&A, &B, &C, &D, &R) == 0;
+
+    for (int index = 0; index < count && ok; index++) {
+        batch_get (&A, index, &a);
+        batch_get (&B, index, &b);
+        batch_get (&C, index, &c);
+        batch_get (&D, index, &d);
+        ok = multiply_add_subtract_transposed (&a, &b, &c, &d, &expected) == 0 &&
+             batch_difference (&R, index, &expected) <= 4 * GEMM_TOLERANCE (k);
+    }
+
+    batch_free (&A);
+    batch_free (&B);
+    batch_free (&C);
+    batch_free (&D);
+    batch_free (&R);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&d);
+    free_matrix (&expected);
+
+    return ok;
+}
+
+void test_batch_layout (void) {
+    MatrixBatch batch = batch_create (13, 3, 4);
+    Matrix      m = create_matrix (3, 4), back = create_matrix (3, 4);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (batch.data);
+    CU_ASSERT_EQUAL (batch.lanes, 16);
+    CU_ASSERT_EQUAL ((uintptr_t) batch.data % MATRIX_ALIGNMENT, 0);
+    CU_ASSERT_EQUAL (BATCH_AT (&batch, 12, 2, 3), 0);
+
+    // Элемент (i, j) матрицы b лежит в отрезке элемента по смещению b
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++) m.data[i][j] = 10 * i + j;
+    CU_ASSERT_EQUAL (batch_set (&batch, 5, &m), 0);
+    CU_ASSERT_EQUAL (batch.data[(1 * 4 + 2) * 16 + 5], 12);
+    CU_ASSERT_EQUAL (batch_get (&batch, 5, &back), 0);
+    CU_ASSERT_EQUAL (batch_difference (&batch, 5, &back), 0);
+
+    // Ошибки
+    CU_ASSERT_EQUAL (batch_set (&batch, 13, &m), -1);
+    CU_ASSERT_EQUAL (batch_get (&batch, -1, &back), -1);
+    CU_ASSERT_PTR_NULL (batch_create (0, 3, 3).data);
+    CU_ASSERT_PTR_NULL (batch_create (4, 3, -1).data);
+
+    batch_free (&batch);
+    batch_free (&batch);   // Повторное освобождение безопасно
+    CU_ASSERT_PTR_NULL (batch.data);
+    free_matrix (&m);
+    free_matrix (&back);
+}
+
+void test_batch_elementwise (void) {
+    const int   count = 301;
+    MatrixBatch A = batch_create (count, 5, 7), B = batch_create (count, 5, 7);
+    MatrixBatch S = batch_create (count, 5, 7), T = batch_create (count, 7, 5);
+    MatrixBatch P = batch_create (count, 5, 5);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (P.data);
+    fill_batch (&A, 5);
+    fill_batch (&B, 6);
+
+    CU_ASSERT_EQUAL (batch_add (&A, &B, &S), 0);
+    CU_ASSERT_EQUAL (batch_transpose (&A, &T), 0);
+    int ok = 1;
+    for (int b = 0; b < count; b++) {
+        for (int i = 0; i < 5; i++) {
+            for (int j = 0; j < 7; j++) {
+                ok = ok &&
+                     BATCH_AT (&S, b, i, j) ==
+                         BATCH_AT (&A, b, i, j) + BATCH_AT (&B, b, i, j) &&
+                     BATCH_AT (&T, b, j, i) == BATCH_AT (&A, b, i, j);
+            }
+        }
+    }
+    CU_ASSERT_TRUE (ok);
+
+    // Вычитание на месте возвращает A
+    CU_ASSERT_EQUAL (batch_subtract (&S, &B, &S), 0);
+    for (int b = 0; b < count; b++)
+        ok = ok && fabs (BATCH_AT (&S, b, 4, 6) - BATCH_AT (&A, b, 4, 6)) < 1e-15;
+    CU_ASSERT_TRUE (ok);
+
+    // Несовместимые формы
+    CU_ASSERT_EQUAL (batch_add (&A, &T, &S), -1);
+    CU_ASSERT_EQUAL (batch_transpose (&A, &S), -1);
+    CU_ASSERT_EQUAL (batch_multiply (&A, &A, &P), -1);
+    CU_ASSERT_EQUAL (batch_multiply (&A, &T, &A), -1);
+    CU_ASSERT_EQUAL (batch_determinant (&A, NULL), -1);
+
+    batch_free (&A);
+    batch_free (&B);
+    batch_free (&S);
+    batch_free (&T);
+    batch_free (&P);
+}
+
+void test_batch_multiply (void) {
+    // Квадратные 3x3 .. 8x8 и прямоугольные формы, count не кратен отрезку
+    for (int n = 3; n <= 8; n++)
+        CU_ASSERT_TRUE (check_fused (BATCH_CHUNK + 37, n, n, n));
+    CU_ASSERT_TRUE (check_fused (45, 3, 8, 5));
+    CU_ASSERT_TRUE (check_fused (1, 1, 1, 1));
+
+    // Отдельное умножение совпадает с классическим
+    const int   count = 100;
+    MatrixBatch A = batch_create (count, 6, 4), B = batch_create (count, 4, 3);
+    MatrixBatch R = batch_create (count, 6, 3);
+    Matrix      a = create_matrix (6, 4), b = create_matrix (4, 3);
+    Matrix      expected = create_matrix (6, 3);
+
+    fill_batch (&A, 7);
+    fill_batch (&B, 8);
+    CU_ASSERT_EQUAL (batch_multiply (&A, &B, &R), 0);
+    int ok = 1;
+    for (int index = 0; index < count; index++) {
+        batch_get (&A, index, &a);
+        batch_get (&B, index, &b);
+        multiply_matrices (&a, &b, &expected);
+        ok = ok && batch_difference (&R, index, &expected) <= GEMM_TOLERANCE (4);
+    }
+    CU_ASSERT_TRUE (ok);
+
+    batch_free (&A);
+    batch_free (&B);
+    batch_free (&R);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&expected);
+}
+
+void test_batch_parallel (void) {
+    const int threads = thread_pool_threads ();
+
+    // 5000 произведений 8x8x8 превышают порог параллельного выполнения
+    thread_pool_set_threads (4);
+    CU_ASSERT_TRUE (check_fused (5000, 8, 8, 8));
+    thread_pool_set_threads (threads);
+}
+
+void test_batch_determinant (void) {
+    const int   count = 600;
+    MatrixBatch A     = batch_create (count, 6, 6);
+    Matrix      a     = create_matrix (6, 6);
+    MATRIX_TYPE det[600];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (A.data);
+    fill_batch (&A, 9);
+
+    // Вырожденная матрица (две равные строки) и нулевая
+    for (int j = 0; j < 6; j++) {
+        BATCH_AT (&A, 17, 3, j) = BATCH_AT (&A, 17, 1, j);
+        for (int i = 0; i < 6; i++) BATCH_AT (&A, 18, i, j) = 0;
+    }
+    // Перестановочная матрица требует обмена строк
+    for (int i = 0; i < 6; i++)
+        for (int j = 0; j < 6; j++) BATCH_AT (&A, 19, i, j) = (j == (i + 1) % 6);
+
+    CU_ASSERT_EQUAL (batch_determinant (&A, det), 0);
+    int ok = 1;
+    for (int index = 0; index < count; index++) {
+        batch_get (&A, index, &a);
+        MATRIX_TYPE expected = determinant (&a);
+        ok = ok && fabs (det[index] - expected) <= 1e-12 * (1 + fabs (expected));
+    }
+    CU_ASSERT_TRUE (ok);
+    CU_ASSERT_TRUE (fabs (det[17]) < 1e-15);
+    CU_ASSERT_EQUAL (det[18], 0);
+    CU_ASSERT_EQUAL (det[19], -1);   // Цикл длины 6 - нечетная перестановка
+
+    // Детерминант 1 x 1 и неквадратные матрицы
+    MatrixBatch one = batch_create (3, 1, 1);
+    BATCH_AT (&one, 2, 0, 0) = -2.5;
+    CU_ASSERT_EQUAL (batch_determinant (&one, det), 0);
+    CU_ASSERT_EQUAL (det[2], -2.5);
+    MatrixBatch rect = batch_create (3, 2, 3);
+    CU_ASSERT_EQUAL (batch_determinant (&rect, det), -1);
+
+    batch_free (&A);
+    batch_free (&one);
+    batch_free (&rect);
+    free_matrix (&a);
+}
+
+void register_batch_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Batch Tests", NULL, NULL);
+    CU_add_test (suite, "Interleaved Layout", test_batch_layout);
+    CU_add_test (suite, "Add Subtract Transpose", test_batch_elementwise);
+    CU_add_test (suite, "Multiply and Fused Expression", test_batch_multiply);
+    CU_add_test (suite, "Parallel Chunks", test_batch_parallel);
+    CU_add_test (suite, "Determinant", test_batch_determinant);
+}
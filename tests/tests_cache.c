@@ -0,0 +1,211 @@
+/**
+ * @file tests_cache.c
+ *
+ * @brief Модуль реализации тестов для cache.c
+ */
+
+#include "matrix/cache.h"
+#include "matrix/matrix.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Проверяет, что матрицы совпадают по размерам и побитово по элементам
+static int same_matrix (const Matrix* a, const Matrix* b) {
+    int same = a->rows == b->rows && a->cols == b->cols;
+
+    for (int i = 0; same && i < a->rows; i++) {
+        for (int j = 0; j < a->cols; j++) {
+            same = same && memcmp (&MATRIX_AT (a, i, j), &MATRIX_AT (b, i, j),
+                                   sizeof (MATRIX_TYPE)) == 0;
+        }
+    }
+
+    return same;
+}
+
+void test_cache_hash (void) {
+    Matrix parent = create_matrix (9, 13);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (parent.data);
+    fill_random (&parent, 3);
+
+    // Хеш зависит от элементов, а не от шага строки: представление и его
+    // плотная копия хешируются одинаково (в том числе хвосты строк)
+    Matrix view = matrix_view (&parent, 2, 3, 5, 7);
+    Matrix copy = create_matrix (5, 7);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (copy.data);
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 7; j++) copy.data[i][j] = MATRIX_AT (&view, i, j);
+    }
+    CU_ASSERT_NOT_EQUAL (view.stride, copy.stride);
+    CU_ASSERT_EQUAL (matrix_hash (&view), matrix_hash (&copy));
+    CU_ASSERT_NOT_EQUAL (matrix_hash (&copy), 0);
+
+    // Изменение одного элемента, в том числе знака нуля, меняет хеш
+    const uint64_t before = matrix_hash (&copy);
+    copy.data[4][6]       = nextafter (copy.data[4][6], 2.0);
+    CU_ASSERT_NOT_EQUAL (matrix_hash (&copy), before);
+    copy.data[0][0] = 0.0;
+    const uint64_t zero = matrix_hash (&copy);
+    copy.data[0][0] = -0.0;
+    CU_ASSERT_NOT_EQUAL (matrix_hash (&copy), zero);
+
+    // Те же байты в другой форме и тот же размер в другом типе различаются
+    Matrix wide = create_matrix (1, 8), tall = create_matrix (8, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (wide.data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (tall.data);
+    for (int i = 0; i < 8; i++) wide.data[0][i] = tall.data[i][0] = i;
+    CU_ASSERT_NOT_EQUAL (matrix_hash (&wide), matrix_hash (&tall));
+
+    Matrix narrow = convert_matrix_type (&copy, MATRIX_F32);
+    Matrix back   = convert_matrix_type (&narrow, MATRIX_F64);
+    CU_ASSERT_FATAL (matrix_valid (&narrow));
+    CU_ASSERT_NOT_EQUAL (matrix_hash (&narrow), matrix_hash (&back));
+
+    Matrix empty = {0};
+    CU_ASSERT_EQUAL (matrix_hash (&empty), 0);
+    CU_ASSERT_EQUAL (matrix_hash (NULL), 0);
+
+    // Ключ зависит от операции, порядка и числа входов
+    const uint64_t hashes[2] = {matrix_hash (&copy), matrix_hash (&wide)};
+    const uint64_t swapped[2] = {hashes[1], hashes[0]};
+    const uint64_t key        = matrix_cache_key ("A*B", hashes, 2);
+    CU_ASSERT_EQUAL (matrix_cache_key ("A*B", hashes, 2), key);
+    CU_ASSERT_NOT_EQUAL (matrix_cache_key ("A+B", hashes, 2), key);
+    CU_ASSERT_NOT_EQUAL (matrix_cache_key ("A*B", swapped, 2), key);
+    CU_ASSERT_NOT_EQUAL (matrix_cache_key ("A*B", hashes, 1), key);
+
+    free_matrix (&view);
+    free_matrix (&parent);
+    free_matrix (&copy);
+    free_matrix (&wide);
+    free_matrix (&tall);
+    free_matrix (&narrow);
+    free_matrix (&back);
+}
+
+void test_cache_lookup_store (void) {
+    remove_cache ("test_cache_dir");
+    MatrixCache* cache = matrix_cache_open ("test_cache_dir", 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (cache);
+
+    Matrix result = create_matrix (11, 6);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (result.data);
+    fill_random (&result, 7);
+    Matrix narrow = convert_matrix_type (&result, MATRIX_F32);
+    CU_ASSERT_FATAL (matrix_valid (&narrow));
+
+    Matrix found = {0};
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 1, &found), 0);
+    CU_ASSERT_EQUAL (matrix_cache_store (cache, 1, &result), 0);
+    CU_ASSERT_EQUAL (matrix_cache_store (cache, 2, &narrow), 0);
+
+    // Попадание возвращает тот же результат побитово и того же типа
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 1, &found), 1);
+    CU_ASSERT (same_matrix (&found, &result));
+    free_matrix (&found);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 2, &found), 1);
+    CU_ASSERT_EQUAL (found.type, MATRIX_F32);
+    CU_ASSERT_EQUAL (found.rows, 11);
+    CU_ASSERT_EQUAL (MATRIX_AT_F32 (&found, 10, 5), MATRIX_AT_F32 (&narrow, 10, 5));
+    free_matrix (&found);
+
+    // Записи переживают закрытие кэша, счетчики - нет
+    MatrixCacheStats stats = matrix_cache_stats (cache);
+    CU_ASSERT_EQUAL (stats.hits, 2);
+    CU_ASSERT_EQUAL (stats.misses, 1);
+    CU_ASSERT_EQUAL (stats.stores, 2);
+    CU_ASSERT_EQUAL (stats.entries, 2);
+    CU_ASSERT (stats.bytes > 11 * 6 * sizeof (double));
+    matrix_cache_close (cache);
+
+    cache = matrix_cache_open ("test_cache_dir", 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (cache);
+    stats = matrix_cache_stats (cache);
+    CU_ASSERT_EQUAL (stats.hits, 0);
+    CU_ASSERT_EQUAL (stats.entries, 2);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 1, &found), 1);
+    CU_ASSERT (same_matrix (&found, &result));
+    free_matrix (&found);
+
+    // Ошибки аргументов
+    Matrix empty = {0};
+    CU_ASSERT_EQUAL (matrix_cache_store (cache, 3, &empty), -1);
+    CU_ASSERT_EQUAL (matrix_cache_store (NULL, 3, &result), -1);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (NULL, 1, &found), 0);
+    CU_ASSERT_PTR_NULL (matrix_cache_open (NULL, 0));
+    CU_ASSERT_PTR_NULL (matrix_cache_open ("test_cache_dir/missing/nested", 0));
+    matrix_cache_close (NULL);
+
+    matrix_cache_close (cache);
+    free_matrix (&result);
+    free_matrix (&narrow);
+    remove_cache ("test_cache_dir");
+}
+
+void test_cache_eviction (void) {
+    Matrix result = create_matrix (16, 16);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (result.data);
+    fill_random (&result, 11);
+
+    // Размер одной записи
+    remove_cache ("test_cache_lru");
+    MatrixCache* cache = matrix_cache_open ("test_cache_lru", 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (cache);
+    CU_ASSERT_EQUAL (matrix_cache_store (cache, 1, &result), 0);
+    const uint64_t size = matrix_cache_stats (cache).bytes;
+    CU_ASSERT_FATAL (size > 0);
+    matrix_cache_close (cache);
+
+    // В предел помещаются две записи; обращение к первой делает лишней вторую
+    cache = matrix_cache_open ("test_cache_lru", 2 * size + size / 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (cache);
+    Matrix found = {0};
+    CU_ASSERT_EQUAL (matrix_cache_store (cache, 2, &result), 0);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 1, &found), 1);
+    free_matrix (&found);
+    CU_ASSERT_EQUAL (matrix_cache_store (cache, 3, &result), 0);
+
+    MatrixCacheStats stats = matrix_cache_stats (cache);
+    CU_ASSERT_EQUAL (stats.evictions, 1);
+    CU_ASSERT_EQUAL (stats.entries, 2);
+    CU_ASSERT_EQUAL (stats.bytes, 2 * size);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 2, &found), 0);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 1, &found), 1);
+    free_matrix (&found);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 3, &found), 1);
+    free_matrix (&found);
+    matrix_cache_close (cache);
+
+    // Меньший предел вытесняет лишнее при открытии, а результат больше
+    // предела не сохраняется
+    cache = matrix_cache_open ("test_cache_lru", size);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (cache);
+    stats = matrix_cache_stats (cache);
+    CU_ASSERT_EQUAL (stats.entries, 1);
+    CU_ASSERT_EQUAL (stats.evictions, 1);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 3, &found), 1);
+    free_matrix (&found);
+    matrix_cache_close (cache);
+
+    cache = matrix_cache_open ("test_cache_lru", size / 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (cache);
+    CU_ASSERT_EQUAL (matrix_cache_store (cache, 4, &result), 0);
+    CU_ASSERT_EQUAL (matrix_cache_lookup (cache, 4, &found), 0);
+    CU_ASSERT_EQUAL (matrix_cache_stats (cache).stores, 0);
+    matrix_cache_close (cache);
+
+    free_matrix (&result);
+    remove_cache ("test_cache_lru");
+}
+
+void register_cache_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Cache Tests", NULL, NULL);
+    CU_add_test (suite, "Hash", test_cache_hash);
+    CU_add_test (suite, "Lookup And Store", test_cache_lookup_store);
+    CU_add_test (suite, "LRU Eviction", test_cache_eviction);
+}
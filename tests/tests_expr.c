@@ -0,0 +1,242 @@
+/**
+ * @file tests_expr.c
+ *
+ * @brief Модуль реализации тестов для expr.c
+ */
+
+#include "matrix/expr.h"
+#include "matrix/matrix.h"
+
+#include <CUnit/CUnit.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Создает матрицу, заполненную псевдослучайными значениями из [-1, 1]
+static Matrix random_matrix (int rows, int cols, unsigned seed) {
+    Matrix m = create_matrix (rows, cols);
+    srand (seed);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) m.data[i][j] = 2.0 * rand () / RAND_MAX - 1.0;
+    }
+    return m;
+}
+
+// Побитовое сравнение значений двух матриц
+static int same_values (const Matrix* a, const Matrix* b) {
+    int same = a->rows == b->rows && a->cols == b->cols;
+    for (int i = 0; same && i < a->rows; i++) {
+        same = memcmp (a->data[i], b->data[i], a->cols * sizeof (MATRIX_TYPE)) == 0;
+    }
+    return same;
+}
+
+void test_expr_fused_expression (void) {
+    const int  m = 150, n = 130, k = 140;
+    Matrix     a = random_matrix (m, k, 1), b = random_matrix (k, n, 2);
+    Matrix     c = random_matrix (m, n, 3), d = random_matrix (n, m, 4);
+    Matrix     expected = create_matrix (m, n), result = create_matrix (m, n);
+    ExprGraph* graph    = expr_graph_create ();
+
+    // A x B + C - D^T: одно умножение с эпилогом, без временных матриц
+    Expr* root = expr_sub (
+        graph,
+        expr_add (graph, expr_mul (graph, expr_input (graph, &a), expr_input (graph, &b)),
+                  expr_input (graph, &c)),
+        expr_transpose (graph, expr_input (graph, &d)));
+    CU_ASSERT_EQUAL (expr_evaluate (graph, root, &result), 0);
+    CU_ASSERT_EQUAL (expr_temporaries (graph), 0);
+
+    multiply_add_subtract_transposed (&a, &b, &c, &d, &expected);
+    CU_ASSERT (same_values (&result, &expected));
+
+    // 2 * (A x B) + C: произведение пишется прямо в результат
+    Matrix ab = create_matrix (m, n);
+    root      = expr_add (graph,
+                          expr_scale (graph,
+                                      expr_mul (graph, expr_input (graph, &a),
+                                                expr_input (graph, &b)),
+                                      2.0),
+                          expr_input (graph, &c));
+    CU_ASSERT_EQUAL (expr_evaluate (graph, root, &result), 0);
+    CU_ASSERT_EQUAL (expr_temporaries (graph), 0);
+
+    multiply_matrices (&a, &b, &ab);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) ab.data[i][j] = 2.0 * ab.data[i][j] + c.data[i][j];
+    }
+    CU_ASSERT (same_values (&result, &ab));
+
+    expr_graph_free (graph);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&d);
+    free_matrix (&ab);
+    free_matrix (&expected);
+    free_matrix (&result);
+}
+
+void test_expr_common_subexpressions (void) {
+    const int  n = 70;
+    Matrix     a = random_matrix (n, n, 5), b = random_matrix (n, n, 6);
+    Matrix     sum = create_matrix (n, n), expected = create_matrix (n, n);
+    Matrix     result = create_matrix (n, n);
+    ExprGraph* graph  = expr_graph_create ();
+    Expr*      in_a   = expr_input (graph, &a);
+    Expr*      in_b   = expr_input (graph, &b);
+
+    // Повторное построение возвращает тот же узел
+    CU_ASSERT_PTR_EQUAL (expr_input (graph, &a), in_a);
+    CU_ASSERT_PTR_EQUAL (expr_add (graph, in_a, in_b), expr_add (graph, in_b, in_a));
+    CU_ASSERT_PTR_EQUAL (expr_transpose (graph, expr_transpose (graph, in_a)), in_a);
+    CU_ASSERT_PTR_NOT_EQUAL (expr_sub (graph, in_a, in_b), expr_sub (graph, in_b, in_a));
+
+    // (A + B) x (A + B): сумма вычисляется один раз
+    const int count = expr_node_count (graph);
+    Expr*     root  = expr_mul (graph, expr_add (graph, in_a, in_b),
+                                expr_add (graph, in_b, in_a));
+    CU_ASSERT_EQUAL (expr_node_count (graph), count + 1);
+    CU_ASSERT_EQUAL (expr_evaluate (graph, root, &result), 0);
+    CU_ASSERT_EQUAL (expr_temporaries (graph), 1);
+
+    add_matrices (&a, &b, &sum);
+    multiply_matrices (&sum, &sum, &expected);
+    CU_ASSERT (same_values (&result, &expected));
+
+    expr_graph_free (graph);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&sum);
+    free_matrix (&expected);
+    free_matrix (&result);
+}
+
+void test_expr_transposes (void) {
+    const int  m = 90, n = 110;
+    Matrix     a = random_matrix (m, n, 7), b = random_matrix (m, n, 8);
+    Matrix     a_t = transpose_matrix (&a), b_t = transpose_matrix (&b);
+    Matrix     expected = create_matrix (n, n), result = create_matrix (n, n);
+    Matrix     wide = create_matrix (n, m), wide_expected = create_matrix (n, m);
+    ExprGraph* graph = expr_graph_create ();
+    Expr*      in_a  = expr_input (graph, &a);
+    Expr*      in_b  = expr_input (graph, &b);
+
+    // A^T x B: транспонирование выполняется при упаковке, без копии
+    Expr* root = expr_mul (graph, expr_transpose (graph, in_a), in_b);
+    CU_ASSERT_EQUAL (expr_rows (root), n);
+    CU_ASSERT_EQUAL (expr_evaluate (graph, root, &result), 0);
+    CU_ASSERT_EQUAL (expr_temporaries (graph), 0);
+    multiply_matrices (&a_t, &b, &expected);
+    CU_ASSERT (same_values (&result, &expected));
+
+    // (A - 3B)^T: поэлементная цепочка читает транспонированные плитки
+    root = expr_transpose (graph, expr_sub (graph, in_a, expr_scale (graph, in_b, 3.0)));
+    CU_ASSERT_EQUAL (expr_evaluate (graph, root, &wide), 0);
+    CU_ASSERT_EQUAL (expr_temporaries (graph), 0);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < m; j++) {
+            wide_expected.data[i][j] = a_t.data[i][j] - 3.0 * b_t.data[i][j];
+        }
+    }
+    CU_ASSERT (same_values (&wide, &wide_expected));
+
+    expr_graph_free (graph);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&a_t);
+    free_matrix (&b_t);
+    free_matrix (&expected);
+    free_matrix (&result);
+    free_matrix (&wide);
+    free_matrix (&wide_expected);
+}
+
+void test_expr_invalid (void) {
+    Matrix     a      = create_matrix (2, 3);
+    Matrix     result = create_matrix (2, 2);
+    ExprGraph* graph  = expr_graph_create ();
+    Expr*      in_a   = expr_input (graph, &a);
+
+    // Несовместимые размеры и NULL распространяются до корня
+    CU_ASSERT_PTR_NULL (expr_mul (graph, in_a, in_a));
+    CU_ASSERT_PTR_NULL (expr_add (graph, in_a, expr_transpose (graph, in_a)));
+    CU_ASSERT_PTR_NULL (expr_scale (graph, expr_mul (graph, in_a, in_a), 2.0));
+    CU_ASSERT_EQUAL (expr_evaluate (graph, NULL, &result), 1);
+
+    // Результат меньше значения выражения
+    CU_ASSERT_EQUAL (expr_evaluate (graph, in_a, &result), 1);
+
+    expr_graph_free (graph);
+    free_matrix (&a);
+    free_matrix (&result);
+}
+
+void test_expr_parse (void) {
+    Matrix a = random_matrix (4, 5, 5), b = random_matrix (5, 3, 6);
+    Matrix c = random_matrix (4, 3, 7), d = random_matrix (3, 4, 8);
+    const char* const   names[]  = {"A", "B", "C", "D_1"};
+    const Matrix* const inputs[] = {&a, &b, &c, &d};
+    ExprGraph*          graph    = expr_graph_create ();
+
+    // Запись дает те же узлы, что и построение вызовами
+    Expr* A = expr_input (graph, &a);
+    Expr* B = expr_input (graph, &b);
+    Expr* C = expr_input (graph, &c);
+    Expr* D = expr_input (graph, &d);
+    Expr* fused =
+        expr_sub (graph, expr_add (graph, expr_mul (graph, A, B), C),
+                  expr_transpose (graph, D));
+    CU_ASSERT_PTR_EQUAL (expr_parse (graph, "A*B+C-D_1^T", names, inputs, 4), fused);
+    CU_ASSERT_PTR_EQUAL (expr_parse (graph, " ( A * B + C ) - D_1 ^T ", names,
+                                     inputs, 4),
+                         fused);
+    CU_ASSERT_PTR_EQUAL (expr_parse (graph, "2*(A*B)*0.5e1+C", names, inputs, 4),
+                         expr_add (graph,
+                                   expr_scale (graph,
+                                               expr_scale (graph,
+                                                           expr_mul (graph, A, B), 2),
+                                               5),
+                                   C));
+    CU_ASSERT_PTR_EQUAL (expr_parse (graph, "--A^T^T-C*B^T*-1", names, inputs, 4),
+                         expr_sub (graph, A,
+                                   expr_scale (graph,
+                                               expr_mul (graph, C,
+                                                         expr_transpose (graph, B)),
+                                               -1)));
+
+    // Синтаксические ошибки, неизвестные имена, размеры и значение-число
+    const char* invalid[] = {"",    "A+",      "A*B*", "E",   "2",   "A+2",
+                             "((A)", "A^X",    "A B",  "A*C", "A+D", "1*2*",
+                             "A)",  "4A",      "A_"};
+    for (size_t i = 0; i < sizeof invalid / sizeof invalid[0]; i++) {
+        CU_ASSERT_PTR_NULL (expr_parse (graph, invalid[i], names, inputs, 4));
+    }
+    CU_ASSERT_PTR_NULL (expr_parse (NULL, "A", names, inputs, 4));
+    CU_ASSERT_PTR_NULL (expr_parse (graph, "A", NULL, inputs, 4));
+
+    // Вложенность скобок ограничена
+    char deep[2 * 100 + 2];
+    memset (deep, '(', 100);
+    deep[100] = 'A';
+    memset (deep + 101, ')', 100);
+    deep[201] = '\0';
+    CU_ASSERT_PTR_NULL (expr_parse (graph, deep, names, inputs, 4));
+    CU_ASSERT_PTR_EQUAL (expr_parse (graph, deep + 90, names, inputs, 4), NULL);
+    deep[111] = '\0';   // 10 скобок с каждой стороны
+    CU_ASSERT_PTR_EQUAL (expr_parse (graph, deep + 90, names, inputs, 4), A);
+
+    expr_graph_free (graph);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&d);
+}
+
+void register_expr_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Expression Tests", NULL, NULL);
+    CU_add_test (suite, "Expr Fused Expression", test_expr_fused_expression);
+    CU_add_test (suite, "Expr Common Subexpressions", test_expr_common_subexpressions);
+    CU_add_test (suite, "Expr Transposes", test_expr_transposes);
+    CU_add_test (suite, "Expr Invalid", test_expr_invalid);
+    CU_add_test (suite, "Expr Parse", test_expr_parse);
+}
@@ -0,0 +1,176 @@
+/**
+ * @file tests_format.c
+ *
+ * @brief Модуль реализации тестов для format.c
+ */
+
+#include "matrix/matrix.h"
+#include "output/format.h"
+#include "output/output.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <float.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Сравнивает format_fixed с snprintf ("%.*f"); 1 при совпадении
+static int same_as_printf (double value, int precision) {
+    char   expected[FORMAT_BUFFER_SIZE], actual[FORMAT_BUFFER_SIZE];
+    size_t length = format_fixed (value, precision, actual);
+
+    snprintf (expected, sizeof expected, "%.*f", precision, value);
+
+    return length == strlen (expected) && memcmp (actual, expected, length) == 0;
+}
+
+// Проверяет, что запись читается обратно в то же число и содержит не
+// больше значащих цифр, чем кратчайшая подходящая запись %.Ng
+static int round_trips (double value) {
+    char   text[FORMAT_BUFFER_SIZE], reference[32], digits[FORMAT_BUFFER_SIZE];
+    size_t length = format_shortest (value, text);
+    size_t count = 0, first = 0;
+    int    shortest = 17;
+    double parsed;
+
+    text[length] = '\0';
+    parsed       = strtod (text, NULL);
+
+    for (int n = 16; n >= 1; n--) {
+        snprintf (reference, sizeof reference, "%.*g", n, value);
+        if (strtod (reference, NULL) == value) shortest = n;
+    }
+
+    // Значащие цифры мантиссы без ведущих и завершающих нулей
+    for (size_t i = 0; i < length && text[i] != 'e'; i++) {
+        if ((unsigned) (text[i] - '0') < 10) digits[count++] = text[i];
+    }
+    while (first < count && digits[first] == '0') first++;
+    while (count > first && digits[count - 1] == '0') count--;
+
+    return memcmp (&parsed, &value, sizeof value) == 0 &&
+           (int) (count - first) <= shortest;
+}
+
+void test_format_fixed (void) {
+    const double cases[] = {0.0,    -0.0,   0.5,   1.5,     2.5,    -2.5,  0.125,
+                            0.375,  1.005,  2.675, 1e-7,    -1e-9,  0.045, 123.456,
+                            1e15,   1e19,   1e20,  1.8e19,  -1e300, DBL_MAX,
+                            DBL_MIN, 5e-324, 22.5, 28.5,    1.0 / 3};
+    uint64_t     state      = 88172645463325252u;
+    int          mismatches = 0;
+
+    for (size_t i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        for (int precision = 0; precision <= FORMAT_MAX_PRECISION; precision++) {
+            CU_ASSERT_TRUE (same_as_printf (cases[i], precision));
+        }
+    }
+
+    // Случайные биты и числа с ровно половиной в последнем знаке
+    for (int i = 0; i < 100000; i++) {
+        uint64_t bits = next_random (&state);
+        double   value;
+        memcpy (&value, &bits, sizeof value);
+        mismatches += !same_as_printf (value, (int) (bits % 10));
+        mismatches += !same_as_printf ((double) (int64_t) (bits >> 40) / 1000, 2);
+        mismatches += !same_as_printf ((double) (int64_t) (bits >> 44) / 64, 1);
+    }
+    CU_ASSERT_EQUAL (mismatches, 0);
+}
+
+void test_format_shortest (void) {
+    const char* cases[][2] = {{"0.1", "0.1"},       {"-0.0", "-0"},
+                              {"100", "100"},       {"123.25", "123.25"},
+                              {"1e23", "1e+23"},    {"1e-5", "1e-05"},
+                              {"0.001", "0.001"},   {"1e17", "1e+17"},
+                              {"inf", "inf"},       {"-inf", "-inf"},
+                              {"5e-324", "4.9e-324"},
+                              {"1.7976931348623157e308", "1.7976931348623157e+308"}};
+    uint64_t    state      = 12345;
+    int         mismatches = 0;
+    char        text[FORMAT_BUFFER_SIZE];
+
+    for (size_t i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        size_t length = format_shortest (strtod (cases[i][0], NULL), text);
+        text[length]  = '\0';
+        CU_ASSERT_STRING_EQUAL (text, cases[i][1]);
+    }
+
+    for (int i = 0; i < 100000; i++) {
+        uint64_t bits = next_random (&state);
+        double   value;
+        memcpy (&value, &bits, sizeof value);
+        if (value != value || value - value != 0) continue;   // nan и inf
+        mismatches += !round_trips (value);
+        mismatches += !round_trips ((double) (int64_t) (bits >> 40) / 100);
+    }
+    CU_ASSERT_EQUAL (mismatches, 0);
+}
+
+void test_format_lossless_file (void) {
+    const char* filename = "test_format.txt";
+    const int   rows = 200, cols = 300;   // Больше одного блока записи
+    uint64_t    state = 777;
+    Matrix      m     = create_matrix (rows, cols);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (m.data);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            uint64_t bits = next_random (&state);
+            m.data[i][j]  = ((double) (bits >> 11) - 4503599627370496.0) /
+                           (double) (1 + (bits & 0xFFFF));
+        }
+    }
+
+    // Без потерь загруженная матрица совпадает побитово
+    CU_ASSERT_EQUAL (
+        save_matrix_to_file_precision (&m, filename, OUTPUT_PRECISION_LOSSLESS), 0);
+    Matrix loaded = load_matrix_from_file (filename);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (loaded.data);
+    int mismatches = 0;
+    for (int i = 0; i < rows; i++) {
+        mismatches += memcmp (loaded.data[i], m.data[i], cols * sizeof (double)) != 0;
+    }
+    CU_ASSERT_EQUAL (mismatches, 0);
+    free_matrix (&loaded);
+
+    // Обычное сохранение совпадает с fprintf ("%.2f ")
+    CU_ASSERT_EQUAL (save_matrix_to_file (&m, filename), 0);
+    FILE*  f    = fopen (filename, "r");
+    size_t size = (size_t) rows * cols * 32 + 64;
+    char*  got  = calloc (size, 1);
+    char*  want = calloc (size, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (f);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (got);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (want);
+    CU_ASSERT_TRUE (fread (got, 1, size - 1, f) > 0);
+    fclose (f);
+
+    size_t fill = (size_t) snprintf (want, size, "%d %d\n", rows, cols);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            fill += (size_t) snprintf (want + fill, size - fill, "%.2f ", m.data[i][j]);
+        }
+        fill += (size_t) snprintf (want + fill, size - fill, "\n");
+    }
+    CU_ASSERT_STRING_EQUAL (got, want);
+
+    // Точность вне диапазона отвергается
+    CU_ASSERT_EQUAL (save_matrix_to_file_precision (&m, filename, -2), -1);
+    CU_ASSERT_EQUAL (
+        save_matrix_to_file_precision (&m, filename, FORMAT_MAX_PRECISION + 1), -1);
+
+    free (got);
+    free (want);
+    free_matrix (&m);
+    remove (filename);
+}
+
+void register_format_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Format Tests", NULL, NULL);
+    CU_add_test (suite, "Fixed Precision Formatting", test_format_fixed);
+    CU_add_test (suite, "Shortest Round-trip Formatting", test_format_shortest);
+    CU_add_test (suite, "Lossless Matrix File", test_format_lossless_file);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file tests_gemm.c
+ *
+ * @brief Модуль реализации тестов для gemm.c
+ */
+
+#include "matrix/gemm.h"
+#include "matrix/matrix.h"
+#include "parallel/thread_pool.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Сравнивает блочное умножение с эталоном с допуском из gemm.h
+static int gemm_matches_reference (int m, int n, int k) {
+    Matrix a        = create_matrix (m, k);
+    Matrix b        = create_matrix (k, n);
+    Matrix result   = create_matrix (m, n);
+    Matrix expected = create_matrix (m, n);
+    int    ok       = 1;
+
+    fill_random (&a, 1);
+    fill_random (&b, 2);
+
+    ok = (multiply_matrices (&a, &b, &result) == 0);
+    gemm_reference (m, n, k, a.block, a.stride, b.block, b.stride, expected.block,
+                    expected.stride);
+
+    for (int i = 0; i < m && ok; i++) {
+        for (int j = 0; j < n && ok; j++) {
+            double bound = 0;
+            for (int p = 0; p < k; p++) bound += fabs (a.data[i][p] * b.data[p][j]);
+            if (fabs (result.data[i][j] - expected.data[i][j]) >
+                GEMM_TOLERANCE (k) * bound)
+                ok = 0;
+        }
+    }
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&result);
+    free_matrix (&expected);
+
+    return ok;
+}
+
+void test_gemm_small_sizes (void) {
+    CU_ASSERT (gemm_matches_reference (1, 1, 1));
+    CU_ASSERT (gemm_matches_reference (3, 5, 7));
+    CU_ASSERT (gemm_matches_reference (16, 16, 16));
+}
+
+void test_gemm_edge_tiles (void) {
+    // Размеры, не кратные плитке микроядра
+    CU_ASSERT (gemm_matches_reference (67, 45, 131));
+    CU_ASSERT (gemm_matches_reference (33, 1, 129));
+    CU_ASSERT (gemm_matches_reference (1, 97, 65));
+}
+
+void test_gemm_block_boundaries (void) {
+    // Размеры, пересекающие границы блоков GEMM_MC и GEMM_KC
+    CU_ASSERT (gemm_matches_reference (GEMM_MC + 5, 37, GEMM_KC + 3));
+    CU_ASSERT (gemm_matches_reference (2 * GEMM_MC, 64, 2 * GEMM_KC));
+}
+
+void test_gemm_parallel_matches_serial (void) {
+    const int m = 301, n = 277, k = 263;
+    Matrix    a        = create_matrix (m, k);
+    Matrix    b        = create_matrix (k, n);
+    Matrix    serial   = create_matrix (m, n);
+    Matrix    parallel = create_matrix (m, n);
+    int       same     = 1;
+
+    fill_random (&a, 3);
+    fill_random (&b, 4);
+
+    thread_pool_set_threads (1);
+    CU_ASSERT_EQUAL (multiply_matrices (&a, &b, &serial), 0);
+    thread_pool_set_threads (5);
+    CU_ASSERT_EQUAL (multiply_matrices (&a, &b, &parallel), 0);
+    thread_pool_set_threads (0);
+
+    // Побитовое совпадение: плитки и порядок суммирования те же
+    for (int i = 0; i < m; i++) {
+        same = same && memcmp (serial.data[i], parallel.data[i],
+                               n * sizeof (MATRIX_TYPE)) == 0;
+    }
+    CU_ASSERT (same);
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&serial);
+    free_matrix (&parallel);
+}
+
+void register_gemm_tests (void) {
+    CU_pSuite suite = CU_add_suite ("GEMM Tests", NULL, NULL);
+    CU_add_test (suite, "GEMM Small Sizes", test_gemm_small_sizes);
+    CU_add_test (suite, "GEMM Edge Tiles", test_gemm_edge_tiles);
+    CU_add_test (suite, "GEMM Block Boundaries", test_gemm_block_boundaries);
+    CU_add_test (suite, "GEMM Parallel Matches Serial",
+                 test_gemm_parallel_matches_serial);
+}
@@ -0,0 +1,180 @@
+/**
+ * @file tests_jobs.c
+ *
+ * @brief Модуль реализации тестов для jobs.c
+ */
+
+#include "matrix/cache.h"
+#include "matrix/jobs.h"
+#include "matrix/matrix.h"
+#include "output/output.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Записывает текст в файл
+static void write_text (const char* filename, const char* text) {
+    FILE* file = fopen (filename, "w");
+    if (file) {
+        fputs (text, file);
+        fclose (file);
+    }
+}
+
+// Сравнивает сохраненный результат с матрицей побитово
+static int file_matches (const char* filename, const Matrix* expected) {
+    Matrix loaded = load_matrix_from_file (filename);
+    int    same   = loaded.data != NULL && loaded.rows == expected->rows &&
+               loaded.cols == expected->cols;
+
+    for (int i = 0; same && i < loaded.rows; i++) {
+        for (int j = 0; j < loaded.cols; j++)
+            same = same && loaded.data[i][j] == expected->data[i][j];
+    }
+    free_matrix (&loaded);
+
+    return same;
+}
+
+void test_jobs_run (void) {
+    const char* files[4] = {"test_jobs_a.bin", "test_jobs_b.bin", "test_jobs_c.txt",
+                            "test_jobs_d.bin"};
+    Matrix      inputs[4];
+    for (int f = 0; f < 4; f++) {
+        inputs[f] = create_matrix (f == 1 ? 21 : 17, f == 0 ? 21 : 17);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (inputs[f].data);
+        fill_random (&inputs[f], f + 40);
+        if (f == 2) {
+            save_matrix_to_file_precision (&inputs[f], files[f],
+                                           OUTPUT_PRECISION_LOSSLESS);
+        } else {
+            save_matrix_to_binary_file (&inputs[f], files[f]);
+        }
+    }
+
+    // Два задания делят файлы A и B; третье ссылается на отсутствующий
+    // файл, в четвертом не согласованы размеры
+    write_text ("test_jobs.manifest",
+                "# номер выход выражение входы\n"
+                "\n"
+                "fused test_jobs_r1.txt A*B+C-D^T A=test_jobs_a.bin "
+                "B=test_jobs_b.bin C=test_jobs_c.txt D=test_jobs_d.bin\r\n"
+                "  product\ttest_jobs_r2.txt X*Y X=test_jobs_a.bin "
+                "Y=test_jobs_b.bin\n"
+                "missing test_jobs_r3.txt A A=test_jobs_missing.txt\n"
+                "shape test_jobs_r4.txt A*A A=test_jobs_a.bin");
+
+    JobManifest manifest;
+    CU_ASSERT_FATAL (jobs_load_manifest ("test_jobs.manifest", &manifest) == 0);
+    CU_ASSERT_EQUAL (manifest.job_count, 4);
+    CU_ASSERT_EQUAL (manifest.file_count, 5);
+    CU_ASSERT_EQUAL (jobs_run (&manifest, OUTPUT_PRECISION_LOSSLESS, NULL), 2);
+
+    Matrix expected = create_matrix (17, 17), product = create_matrix (17, 17);
+    multiply_add_subtract_transposed (&inputs[0], &inputs[1], &inputs[2], &inputs[3],
+                                      &expected);
+    multiply_matrices (&inputs[0], &inputs[1], &product);
+    CU_ASSERT_EQUAL (manifest.jobs[0].status, JOB_DONE);
+    CU_ASSERT_EQUAL (manifest.jobs[1].status, JOB_DONE);
+    CU_ASSERT_EQUAL (manifest.jobs[1].rows, 17);
+    CU_ASSERT (file_matches ("test_jobs_r1.txt", &expected));
+    CU_ASSERT (file_matches ("test_jobs_r2.txt", &product));
+    CU_ASSERT_EQUAL (manifest.jobs[2].status, JOB_FAILED);
+    CU_ASSERT_EQUAL (manifest.jobs[3].status, JOB_FAILED);
+
+    // Отчет перечисляет все задания и сводку
+    FILE* report = tmpfile ();
+    CU_ASSERT_PTR_NOT_NULL_FATAL (report);
+    jobs_report (&manifest, report);
+    CU_ASSERT (ftell (report) > 0);
+    fclose (report);
+
+    // С кэшем второй запуск берет оба успешных результата из кэша; задание
+    // с несогласованными размерами промахивается оба раза
+    remove_cache ("test_jobs_cache");
+    MatrixCache* cache = matrix_cache_open ("test_jobs_cache", 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (cache);
+    for (int pass = 0; pass < 2; pass++) {
+        JobManifest again;
+        remove ("test_jobs_r1.txt");
+        CU_ASSERT_FATAL (jobs_load_manifest ("test_jobs.manifest", &again) == 0);
+        CU_ASSERT_EQUAL (jobs_run (&again, OUTPUT_PRECISION_LOSSLESS, cache), 2);
+        CU_ASSERT_EQUAL (again.jobs[0].cached, pass);
+        CU_ASSERT_EQUAL (again.jobs[1].cached, pass);
+        CU_ASSERT_EQUAL (again.jobs[0].rows, 17);
+        CU_ASSERT (file_matches ("test_jobs_r1.txt", &expected));
+        jobs_free (&again);
+    }
+    MatrixCacheStats stats = matrix_cache_stats (cache);
+    CU_ASSERT_EQUAL (stats.hits, 2);
+    CU_ASSERT_EQUAL (stats.misses, 4);
+    CU_ASSERT_EQUAL (stats.stores, 2);
+
+    // Ошибка записи в кэш не проваливает задание, но видна в отчете
+    remove_cache ("test_jobs_cache");
+    JobManifest uncached;
+    CU_ASSERT_FATAL (jobs_load_manifest ("test_jobs.manifest", &uncached) == 0);
+    CU_ASSERT_EQUAL (jobs_run (&uncached, OUTPUT_PRECISION_LOSSLESS, cache), 2);
+    CU_ASSERT_EQUAL (uncached.jobs[0].status, JOB_DONE);
+    CU_ASSERT_EQUAL (uncached.jobs[0].cache_failed, 1);
+    CU_ASSERT_EQUAL (uncached.jobs[1].cache_failed, 1);
+    CU_ASSERT (file_matches ("test_jobs_r1.txt", &expected));
+    char text[1024] = {0};
+    report          = tmpfile ();
+    CU_ASSERT_PTR_NOT_NULL_FATAL (report);
+    jobs_report (&uncached, report);
+    rewind (report);
+    CU_ASSERT (fread (text, 1, sizeof (text) - 1, report) > 0);
+    CU_ASSERT_PTR_NOT_NULL (strstr (text, "fused: 17 x 17"));
+    CU_ASSERT_PTR_NOT_NULL (strstr (text, "(ошибка записи в кэш)"));
+    fclose (report);
+    jobs_free (&uncached);
+
+    matrix_cache_close (cache);
+    remove_cache ("test_jobs_cache");
+
+    jobs_free (&manifest);
+    CU_ASSERT_PTR_NULL (manifest.jobs);
+    free_matrix (&expected);
+    free_matrix (&product);
+    for (int f = 0; f < 4; f++) {
+        free_matrix (&inputs[f]);
+        remove (files[f]);
+    }
+    remove ("test_jobs.manifest");
+    remove ("test_jobs_r1.txt");
+    remove ("test_jobs_r2.txt");
+}
+
+void test_jobs_manifest_errors (void) {
+    JobManifest manifest;
+
+    CU_ASSERT_EQUAL (jobs_load_manifest ("test_jobs_none.manifest", &manifest), -1);
+    jobs_free (&manifest);
+
+    // Нет входов, вход без имени или без файла
+    const char* lines[] = {"job out.txt A\n", "job out.txt A =a.txt\n",
+                           "job out.txt A A=\n", "job out.txt\n"};
+    for (size_t i = 0; i < sizeof lines / sizeof lines[0]; i++) {
+        write_text ("test_jobs.manifest", lines[i]);
+        CU_ASSERT_EQUAL (jobs_load_manifest ("test_jobs.manifest", &manifest), -1);
+        jobs_free (&manifest);
+    }
+
+    // Пустой манифест - пакет без заданий
+    write_text ("test_jobs.manifest", "# только комментарий\n");
+    CU_ASSERT_EQUAL (jobs_load_manifest ("test_jobs.manifest", &manifest), 0);
+    CU_ASSERT_EQUAL (jobs_run (&manifest, 2, NULL), 0);
+    CU_ASSERT_EQUAL (jobs_run (NULL, 2, NULL), -1);
+    jobs_free (&manifest);
+    remove ("test_jobs.manifest");
+}
+
+void register_jobs_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Jobs Tests", NULL, NULL);
+    CU_add_test (suite, "Run Manifest", test_jobs_run);
+    CU_add_test (suite, "Manifest Errors", test_jobs_manifest_errors);
+}
@@ -0,0 +1,91 @@
+/**
+ * @file tests_loader.c
+ *
+ * @brief Модуль реализации тестов для loader.c
+ */
+
+#include "matrix/loader.h"
+#include "matrix/matrix.h"
+#include "output/output.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void test_loader_parallel (void) {
+    const char* files[3] = {"test_loader_a.bin", "test_loader_b.txt",
+                            "test_loader_c.bin"};
+    Matrix      sources[3];
+    MatrixLoad  loads[3];
+
+    for (int f = 0; f < 3; f++) {
+        sources[f] = create_matrix (40 + f, 33);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (sources[f].data);
+        fill_random (&sources[f], f + 1);
+    }
+    CU_ASSERT_EQUAL (save_matrix_to_binary_file (&sources[0], files[0]), 0);
+    CU_ASSERT_EQUAL (save_matrix_to_file_precision (&sources[1], files[1],
+                                                    OUTPUT_PRECISION_LOSSLESS),
+                     0);
+    CU_ASSERT_EQUAL (save_matrix_to_binary_file (&sources[2], files[2]), 0);
+
+    // Все файлы загружаются одновременно, порядок ожидания произвольный
+    for (int f = 0; f < 3; f++) {
+        CU_ASSERT_EQUAL (matrix_load_start (&loads[f], files[f], MATRIX_F64), 0);
+    }
+    for (int f = 2; f >= 0; f--) {
+        Matrix loaded = matrix_load_wait (&loads[f]);
+        CU_ASSERT (matrix_load_ready (&loads[f]));
+        CU_ASSERT_EQUAL (loaded.rows, sources[f].rows);
+        CU_ASSERT_EQUAL (loaded.cols, sources[f].cols);
+        int ok = loaded.data != NULL;
+        for (int i = 0; ok && i < loaded.rows; i++) {
+            for (int j = 0; j < loaded.cols; j++)
+                ok = ok && loaded.data[i][j] == sources[f].data[i][j];
+        }
+        CU_ASSERT (ok);
+        free_matrix (&loaded);
+
+        // Матрица уже передана вызывающему
+        Matrix again = matrix_load_wait (&loads[f]);
+        CU_ASSERT (!matrix_valid (&again));
+    }
+
+    // Преобразование типа выполняется в потоке загрузки
+    CU_ASSERT_EQUAL (matrix_load_start (&loads[0], files[0], MATRIX_F32), 0);
+    Matrix narrow = matrix_load_wait (&loads[0]);
+    CU_ASSERT_EQUAL (narrow.type, MATRIX_F32);
+    CU_ASSERT (matrix_valid (&narrow) &&
+               MATRIX_AT_F32 (&narrow, 5, 7) == (float) sources[0].data[5][7]);
+    free_matrix (&narrow);
+
+    for (int f = 0; f < 3; f++) {
+        free_matrix (&sources[f]);
+        remove (files[f]);
+    }
+}
+
+void test_loader_errors (void) {
+    MatrixLoad load;
+
+    CU_ASSERT_EQUAL (matrix_load_start (NULL, "x.txt", MATRIX_F64), -1);
+    CU_ASSERT_EQUAL (matrix_load_start (&load, NULL, MATRIX_F64), -1);
+    CU_ASSERT_EQUAL (matrix_load_start (&load, "x.txt", MATRIX_ELEMENT_TYPE_COUNT),
+                     -1);
+
+    // Ошибка чтения отдается как нулевая матрица
+    CU_ASSERT_EQUAL (matrix_load_start (&load, "test_loader_missing.txt",
+                                        MATRIX_F64),
+                     0);
+    Matrix missing = matrix_load_wait (&load);
+    CU_ASSERT (!matrix_valid (&missing));
+    CU_ASSERT (matrix_load_ready (&load));
+    CU_ASSERT (!matrix_load_ready (NULL));
+}
+
+void register_loader_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Loader Tests", NULL, NULL);
+    CU_add_test (suite, "Parallel Loads", test_loader_parallel);
+    CU_add_test (suite, "Load Errors", test_loader_errors);
+}
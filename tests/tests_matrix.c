@@ -3,11 +3,16 @@
  *
  * @brief Модуль реализации тестов для matrix.c
  */
+#include "matrix/arena.h"
 #include "matrix/matrix.h"
+#include "tests.h"
 
 #include <CUnit/Basic.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void test_matrix_creation (void) {
     Matrix m = create_matrix (2, 3);
@@ -22,6 +27,29 @@ void test_matrix_creation (void) {
     CU_ASSERT_EQUAL (invalid.cols, 0);
 }
 
+void test_matrix_storage_layout (void) {
+    Matrix m = create_matrix (3, 5);
+    CU_ASSERT_PTR_NOT_NULL (m.block);
+    CU_ASSERT ((uintptr_t) m.block % MATRIX_ALIGNMENT == 0);
+    CU_ASSERT (m.stride >= m.cols);
+    CU_ASSERT ((m.stride * sizeof (MATRIX_TYPE)) % MATRIX_ALIGNMENT == 0);
+
+    // Указатели на строки смотрят в единый блок
+    for (int i = 0; i < 3; i++) {
+        CU_ASSERT_PTR_EQUAL (m.data[i], m.block + (size_t) i * m.stride);
+    }
+    m.data[2][4] = 7.0;
+    CU_ASSERT_DOUBLE_EQUAL (MATRIX_AT (&m, 2, 4), 7.0, 0.001);
+    free_matrix (&m);
+    CU_ASSERT_PTR_NULL (m.block);
+
+    // Шаг, кратный периоду наборов кэша, дополняется
+    int ld = matrix_leading_dimension (MATRIX_ALIAS_PERIOD / sizeof (MATRIX_TYPE),
+                                       sizeof (MATRIX_TYPE));
+    CU_ASSERT (((size_t) ld * sizeof (MATRIX_TYPE)) % MATRIX_ALIAS_PERIOD != 0);
+    CU_ASSERT_EQUAL (matrix_leading_dimension (0, sizeof (MATRIX_TYPE)), 0);
+}
+
 void test_matrix_addition (void) {
     Matrix a = create_matrix (2, 2);
     Matrix b = create_matrix (2, 2);
@@ -114,6 +142,94 @@ void test_matrix_transpose (void) {
     free_matrix (&transposed);
 }
 
+// Проверяет, что t - транспонированная матрица с элементами i * 1000 + j
+static int is_transposed (const Matrix* t, int rows, int cols) {
+    int ok = t->data != NULL && t->rows == cols && t->cols == rows;
+
+    for (int i = 0; ok && i < cols; i++) {
+        for (int j = 0; ok && j < rows; j++) {
+            ok = t->data[i][j] == j * 1000.0 + i;
+        }
+    }
+
+    return ok;
+}
+
+void test_matrix_transpose_large (void) {
+    // Размеры вокруг листа рекурсии и плиток ядер, квадратные и нет
+    const int sizes[][2] = {{1, 1},     {1, 130},  {130, 1},  {63, 65},
+                            {64, 64},   {65, 65},  {200, 3},  {129, 257},
+                            {300, 300}, {37, 500}, {500, 37}, {4, 1000}};
+
+    const size_t size = sizeof (MATRIX_TYPE);   // Шаг double
+
+    for (size_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++) {
+        const int rows = sizes[s][0], cols = sizes[s][1];
+        Matrix    m    = create_matrix (rows, cols);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (m.data);
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                m.data[i][j] = i * 1000.0 + j;
+            }
+        }
+
+        Matrix t = transpose_matrix (&m);
+        CU_ASSERT_TRUE (is_transposed (&t, rows, cols));
+        free_matrix (&t);
+
+        // На месте - выровненный или плотный шаг; высокая остается в блоке
+        MATRIX_TYPE* block = m.block;
+        CU_ASSERT_EQUAL (transpose_matrix_inplace (&m), 0);
+        CU_ASSERT_TRUE (is_transposed (&m, rows, cols));
+        CU_ASSERT_TRUE (m.stride == matrix_leading_dimension (rows, size) ||
+                        m.stride == rows);
+        if (rows >= cols) CU_ASSERT_PTR_EQUAL (m.block, block);
+        int pointers = 1;
+        for (int i = 0; i < m.rows; i++) {
+            pointers &= m.data[i] == m.block + (size_t) i * m.stride;
+        }
+        CU_ASSERT_TRUE (pointers);
+
+        // Обратно к исходной форме
+        CU_ASSERT_EQUAL (transpose_matrix_inplace (&m), 0);
+        CU_ASSERT_EQUAL (m.rows, rows);
+        CU_ASSERT_TRUE (m.stride >= cols);
+        int same = 1;
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) same &= m.data[i][j] == i * 1000.0 + j;
+        }
+        CU_ASSERT_TRUE (same);
+        free_matrix (&m);
+    }
+
+    // Высокая -> широкая -> высокая в своем блоке с выровненным шагом
+    Matrix       tall  = create_matrix (1000, 3);
+    MatrixArena* arena = arena_create (0);
+    Matrix       wide  = create_matrix_arena (3, 1000, arena);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (tall.data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (wide.data);
+    MATRIX_TYPE* block = tall.block;
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (&tall), 0);
+    CU_ASSERT_EQUAL (tall.rows, 3);
+    CU_ASSERT_EQUAL (tall.stride, matrix_leading_dimension (1000, size));
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (&tall), 0);
+    CU_ASSERT_EQUAL (tall.rows, 1000);
+    CU_ASSERT_EQUAL (tall.stride, matrix_leading_dimension (3, size));
+    CU_ASSERT_PTR_EQUAL (tall.block, block);
+
+    // Широкая без запаса в строках переносится в новый блок той же арены
+    wide.data[2][999] = 7.0;
+    block             = wide.block;
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (&wide), 0);
+    CU_ASSERT_EQUAL (wide.data[999][2], 7.0);
+    CU_ASSERT_PTR_NOT_EQUAL (wide.block, block);
+    CU_ASSERT_PTR_EQUAL (wide.arena, arena);
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (NULL), -1);
+    free_matrix (&tall);
+    free_matrix (&wide);
+    arena_destroy (arena);
+}
+
 void test_determinant (void) {
     Matrix m = create_matrix (2, 2);
 
@@ -136,6 +252,448 @@ void test_determinant (void) {
     free_matrix (&non_square);
 }
 
+// Детерминант разложением по первой строке для сверки
+static double cofactor_determinant (const Matrix* m) {
+    double det = 0;
+    if (m->rows == 1) det = m->data[0][0];
+    else {
+        for (int col = 0; col < m->cols; col++) {
+            Matrix sub = create_matrix (m->rows - 1, m->cols - 1);
+            for (int i = 1; i < m->rows; i++) {
+                for (int j = 0, k = 0; j < m->cols; j++) {
+                    if (j != col) sub.data[i - 1][k++] = m->data[i][j];
+                }
+            }
+            det += (col % 2 ? -1 : 1) * m->data[0][col] * cofactor_determinant (&sub);
+            free_matrix (&sub);
+        }
+    }
+    return det;
+}
+
+void test_determinant_lu (void) {
+    // Нулевой ведущий элемент требует перестановки строк
+    Matrix m = create_matrix (3, 3);
+    double values[3][3] = {{0, 2, 1}, {1, 1, 1}, {2, 1, 3}};
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) m.data[i][j] = values[i][j];
+    }
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&m), cofactor_determinant (&m), 1e-12);
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&m), -3.0, 1e-12);
+
+    // Вырожденная матрица: две одинаковые строки
+    m.data[2][0] = 0;
+    m.data[2][1] = 2;
+    m.data[2][2] = 1;
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&m), 0.0, 0.0);
+    free_matrix (&m);
+
+    // Случайная хорошо обусловленная матрица совпадает с разложением по строке
+    Matrix r = create_matrix (7, 7);
+    srand (5);
+    for (int i = 0; i < 7; i++) {
+        for (int j = 0; j < 7; j++) r.data[i][j] = rand () % 19 - 9 + (i == j) * 20;
+    }
+    double expected = cofactor_determinant (&r);
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&r), expected, fabs (expected) * 1e-12);
+    free_matrix (&r);
+}
+
+void test_log_determinant (void) {
+    // det = 10^400 переполняет double, логарифм остается конечным
+    const int n = 400;
+    Matrix    m = create_matrix (n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) m.data[i][j] = (i == j) ? 10.0 : 0.0;
+    }
+    m.data[0][0] = -10.0;
+
+    int    sign    = 0;
+    double log_det = log_determinant (&m, &sign);
+    CU_ASSERT_EQUAL (sign, -1);
+    CU_ASSERT_DOUBLE_EQUAL (log_det, n * log (10.0), 1e-9);
+    CU_ASSERT (isinf (determinant (&m)));
+
+    // Вырожденная матрица
+    for (int j = 0; j < n; j++) m.data[1][j] = 0;
+    log_det = log_determinant (&m, &sign);
+    CU_ASSERT_EQUAL (sign, 0);
+    CU_ASSERT (isinf (log_det) && log_det < 0);
+    free_matrix (&m);
+
+    Matrix non_square = create_matrix (2, 3);
+    log_determinant (&non_square, &sign);
+    CU_ASSERT_EQUAL (sign, 0);
+    free_matrix (&non_square);
+}
+
+// Сравнивает однопроходное A x B + C - D^T с пошаговым вычислением побитово
+static int fused_matches_steps (int m, int n, int k) {
+    Matrix a = create_matrix (m, k), b = create_matrix (k, n);
+    Matrix c = create_matrix (m, n), d = create_matrix (n, m);
+    Matrix ab = create_matrix (m, n), ab_c = create_matrix (m, n);
+    Matrix steps = create_matrix (m, n), fused = create_matrix (m, n);
+    int    same  = 1;
+
+    srand (m * 31 + n);
+    Matrix* inputs[] = {&a, &b, &c, &d};
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; i < inputs[t]->rows; i++) {
+            for (int j = 0; j < inputs[t]->cols; j++) {
+                inputs[t]->data[i][j] = 2.0 * rand () / RAND_MAX - 1.0;
+            }
+        }
+    }
+
+    Matrix d_t = transpose_matrix (&d);
+    multiply_matrices (&a, &b, &ab);
+    add_matrices (&ab, &c, &ab_c);
+    subtract_matrices (&ab_c, &d_t, &steps);
+    same = multiply_add_subtract_transposed (&a, &b, &c, &d, &fused) == 0;
+
+    for (int i = 0; i < m && same; i++) {
+        same = memcmp (steps.data[i], fused.data[i], n * sizeof (MATRIX_TYPE)) == 0;
+    }
+
+    // Результат на месте C: другой порядок сложения, совпадение с допуском
+    same = same && multiply_add_subtract_transposed (&a, &b, &c, &d, &c) == 0;
+    for (int i = 0; i < m && same; i++) {
+        for (int j = 0; j < n && same; j++)
+            same = fabs (c.data[i][j] - steps.data[i][j]) <= 1e-13 * k;
+    }
+
+    Matrix* all[] = {&a, &b, &c, &d, &d_t, &ab, &ab_c, &steps, &fused};
+    for (int t = 0; t < 9; t++) free_matrix (all[t]);
+
+    return same;
+}
+
+void test_fused_expression (void) {
+    // Малый путь, краевые плитки и параллельный путь
+    CU_ASSERT (fused_matches_steps (2, 3, 4));
+    CU_ASSERT (fused_matches_steps (67, 45, 131));
+    CU_ASSERT (fused_matches_steps (301, 277, 263));
+
+    // Несовместимые размеры D
+    Matrix a = create_matrix (2, 3), b = create_matrix (3, 4);
+    Matrix c = create_matrix (2, 4), d = create_matrix (2, 4);
+    Matrix result = create_matrix (2, 4);
+    CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&a, &b, &c, &d, &result), 1);
+    CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&a, &b, &c, NULL, &result), 1);
+    CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&a, &b, &c, &d, &a), 1);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&d);
+    free_matrix (&result);
+}
+
+// Проверяет побитовое совпадение строк двух матриц одного типа и размера
+static int same_rows (const Matrix* a, const Matrix* b) {
+    const size_t size = matrix_element_size (a->type);
+    int          same = a->rows == b->rows && a->cols == b->cols;
+
+    for (int i = 0; same && i < a->rows; i++) {
+        const char* row_a = (const char*) (a->type == MATRIX_F64 ? (void*) a->block
+                                                                 : a->elements);
+        const char* row_b = (const char*) (b->type == MATRIX_F64 ? (void*) b->block
+                                                                 : b->elements);
+        same = memcmp (row_a + (size_t) i * a->stride * size,
+                       row_b + (size_t) i * b->stride * size, a->cols * size) == 0;
+    }
+
+    return same;
+}
+
+void test_add_subtract_transposed (void) {
+    // Краевые плитки по обоим измерениям, D прямоугольная
+    const int m = 70, n = 131;
+    Matrix    c = create_matrix (m, n), d = create_matrix (n, m);
+    Matrix    steps = create_matrix (m, n), single = create_matrix (m, n);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (steps.data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (single.data);
+    fill_random (&c, 3);
+    fill_random (&d, 4);
+    fill_random (&steps, 5);
+    fill_random (&single, 5);
+
+    Matrix cf = convert_matrix_type (&c, MATRIX_F32);
+    Matrix df = convert_matrix_type (&d, MATRIX_F32);
+    Matrix sf = convert_matrix_type (&single, MATRIX_F32);
+    Matrix rf = convert_matrix_type (&single, MATRIX_F32);
+    Matrix ci = convert_matrix_type (&c, MATRIX_I32);
+    Matrix di = convert_matrix_type (&d, MATRIX_I32);
+    Matrix si = convert_matrix_type (&single, MATRIX_I32);
+    Matrix ri = convert_matrix_type (&single, MATRIX_I32);
+    CU_ASSERT_FATAL (matrix_valid (&rf) && matrix_valid (&ri));
+
+    // Один проход совпадает со сложением, транспонированием и вычитанием
+    Matrix d_t = transpose_matrix (&d);
+    CU_ASSERT_EQUAL (add_matrices (&steps, &c, &steps), 0);
+    CU_ASSERT_EQUAL (subtract_matrices (&steps, &d_t, &steps), 0);
+    CU_ASSERT_EQUAL (add_subtract_transposed (&c, &d, &single), 0);
+    CU_ASSERT (same_rows (&steps, &single));
+
+    // Результат на месте C
+    CU_ASSERT_EQUAL (add_matrices (&c, &c, &steps), 0);
+    CU_ASSERT_EQUAL (subtract_matrices (&steps, &d_t, &steps), 0);
+    CU_ASSERT_EQUAL (add_subtract_transposed (&c, &d, &c), 0);
+    CU_ASSERT (same_rows (&steps, &c));
+
+    // float и int32_t
+    Matrix df_t = transpose_matrix (&df), di_t = transpose_matrix (&di);
+    CU_ASSERT_EQUAL (add_matrices (&sf, &cf, &sf), 0);
+    CU_ASSERT_EQUAL (subtract_matrices (&sf, &df_t, &sf), 0);
+    CU_ASSERT_EQUAL (add_subtract_transposed (&cf, &df, &rf), 0);
+    CU_ASSERT (same_rows (&sf, &rf));
+    CU_ASSERT_EQUAL (add_matrices (&si, &ci, &si), 0);
+    CU_ASSERT_EQUAL (subtract_matrices (&si, &di_t, &si), 0);
+    CU_ASSERT_EQUAL (add_subtract_transposed (&ci, &di, &ri), 0);
+    CU_ASSERT (same_rows (&si, &ri));
+
+    // Ошибки: размеры D, разные типы, D пересекается с результатом, NULL
+    CU_ASSERT_EQUAL (add_subtract_transposed (&c, &c, &single), -1);
+    CU_ASSERT_EQUAL (add_subtract_transposed (&cf, &d, &single), -1);
+    CU_ASSERT_EQUAL (add_subtract_transposed (&c, &d, NULL), -1);
+    Matrix square = create_matrix (4, 4), other = create_matrix (4, 4);
+    CU_ASSERT_EQUAL (add_subtract_transposed (&other, &square, &square), -1);
+
+    Matrix* all[] = {&c,  &d,  &steps, &single, &cf,   &df,   &sf,     &rf,
+                     &ci, &di, &si,    &ri,     &d_t,  &df_t, &di_t,   &square,
+                     &other};
+    for (int t = 0; t < 17; t++) free_matrix (all[t]);
+}
+
+// Сравнивает C = alpha * A x B + beta * C с эталоном по отдельным операциям
+static int gemm_accumulates (int m, int n, int k, double alpha, double beta) {
+    Matrix a = create_matrix (m, k), b = create_matrix (k, n);
+    Matrix c = create_matrix (m, n), ab = create_matrix (m, n);
+    Matrix expected = create_matrix (m, n);
+    int    ok       = 1;
+
+    fill_random (&a, m + 1);
+    fill_random (&b, n + 2);
+    fill_random (&c, k + 3);
+
+    ok = multiply_matrices (&a, &b, &ab) == 0;
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            expected.data[i][j] = alpha * ab.data[i][j] + beta * c.data[i][j];
+            if (beta == 0) c.data[i][j] = NAN;   // Не должно читаться
+        }
+    }
+    ok = ok && gemm_matrices (alpha, &a, &b, beta, &c) == 0;
+    for (int i = 0; i < m && ok; i++) {
+        for (int j = 0; j < n && ok; j++) {
+            ok = fabs (c.data[i][j] - expected.data[i][j]) <= 1e-12 * k;
+        }
+    }
+
+    Matrix* all[] = {&a, &b, &c, &ab, &expected};
+    for (int t = 0; t < 5; t++) free_matrix (all[t]);
+
+    return ok;
+}
+
+void test_gemm_accumulate (void) {
+    // Путь без упаковки, краевые плитки, несколько блоков по k
+    CU_ASSERT (gemm_accumulates (3, 4, 5, 2.0, 1.0));
+    CU_ASSERT (gemm_accumulates (67, 45, 131, -0.5, 0.25));
+    CU_ASSERT (gemm_accumulates (301, 277, 263, 1.0, 0.0));
+    CU_ASSERT (gemm_accumulates (130, 70, 300, 3.0, -1.0));
+
+    // Накопление в C без промежуточной матрицы: C += A x B дважды
+    Matrix a = create_matrix (40, 30), b = create_matrix (30, 20);
+    Matrix c = create_matrix (40, 20), ab = create_matrix (40, 20);
+    fill_random (&a, 5);
+    fill_random (&b, 6);
+    for (int i = 0; i < 40; i++) memset (c.data[i], 0, 20 * sizeof (MATRIX_TYPE));
+    CU_ASSERT_EQUAL (multiply_matrices (&a, &b, &ab), 0);
+    CU_ASSERT_EQUAL (gemm_matrices (1, &a, &b, 1, &c), 0);
+    CU_ASSERT_EQUAL (gemm_matrices (1, &a, &b, 1, &c), 0);
+    int ok = 1;
+    for (int i = 0; i < 40; i++) {
+        for (int j = 0; j < 20; j++)
+            ok = ok && fabs (c.data[i][j] - 2 * ab.data[i][j]) <= 1e-12;
+    }
+    CU_ASSERT (ok);
+
+    // Результат не может пересекаться с множителями
+    Matrix sq = create_matrix (20, 20);
+    fill_random (&sq, 7);
+    CU_ASSERT_EQUAL (gemm_matrices (1, &sq, &sq, 0, &sq), 1);
+    CU_ASSERT_EQUAL (multiply_matrices (&sq, &sq, &sq), 1);
+    CU_ASSERT_EQUAL (gemm_matrices (1, &a, NULL, 0, &c), 1);
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&ab);
+    free_matrix (&sq);
+}
+
+void test_axpby_and_aliasing (void) {
+    Matrix x = create_matrix (9, 37), y = create_matrix (9, 37);
+    Matrix y0 = create_matrix (9, 37);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (y0.data);
+    fill_random (&x, 8);
+    fill_random (&y, 9);
+    for (int i = 0; i < 9; i++) memcpy (y0.data[i], y.data[i], 37 * sizeof (double));
+
+    CU_ASSERT_EQUAL (axpby_matrices (2.0, &x, -0.5, &y), 0);
+    int ok = 1;
+    for (int i = 0; i < 9; i++) {
+        for (int j = 0; j < 37; j++) {
+            const double want = 2.0 * x.data[i][j] - 0.5 * y0.data[i][j];
+            ok                = ok && fabs (y.data[i][j] - want) <= 1e-15;
+        }
+    }
+    CU_ASSERT (ok);
+
+    // beta = 0: прежнее содержимое не читается; X = Y: y = (alpha + beta) * y
+    for (int i = 0; i < 9; i++) y.data[i][3] = NAN;
+    CU_ASSERT_EQUAL (axpby_matrices (3.0, &x, 0, &y), 0);
+    CU_ASSERT_EQUAL (axpby_matrices (1.0, &y, 1.0, &y), 0);
+    for (int i = 0; i < 9; i++) {
+        for (int j = 0; j < 37; j++)
+            ok = ok && fabs (y.data[i][j] - 6.0 * x.data[i][j]) <= 1e-15;
+    }
+    CU_ASSERT (ok);
+
+    // Сложение и вычитание на месте: result совпадает с операндом
+    double expected[9][37];
+    for (int i = 0; i < 9; i++) {
+        for (int j = 0; j < 37; j++)
+            expected[i][j] = x.data[i][j] - (y0.data[i][j] + x.data[i][j]);
+    }
+    CU_ASSERT_EQUAL (add_matrices (&y0, &x, &y0), 0);
+    CU_ASSERT_EQUAL (subtract_matrices (&x, &y0, &y0), 0);
+    for (int i = 0; i < 9; i++) {
+        for (int j = 0; j < 37; j++) ok = ok && y0.data[i][j] == expected[i][j];
+    }
+    CU_ASSERT (ok);
+
+    // Частичное пересечение: результат сдвинут на строку относительно X
+    Matrix shifted = x;
+    shifted.rows   = 8;
+    shifted.block  = x.block + x.stride;
+    Matrix top     = x;
+    top.rows       = 8;
+    CU_ASSERT (matrices_overlap (&shifted, &top));
+    CU_ASSERT (!matrices_overlap (&x, &y));
+    CU_ASSERT_EQUAL (add_matrices (&top, &top, &shifted), -1);
+    CU_ASSERT_EQUAL (axpby_matrices (1.0, &top, 1.0, &shifted), -1);
+    CU_ASSERT_EQUAL (axpby_matrices (1.0, &x, 1.0, &top), -1);
+
+    free_matrix (&x);
+    free_matrix (&y);
+    free_matrix (&y0);
+}
+
+void test_matrix_views (void) {
+    Matrix parent = create_matrix (12, 16), a = create_matrix (4, 5);
+    Matrix b      = create_matrix (5, 4), product = create_matrix (4, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (product.data);
+    fill_random (&parent, 21);
+    fill_random (&a, 22);
+    fill_random (&b, 23);
+
+    // Представление ссылается на элементы родителя без копирования
+    Matrix view = matrix_view (&parent, 2, 3, 4, 5);
+    CU_ASSERT_PTR_NULL (view.data);
+    CU_ASSERT_PTR_EQUAL (&MATRIX_AT (&view, 1, 2), &parent.data[3][5]);
+    Matrix inner = matrix_view (&view, 1, 1, 2, 2);
+    CU_ASSERT_PTR_EQUAL (&MATRIX_AT (&inner, 0, 0), &parent.data[3][4]);
+    CU_ASSERT_PTR_NULL (matrix_view (&parent, 10, 0, 3, 1).block);
+    CU_ASSERT_PTR_NULL (matrix_view (&parent, 0, 12, 1, 5).block);
+
+    // Соседние блоки столбцов не пересекаются, блоки со сдвигом - да
+    Matrix left  = matrix_view (&parent, 0, 0, 12, 8);
+    Matrix right = matrix_view (&parent, 0, 8, 12, 8);
+    Matrix mid   = matrix_view (&parent, 1, 4, 4, 8);
+    CU_ASSERT (!matrices_overlap (&left, &right));
+    CU_ASSERT (matrices_overlap (&left, &mid) && matrices_overlap (&mid, &right));
+
+    // Операнды и результат - представления; результат пишется в родителя
+    Matrix out = matrix_view (&parent, 6, 8, 4, 5);
+    CU_ASSERT_EQUAL (add_matrices (&view, &a, &out), 0);
+    int ok = 1;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 5; j++) {
+            ok = ok && parent.data[6 + i][8 + j] == parent.data[2 + i][3 + j] +
+                                                        a.data[i][j];
+        }
+    }
+    CU_ASSERT (ok);
+
+    Matrix square = matrix_view (&parent, 8, 0, 4, 4);
+    CU_ASSERT_EQUAL (multiply_matrices (&view, &b, &product), 0);
+    CU_ASSERT_EQUAL (multiply_matrices (&view, &b, &square), 0);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++)
+            ok = ok && parent.data[8 + i][j] == product.data[i][j];
+    }
+    CU_ASSERT (ok);
+    CU_ASSERT_EQUAL (gemm_matrices (1.0, &view, &b, -1.0, &square), 0);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) ok = ok && fabs (parent.data[8 + i][j]) <= 1e-12;
+    }
+    CU_ASSERT (ok);
+    CU_ASSERT_EQUAL (gemm_matrices (1.0, &view, &b, 0, &mid), 1);
+
+    // Детерминант и транспонирование квадратного блока на месте
+    fill_random (&product, 24);
+    CU_ASSERT_EQUAL (add_matrices (&product, &product, &square), 0);
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&square), 16 * determinant (&product),
+                            1e-12);
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (&square), 0);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++)
+            ok = ok && parent.data[8 + i][j] == 2 * product.data[j][i];
+    }
+    CU_ASSERT (ok);
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (&view), -1);
+
+    // Сохранение представления - только его элементы
+    const char* filename = "test_view.txt";
+    CU_ASSERT_EQUAL (save_matrix_to_file_precision (&view, filename, -1), 0);
+    Matrix loaded = load_matrix_from_file (filename);
+    CU_ASSERT_EQUAL (loaded.rows, 4);
+    CU_ASSERT_EQUAL (loaded.cols, 5);
+    if (loaded.data) {
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 5; j++)
+                ok = ok && loaded.data[i][j] == MATRIX_AT (&view, i, j);
+        }
+    }
+    CU_ASSERT (ok);
+    free_matrix (&loaded);
+    remove (filename);
+
+    // Представление матрицы int32_t
+    Matrix ints   = create_matrix_typed (6, 6, MATRIX_I32);
+    Matrix corner = matrix_view (&ints, 3, 3, 3, 3);
+    CU_ASSERT_EQUAL (corner.type, MATRIX_I32);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) MATRIX_AT_I32 (&corner, i, j) = i == j ? 2 : 0;
+    }
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&corner), 8, 1e-12);
+    CU_ASSERT_EQUAL (MATRIX_AT_I32 (&ints, 4, 4), 2);
+
+    // Освобождение представления не затрагивает родителя
+    free_matrix (&view);
+    CU_ASSERT_PTR_NULL (view.block);
+    CU_ASSERT_PTR_NOT_NULL (parent.data);
+    CU_ASSERT_DOUBLE_EQUAL (parent.data[11][15], MATRIX_AT (&right, 11, 7), 0);
+    free_matrix (&corner);
+
+    free_matrix (&ints);
+    free_matrix (&parent);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&product);
+}
+
 void test_null_safety (void) {
     // Проверка обработки NULL указателей
     Matrix result = create_matrix (1, 1);
@@ -182,6 +740,65 @@ void test_file_operations (void) {
     remove ("test_save.txt");
 }
 
+void test_binary_file_operations (void) {
+    const char* binary   = "test_matrix.bin";
+    const char* text     = "test_matrix_converted.txt";
+    Matrix      original = create_matrix (3, 5);
+
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 5; col++) {
+            original.data[row][col] = (row * 5 + col) / 7.0;
+        }
+    }
+
+    // Сохранение и загрузка отображением без копирования
+    CU_ASSERT_EQUAL (save_matrix_to_binary_file (&original, binary), 0);
+    Matrix loaded = load_matrix_from_file (binary);
+    CU_ASSERT_PTR_NOT_NULL (loaded.data);
+    CU_ASSERT_PTR_NOT_NULL (loaded.mapping);
+    if (loaded.data) {
+        CU_ASSERT_EQUAL (loaded.rows, 3);
+        CU_ASSERT_EQUAL (loaded.cols, 5);
+        CU_ASSERT_EQUAL (loaded.stride, original.stride);
+        CU_ASSERT_EQUAL ((uintptr_t) loaded.block % MATRIX_ALIGNMENT, 0);
+        for (int row = 0; row < 3; row++) {
+            CU_ASSERT_EQUAL (memcmp (loaded.data[row], original.data[row],
+                                     5 * sizeof (MATRIX_TYPE)),
+                             0);
+        }
+
+        // Изменения отображения не попадают в файл
+        loaded.data[0][0] = 100.0;
+        Matrix again      = load_matrix_from_file (binary);
+        CU_ASSERT_PTR_NOT_NULL (again.data);
+        if (again.data) CU_ASSERT_EQUAL (again.data[0][0], original.data[0][0]);
+        free_matrix (&again);
+
+        // Матрица из отображения пригодна для вычислений
+        Matrix sum = create_matrix (3, 5);
+        CU_ASSERT_EQUAL (add_matrices (&loaded, &original, &sum), 0);
+        CU_ASSERT_EQUAL (sum.data[2][4], 2 * original.data[2][4]);
+        free_matrix (&sum);
+    }
+    free_matrix (&loaded);
+    CU_ASSERT_PTR_NULL (loaded.mapping);
+
+    // Преобразование в текст и обратно
+    CU_ASSERT_EQUAL (convert_matrix_file (binary, text), 0);
+    Matrix from_text = load_matrix_from_file (text);
+    CU_ASSERT_PTR_NOT_NULL (from_text.data);
+    CU_ASSERT_PTR_NULL (from_text.mapping);
+    if (from_text.data) CU_ASSERT_DOUBLE_EQUAL (from_text.data[1][2], 1.0, 0.001);
+    free_matrix (&from_text);
+
+    CU_ASSERT_EQUAL (convert_matrix_file (text, binary), 0);
+    CU_ASSERT_EQUAL (convert_matrix_file ("nonexistent.txt", binary), -1);
+
+    free_matrix (&original);
+    remove (binary);
+    remove (text);
+}
+
 void test_file_errors (void) {
     // Тест с несуществующим файлом
     Matrix loaded = load_matrix_from_file ("nonexistent.txt");
@@ -200,10 +817,21 @@ void test_file_errors (void) {
 void register_matrix_tests (void) {
     CU_pSuite suite = CU_add_suite ("Matrix Tests", NULL, NULL);
     CU_add_test (suite, "Matrix Creation", test_matrix_creation);
+    CU_add_test (suite, "Matrix Storage Layout", test_matrix_storage_layout);
     CU_add_test (suite, "Matrix Addition", test_matrix_addition);
     CU_add_test (suite, "Matrix Multiplication", test_matrix_multiplication);
     CU_add_test (suite, "Matrix Transpose", test_matrix_transpose);
+    CU_add_test (suite, "Matrix Transpose Large", test_matrix_transpose_large);
     CU_add_test (suite, "Matrix Determinant", test_determinant);
+    CU_add_test (suite, "Matrix Determinant LU", test_determinant_lu);
+    CU_add_test (suite, "Matrix Log Determinant", test_log_determinant);
+    CU_add_test (suite, "Matrix Fused Expression", test_fused_expression);
+    CU_add_test (suite, "Matrix Add Subtract Transposed",
+                 test_add_subtract_transposed);
+    CU_add_test (suite, "Matrix GEMM Accumulate", test_gemm_accumulate);
+    CU_add_test (suite, "Matrix AXPBY and Aliasing", test_axpby_and_aliasing);
+    CU_add_test (suite, "Matrix Views", test_matrix_views);
     CU_add_test (suite, "NULL Safety", test_null_safety);
     CU_add_test (suite, "File Operations", test_file_operations);
+    CU_add_test (suite, "Binary File Operations", test_binary_file_operations);
 }
@@ -0,0 +1,138 @@
+/**
+ * @file tests_metrics.c
+ *
+ * @brief Модуль реализации тестов для metrics.c
+ */
+
+#include "matrix/matrix.h"
+#include "metrics/metrics.h"
+
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Выполняет пустой замер операции длительностью не меньше ns наносекунд
+static void record (MetricsOp op, long ns, uint64_t read, uint64_t written) {
+    MetricsTimer    timer = metrics_begin ();
+    struct timespec delay = {0, ns};
+
+    if (ns > 0) nanosleep (&delay, NULL);
+    metrics_end (&timer, op, read, written);
+}
+
+void test_metrics_counters (void) {
+    MetricsSnapshot s;
+
+    metrics_reset ();
+    CU_ASSERT_EQUAL (metrics_snapshot (METRICS_SUBTRACT, &s), 0);
+    CU_ASSERT_EQUAL (s.calls, 0);
+    CU_ASSERT_EQUAL (s.min_ns, 0);
+    CU_ASSERT_EQUAL (metrics_snapshot (METRICS_OP_COUNT, &s), -1);
+    CU_ASSERT_PTR_NULL (metrics_name (METRICS_OP_COUNT));
+    CU_ASSERT_STRING_EQUAL (metrics_name (METRICS_MULTIPLY), "multiply");
+
+    record (METRICS_SUBTRACT, 0, 10, 5);
+    record (METRICS_SUBTRACT, 2000000, 20, 7);   // Не меньше 2 мс
+    metrics_count_allocation ();
+    record (METRICS_SUBTRACT, 0, 0, 0);
+
+    CU_ASSERT_EQUAL (metrics_snapshot (METRICS_SUBTRACT, &s), 0);
+    CU_ASSERT_EQUAL (s.calls, 3);
+    CU_ASSERT_EQUAL (s.bytes_read, 30);
+    CU_ASSERT_EQUAL (s.bytes_written, 12);
+    CU_ASSERT_EQUAL (s.allocations, 0);   // Выделение было вне замеров
+    CU_ASSERT_TRUE (s.min_ns >= 1 && s.min_ns <= s.max_ns);
+    CU_ASSERT_TRUE (s.max_ns >= 2000000);
+    CU_ASSERT_TRUE (s.total_ns >= s.max_ns + s.min_ns);
+
+    // Сумма корзин равна числу вызовов, долгий вызов - в корзине 2^20..2^21+
+    uint64_t calls = 0, slow = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        calls += s.histogram[i];
+        if (i >= 20) slow += s.histogram[i];
+    }
+    CU_ASSERT_EQUAL (calls, 3);
+    CU_ASSERT_EQUAL (slow, 1);
+
+    // Выделения внутри замера относятся к операции
+    MetricsTimer timer = metrics_begin ();
+    metrics_count_allocation ();
+    metrics_count_allocation ();
+    metrics_end (&timer, METRICS_CREATE, 0, 0);
+    CU_ASSERT_EQUAL (metrics_snapshot (METRICS_CREATE, &s), 0);
+    CU_ASSERT_EQUAL (s.allocations, 2);
+
+    metrics_reset ();
+    CU_ASSERT_EQUAL (metrics_snapshot (METRICS_SUBTRACT, &s), 0);
+    CU_ASSERT_EQUAL (s.calls, 0);
+    CU_ASSERT_EQUAL (s.max_ns, 0);
+}
+
+void test_metrics_dump (void) {
+    const char* filename = "test_metrics.json";
+    char        text[4096];
+
+    metrics_reset ();
+    record (METRICS_TRANSPOSE, 0, 64, 64);
+    CU_ASSERT_EQUAL (metrics_dump_file (filename), 0);
+
+    FILE* f = fopen (filename, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL (f);
+    size_t length = fread (text, 1, sizeof text - 1, f);
+    text[length]  = '\0';
+    fclose (f);
+
+    CU_ASSERT_PTR_NOT_NULL (strstr (text, "\"op\": \"transpose\""));
+    CU_ASSERT_PTR_NOT_NULL (strstr (text, "\"calls\": 1"));
+    CU_ASSERT_PTR_NOT_NULL (strstr (text, "\"bytes_read\": 64"));
+    CU_ASSERT_PTR_NOT_NULL (strstr (text, "\"histogram\": [{\"from_ns\": "));
+    CU_ASSERT_PTR_NULL (strstr (text, "\"op\": \"add\""));   // Не вызывалась
+    CU_ASSERT_EQUAL (text[0], '{');
+    CU_ASSERT_EQUAL (text[length - 2], '}');
+
+    CU_ASSERT_EQUAL (metrics_dump_file ("/nonexistent/dir/metrics.json"), -1);
+    metrics_reset ();
+    remove (filename);
+}
+
+void test_metrics_operations (void) {
+    MetricsSnapshot s;
+    Matrix          a = create_matrix (16, 8);
+    Matrix          b = create_matrix (16, 8);
+    Matrix          c = create_matrix (16, 8);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (c.data);
+    metrics_reset ();
+    CU_ASSERT_EQUAL (add_matrices (&a, &b, &c), 0);
+    CU_ASSERT_EQUAL (add_matrices (&a, &b, &c), 0);
+    Matrix t = transpose_matrix (&a);
+    CU_ASSERT_PTR_NOT_NULL (t.data);
+
+    // Точки замера есть только в сборке с MATRIX_METRICS
+    metrics_snapshot (METRICS_ADD, &s);
+    if (metrics_enabled ()) {
+        CU_ASSERT_EQUAL (s.calls, 2);
+        CU_ASSERT_EQUAL (s.bytes_read, 2 * 2 * 16 * 8 * sizeof (MATRIX_TYPE));
+        CU_ASSERT_EQUAL (s.bytes_written, 2 * 16 * 8 * sizeof (MATRIX_TYPE));
+        metrics_snapshot (METRICS_TRANSPOSE, &s);
+        CU_ASSERT_EQUAL (s.calls, 1);
+        CU_ASSERT_EQUAL (s.allocations, 1);   // Результирующая матрица
+    } else {
+        CU_ASSERT_EQUAL (s.calls, 0);
+    }
+
+    free_matrix (&t);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    metrics_reset ();
+}
+
+void register_metrics_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Metrics Tests", NULL, NULL);
+    CU_add_test (suite, "Counters and Histogram", test_metrics_counters);
+    CU_add_test (suite, "JSON Dump", test_metrics_dump);
+    CU_add_test (suite, "Instrumented Operations", test_metrics_operations);
+}
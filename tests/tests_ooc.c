@@ -0,0 +1,128 @@
+/**
+ * @file tests_ooc.c
+ *
+ * @brief Модуль реализации тестов для ooc.c
+ */
+
+#include "matrix/gemm.h"
+#include "matrix/matrix.h"
+#include "matrix/ooc.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Сохраняет матрицу в плиточный файл через промежуточный двоичный
+static int save_tiled (const Matrix* m, const char* filename, int tile) {
+    const char* staging = "test_ooc_staging.bin";
+    int         res     = save_matrix_to_binary_file (m, staging);
+
+    if (res == 0) res = ooc_tile_file (staging, filename, tile);
+    remove (staging);
+
+    return res;
+}
+
+void test_ooc_tiled_file (void) {
+    const char* filename = "test_ooc_tiled.bin";
+    Matrix      m        = create_matrix (70, 45);   // Неполные крайние плитки
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (m.data);
+    fill_random (&m, 3);
+    CU_ASSERT_EQUAL (save_tiled (&m, filename, 16), 0);
+
+    // Плиточный файл загружается как обычный двоичный
+    Matrix loaded = load_matrix_from_file (filename);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (loaded.data);
+    CU_ASSERT_EQUAL (loaded.rows, 70);
+    CU_ASSERT_EQUAL (loaded.cols, 45);
+    int mismatches = 0;
+    for (int i = 0; i < m.rows; i++) {
+        mismatches +=
+            memcmp (loaded.data[i], m.data[i], m.cols * sizeof (MATRIX_TYPE)) != 0;
+    }
+    CU_ASSERT_EQUAL (mismatches, 0);
+
+    free_matrix (&loaded);
+    free_matrix (&m);
+    remove (filename);
+}
+
+void test_ooc_block_shape (void) {
+    int p = 0, q = 0;
+
+    // Блок помещается в бюджет и не больше матрицы
+    const size_t budgets[] = {6 * 64 * 64 * 8, 1 << 20, 10 << 20, 1 << 30};
+    for (size_t i = 0; i < sizeof (budgets) / sizeof (budgets[0]); i++) {
+        CU_ASSERT_EQUAL (ooc_block_shape (64, 40, 7, budgets[i], &p, &q), 0);
+        CU_ASSERT_TRUE (p >= 1 && p <= 40 && q >= 1 && q <= 7);
+        CU_ASSERT_TRUE (ooc_memory (64, p, q) <= budgets[i]);
+    }
+
+    // Узкий результат: весь бюджет уходит на строки блока
+    CU_ASSERT_EQUAL (ooc_block_shape (64, 1000, 1, 1 << 20, &p, &q), 0);
+    CU_ASSERT_EQUAL (q, 1);
+    CU_ASSERT_TRUE (ooc_memory (64, p + 1, q) > (1 << 20));
+
+    CU_ASSERT_EQUAL (ooc_block_shape (64, 4, 4, 5 * 64 * 64 * 8, &p, &q), -1);
+}
+
+void test_ooc_multiply (void) {
+    const int   m = 150, n = 130, k = 110, tile = 32;
+    const char* a_file   = "test_ooc_a.bin";
+    const char* b_file   = "test_ooc_b.bin";
+    const char* c_file   = "test_ooc_c.bin";
+    Matrix      a        = create_matrix (m, k);
+    Matrix      b        = create_matrix (k, n);
+    Matrix      expected = create_matrix (m, n);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (a.data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (b.data);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (expected.data);
+    fill_random (&a, 11);
+    fill_random (&b, 12);
+    CU_ASSERT_EQUAL (multiply_matrices (&a, &b, &expected), 0);
+    CU_ASSERT_EQUAL (save_tiled (&a, a_file, tile), 0);
+    CU_ASSERT_EQUAL (save_tiled (&b, b_file, tile), 0);
+
+    // Бюджет на блок 2 x 3 плитки: несколько блоков, неполные по краям
+    const size_t budget = ooc_memory (tile, 2, 3);
+    CU_ASSERT_EQUAL (ooc_multiply (a_file, b_file, c_file, budget), 0);
+
+    Matrix c = load_matrix_from_file (c_file);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (c.data);
+    CU_ASSERT_EQUAL (c.rows, m);
+    CU_ASSERT_EQUAL (c.cols, n);
+    double error = 0;
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            double diff = fabs (c.data[i][j] - expected.data[i][j]);
+            if (diff > error) error = diff;
+        }
+    }
+    CU_ASSERT_TRUE (error <= GEMM_TOLERANCE (k) * k);
+
+    // Несогласованные размеры и слишком маленький бюджет
+    CU_ASSERT_EQUAL (ooc_multiply (b_file, b_file, c_file, budget), -1);
+    CU_ASSERT_EQUAL (ooc_multiply (a_file, b_file, c_file,
+                                   5 * tile * tile * sizeof (MATRIX_TYPE)),
+                     -1);
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&expected);
+    remove (a_file);
+    remove (b_file);
+    remove (c_file);
+}
+
+void register_ooc_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Out-of-core Tests", NULL, NULL);
+    CU_add_test (suite, "Tiled File Layout", test_ooc_tiled_file);
+    CU_add_test (suite, "Block Shape Under Budget", test_ooc_block_shape);
+    CU_add_test (suite, "Tiled Multiplication", test_ooc_multiply);
+}
@@ -7,9 +7,11 @@
 #include "../src/output/output.h"
 
 #include <CUnit/CUnit.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 // Вспомогательная функция для создания тестового файла
 void create_test_file (const char* filename, const char* content) {
@@ -125,6 +127,88 @@ void test_file_operations_integration (void) {
     remove (filename);
 }
 
+void test_output_binary_file (void) {
+    const char* filename = "test_binary.bin";
+    double      data[6]  = {1.0 / 3.0, -2.5, 1e-300, 4.0, 0.1, -0.0};
+    double      read[9]  = {0};
+
+    // Сохранение с шагом 3 и отображение обратно
+    CU_ASSERT_EQUAL (output_save_binary_file_strided (2, 2, 3, data, filename), 0);
+    CU_ASSERT_TRUE (output_is_binary_file (filename));
+
+    OutputBinaryFile file;
+    CU_ASSERT_EQUAL (output_map_binary_file (filename, &file), 0);
+    if (file.mapping) {
+        CU_ASSERT_EQUAL (file.header.rows, 2);
+        CU_ASSERT_EQUAL (file.header.cols, 2);
+        CU_ASSERT_EQUAL (file.header.stride, 3);
+        CU_ASSERT_TRUE (file.native);
+        CU_ASSERT_EQUAL ((uintptr_t) file.data % 64, 0);
+
+        // Значения совпадают побитово при любом шаге буфера
+        CU_ASSERT_EQUAL (output_read_binary_elements (&file, 4, read), 0);
+        CU_ASSERT_EQUAL (memcmp (&read[0], &data[0], 2 * sizeof (double)), 0);
+        CU_ASSERT_EQUAL (memcmp (&read[4], &data[3], 2 * sizeof (double)), 0);
+        output_unmap_binary_file (&file);
+        CU_ASSERT_PTR_NULL (file.mapping);
+    }
+
+    // Файл с обратным порядком байтов и элементами float
+    OutputBinaryHeader header = {0};
+    float              values[2];
+    uint32_t           bits[2];
+    values[0] = 1.5f;
+    values[1] = -3.0f;
+    memcpy (bits, values, sizeof bits);
+    memcpy (header.magic, OUTPUT_BINARY_MAGIC, sizeof (header.magic));
+    header.version      = __builtin_bswap32 (OUTPUT_BINARY_VERSION);
+    header.endian       = __builtin_bswap32 (OUTPUT_BINARY_ENDIAN);
+    header.element_type = __builtin_bswap32 (OUTPUT_ELEMENT_F32);
+    header.element_size = __builtin_bswap32 (sizeof (float));
+    header.rows         = (int64_t) __builtin_bswap64 (1);
+    header.cols         = (int64_t) __builtin_bswap64 (2);
+    header.stride       = (int64_t) __builtin_bswap64 (2);
+    header.data_offset  = __builtin_bswap64 (OUTPUT_BINARY_HEADER_SIZE);
+    bits[0]             = __builtin_bswap32 (bits[0]);
+    bits[1]             = __builtin_bswap32 (bits[1]);
+
+    FILE* f = fopen (filename, "wb");
+    if (f) {
+        fwrite (&header, sizeof header, 1, f);
+        fwrite (bits, sizeof bits, 1, f);
+        fclose (f);
+    }
+    CU_ASSERT_EQUAL (output_map_binary_file (filename, &file), 0);
+    if (file.mapping) {
+        CU_ASSERT_FALSE (file.native);
+        CU_ASSERT_EQUAL (file.header.cols, 2);
+        CU_ASSERT_EQUAL (output_read_binary_elements (&file, 2, read), 0);
+        CU_ASSERT_EQUAL (read[0], 1.5);
+        CU_ASSERT_EQUAL (read[1], -3.0);
+        output_unmap_binary_file (&file);
+    }
+
+    // Обрезанный файл: данные выходят за его конец
+    CU_ASSERT_EQUAL (output_save_binary_file_strided (2, 2, 2, data, filename), 0);
+    CU_ASSERT_EQUAL (truncate (filename, OUTPUT_BINARY_HEADER_SIZE + 8), 0);
+    CU_ASSERT_EQUAL (output_map_binary_file (filename, &file), -1);
+    CU_ASSERT_PTR_NULL (file.mapping);
+
+    // Текстовый и несуществующий файлы не считаются двоичными
+    create_test_file (filename, "2 2\n1 2\n3 4\n");
+    CU_ASSERT_FALSE (output_is_binary_file (filename));
+    CU_ASSERT_FALSE (output_is_binary_file ("nonexistent.bin"));
+    CU_ASSERT_EQUAL (output_map_binary_file (filename, &file), -1);
+
+    // Ошибки записи
+    CU_ASSERT_EQUAL (output_save_binary_file_strided (2, 2, 2, NULL, filename), -1);
+    CU_ASSERT_EQUAL (output_save_binary_file_strided (2, 3, 2, data, filename), -1);
+    CU_ASSERT_EQUAL (
+        output_save_binary_file_strided (2, 2, 2, data, "/invalid/path/m.bin"), -1);
+
+    remove (filename);
+}
+
 void register_output_tests (void) {
     CU_pSuite suite = CU_add_suite ("Output Tests", NULL, NULL);
     CU_add_test (suite, "Print Matrix", test_output_print_matrix);
@@ -132,4 +216,5 @@ void register_output_tests (void) {
     CU_add_test (suite, "Load Matrix from File", test_output_load_matrix_from_file);
     CU_add_test (suite, "File Operations Integration",
                  test_file_operations_integration);
+    CU_add_test (suite, "Binary File", test_output_binary_file);
 }
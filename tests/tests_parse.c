@@ -0,0 +1,133 @@
+/**
+ * @file tests_parse.c
+ *
+ * @brief Модуль реализации тестов для parse.c
+ */
+
+#include "output/output.h"
+#include "output/parse.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Сравнивает parse_double со strtod побитово; 1 при совпадении
+static int same_as_strtod (const char* text) {
+    const size_t length = strlen (text);
+    double       parsed = 0, expected = 0;
+    char*        stop   = NULL;
+
+    expected = strtod (text, &stop);
+
+    return parse_double (text, text + length, &parsed) == length &&
+           stop == text + length && memcmp (&parsed, &expected, sizeof parsed) == 0;
+}
+
+void test_parse_exact (void) {
+    const char* cases[] = {
+        "0", "-0", "+1", "1.5", "0.1", "-123.45", ".5", "5.", "1e10", "1E-10",
+        "0.30000000000000004", "9007199254740993", "4503599627370497.5",
+        "1.7976931348623157e308", "1.7976931348623159e308", "1e309", "4.9e-324",
+        "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-400",
+        "2.2250738585072011e-308", "2.2250738585072014e-308", "1e23",
+        "123456789012345678901234567890", "0.000000000000000000000012345678901",
+        "1.00000000000000011102230246251565404236316680908203125", "inf",
+        "-nan", "0x1.8p3"};
+    uint64_t state = 88172645463325252u;
+    char     text[64];
+    int      mismatches = 0;
+
+    for (size_t i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        CU_ASSERT_TRUE (same_as_strtod (cases[i]));
+    }
+
+    // Случайные числа с 1-17 значащими цифрами и с двумя знаками после точки
+    for (int i = 0; i < 100000; i++) {
+        uint64_t bits = next_random (&state);
+        double   value;
+        memcpy (&value, &bits, sizeof value);
+        if (value != value || value - value != 0) continue;   // nan и inf
+
+        snprintf (text, sizeof text, "%.*g", (int) (bits % 17) + 1, value);
+        mismatches += !same_as_strtod (text);
+        snprintf (text, sizeof text, "%.2f", (double) (int64_t) (bits >> 40) / 100);
+        mismatches += !same_as_strtod (text);
+    }
+    CU_ASSERT_EQUAL (mismatches, 0);
+}
+
+void test_parse_invalid (void) {
+    const char* cases[] = {"", "-", ".", "e5", "1e", "1.5x", "--1", "1..2", "abc"};
+    double      value   = 0;
+
+    for (size_t i = 0; i < sizeof (cases) / sizeof (cases[0]); i++) {
+        const char* end = cases[i] + strlen (cases[i]);
+        CU_ASSERT_EQUAL (parse_double (cases[i], end, &value), 0);
+    }
+
+    // Число заканчивается на пробеле, а не на конце строки
+    const char* text = "2.5e3 7";
+    CU_ASSERT_EQUAL (parse_double (text, text + strlen (text), &value), 5);
+    CU_ASSERT_EQUAL (value, 2500.0);
+
+    // Конец данных обрывает число, даже если дальше есть символы
+    CU_ASSERT_EQUAL (parse_double (text, text + 4, &value), 0);
+    CU_ASSERT_EQUAL (parse_double (text, text + 3, &value), 3);
+    CU_ASSERT_EQUAL (value, 2.5);
+}
+
+void test_parse_matrix_file (void) {
+    const char* filename = "test_parse.txt";
+    const int   rows = 300, cols = 400;   // Больше одного блока чтения
+    uint64_t    state = 12345;
+    double*     expected = malloc ((size_t) rows * cols * sizeof (double));
+    FILE*       f        = fopen (filename, "w");
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (expected);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (f);
+    fprintf (f, "%d %d\n", rows, cols);
+    for (int i = 0; i < rows * cols; i++) {
+        char   text[32];
+        double value = ((double) (next_random (&state) >> 11) - 4503599627370496.0) /
+                       (double) (1 + i % 1000);
+        snprintf (text, sizeof text, "%.17g", value);
+        expected[i] = strtod (text, NULL);
+        fprintf (f, "%s%s", text, (i + 1) % cols ? (i % 3 ? " " : "\t ") : "\r\n");
+    }
+    fclose (f);
+
+    int     r, c;
+    double* data = output_load_matrix_from_file (&r, &c, filename);
+    CU_ASSERT_PTR_NOT_NULL (data);
+    if (data) {
+        CU_ASSERT_EQUAL (r, rows);
+        CU_ASSERT_EQUAL (c, cols);
+        const size_t bytes = (size_t) rows * cols * sizeof (double);
+        CU_ASSERT_EQUAL (memcmp (data, expected, bytes), 0);
+        free (data);
+    }
+
+    // Ошибка в середине файла и нехватка элементов
+    f = fopen (filename, "w");
+    fprintf (f, "2 3\n1 2 3\n4 5x 6\n");
+    fclose (f);
+    CU_ASSERT_PTR_NULL (output_load_matrix_from_file (&r, &c, filename));
+
+    f = fopen (filename, "w");
+    fprintf (f, "2 3\n1 2 3\n4 5");
+    fclose (f);
+    CU_ASSERT_PTR_NULL (output_load_matrix_from_file (&r, &c, filename));
+
+    free (expected);
+    remove (filename);
+}
+
+void register_parse_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Parse Tests", NULL, NULL);
+    CU_add_test (suite, "Bit-exact Parsing", test_parse_exact);
+    CU_add_test (suite, "Invalid Numbers", test_parse_invalid);
+    CU_add_test (suite, "Matrix File Parsing", test_parse_matrix_file);
+}
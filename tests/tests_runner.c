@@ -10,6 +10,23 @@
 // Объявления тестовых функций
 void register_matrix_tests (void);
 void register_output_tests (void);
+void register_gemm_tests (void);
+void register_simd_tests (void);
+void register_thread_pool_tests (void);
+void register_strassen_tests (void);
+void register_expr_tests (void);
+void register_parse_tests (void);
+void register_format_tests (void);
+void register_ooc_tests (void);
+void register_arena_tests (void);
+void register_metrics_tests (void);
+void register_sparse_tests (void);
+void register_batch_tests (void);
+void register_small_tests (void);
+void register_typed_tests (void);
+void register_loader_tests (void);
+void register_jobs_tests (void);
+void register_cache_tests (void);
 void test_file_operations (void);
 void test_file_operations_integration (void);
 
@@ -22,6 +39,23 @@ int main (void) {
     // Регистрация всех тестовых сьют
     register_matrix_tests ();
     register_output_tests ();
+    register_gemm_tests ();
+    register_simd_tests ();
+    register_thread_pool_tests ();
+    register_strassen_tests ();
+    register_expr_tests ();
+    register_parse_tests ();
+    register_format_tests ();
+    register_ooc_tests ();
+    register_arena_tests ();
+    register_metrics_tests ();
+    register_sparse_tests ();
+    register_batch_tests ();
+    register_small_tests ();
+    register_typed_tests ();
+    register_loader_tests ();
+    register_jobs_tests ();
+    register_cache_tests ();
 
     // Сьют для файловых операций
     CU_pSuite fileSuite = CU_add_suite ("File Operations", NULL, NULL);
@@ -0,0 +1,179 @@
+/**
+ * @file tests_simd.c
+ *
+ * @brief Модуль реализации тестов для simd.c и ядер simd_*.c
+ */
+
+#include "matrix/gemm.h"
+#include "matrix/matrix.h"
+#include "matrix/simd.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Проверяет операции активного уровня на матрицах нецелого числа плиток
+static int check_active_level (void) {
+    const int rows = 37, cols = 29, inner = 41;
+    Matrix    a      = create_matrix (rows, cols);
+    Matrix    b      = create_matrix (rows, cols);
+    Matrix    c      = create_matrix (cols, inner);
+    Matrix    sum    = create_matrix (rows, cols);
+    Matrix    diff   = create_matrix (rows, cols);
+    Matrix    prod   = create_matrix (rows, inner);
+    Matrix    expect = create_matrix (rows, inner);
+    int       ok     = 1;
+
+    fill_random (&a, 11);
+    fill_random (&b, 12);
+    fill_random (&c, 13);
+
+    ok = ok && add_matrices (&a, &b, &sum) == 0;
+    ok = ok && subtract_matrices (&a, &b, &diff) == 0;
+    ok = ok && multiply_matrices (&a, &c, &prod) == 0;
+    Matrix t = transpose_matrix (&a);
+    ok       = ok && t.data != NULL;
+
+    for (int i = 0; i < rows && ok; i++) {
+        for (int j = 0; j < cols && ok; j++) {
+            ok = sum.data[i][j] == a.data[i][j] + b.data[i][j] &&
+                 diff.data[i][j] == a.data[i][j] - b.data[i][j] &&
+                 t.data[j][i] == a.data[i][j];
+        }
+    }
+
+    // Вычитание произведения: FMA отличается от mul + sub на одно округление
+    const SimdOps*     ops = simd_ops ();
+    MATRIX_TYPE        acc[41];
+    const MATRIX_TYPE* x = c.data[1];
+    const MATRIX_TYPE* y = c.data[2];
+    for (int i = 0; i < inner; i++) acc[i] = c.data[0][i];
+    ops->mul_sub (inner, x, y, acc);
+    for (int i = 0; i < inner && ok; i++) {
+        ok = fabs (acc[i] - (c.data[0][i] - x[i] * y[i])) <= 1e-15;
+    }
+
+    // Пакетное умножение 16 матриц 3 x 2 на 2 x 5: блок столбцов и хвост
+    enum { LEN = 2 * SIMD_BATCH_LANES, M = 3, K = 2, N = 5 };
+    MATRIX_TYPE ba[M * K * LEN], bb[K * N * LEN], bc[M * N * LEN];
+    for (int i = 0; i < M * K * LEN; i++) ba[i] = c.data[i / inner][i % inner];
+    for (int i = 0; i < K * N * LEN; i++) bb[i] = b.data[i / cols][i % cols];
+    ops->batch_gemm (LEN, M, N, K, ba, LEN, bb, LEN, bc, LEN);
+    for (int i = 0; i < M * N && ok; i++) {
+        for (int l = 0; l < LEN && ok; l++) {
+            MATRIX_TYPE s = 0;
+            for (int p = 0; p < K; p++) {
+                s += ba[(i / N * K + p) * LEN + l] * bb[(p * N + i % N) * LEN + l];
+            }
+            ok = fabs (bc[i * LEN + l] - s) <= 1e-15;
+        }
+    }
+
+    // Строки float длиной 41: полные векторы и хвост
+    float fa[41], fb[41], fs[41], fd[41], fy[41];
+    for (int i = 0; i < inner; i++) {
+        fa[i] = (float) x[i];
+        fb[i] = (float) y[i];
+        fy[i] = fb[i];
+    }
+    ops->add_f32 (inner, fa, fb, fs);
+    ops->sub_f32 (inner, fa, fb, fd);
+    ops->axpy_f32 (inner, 0.5f, fa, fy);
+    for (int i = 0; i < inner && ok; i++) {
+        ok = fs[i] == fa[i] + fb[i] && fd[i] == fa[i] - fb[i] &&
+             fabsf (fy[i] - (fb[i] + 0.5f * fa[i])) <= 1e-6f;
+    }
+
+    // Целочисленное накопление с переполнением по модулю 2^32
+    int32_t ix[41], iy[41];
+    for (int i = 0; i < inner; i++) {
+        ix[i] = (int32_t) (x[i] * 1e9);
+        iy[i] = i - 20;
+    }
+    ops->axpy_i32 (inner, 7, ix, iy);
+    for (int i = 0; i < inner && ok; i++) {
+        ok = iy[i] == (int32_t) ((uint32_t) (i - 20) + 7u * (uint32_t) ix[i]);
+    }
+
+    // Линейная комбинация строк double: FMA - на одно округление точнее
+    MATRIX_TYPE z[41];
+    for (int i = 0; i < inner; i++) z[i] = y[i];
+    ops->axpby (inner, 0.75, x, -2.0, z);
+    for (int i = 0; i < inner && ok; i++) {
+        ok = fabs (z[i] - (0.75 * x[i] - 2.0 * y[i])) <= 1e-15;
+    }
+
+    gemm_reference (rows, inner, cols, a.block, a.stride, c.block, c.stride,
+                    expect.block, expect.stride);
+    for (int i = 0; i < rows && ok; i++) {
+        for (int j = 0; j < inner && ok; j++) {
+            ok = fabs (prod.data[i][j] - expect.data[i][j]) <=
+                 GEMM_TOLERANCE (cols) * cols;
+        }
+    }
+
+    // Умножение float микроядром уровня - в пределах точности float
+    Matrix af = convert_matrix_type (&a, MATRIX_F32);
+    Matrix cf = convert_matrix_type (&c, MATRIX_F32);
+    Matrix pf = create_matrix_typed (rows, inner, MATRIX_F32);
+    ok        = ok && multiply_matrices (&af, &cf, &pf) == 0;
+    for (int i = 0; i < rows && ok; i++) {
+        for (int j = 0; j < inner && ok; j++) {
+            ok = fabs (MATRIX_AT_F32 (&pf, i, j) - expect.data[i][j]) <=
+                 4.0 * cols * FLT_EPSILON;
+        }
+    }
+    free_matrix (&af);
+    free_matrix (&cf);
+    free_matrix (&pf);
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c);
+    free_matrix (&sum);
+    free_matrix (&diff);
+    free_matrix (&prod);
+    free_matrix (&expect);
+    free_matrix (&t);
+
+    return ok;
+}
+
+void test_simd_dispatch (void) {
+    const SimdOps* ops = simd_ops ();
+    CU_ASSERT_PTR_NOT_NULL (ops);
+    if (ops) {
+        CU_ASSERT (ops->level <= simd_detect_level ());
+        CU_ASSERT (ops->gemm->mr <= GEMM_MAX_MR);
+        CU_ASSERT (ops->gemm->nr <= GEMM_MAX_NR);
+        CU_ASSERT (ops->gemm_f32->mr <= GEMM_MAX_MR);
+        CU_ASSERT (ops->gemm_f32->nr <= GEMM_MAX_NR);
+    }
+
+    CU_ASSERT_PTR_NOT_NULL (simd_ops_for_level (SIMD_SCALAR));
+    CU_ASSERT_EQUAL (simd_set_level (SIMD_LEVEL_COUNT), -1);
+    CU_ASSERT_PTR_NULL (simd_level_name (SIMD_LEVEL_COUNT));
+}
+
+void test_simd_levels_match_scalar (void) {
+    const SimdLevel initial = simd_ops ()->level;
+
+    // Каждый доступный уровень дает тот же результат, что и скалярный
+    for (int level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; level++) {
+        if (simd_set_level ((SimdLevel) level) == 0) {
+            CU_ASSERT (check_active_level ());
+        }
+    }
+
+    simd_set_level (initial);
+}
+
+void register_simd_tests (void) {
+    CU_pSuite suite = CU_add_suite ("SIMD Tests", NULL, NULL);
+    CU_add_test (suite, "SIMD Dispatch", test_simd_dispatch);
+    CU_add_test (suite, "SIMD Levels Match Scalar", test_simd_levels_match_scalar);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file tests_small.c
+ *
+ * @brief Модуль реализации тестов для small.c
+ */
+
+#include "matrix/gemm.h"
+#include "matrix/matrix.h"
+#include "matrix/small.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdlib.h>
+
+void test_small_multiply (void) {
+    for (int n = 2; n <= SMALL_MAX_SIZE; n++) {
+        Matrix A = create_matrix (n, n), B = create_matrix (n, n);
+        Matrix C = create_matrix (n, n), D = create_matrix (n, n);
+        Matrix R = create_matrix (n, n), E = create_matrix (n, n);
+        Matrix F = create_matrix (n, n);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (F.data);
+        fill_random (&A, n);
+        fill_random (&B, n + 10);
+        fill_random (&C, n + 20);
+        fill_random (&D, n + 30);
+
+        // Произведение - в том же порядке слагаемых, что и эталон
+        gemm_reference (n, n, n, A.block, A.stride, B.block, B.stride, E.block,
+                        E.stride);
+        CU_ASSERT_EQUAL (multiply_matrices (&A, &B, &R), 0);
+        int ok = 1;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) ok = ok && R.data[i][j] == E.data[i][j];
+        }
+        CU_ASSERT_TRUE (ok);
+
+        // Слитое выражение совпадает с последовательными операциями
+        CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&A, &B, &C, &D, &R), 0);
+        Matrix Dt = transpose_matrix (&D);
+        CU_ASSERT_EQUAL (add_matrices (&E, &C, &F), 0);
+        CU_ASSERT_EQUAL (subtract_matrices (&F, &Dt, &F), 0);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                ok = ok && R.data[i][j] == F.data[i][j] &&
+                     Dt.data[i][j] == D.data[j][i];
+            }
+        }
+        CU_ASSERT_TRUE (ok);
+
+        // Результат может совпадать с операндом
+        CU_ASSERT_EQUAL (small_multiply (n, n, n, A.block, A.stride, B.block,
+                                         B.stride, A.block, A.stride, NULL),
+                         0);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) ok = ok && A.data[i][j] == E.data[i][j];
+        }
+        CU_ASSERT_TRUE (ok);
+
+        free_matrix (&A);
+        free_matrix (&B);
+        free_matrix (&C);
+        free_matrix (&D);
+        free_matrix (&R);
+        free_matrix (&E);
+        free_matrix (&F);
+        free_matrix (&Dt);
+    }
+
+    // Для прочих размеров ядра нет
+    MATRIX_TYPE x[25] = {0};
+    CU_ASSERT_EQUAL (small_multiply (5, 5, 5, x, 5, x, 5, x, 5, NULL), -1);
+    CU_ASSERT_EQUAL (small_multiply (2, 3, 2, x, 3, x, 3, x, 3, NULL), -1);
+    CU_ASSERT_EQUAL (small_multiply (1, 1, 1, x, 1, x, 1, x, 1, NULL), -1);
+}
+
+void test_small_elementwise (void) {
+    for (int n = 2; n <= SMALL_MAX_SIZE; n++) {
+        Matrix A = create_matrix (n, n), B = create_matrix (n, n);
+        Matrix S = create_matrix (n, n), T = create_matrix (n, n);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (T.data);
+        fill_random (&A, n);
+        fill_random (&B, n + 10);
+
+        CU_ASSERT_EQUAL (add_matrices (&A, &B, &S), 0);
+        CU_ASSERT_EQUAL (subtract_matrices (&A, &B, &T), 0);
+        int ok = 1;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                ok = ok && S.data[i][j] == A.data[i][j] + B.data[i][j] &&
+                     T.data[i][j] == A.data[i][j] - B.data[i][j];
+            }
+        }
+        CU_ASSERT_TRUE (ok);
+
+        // Транспонирование на месте - без буфера
+        Matrix At = transpose_matrix (&A);
+        CU_ASSERT_EQUAL (transpose_matrix_inplace (&A), 0);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) ok = ok && A.data[i][j] == At.data[i][j];
+        }
+        CU_ASSERT_TRUE (ok);
+
+        free_matrix (&A);
+        free_matrix (&B);
+        free_matrix (&S);
+        free_matrix (&T);
+        free_matrix (&At);
+    }
+
+    MATRIX_TYPE x[6] = {0};
+    CU_ASSERT_EQUAL (small_add (2, 3, x, 3, x, 3, x, 3), -1);
+    CU_ASSERT_EQUAL (small_subtract (3, 2, x, 2, x, 2, x, 2), -1);
+    CU_ASSERT_EQUAL (small_transpose (2, 3, x, 3, x, 2), -1);
+}
+
+void test_small_determinant (void) {
+    // Замкнутая форма совпадает с LU-разложением
+    for (int n = 2; n <= SMALL_MAX_SIZE; n++) {
+        Matrix A = create_matrix (n, n);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (A.data);
+        for (unsigned seed = 1; seed <= 20; seed++) {
+            fill_random (&A, seed * 7 + n);
+            int    sign    = 0;
+            double log_det = log_determinant (&A, &sign);
+            CU_ASSERT_DOUBLE_EQUAL (determinant (&A), sign * exp (log_det), 1e-12);
+        }
+        free_matrix (&A);
+    }
+
+    // Перестановка строк 4 x 4 с нечетным числом транспозиций
+    const double perm[4][4] = {
+        {0, 1, 0, 0}, {0, 0, 0, 1}, {1, 0, 0, 0}, {0, 0, 1, 0}};
+    Matrix P = create_matrix (4, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (P.data);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) P.data[i][j] = perm[i][j];
+    }
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&P), -1, 1e-15);
+
+    // Вырожденная 3 x 3: третья строка - сумма первых двух
+    const double rows[3][3] = {{1, 2, 3}, {4, 5, 6}, {5, 7, 9}};
+    MATRIX_TYPE  det        = 1;
+    CU_ASSERT_EQUAL (small_determinant (3, &rows[0][0], 3, &det), 0);
+    CU_ASSERT_DOUBLE_EQUAL (det, 0, 1e-12);
+    CU_ASSERT_EQUAL (small_determinant (5, &rows[0][0], 3, &det), -1);
+
+    free_matrix (&P);
+}
+
+void register_small_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Small Kernel Tests", NULL, NULL);
+    CU_add_test (suite, "Multiply and Fused", test_small_multiply);
+    CU_add_test (suite, "Add Subtract Transpose", test_small_elementwise);
+    CU_add_test (suite, "Closed-form Determinant", test_small_determinant);
+}
@@ -0,0 +1,266 @@
+/**
+ * @file tests_sparse.c
+ *
+ * @brief Модуль реализации тестов для sparse.c
+ */
+
+#include "matrix/matrix.h"
+#include "matrix/sparse.h"
+#include "parallel/thread_pool.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Заполняет матрицу так, что ненулевой примерно каждый period-й элемент
+static void fill_sparse (Matrix* m, int period, unsigned seed) {
+    srand (seed);
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            int nonzero   = rand () % period == 0;
+            m->data[i][j] = nonzero ? 2.0 * rand () / RAND_MAX - 1.0 : 0;
+        }
+    }
+}
+
+// Наибольшее отклонение между первыми rows x cols элементами матриц
+static double max_difference (const Matrix* a, const Matrix* b) {
+    double diff = 0;
+    for (int i = 0; i < a->rows; i++) {
+        for (int j = 0; j < a->cols; j++) {
+            diff = fmax (diff, fabs (a->data[i][j] - b->data[i][j]));
+        }
+    }
+    return diff;
+}
+
+// Проверяет, что номера столбцов в строках строго возрастают
+static int columns_sorted (const SparseMatrix* s) {
+    int sorted = s->row_ptr[0] == 0 && s->row_ptr[s->rows] == s->nnz;
+    for (int i = 0; i < s->rows; i++) {
+        for (size_t p = s->row_ptr[i] + 1; p < s->row_ptr[i + 1]; p++)
+            sorted = sorted && s->col_idx[p - 1] < s->col_idx[p];
+    }
+    return sorted;
+}
+
+void test_sparse_conversion (void) {
+    Matrix m = create_matrix (37, 53);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (m.data);
+    fill_sparse (&m, 10, 1);
+
+    double density = matrix_density (&m);
+    CU_ASSERT_TRUE (density > 0.05 && density < 0.2);
+
+    // Порог плотности: слишком плотная матрица не преобразуется
+    SparseMatrix rejected = sparse_from_dense (&m, density / 2);
+    CU_ASSERT_PTR_NULL (rejected.row_ptr);
+
+    SparseMatrix s = sparse_from_dense (&m, density);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (s.row_ptr);
+    CU_ASSERT_EQUAL (s.rows, 37);
+    CU_ASSERT_EQUAL (s.cols, 53);
+    CU_ASSERT_EQUAL (s.nnz, (size_t) (density * 37 * 53 + 0.5));
+    CU_ASSERT_TRUE (columns_sorted (&s));
+
+    Matrix back = sparse_to_dense (&s);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (back.data);
+    CU_ASSERT_EQUAL (max_difference (&m, &back), 0);
+
+    // Нулевая матрица
+    Matrix zero = create_matrix (4, 4);
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) zero.data[i][j] = 0;
+    CU_ASSERT_EQUAL (matrix_density (&zero), 0);
+    SparseMatrix empty = sparse_from_dense (&zero, 0);
+    CU_ASSERT_PTR_NOT_NULL (empty.row_ptr);
+    CU_ASSERT_EQUAL (empty.nnz, 0);
+
+    CU_ASSERT_EQUAL (matrix_density (NULL), -1);
+    CU_ASSERT_PTR_NULL (sparse_create (0, 3, 0).row_ptr);
+
+    sparse_free (&empty);
+    sparse_free (&s);
+    sparse_free (&s);   // Повторное освобождение безопасно
+    CU_ASSERT_PTR_NULL (s.values);
+    free_matrix (&zero);
+    free_matrix (&back);
+    free_matrix (&m);
+}
+
+void test_sparse_multiply_dense (void) {
+    const int m = 70, k = 90, n = 45;
+    Matrix    A = create_matrix (m, k), B = create_matrix (k, n);
+    Matrix    expected = create_matrix (m, n), result = create_matrix (m, n);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (result.data);
+    fill_sparse (&A, 20, 2);
+    fill_sparse (&B, 1, 3);   // Плотная
+    CU_ASSERT_EQUAL (multiply_matrices (&A, &B, &expected), 0);
+
+    // Разреженная слева
+    SparseMatrix sa = sparse_from_dense (&A, 1);
+    CU_ASSERT_EQUAL (sparse_multiply_dense (&sa, &B, &result), 0);
+    CU_ASSERT_TRUE (max_difference (&expected, &result) < 1e-12);
+
+    // Разреженная справа: B^T x A^T = (A x B)^T
+    Matrix       Bt = transpose_matrix (&B), At = transpose_matrix (&A);
+    SparseMatrix st = sparse_from_dense (&At, 1);
+    Matrix       expected_t = transpose_matrix (&expected);
+    Matrix       result_t   = create_matrix (n, m);
+    CU_ASSERT_EQUAL (dense_multiply_sparse (&Bt, &st, &result_t), 0);
+    CU_ASSERT_TRUE (max_difference (&expected_t, &result_t) < 1e-12);
+
+    // Умножение на вектор (SpMV)
+    Matrix x = create_matrix (k, 1), y = create_matrix (m, 1);
+    Matrix y_ref = create_matrix (m, 1);
+    fill_sparse (&x, 1, 4);
+    CU_ASSERT_EQUAL (multiply_matrices (&A, &x, &y_ref), 0);
+    CU_ASSERT_EQUAL (sparse_multiply_dense (&sa, &x, &y), 0);
+    CU_ASSERT_TRUE (max_difference (&y_ref, &y) < 1e-12);
+
+    // Несовместимые размеры
+    CU_ASSERT_EQUAL (sparse_multiply_dense (&sa, &A, &result), -1);
+    CU_ASSERT_EQUAL (dense_multiply_sparse (&A, &sa, &result), -1);
+    CU_ASSERT_EQUAL (sparse_multiply_dense (NULL, &B, &result), -1);
+
+    sparse_free (&sa);
+    sparse_free (&st);
+    free_matrix (&A);
+    free_matrix (&B);
+    free_matrix (&At);
+    free_matrix (&Bt);
+    free_matrix (&x);
+    free_matrix (&y);
+    free_matrix (&y_ref);
+    free_matrix (&expected);
+    free_matrix (&expected_t);
+    free_matrix (&result);
+    free_matrix (&result_t);
+}
+
+void test_sparse_multiply_parallel (void) {
+    const int n = 300;
+    Matrix    A = create_matrix (n, n), B = create_matrix (n, n);
+    Matrix    expected = create_matrix (n, n), result = create_matrix (n, n);
+    int       threads = thread_pool_threads ();
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (result.data);
+    fill_sparse (&A, 3, 5);
+    fill_sparse (&B, 1, 6);
+    CU_ASSERT_EQUAL (multiply_matrices (&A, &B, &expected), 0);
+
+    // Полосы строк на нескольких потоках дают тот же результат
+    SparseMatrix sa = sparse_from_dense (&A, 1);
+    thread_pool_set_threads (4);
+    CU_ASSERT_EQUAL (sparse_multiply_dense (&sa, &B, &result), 0);
+    CU_ASSERT_TRUE (max_difference (&expected, &result) < 1e-11);
+    SparseMatrix sb = sparse_from_dense (&A, 1);
+    CU_ASSERT_EQUAL (dense_multiply_sparse (&B, &sb, &result), 0);
+    CU_ASSERT_EQUAL (multiply_matrices (&B, &A, &expected), 0);
+    CU_ASSERT_TRUE (max_difference (&expected, &result) < 1e-11);
+    thread_pool_set_threads (threads);
+
+    sparse_free (&sa);
+    sparse_free (&sb);
+    free_matrix (&A);
+    free_matrix (&B);
+    free_matrix (&expected);
+    free_matrix (&result);
+}
+
+void test_sparse_multiply_sparse (void) {
+    const int m = 64, k = 80, n = 50;
+    Matrix    A = create_matrix (m, k), B = create_matrix (k, n);
+    Matrix    expected = create_matrix (m, n);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (expected.data);
+    fill_sparse (&A, 8, 7);
+    fill_sparse (&B, 6, 8);
+    CU_ASSERT_EQUAL (multiply_matrices (&A, &B, &expected), 0);
+
+    SparseMatrix sa = sparse_from_dense (&A, 1), sb = sparse_from_dense (&B, 1);
+    SparseMatrix sc = sparse_multiply (&sa, &sb);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (sc.row_ptr);
+    CU_ASSERT_EQUAL (sc.rows, m);
+    CU_ASSERT_EQUAL (sc.cols, n);
+    CU_ASSERT_TRUE (columns_sorted (&sc));
+
+    Matrix result = sparse_to_dense (&sc);
+    CU_ASSERT_TRUE (max_difference (&expected, &result) < 1e-12);
+
+    // Несовместимые размеры
+    CU_ASSERT_PTR_NULL (sparse_multiply (&sb, &sb).row_ptr);
+
+    sparse_free (&sa);
+    sparse_free (&sb);
+    sparse_free (&sc);
+    free_matrix (&A);
+    free_matrix (&B);
+    free_matrix (&expected);
+    free_matrix (&result);
+}
+
+void test_sparse_add_subtract_transpose (void) {
+    Matrix A = create_matrix (33, 41), B = create_matrix (33, 41);
+    Matrix sum = create_matrix (33, 41), diff = create_matrix (33, 41);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL (diff.data);
+    fill_sparse (&A, 5, 9);
+    fill_sparse (&B, 4, 10);
+    CU_ASSERT_EQUAL (add_matrices (&A, &B, &sum), 0);
+    CU_ASSERT_EQUAL (subtract_matrices (&A, &B, &diff), 0);
+
+    SparseMatrix sa = sparse_from_dense (&A, 1), sb = sparse_from_dense (&B, 1);
+    SparseMatrix ss = sparse_add (&sa, &sb), sd = sparse_subtract (&sa, &sb);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (ss.row_ptr);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (sd.row_ptr);
+    CU_ASSERT_TRUE (columns_sorted (&ss));
+    CU_ASSERT_EQUAL (ss.nnz, sd.nnz);
+
+    Matrix ds = sparse_to_dense (&ss), dd = sparse_to_dense (&sd);
+    CU_ASSERT_EQUAL (max_difference (&sum, &ds), 0);
+    CU_ASSERT_EQUAL (max_difference (&diff, &dd), 0);
+
+    // A - A: структура сохраняется, значения нулевые
+    SparseMatrix zero = sparse_subtract (&sa, &sa);
+    CU_ASSERT_EQUAL (zero.nnz, sa.nnz);
+    for (size_t p = 0; p < zero.nnz; p++) CU_ASSERT_EQUAL (zero.values[p], 0);
+
+    // Транспонирование (CSR -> CSC)
+    Matrix       At = transpose_matrix (&A);
+    SparseMatrix st = sparse_transpose (&sa);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (st.row_ptr);
+    CU_ASSERT_EQUAL (st.rows, 41);
+    CU_ASSERT_EQUAL (st.cols, 33);
+    CU_ASSERT_TRUE (columns_sorted (&st));
+    Matrix dt = sparse_to_dense (&st);
+    CU_ASSERT_EQUAL (max_difference (&At, &dt), 0);
+
+    CU_ASSERT_PTR_NULL (sparse_add (&sa, &st).row_ptr);   // Разные размеры
+
+    sparse_free (&sa);
+    sparse_free (&sb);
+    sparse_free (&ss);
+    sparse_free (&sd);
+    sparse_free (&st);
+    sparse_free (&zero);
+    free_matrix (&A);
+    free_matrix (&B);
+    free_matrix (&At);
+    free_matrix (&sum);
+    free_matrix (&diff);
+    free_matrix (&ds);
+    free_matrix (&dd);
+    free_matrix (&dt);
+}
+
+void register_sparse_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Sparse Tests", NULL, NULL);
+    CU_add_test (suite, "Dense Conversion", test_sparse_conversion);
+    CU_add_test (suite, "Sparse x Dense", test_sparse_multiply_dense);
+    CU_add_test (suite, "Parallel Products", test_sparse_multiply_parallel);
+    CU_add_test (suite, "Sparse x Sparse", test_sparse_multiply_sparse);
+    CU_add_test (suite, "Add Subtract Transpose",
+                 test_sparse_add_subtract_transpose);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file tests_strassen.c
+ *
+ * @brief Модуль реализации тестов для strassen.c
+ */
+
+#include "matrix/gemm.h"
+#include "matrix/matrix.h"
+#include "matrix/strassen.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Наибольший модуль элемента
+static double max_abs (const Matrix* m) {
+    double value = 0;
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            if (fabs (m->data[i][j]) > value) value = fabs (m->data[i][j]);
+        }
+    }
+    return value;
+}
+
+// Нормированная ошибка метода Штрассена относительно эталона; -1 при сбое
+static double strassen_error (int m, int n, int k, int crossover) {
+    Matrix a        = create_matrix (m, k);
+    Matrix b        = create_matrix (k, n);
+    Matrix result   = create_matrix (m, n);
+    Matrix expected = create_matrix (m, n);
+    double error    = 0;
+
+    fill_random (&a, 5);
+    fill_random (&b, 6);
+
+    if (multiply_matrices_strassen (&a, &b, &result, crossover) != 0) error = -1;
+    gemm_reference (m, n, k, a.block, a.stride, b.block, b.stride, expected.block,
+                    expected.stride);
+
+    for (int i = 0; i < m && error >= 0; i++) {
+        for (int j = 0; j < n; j++) {
+            double diff = fabs (result.data[i][j] - expected.data[i][j]);
+            if (diff > error) error = diff;
+        }
+    }
+    if (error > 0) error /= max_abs (&a) * max_abs (&b);
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&result);
+    free_matrix (&expected);
+
+    return error;
+}
+
+// Проверяет ошибку против допуска из strassen.h
+static int strassen_within_tolerance (int m, int n, int k, int crossover) {
+    const double error = strassen_error (m, n, k, crossover);
+    return error >= 0 &&
+           error <= STRASSEN_TOLERANCE (k, strassen_levels (m, n, k, crossover));
+}
+
+void test_strassen_even_sizes (void) {
+    CU_ASSERT_EQUAL (strassen_levels (256, 256, 256, 32), 3);
+    CU_ASSERT (strassen_within_tolerance (256, 256, 256, 32));
+    CU_ASSERT (strassen_within_tolerance (128, 192, 160, 16));
+}
+
+void test_strassen_odd_sizes (void) {
+    // Нечетные и неквадратные размеры на каждом уровне рекурсии
+    CU_ASSERT (strassen_within_tolerance (257, 263, 251, 32));
+    CU_ASSERT (strassen_within_tolerance (99, 35, 71, 8));
+    CU_ASSERT (strassen_within_tolerance (3, 3, 3, 1));
+}
+
+void test_strassen_crossover (void) {
+    const int m = 70, n = 50, k = 60;
+    Matrix    a        = create_matrix (m, k);
+    Matrix    b        = create_matrix (k, n);
+    Matrix    strassen = create_matrix (m, n);
+    Matrix    classic  = create_matrix (m, n);
+    int       same     = 1;
+
+    fill_random (&a, 7);
+    fill_random (&b, 8);
+
+    // Если размеры не больше порога, результат совпадает с gemm побитово
+    CU_ASSERT_EQUAL (strassen_levels (m, n, k, 64), 0);
+    CU_ASSERT_EQUAL (strassen_workspace_size (m, n, k, 64), 0);
+    CU_ASSERT_EQUAL (multiply_matrices_strassen (&a, &b, &strassen, 64), 0);
+    CU_ASSERT_EQUAL (multiply_matrices (&a, &b, &classic), 0);
+    for (int i = 0; i < m; i++) {
+        same = same && memcmp (strassen.data[i], classic.data[i],
+                               n * sizeof (MATRIX_TYPE)) == 0;
+    }
+    CU_ASSERT (same);
+
+    CU_ASSERT_EQUAL (multiply_matrices_strassen (&a, &a, &strassen, 64), 1);
+
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&strassen);
+    free_matrix (&classic);
+}
+
+void test_strassen_workspace (void) {
+    const int    m = 200, n = 180, k = 190, crossover = 40;
+    const size_t size = strassen_workspace_size (m, n, k, crossover);
+    Matrix       a    = create_matrix (m, k);
+    Matrix       b    = create_matrix (k, n);
+    Matrix       c1   = create_matrix (m, n);
+    Matrix       c2   = create_matrix (m, n);
+    MATRIX_TYPE* ws   = malloc (size * sizeof (MATRIX_TYPE));
+    int          same = 1;
+
+    // X и Y на каждом уровне меньше четверти операндов этого уровня
+    CU_ASSERT_EQUAL (strassen_levels (m, n, k, crossover), 3);
+    CU_ASSERT (size > 0 && size < (size_t) (m * k + k * n));
+
+    fill_random (&a, 9);
+    fill_random (&b, 10);
+
+    // Внешняя рабочая область дает тот же результат, что и внутренняя
+    CU_ASSERT_EQUAL (strassen_multiply (m, n, k, a.block, a.stride, b.block,
+                                        b.stride, c1.block, c1.stride, crossover, ws),
+                     0);
+    CU_ASSERT_EQUAL (multiply_matrices_strassen (&a, &b, &c2, crossover), 0);
+    for (int i = 0; i < m; i++) {
+        same = same && memcmp (c1.data[i], c2.data[i], n * sizeof (MATRIX_TYPE)) == 0;
+    }
+    CU_ASSERT (same);
+
+    free (ws);
+    free_matrix (&a);
+    free_matrix (&b);
+    free_matrix (&c1);
+    free_matrix (&c2);
+}
+
+void register_strassen_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Strassen Tests", NULL, NULL);
+    CU_add_test (suite, "Strassen Even Sizes", test_strassen_even_sizes);
+    CU_add_test (suite, "Strassen Odd Sizes", test_strassen_odd_sizes);
+    CU_add_test (suite, "Strassen Crossover", test_strassen_crossover);
+    CU_add_test (suite, "Strassen Workspace", test_strassen_workspace);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file tests_thread_pool.c
+ *
+ * @brief Модуль реализации тестов для thread_pool.c
+ */
+
+#include "parallel/thread_pool.h"
+
+#include <CUnit/CUnit.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TASKS 1000
+
+static atomic_int visited[TASKS];
+static atomic_int nested_sum;
+
+// Отмечает выполнение задачи
+static void mark_task (void* arg, int task, int worker) {
+    (void) arg;
+    if (worker >= 0 && worker < THREAD_POOL_MAX_THREADS)
+        atomic_fetch_add (&visited[task], 1);
+}
+
+// Суммирует номера задач вложенного цикла
+static void nested_inner (void* arg, int task, int worker) {
+    (void) arg;
+    (void) worker;
+    atomic_fetch_add (&nested_sum, task);
+}
+
+// Запускает вложенный цикл из задачи пула
+static void nested_outer (void* arg, int task, int worker) {
+    (void) arg;
+    (void) task;
+    (void) worker;
+    thread_pool_run (10, nested_inner, NULL);
+}
+
+void test_thread_pool_runs_every_task (void) {
+    CU_ASSERT_EQUAL (thread_pool_set_threads (4), 0);
+    CU_ASSERT_EQUAL (thread_pool_threads (), 4);
+
+    // Пул переиспользуется между вызовами, каждая задача ровно один раз
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < TASKS; i++) atomic_store (&visited[i], 0);
+        CU_ASSERT_EQUAL (thread_pool_run (TASKS, mark_task, NULL), 0);
+        int once = 1;
+        for (int i = 0; i < TASKS; i++) once = once && atomic_load (&visited[i]) == 1;
+        CU_ASSERT (once);
+    }
+
+    CU_ASSERT_EQUAL (thread_pool_run (-1, mark_task, NULL), -1);
+    CU_ASSERT_EQUAL (thread_pool_run (1, NULL, NULL), -1);
+    CU_ASSERT_EQUAL (thread_pool_set_threads (-1), -1);
+
+    thread_pool_set_threads (0);
+}
+
+void test_thread_pool_nested (void) {
+    thread_pool_set_threads (3);
+
+    // Вложенные циклы выполняются последовательно без взаимной блокировки
+    atomic_store (&nested_sum, 0);
+    CU_ASSERT_EQUAL (thread_pool_run (8, nested_outer, NULL), 0);
+    CU_ASSERT_EQUAL (atomic_load (&nested_sum), 8 * 45);
+
+    thread_pool_set_threads (0);
+}
+
+void register_thread_pool_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Thread Pool Tests", NULL, NULL);
+    CU_add_test (suite, "Thread Pool Runs Every Task", test_thread_pool_runs_every_task);
+    CU_add_test (suite, "Thread Pool Nested", test_thread_pool_nested);
+}
@@ -0,0 +1,387 @@
+/**
+ * @file tests_typed.c
+ *
+ * @brief Модуль реализации тестов для typed.c
+ */
+
+#include "matrix/matrix.h"
+#include "matrix/simd.h"
+#include "output/output.h"
+#include "tests.h"
+
+#include <CUnit/CUnit.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Заполняет матрицу double целыми значениями из [-range, range]
+static void fill_integers (Matrix* m, unsigned seed, int range) {
+    srand (seed);
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            m->data[i][j] = rand () % (2 * range + 1) - range;
+        }
+    }
+}
+
+void test_typed_convert (void) {
+    MatrixElementType type = MATRIX_F64;
+
+    // Имена и размеры типов
+    CU_ASSERT_EQUAL (matrix_type_from_name ("i32", &type), 0);
+    CU_ASSERT_EQUAL (type, MATRIX_I32);
+    CU_ASSERT_EQUAL (matrix_type_from_name ("f16", &type), -1);
+    CU_ASSERT_STRING_EQUAL (matrix_type_name (MATRIX_F32), "f32");
+    CU_ASSERT_PTR_NULL (matrix_type_name (MATRIX_ELEMENT_TYPE_COUNT));
+    CU_ASSERT_EQUAL (matrix_element_size (MATRIX_F64), sizeof (double));
+    CU_ASSERT_EQUAL (matrix_element_size (MATRIX_I32), sizeof (int32_t));
+
+    // Строки выровнены по кэш-линии
+    Matrix T = create_matrix_typed (3, 17, MATRIX_F32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (T.elements);
+    CU_ASSERT_PTR_NULL (T.data);
+    CU_ASSERT_EQUAL ((T.stride * sizeof (float)) % MATRIX_ALIGNMENT, 0);
+    CU_ASSERT_EQUAL ((uintptr_t) T.elements % MATRIX_ALIGNMENT, 0);
+    free_matrix (&T);
+    CU_ASSERT_FALSE (matrix_valid (&T));
+
+    // Округление к ближайшему, насыщение и NaN
+    const double values[6]   = {2.5, -1.6, 3e10, -3e10, NAN, 7.0};
+    const int32_t expected[6] = {2, -2, INT32_MAX, INT32_MIN, 0, 7};
+    Matrix        D           = create_matrix (2, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (D.data);
+    for (int i = 0; i < 6; i++) D.data[i / 3][i % 3] = values[i];
+
+    Matrix I = convert_matrix_type (&D, MATRIX_I32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (I.elements);
+    CU_ASSERT_EQUAL (I.type, MATRIX_I32);
+    int ok = 1;
+    for (int i = 0; i < 6; i++) {
+        ok = ok && MATRIX_AT_I32 (&I, i / 3, i % 3) == expected[i];
+    }
+    CU_ASSERT_TRUE (ok);
+
+    // float -> double точно, double -> float - до ближайшего float
+    Matrix F = convert_matrix_type (&D, MATRIX_F32);
+    Matrix W = convert_matrix_type (&F, MATRIX_F64);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (W.data);
+    CU_ASSERT_EQUAL (W.data[0][1], (double) -1.6f);
+    CU_ASSERT_TRUE (isnan (W.data[1][1]));
+
+    // Копия того же типа не делит память с исходной
+    Matrix J = convert_matrix_type (&I, MATRIX_I32);
+    CU_ASSERT_PTR_NOT_EQUAL (J.elements, I.elements);
+    CU_ASSERT_EQUAL (MATRIX_AT_I32 (&J, 1, 2), 7);
+
+    free_matrix (&D);
+    free_matrix (&I);
+    free_matrix (&F);
+    free_matrix (&W);
+    free_matrix (&J);
+}
+
+void test_typed_arithmetic (void) {
+    const int m = 37, k = 300, n = 45;   // k больше TYPED_KC, хвосты векторов
+    Matrix    A = create_matrix (m, k), B = create_matrix (k, n);
+    Matrix    E = create_matrix (m, n);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (E.data);
+
+    // float: результат в пределах точности float от произведения в double
+    fill_random (&A, 1);
+    fill_random (&B, 2);
+    CU_ASSERT_EQUAL (multiply_matrices (&A, &B, &E), 0);
+    Matrix Af = convert_matrix_type (&A, MATRIX_F32);
+    Matrix Bf = convert_matrix_type (&B, MATRIX_F32);
+    Matrix Rf = create_matrix_typed (m, n, MATRIX_F32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (Rf.elements);
+    CU_ASSERT_EQUAL (multiply_matrices (&Af, &Bf, &Rf), 0);
+    int ok = 1;
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            ok = ok && fabs (MATRIX_AT_F32 (&Rf, i, j) - E.data[i][j]) <=
+                           4.0 * k * FLT_EPSILON;
+        }
+    }
+    CU_ASSERT_TRUE (ok);
+
+    // Сложение и вычитание float совпадают со скалярной арифметикой
+    Matrix Sf = create_matrix_typed (m, k, MATRIX_F32);
+    CU_ASSERT_EQUAL (add_matrices (&Af, &Af, &Sf), 0);
+    CU_ASSERT_EQUAL (subtract_matrices (&Sf, &Af, &Sf), 0);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < k; j++) {
+            const float a = MATRIX_AT_F32 (&Af, i, j);
+            ok            = ok && MATRIX_AT_F32 (&Sf, i, j) == (a + a) - a;
+        }
+    }
+    CU_ASSERT_TRUE (ok);
+
+    // int32_t: произведение небольших целых точно
+    fill_integers (&A, 3, 100);
+    fill_integers (&B, 4, 100);
+    CU_ASSERT_EQUAL (multiply_matrices (&A, &B, &E), 0);
+    Matrix Ai = convert_matrix_type (&A, MATRIX_I32);
+    Matrix Bi = convert_matrix_type (&B, MATRIX_I32);
+    Matrix Ri = create_matrix_typed (m, n, MATRIX_I32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (Ri.elements);
+    CU_ASSERT_EQUAL (multiply_matrices (&Ai, &Bi, &Ri), 0);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            ok = ok && MATRIX_AT_I32 (&Ri, i, j) == E.data[i][j];
+        }
+    }
+    CU_ASSERT_TRUE (ok);
+
+    // Переполнение int32_t - по модулю 2^32
+    Matrix X = create_matrix_typed (1, 2, MATRIX_I32);
+    Matrix Y = create_matrix_typed (1, 2, MATRIX_I32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (Y.elements);
+    MATRIX_AT_I32 (&X, 0, 0) = INT32_MAX;
+    MATRIX_AT_I32 (&X, 0, 1) = INT32_MIN;
+    MATRIX_AT_I32 (&Y, 0, 0) = 1;
+    MATRIX_AT_I32 (&Y, 0, 1) = 1;
+    CU_ASSERT_EQUAL (add_matrices (&X, &Y, &Y), 0);
+    CU_ASSERT_EQUAL (MATRIX_AT_I32 (&Y, 0, 0), INT32_MIN);
+    CU_ASSERT_EQUAL (MATRIX_AT_I32 (&Y, 0, 1), INT32_MIN + 1);
+
+    free_matrix (&A);
+    free_matrix (&B);
+    free_matrix (&E);
+    free_matrix (&Af);
+    free_matrix (&Bf);
+    free_matrix (&Rf);
+    free_matrix (&Sf);
+    free_matrix (&Ai);
+    free_matrix (&Bi);
+    free_matrix (&Ri);
+    free_matrix (&X);
+    free_matrix (&Y);
+}
+
+void test_typed_accumulate (void) {
+    const int m = 70, k = 40, n = 33;
+    Matrix    A = create_matrix (m, k), B = create_matrix (k, n);
+    Matrix    C = create_matrix (m, n), E = create_matrix (m, n);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (E.data);
+    fill_integers (&A, 11, 50);
+    fill_integers (&B, 12, 50);
+    fill_integers (&C, 13, 1000);
+    CU_ASSERT_EQUAL (multiply_matrices (&A, &B, &E), 0);
+
+    // int32_t: C = 2 * A x B - 3 * C точно, затем Y = X + Y на месте
+    Matrix Ai = convert_matrix_type (&A, MATRIX_I32);
+    Matrix Bi = convert_matrix_type (&B, MATRIX_I32);
+    Matrix Ci = convert_matrix_type (&C, MATRIX_I32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (Ci.elements);
+    CU_ASSERT_EQUAL (gemm_matrices (2, &Ai, &Bi, -3, &Ci), 0);
+    CU_ASSERT_EQUAL (axpby_matrices (1, &Ci, 1, &Ci), 0);
+    int ok = 1;
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            ok = ok && MATRIX_AT_I32 (&Ci, i, j) ==
+                           2 * (2 * E.data[i][j] - 3 * C.data[i][j]);
+        }
+    }
+    CU_ASSERT_TRUE (ok);
+
+    // Дробные множители для int32_t не допускаются
+    CU_ASSERT_EQUAL (gemm_matrices (0.5, &Ai, &Bi, 1, &Ci), 1);
+    CU_ASSERT_EQUAL (axpby_matrices (1, &Ci, 0.5, &Ci), -1);
+
+    // float: C = 0.5 * A x B + C и Y = 2 * X + 0 * Y
+    Matrix Af = convert_matrix_type (&A, MATRIX_F32);
+    Matrix Bf = convert_matrix_type (&B, MATRIX_F32);
+    Matrix Cf = convert_matrix_type (&C, MATRIX_F32);
+    Matrix Yf = create_matrix_typed (m, n, MATRIX_F32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (Yf.elements);
+    CU_ASSERT_EQUAL (gemm_matrices (0.5, &Af, &Bf, 1, &Cf), 0);
+    CU_ASSERT_EQUAL (axpby_matrices (2, &Cf, 0, &Yf), 0);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            ok = ok && MATRIX_AT_F32 (&Yf, i, j) == (float) (E.data[i][j] +
+                                                             2 * C.data[i][j]);
+        }
+    }
+    CU_ASSERT_TRUE (ok);
+    CU_ASSERT_EQUAL (gemm_matrices (1, &Af, &Bf, 1, &Ci), 1);
+
+    Matrix* all[] = {&A, &B, &C, &E, &Ai, &Bi, &Ci, &Af, &Bf, &Cf, &Yf};
+    for (int t = 0; t < 11; t++) free_matrix (all[t]);
+}
+
+void test_typed_fused_transpose (void) {
+    const int m = 19, k = 23, n = 29;
+    Matrix    A = create_matrix (m, k), B = create_matrix (k, n);
+    Matrix    C = create_matrix (m, n), D = create_matrix (n, m);
+    Matrix    E = create_matrix (m, n);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (E.data);
+    fill_integers (&A, 5, 50);
+    fill_integers (&B, 6, 50);
+    fill_integers (&C, 7, 1000);
+    fill_integers (&D, 8, 1000);
+    CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&A, &B, &C, &D, &E), 0);
+
+    for (int t = MATRIX_F32; t <= MATRIX_I32; t++) {
+        const MatrixElementType type = (MatrixElementType) t;
+        Matrix                  At   = convert_matrix_type (&A, type);
+        Matrix                  Bt   = convert_matrix_type (&B, type);
+        Matrix                  Ct   = convert_matrix_type (&C, type);
+        Matrix                  Dt   = convert_matrix_type (&D, type);
+        Matrix                  R    = create_matrix_typed (m, n, type);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (R.elements);
+
+        // Целые значения точно представимы в обоих типах
+        CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&At, &Bt, &Ct, &Dt, &R),
+                         0);
+        Matrix W  = convert_matrix_type (&R, MATRIX_F64);
+        int    ok = W.data != NULL;
+        for (int i = 0; ok && i < m; i++) {
+            for (int j = 0; j < n; j++) ok = ok && W.data[i][j] == E.data[i][j];
+        }
+        CU_ASSERT_TRUE (ok);
+
+        // Транспонирование в новую матрицу и на месте
+        Matrix Tr = transpose_matrix (&Dt);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (Tr.elements);
+        CU_ASSERT_EQUAL (Tr.type, type);
+        CU_ASSERT_EQUAL (Tr.rows, m);
+        CU_ASSERT_EQUAL (transpose_matrix_inplace (&Dt), 0);
+        CU_ASSERT_EQUAL (Dt.rows, m);
+        CU_ASSERT_EQUAL (Dt.cols, n);
+        CU_ASSERT_EQUAL (transpose_matrix_inplace (&At), 0);
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                const uint32_t* tr = Tr.elements;
+                const uint32_t* dt = Dt.elements;
+                ok              = ok && tr[(size_t) i * Tr.stride + j] ==
+                                     dt[(size_t) i * Dt.stride + j];
+            }
+        }
+        CU_ASSERT_TRUE (ok);
+        Matrix Aw = convert_matrix_type (&At, MATRIX_F64);
+        for (int i = 0; Aw.data && i < k; i++) {
+            for (int j = 0; j < m; j++) ok = ok && Aw.data[i][j] == A.data[j][i];
+        }
+        CU_ASSERT_TRUE (ok);
+
+        free_matrix (&At);
+        free_matrix (&Bt);
+        free_matrix (&Ct);
+        free_matrix (&Dt);
+        free_matrix (&R);
+        free_matrix (&W);
+        free_matrix (&Tr);
+        free_matrix (&Aw);
+    }
+
+    // Широкая матрица без запаса в строках: плотный шаг в том же блоке
+    Matrix wide = create_matrix_typed (3, 1000, MATRIX_I32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (wide.elements);
+    void* block = wide.elements;
+    MATRIX_AT_I32 (&wide, 2, 999) = 7;
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (&wide), 0);
+    CU_ASSERT_EQUAL (wide.stride, 3);
+    CU_ASSERT_EQUAL (MATRIX_AT_I32 (&wide, 999, 2), 7);
+    CU_ASSERT_EQUAL (transpose_matrix_inplace (&wide), 0);
+    CU_ASSERT_EQUAL (MATRIX_AT_I32 (&wide, 2, 999), 7);
+    CU_ASSERT_PTR_EQUAL (wide.elements, block);
+    free_matrix (&wide);
+
+    // Детерминант и его логарифм считаются в double
+    Matrix S = create_matrix_typed (3, 3, MATRIX_I32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (S.elements);
+    const int32_t rows[3][3] = {{2, 0, 1}, {1, 3, 2}, {1, 1, 2}};
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) MATRIX_AT_I32 (&S, i, j) = rows[i][j];
+    }
+    int sign = 0;
+    CU_ASSERT_DOUBLE_EQUAL (determinant (&S), 6, 1e-12);
+    CU_ASSERT_DOUBLE_EQUAL (log_determinant (&S, &sign), log (6.0), 1e-12);
+    CU_ASSERT_EQUAL (sign, 1);
+
+    free_matrix (&A);
+    free_matrix (&B);
+    free_matrix (&C);
+    free_matrix (&D);
+    free_matrix (&E);
+    free_matrix (&S);
+}
+
+void test_typed_binary_file (void) {
+    const char* filename = "test_typed.bin";
+    Matrix      D        = create_matrix (5, 7);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (D.data);
+    fill_integers (&D, 9, 1000);
+
+    for (int t = MATRIX_F32; t <= MATRIX_I32; t++) {
+        Matrix M = convert_matrix_type (&D, (MatrixElementType) t);
+        CU_ASSERT_EQUAL (save_matrix_to_binary_file (&M, filename), 0);
+
+        // Тип хранится в файле и сохраняется при загрузке
+        OutputBinaryFile file;
+        CU_ASSERT_EQUAL (output_map_binary_file (filename, &file), 0);
+        CU_ASSERT_EQUAL (file.header.element_size, sizeof (int32_t));
+        output_unmap_binary_file (&file);
+
+        Matrix L = load_matrix_typed (filename);
+        CU_ASSERT_PTR_NOT_NULL_FATAL (L.elements);
+        CU_ASSERT_EQUAL (L.type, t);
+        CU_ASSERT_PTR_NOT_NULL (L.mapping);   // Без копирования
+        Matrix W  = load_matrix_from_file (filename);
+        int    ok = W.data != NULL && W.type == MATRIX_F64;
+        for (int i = 0; ok && i < D.rows; i++) {
+            for (int j = 0; j < D.cols; j++) {
+                const uint32_t* l = L.elements;
+                const uint32_t* m = M.elements;
+                ok = ok && W.data[i][j] == D.data[i][j] &&
+                     l[(size_t) i * L.stride + j] == m[(size_t) i * M.stride + j];
+            }
+        }
+        CU_ASSERT_TRUE (ok);
+
+        // Текстовый файл пишется через double
+        CU_ASSERT_EQUAL (save_matrix_to_file (&L, "test_typed.txt"), 0);
+
+        free_matrix (&M);
+        free_matrix (&L);
+        free_matrix (&W);
+    }
+
+    remove (filename);
+    remove ("test_typed.txt");
+    free_matrix (&D);
+}
+
+void test_typed_mixed (void) {
+    Matrix D = create_matrix (4, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (D.data);
+    fill_integers (&D, 10, 10);
+    Matrix F = convert_matrix_type (&D, MATRIX_F32);
+    Matrix I = convert_matrix_type (&D, MATRIX_I32);
+    Matrix R = create_matrix_typed (4, 4, MATRIX_F32);
+    CU_ASSERT_PTR_NOT_NULL_FATAL (R.elements);
+
+    // Операнды разных типов не смешиваются
+    CU_ASSERT_EQUAL (add_matrices (&F, &I, &R), -1);
+    CU_ASSERT_EQUAL (subtract_matrices (&F, &D, &R), -1);
+    CU_ASSERT_EQUAL (multiply_matrices (&F, &F, &D), 1);
+    CU_ASSERT_EQUAL (multiply_matrices_strassen (&F, &F, &R, 0), 1);
+    CU_ASSERT_EQUAL (multiply_add_subtract_transposed (&F, &F, &F, &I, &R), 1);
+
+    free_matrix (&D);
+    free_matrix (&F);
+    free_matrix (&I);
+    free_matrix (&R);
+}
+
+void register_typed_tests (void) {
+    CU_pSuite suite = CU_add_suite ("Typed Matrix Tests", NULL, NULL);
+    CU_add_test (suite, "Create and Convert", test_typed_convert);
+    CU_add_test (suite, "Arithmetic", test_typed_arithmetic);
+    CU_add_test (suite, "GEMM and AXPBY", test_typed_accumulate);
+    CU_add_test (suite, "Fused and Transpose", test_typed_fused_transpose);
+    CU_add_test (suite, "Binary File Keeps Type", test_typed_binary_file);
+    CU_add_test (suite, "Mixed Types", test_typed_mixed);
+}
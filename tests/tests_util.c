@@ -0,0 +1,44 @@
+/**
+ * @file tests_util.c
+ *
+ * @brief Модуль реализации общих вспомогательных функций тестов
+ */
+
+#include "tests.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Заполняет матрицу double псевдослучайными значениями из [-1, 1]
+void fill_random (Matrix* m, unsigned seed) {
+    srand (seed);
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            m->data[i][j] = 2.0 * rand () / RAND_MAX - 1.0;
+        }
+    }
+}
+
+// Псевдослучайные биты (xorshift), одинаковые при каждом запуске
+uint64_t next_random (uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Удаляет каталог кэша вместе с записями
+void remove_cache (const char* directory) {
+    DIR*           dir = opendir (directory);
+    struct dirent* item;
+    char           path[512];
+
+    while (dir && (item = readdir (dir)) != NULL) {
+        snprintf (path, sizeof (path), "%s/%s", directory, item->d_name);
+        if (item->d_name[0] != '.') remove (path);
+    }
+    if (dir) closedir (dir);
+    rmdir (directory);
+}